@@ -39,8 +39,8 @@
 
 #include "llmath.h"
 
-S32 LLJoint::sNumUpdates = 0;
-S32 LLJoint::sNumTouches = 0;
+LLAtomicS32 LLJoint::sNumUpdates(0);
+LLAtomicS32 LLJoint::sNumTouches(0);
 
 //-----------------------------------------------------------------------------
 // LLJoint()
@@ -55,6 +55,7 @@ LLJoint::LLJoint()
 	mDirtyFlags = MATRIX_DIRTY | ROTATION_DIRTY | POSITION_DIRTY;
 	mUpdateXform = TRUE;
 	mJointNum = -1;
+	mPoseVersion = 0;
 	touch();
 	mResetAfterRestoreOldXform = false;
 }
@@ -72,6 +73,7 @@ LLJoint::LLJoint(const std::string &name, LLJoint *parent)
 	mDirtyFlags = MATRIX_DIRTY | ROTATION_DIRTY | POSITION_DIRTY;
 	mUpdateXform = FALSE;
 	mJointNum = 0;
+	mPoseVersion = 0;
 
 	setName(name);
 	if (parent)
@@ -179,6 +181,9 @@ void LLJoint::addChild(LLJoint* joint)
 	joint->mXform.setParent(&mXform);
 	joint->mParent = this;
 	joint->touch();
+	// touch() is a no-op on already dirty joints: make sure the new skeleton
+	// sees a pose change.
+	bumpPoseVersion();
 }
 
 //--------------------------------------------------------------------
@@ -229,7 +234,10 @@ const LLVector3& LLJoint::getPosition()
 //--------------------------------------------------------------------
 void LLJoint::setPosition( const LLVector3& pos )
 {
-//	if (mXform.getPosition() != pos)
+	// Note: the pose blender sets all the animated joints on each update,
+	// so do not dirty the skeleton (and the rigged meshes skinning caches)
+	// when nothing actually changed.
+	if (mXform.getPosition() != pos)
 	{
 		mXform.setPosition(pos);
 		touch(MATRIX_DIRTY | POSITION_DIRTY);
@@ -269,7 +277,7 @@ void LLJoint::restoreOldXform( void )
 void LLJoint::restoreToDefaultXform( void )
 {
 	mXform = mDefaultXform;
-	setPosition(mXform.getPosition());
+	touch(MATRIX_DIRTY | POSITION_DIRTY);
 }
 
 //--------------------------------------------------------------------
@@ -332,7 +340,7 @@ void LLJoint::setRotation( const LLQuaternion& rot )
 {
 	if (rot.isFinite())
 	{
-	//	if (mXform.getRotation() != rot)
+		if (mXform.getRotation() != rot)
 		{
 			mXform.setRotation(rot);
 			touch(MATRIX_DIRTY | ROTATION_DIRTY);
@@ -396,7 +404,7 @@ const LLVector3& LLJoint::getScale()
 //--------------------------------------------------------------------
 void LLJoint::setScale( const LLVector3& scale )
 {
-//	if (mXform.getScale() != scale)
+	if (mXform.getScale() != scale)
 	{
 		mXform.setScale(scale);
 		touch();
@@ -436,13 +444,25 @@ llinfos << "WARNING: LLJoint::setWorldMatrix() not correctly implemented yet" <<
 // updateWorldMatrixParent()
 //-----------------------------------------------------------------------------
 void LLJoint::updateWorldMatrixParent()
+{
+	if (mDirtyFlags & MATRIX_DIRTY)
+	{
+		updateWorldMatrixAncestors();
+		bumpPoseVersion();
+	}
+}
+
+//-----------------------------------------------------------------------------
+// updateWorldMatrixAncestors()
+//-----------------------------------------------------------------------------
+void LLJoint::updateWorldMatrixAncestors()
 {
 	if (mDirtyFlags & MATRIX_DIRTY)
 	{
 		LLJoint *parent = getParent();
 		if (parent)
 		{
-			parent->updateWorldMatrixParent();
+			parent->updateWorldMatrixAncestors();
 		}
 		updateWorldMatrix();
 	}
@@ -471,19 +491,38 @@ void LLJoint::updateWorldPRSParent()
 //-----------------------------------------------------------------------------
 void LLJoint::updateWorldMatrixChildren()
 {
-	if (!this->mUpdateXform) return;
+	// Bump the pose version only once per skeleton update
+	if (updateWorldMatrixSubtree())
+	{
+		bumpPoseVersion();
+	}
+}
 
+//-----------------------------------------------------------------------------
+// updateWorldMatrixSubtree()
+// Returns true when any world matrix got recomputed.
+//-----------------------------------------------------------------------------
+bool LLJoint::updateWorldMatrixSubtree()
+{
+	if (!this->mUpdateXform) return false;
+
+	bool updated = false;
 	if (mDirtyFlags & MATRIX_DIRTY)
 	{
 		updateWorldMatrix();
+		updated = true;
 	}
 	for (child_list_t::iterator iter = mChildren.begin(),
 								end = mChildren.end();
 		 iter != end; ++iter)
 	{
 		LLJoint* joint = *iter;
-		joint->updateWorldMatrixChildren();
+		if (joint->updateWorldMatrixSubtree())
+		{
+			updated = true;
+		}
 	}
+	return updated;
 }
 
 //-----------------------------------------------------------------------------
@@ -499,6 +538,19 @@ void LLJoint::updateWorldMatrix()
 	}
 }
 
+//-----------------------------------------------------------------------------
+// bumpPoseVersion()
+//-----------------------------------------------------------------------------
+void LLJoint::bumpPoseVersion()
+{
+	LLJoint* root = this;
+	while (root->mParent)
+	{
+		root = root->mParent;
+	}
+	++root->mPoseVersion;
+}
+
 //--------------------------------------------------------------------
 // getSkinOffset()
 //--------------------------------------------------------------------
@@ -39,6 +39,7 @@
 #include <string>
 
 #include "linked_lists.h"
+#include "llapr.h"
 #include "v3math.h"
 #include "v4math.h"
 #include "m4math.h"
@@ -48,6 +49,10 @@
 
 const S32 LL_CHARACTER_MAX_JOINTS_PER_MESH = 15;
 const U32 LL_CHARACTER_MAX_JOINTS = 32; // must be divisible by 4!
+// Upper bound for the number of bones in a character skeleton (num_bones in
+// avatar_skeleton.xml), i.e. for the joint numbers used to index per joint
+// arrays; joints numbered beyond it are dealt with by slower look-ups.
+const S32 LL_CHARACTER_MAX_SKELETON_JOINTS = 256;
 const U32 LL_HAND_JOINT_NUM = 31;
 const U32 LL_FACE_JOINT_NUM = 30;
 const S32 LL_CHARACTER_MAX_PRIORITY = 7;
@@ -106,9 +111,16 @@ public:
 	typedef std::list<LLJoint*> child_list_t;
 	child_list_t mChildren;
 
-	// debug statics
-	static S32		sNumTouches;
-	static S32		sNumUpdates;
+	// Bumped on the root joint once per skeleton update (or lazy world matrix
+	// update) which recomputed any world matrix in the skeleton, so that the
+	// consumers (e.g. rigged mesh skinning) may cache data derived from the
+	// current pose.
+	U32				mPoseVersion;
+
+	// debug statics (atomic, since joints get updated by the animation
+	// worker threads)
+	static LLAtomicS32	sNumTouches;
+	static LLAtomicS32	sNumUpdates;
 
 public:
 	LLJoint();
@@ -174,6 +186,9 @@ public:
 
 	void updateWorldMatrix();
 
+	// Only meaningful for the root joint of a skeleton
+	U32 getPoseVersion() const						{ return mPoseVersion; }
+
 	// get/set skin offset
 	const LLVector3 &getSkinOffset();
 	void setSkinOffset(const LLVector3 &offset);
@@ -201,6 +216,11 @@ public:
 	const BOOL doesJointNeedToBeReset(void) const	{ return mResetAfterRestoreOldXform; }
 	//Setter for joint reset flag
 	void setJointToBeReset(BOOL val)				{ mResetAfterRestoreOldXform = val; }
+
+private:
+	void updateWorldMatrixAncestors();
+	bool updateWorldMatrixSubtree();
+	void bumpPoseVersion();
 };
 
 #endif // LL_LLJOINT_H
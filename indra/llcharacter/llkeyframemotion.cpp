@@ -127,6 +127,164 @@ U32 LLKeyframeMotion::JointMotionList::dumpDiagInfo()
 }
 
 //-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+// Flat key lookups
+//-----------------------------------------------------------------------------
+
+// Set to 1 to check each flat curve lookup against the std::map based
+// getValue() and warn about any difference (which there should be none of).
+#define LL_KEYFRAME_CURVE_CHECK 0
+
+// Returns the index of the first key at or after 'time' (i.e. the key that
+// std::map::lower_bound() would find), or 'count' when past the last key.
+// Motions mostly play forward, so the previous result held in 'cursor', or
+// the key just after it, normally matches without any search.
+static S32 find_key(const F32* times, S32 count, F32 time, S32& cursor)
+{
+	for (S32 i = cursor, last = llmin(cursor + 1, count); i <= last; ++i)
+	{
+		if (i >= 0 && (i == 0 || times[i - 1] < time) &&
+			(i == count || times[i] >= time))
+		{
+			cursor = i;
+			return i;
+		}
+	}
+	cursor = std::lower_bound(times, times + count, time) - times;
+	return cursor;
+}
+
+// Gathers the quaternion linear interpolations of a keyframe update and runs
+// them four at a time with SSE. Each lane performs the same operations, in
+// the same order, as nlerp() -> lerp() -> LLQuaternion::normalize(), so the
+// results are bit-identical. Opposite hemisphere pairs (slerp) stay scalar.
+class LLQuaternionLerpBatch
+{
+public:
+	LLQuaternionLerpBatch()
+	:	mCount(0)
+	{
+	}
+
+	void add(LLJointState* joint_state, F32 u, const LLQuaternion& a,
+			 const LLQuaternion& b)
+	{
+		if (dot(a, b) < 0.f)
+		{
+			joint_state->setRotation(nlerp(u, a, b));
+			return;
+		}
+		mStates[mCount] = joint_state;
+		mU[mCount] = u;
+		mA[mCount] = &a;
+		mB[mCount] = &b;
+		if (++mCount == BATCH_SIZE)
+		{
+			flush();
+		}
+	}
+
+	void flush();
+
+private:
+	enum { BATCH_SIZE = 16 };
+	LLJointState*		mStates[BATCH_SIZE];
+	const LLQuaternion*	mA[BATCH_SIZE];
+	const LLQuaternion*	mB[BATCH_SIZE];
+	F32					mU[BATCH_SIZE];
+	S32					mCount;
+};
+
+void LLQuaternionLerpBatch::flush()
+{
+	static const LLQuad one = _mm_set1_ps(1.f);
+	static const LLQuad mag_threshold = _mm_set1_ps(FP_MAG_THRESHOLD);
+	static const LLQuad unity_threshold = _mm_set1_ps(ONE_PART_IN_A_MILLION);
+	static const LLQuad abs_mask =
+		_mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+
+	for (S32 i = 0; i < mCount; i += 4)
+	{
+		S32 n = llmin(4, mCount - i);
+		// Pad the last block with copies of its first lane
+		S32 l1 = n > 1 ? i + 1 : i;
+		S32 l2 = n > 2 ? i + 2 : i;
+		S32 l3 = n > 3 ? i + 3 : i;
+
+		LLQuad ax = _mm_loadu_ps(mA[i]->mQ);
+		LLQuad ay = _mm_loadu_ps(mA[l1]->mQ);
+		LLQuad az = _mm_loadu_ps(mA[l2]->mQ);
+		LLQuad aw = _mm_loadu_ps(mA[l3]->mQ);
+		_MM_TRANSPOSE4_PS(ax, ay, az, aw);
+		LLQuad bx = _mm_loadu_ps(mB[i]->mQ);
+		LLQuad by = _mm_loadu_ps(mB[l1]->mQ);
+		LLQuad bz = _mm_loadu_ps(mB[l2]->mQ);
+		LLQuad bw = _mm_loadu_ps(mB[l3]->mQ);
+		_MM_TRANSPOSE4_PS(bx, by, bz, bw);
+
+		LLQuad t = _mm_setr_ps(mU[i], mU[l1], mU[l2], mU[l3]);
+		LLQuad inv_t = _mm_sub_ps(one, t);
+
+		// lerp(): r = t * b + inv_t * a
+		LLQuad rx = _mm_add_ps(_mm_mul_ps(t, bx), _mm_mul_ps(inv_t, ax));
+		LLQuad ry = _mm_add_ps(_mm_mul_ps(t, by), _mm_mul_ps(inv_t, ay));
+		LLQuad rz = _mm_add_ps(_mm_mul_ps(t, bz), _mm_mul_ps(inv_t, az));
+		LLQuad rw = _mm_add_ps(_mm_mul_ps(t, bw), _mm_mul_ps(inv_t, aw));
+
+		// normalize()
+		LLQuad mag = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(rx, rx),
+														_mm_mul_ps(ry, ry)),
+											 _mm_mul_ps(rz, rz)),
+								  _mm_mul_ps(rw, rw));
+		mag = _mm_sqrt_ps(mag);
+		LLQuad valid = _mm_cmpgt_ps(mag, mag_threshold);
+		LLQuad rescale =
+			_mm_and_ps(valid,
+					   _mm_cmpgt_ps(_mm_and_ps(_mm_sub_ps(one, mag), abs_mask),
+									unity_threshold));
+		LLQuad oomag = _mm_div_ps(one, mag);
+		rx = _mm_or_ps(_mm_and_ps(rescale, _mm_mul_ps(rx, oomag)),
+					   _mm_andnot_ps(rescale, rx));
+		ry = _mm_or_ps(_mm_and_ps(rescale, _mm_mul_ps(ry, oomag)),
+					   _mm_andnot_ps(rescale, ry));
+		rz = _mm_or_ps(_mm_and_ps(rescale, _mm_mul_ps(rz, oomag)),
+					   _mm_andnot_ps(rescale, rz));
+		rw = _mm_or_ps(_mm_and_ps(rescale, _mm_mul_ps(rw, oomag)),
+					   _mm_andnot_ps(rescale, rw));
+		// A very bad quaternion becomes the identity
+		rx = _mm_and_ps(valid, rx);
+		ry = _mm_and_ps(valid, ry);
+		rz = _mm_and_ps(valid, rz);
+		rw = _mm_or_ps(_mm_and_ps(valid, rw), _mm_andnot_ps(valid, one));
+
+		_MM_TRANSPOSE4_PS(rx, ry, rz, rw);
+		LL_ALIGN_16(F32 result[4][4]);
+		_mm_store_ps(result[0], rx);
+		_mm_store_ps(result[1], ry);
+		_mm_store_ps(result[2], rz);
+		_mm_store_ps(result[3], rw);
+
+		for (S32 j = 0; j < n; ++j)
+		{
+			LLQuaternion rot;
+			rot.mQ[VX] = result[j][VX];
+			rot.mQ[VY] = result[j][VY];
+			rot.mQ[VZ] = result[j][VZ];
+			rot.mQ[VW] = result[j][VW];
+#if LL_KEYFRAME_CURVE_CHECK
+			LLQuaternion ref = nlerp(mU[i + j], *mA[i + j], *mB[i + j]);
+			if (memcmp(ref.mQ, rot.mQ, sizeof(rot.mQ)))
+			{
+				llwarns << "Batched nlerp mismatch: " << rot << " instead of "
+						<< ref << llendl;
+			}
+#endif
+			mStates[i + j]->setRotation(rot);
+		}
+	}
+	mCount = 0;
+}
+
 //-----------------------------------------------------------------------------
 // ****Curve classes
 //-----------------------------------------------------------------------------
@@ -213,6 +371,56 @@ LLVector3 LLKeyframeMotion::ScaleCurve::interp(F32 u, ScaleKey& before, ScaleKey
 	}
 }
 
+//-----------------------------------------------------------------------------
+// ScaleCurve::compile()
+//-----------------------------------------------------------------------------
+void LLKeyframeMotion::ScaleCurve::compile()
+{
+	mKeyTimes.clear();
+	mKeyScales.clear();
+	mKeyTimes.reserve(mKeys.size());
+	mKeyScales.reserve(mKeys.size());
+	for (key_map_t::const_iterator iter = mKeys.begin(), end = mKeys.end();
+		 iter != end; ++iter)
+	{
+		mKeyTimes.push_back(iter->first);
+		mKeyScales.push_back(iter->second.mScale);
+	}
+}
+
+//-----------------------------------------------------------------------------
+// ScaleCurve::getValueAt() (flat arrays version of getValue())
+//-----------------------------------------------------------------------------
+LLVector3 LLKeyframeMotion::ScaleCurve::getValueAt(F32 time, S32& cursor) const
+{
+	S32 count = mKeyTimes.size();
+	if (!count)
+	{
+		return LLVector3::zero;
+	}
+
+	S32 right = find_key(&mKeyTimes[0], count, time, cursor);
+	if (right == count)
+	{
+		// Past last key
+		return mKeyScales[count - 1];
+	}
+	if (right == 0 || mKeyTimes[right] == time)
+	{
+		// Before first key or exactly on a key
+		return mKeyScales[right];
+	}
+
+	// Between two keys
+	S32 left = right - 1;
+	if (mInterpolationType == IT_STEP)
+	{
+		return mKeyScales[left];
+	}
+	F32 u = (time - mKeyTimes[left]) / (mKeyTimes[right] - mKeyTimes[left]);
+	return lerp(mKeyScales[left], mKeyScales[right], u);
+}
+
 //-----------------------------------------------------------------------------
 // RotationCurve::RotationCurve()
 //-----------------------------------------------------------------------------
@@ -294,6 +502,62 @@ LLQuaternion LLKeyframeMotion::RotationCurve::interp(F32 u, RotationKey& before,
 }
 
 
+//-----------------------------------------------------------------------------
+// RotationCurve::compile()
+//-----------------------------------------------------------------------------
+void LLKeyframeMotion::RotationCurve::compile()
+{
+	mKeyTimes.clear();
+	mKeyRotations.clear();
+	mKeyTimes.reserve(mKeys.size());
+	mKeyRotations.reserve(mKeys.size());
+	for (key_map_t::const_iterator iter = mKeys.begin(), end = mKeys.end();
+		 iter != end; ++iter)
+	{
+		mKeyTimes.push_back(iter->first);
+		mKeyRotations.push_back(iter->second.mRotation);
+	}
+}
+
+//-----------------------------------------------------------------------------
+// RotationCurve::getValueAt() (flat arrays version of getValue())
+//-----------------------------------------------------------------------------
+bool LLKeyframeMotion::RotationCurve::getValueAt(F32 time, S32& cursor,
+												 LLQuaternion& value,
+												 S32& left, F32& u) const
+{
+	S32 count = mKeyTimes.size();
+	if (!count)
+	{
+		value = LLQuaternion::DEFAULT;
+		return true;
+	}
+
+	S32 right = find_key(&mKeyTimes[0], count, time, cursor);
+	if (right == count)
+	{
+		// Past last key
+		value = mKeyRotations[count - 1];
+		return true;
+	}
+	if (right == 0 || mKeyTimes[right] == time)
+	{
+		// Before first key or exactly on a key
+		value = mKeyRotations[right];
+		return true;
+	}
+
+	// Between two keys
+	left = right - 1;
+	if (mInterpolationType == IT_STEP)
+	{
+		value = mKeyRotations[left];
+		return true;
+	}
+	u = (time - mKeyTimes[left]) / (mKeyTimes[right] - mKeyTimes[left]);
+	return false;
+}
+
 //-----------------------------------------------------------------------------
 // PositionCurve::PositionCurve()
 //-----------------------------------------------------------------------------
@@ -377,6 +641,67 @@ LLVector3 LLKeyframeMotion::PositionCurve::interp(F32 u, PositionKey& before, Po
 }
 
 
+//-----------------------------------------------------------------------------
+// PositionCurve::compile()
+//-----------------------------------------------------------------------------
+void LLKeyframeMotion::PositionCurve::compile()
+{
+	mKeyTimes.clear();
+	mKeyPositions.clear();
+	mKeyTimes.reserve(mKeys.size());
+	mKeyPositions.reserve(mKeys.size());
+	for (key_map_t::const_iterator iter = mKeys.begin(), end = mKeys.end();
+		 iter != end; ++iter)
+	{
+		mKeyTimes.push_back(iter->first);
+		mKeyPositions.push_back(iter->second.mPosition);
+	}
+}
+
+//-----------------------------------------------------------------------------
+// PositionCurve::getValueAt() (flat arrays version of getValue())
+//-----------------------------------------------------------------------------
+LLVector3 LLKeyframeMotion::PositionCurve::getValueAt(F32 time, S32& cursor) const
+{
+	S32 count = mKeyTimes.size();
+	if (!count)
+	{
+		return LLVector3::zero;
+	}
+
+	LLVector3 value;
+	S32 right = find_key(&mKeyTimes[0], count, time, cursor);
+	if (right == count)
+	{
+		// Past last key
+		value = mKeyPositions[count - 1];
+	}
+	else if (right == 0 || mKeyTimes[right] == time)
+	{
+		// Before first key or exactly on a key
+		value = mKeyPositions[right];
+	}
+	else
+	{
+		// Between two keys
+		S32 left = right - 1;
+		if (mInterpolationType == IT_STEP)
+		{
+			value = mKeyPositions[left];
+		}
+		else
+		{
+			F32 u = (time - mKeyTimes[left]) /
+					(mKeyTimes[right] - mKeyTimes[left]);
+			value = lerp(mKeyPositions[left], mKeyPositions[right], u);
+		}
+	}
+
+	llassert(value.isFinite());
+
+	return value;
+}
+
 //-----------------------------------------------------------------------------
 //-----------------------------------------------------------------------------
 // JointMotion class
@@ -386,7 +711,9 @@ LLVector3 LLKeyframeMotion::PositionCurve::interp(F32 u, PositionKey& before, Po
 //-----------------------------------------------------------------------------
 // JointMotion::update()
 //-----------------------------------------------------------------------------
-void LLKeyframeMotion::JointMotion::update(LLJointState* joint_state, F32 time, F32 duration)
+void LLKeyframeMotion::JointMotion::update(LLJointState* joint_state,
+											F32 time, S32* cursors,
+											LLQuaternionLerpBatch& batch)
 {
 	// this value being 0 is the cause of https://jira.lindenlab.com/browse/SL-22678 but I haven't 
 	// managed to get a stack to see how it got here. Testing for 0 here will stop the crash.
@@ -402,7 +729,14 @@ void LLKeyframeMotion::JointMotion::update(LLJointState* joint_state, F32 time,
 	//-------------------------------------------------------------------------
 	if ((usage & LLJointState::SCALE) && mScaleCurve.mNumKeys)
 	{
-		joint_state->setScale( mScaleCurve.getValue( time, duration ) );
+		LLVector3 scale = mScaleCurve.getValueAt(time, cursors[0]);
+#if LL_KEYFRAME_CURVE_CHECK
+		if (scale != mScaleCurve.getValue(time, 0.f))
+		{
+			llwarns << "Flat scale curve mismatch for " << mJointName << llendl;
+		}
+#endif
+		joint_state->setScale(scale);
 	}
 
 	//-------------------------------------------------------------------------
@@ -410,7 +744,25 @@ void LLKeyframeMotion::JointMotion::update(LLJointState* joint_state, F32 time,
 	//-------------------------------------------------------------------------
 	if ((usage & LLJointState::ROT) && mRotationCurve.mNumKeys)
 	{
-		joint_state->setRotation( mRotationCurve.getValue( time, duration ) );
+		LLQuaternion rot;
+		S32 left;
+		F32 u;
+		if (mRotationCurve.getValueAt(time, cursors[1], rot, left, u))
+		{
+#if LL_KEYFRAME_CURVE_CHECK
+			if (rot != mRotationCurve.getValue(time, 0.f))
+			{
+				llwarns << "Flat rotation curve mismatch for " << mJointName
+						<< llendl;
+			}
+#endif
+			joint_state->setRotation(rot);
+		}
+		else
+		{
+			batch.add(joint_state, u, mRotationCurve.mKeyRotations[left],
+					  mRotationCurve.mKeyRotations[left + 1]);
+		}
 	}
 
 	//-------------------------------------------------------------------------
@@ -418,7 +770,15 @@ void LLKeyframeMotion::JointMotion::update(LLJointState* joint_state, F32 time,
 	//-------------------------------------------------------------------------
 	if ((usage & LLJointState::POS) && mPositionCurve.mNumKeys)
 	{
-		joint_state->setPosition( mPositionCurve.getValue( time, duration ) );
+		LLVector3 pos = mPositionCurve.getValueAt(time, cursors[2]);
+#if LL_KEYFRAME_CURVE_CHECK
+		if (pos != mPositionCurve.getValue(time, 0.f))
+		{
+			llwarns << "Flat position curve mismatch for " << mJointName
+					<< llendl;
+		}
+#endif
+		joint_state->setPosition(pos);
 	}
 }
 
@@ -717,7 +1077,12 @@ BOOL LLKeyframeMotion::onUpdate(F32 time, U8* joint_mask)
 
 	applyKeyframes(mLastLoopedTime);
 
-	applyConstraints(mLastLoopedTime, joint_mask);
+	// Constraints are not worth solving for characters at low animation LOD
+	if (mCharacter->getMotionController().getAnimationLOD() <
+			LLMotionController::ANIM_LOD_LOW)
+	{
+		applyConstraints(mLastLoopedTime, joint_mask);
+	}
 
 	mLastUpdateTime = time;
 
@@ -729,13 +1094,23 @@ BOOL LLKeyframeMotion::onUpdate(F32 time, U8* joint_mask)
 //-----------------------------------------------------------------------------
 void LLKeyframeMotion::applyKeyframes(F32 time)
 {
-	llassert_always (mJointMotionList->getNumJointMotions() <= mJointStates.size());
-	for (U32 i=0; i<mJointMotionList->getNumJointMotions(); i++)
+	U32 count = mJointMotionList->getNumJointMotions();
+	llassert_always(count <= mJointStates.size());
+
+	const U32 cursors = JointMotion::CURSORS_PER_JOINT;
+	if (mKeyCursors.size() != count * cursors)
+	{
+		mKeyCursors.assign(count * cursors, 0);
+	}
+
+	LLQuaternionLerpBatch batch;
+	for (U32 i = 0; i < count; ++i)
 	{
-		mJointMotionList->getJointMotion(i)->update(mJointStates[i],
-													  time, 
-													  mJointMotionList->mDuration );
+		mJointMotionList->getJointMotion(i)->update(mJointStates[i], time,
+													&mKeyCursors[i * cursors],
+													batch);
 	}
+	batch.flush();
 
 	LLJoint::JointPriority* pose_priority = (LLJoint::JointPriority* )mCharacter->getAnimationData("Hand Pose Priority");
 	if (pose_priority)
@@ -1550,6 +1925,7 @@ BOOL LLKeyframeMotion::deserialize(LLDataPacker& dp)
 
 			rCurve->mKeys[time] = rot_key;
 		}
+		rCurve->compile();
 
 		//---------------------------------------------------------------------
 		// scan position curve header
@@ -1634,6 +2010,7 @@ BOOL LLKeyframeMotion::deserialize(LLDataPacker& dp)
 				mJointMotionList->mPelvisBBox.addPoint(pos_key.mPosition);
 			}
 		}
+		pCurve->compile();
 
 		joint_motion->mUsage = joint_state->getUsage();
 	}
@@ -1924,6 +2301,8 @@ BOOL LLKeyframeMotion::serialize(LLDataPacker& dp) const
 			success &= dp.packU16(y, "pos_y");
 			success &= dp.packU16(z, "pos_z");
 		}
+		// The key positions got quantized above
+		joint_motionp->mPositionCurve.compile();
 	}	
 
 	success &= dp.packS32(mJointMotionList->mConstraints.size(), "num_constraints");
@@ -53,6 +53,7 @@
 class LLKeyframeDataCache;
 class LLVFS;
 class LLDataPacker;
+class LLQuaternionLerpBatch;
 
 #define MIN_REQUIRED_PIXEL_AREA_KEYFRAME (40.f)
 #define MAX_CHAIN_LENGTH (4)
@@ -329,12 +330,19 @@ public:
 		LLVector3 getValue(F32 time, F32 duration);
 		LLVector3 interp(F32 u, ScaleKey& before, ScaleKey& after);
 
+		// Builds the flat key arrays from mKeys
+		void compile();
+		// Same result as getValue(), using the flat arrays
+		LLVector3 getValueAt(F32 time, S32& cursor) const;
+
 		InterpolationType	mInterpolationType;
 		S32					mNumKeys;
 		typedef std::map<F32, ScaleKey> key_map_t;
 		key_map_t 			mKeys;
 		ScaleKey			mLoopInKey;
 		ScaleKey			mLoopOutKey;
+		std::vector<F32>		mKeyTimes;
+		std::vector<LLVector3>	mKeyScales;
 	};
 
 	//-------------------------------------------------------------------------
@@ -348,12 +356,22 @@ public:
 		LLQuaternion getValue(F32 time, F32 duration);
 		LLQuaternion interp(F32 u, RotationKey& before, RotationKey& after);
 
+		// Builds the flat key arrays from mKeys
+		void compile();
+		// Same result as getValue(), using the flat arrays. Returns false
+		// when the value is a linear interpolation between mKeyRotations
+		// [left] and [left + 1] at 'u', which is then left to the caller.
+		bool getValueAt(F32 time, S32& cursor, LLQuaternion& value,
+						S32& left, F32& u) const;
+
 		InterpolationType	mInterpolationType;
 		S32					mNumKeys;
 		typedef std::map<F32, RotationKey> key_map_t;
 		key_map_t		mKeys;
 		RotationKey		mLoopInKey;
 		RotationKey		mLoopOutKey;
+		std::vector<F32>			mKeyTimes;
+		std::vector<LLQuaternion>	mKeyRotations;
 	};
 
 	//-------------------------------------------------------------------------
@@ -367,12 +385,19 @@ public:
 		LLVector3 getValue(F32 time, F32 duration);
 		LLVector3 interp(F32 u, PositionKey& before, PositionKey& after);
 
+		// Builds the flat key arrays from mKeys
+		void compile();
+		// Same result as getValue(), using the flat arrays
+		LLVector3 getValueAt(F32 time, S32& cursor) const;
+
 		InterpolationType	mInterpolationType;
 		S32					mNumKeys;
 		typedef std::map<F32, PositionKey> key_map_t;
 		key_map_t		mKeys;
 		PositionKey		mLoopInKey;
 		PositionKey		mLoopOutKey;
+		std::vector<F32>		mKeyTimes;
+		std::vector<LLVector3>	mKeyPositions;
 	};
 
 	//-------------------------------------------------------------------------
@@ -388,7 +413,12 @@ public:
 		U32				mUsage;
 		LLJoint::JointPriority	mPriority;
 
-		void update(LLJointState* joint_state, F32 time, F32 duration);
+		// 'cursors' points to the CURSORS_PER_JOINT last key indices used
+		// by the calling motion instance for this joint.
+		void update(LLJointState* joint_state, F32 time, S32* cursors,
+					LLQuaternionLerpBatch& batch);
+
+		enum { CURSORS_PER_JOINT = 3 };
 	};
 	
 	//-------------------------------------------------------------------------
@@ -435,6 +465,8 @@ protected:
 	LLCharacter*					mCharacter;
 	typedef std::list<JointConstraint*>	constraint_list_t;
 	constraint_list_t				mConstraints;
+	// Per-instance key lookup cursors (the keyframe data is shared)
+	std::vector<S32>				mKeyCursors;
 	U32								mLastSkeletonSerialNum;
 	F32								mLastUpdateTime;
 	F32								mLastLoopedTime;
@@ -141,7 +141,11 @@ LLMotionController::LLMotionController()
 	mPauseTime(0.f),
 	mTimeStep(0.f),
 	mTimeStepCount(0),
-	mLastInterp(0.f)
+	mLastInterp(0.f),
+	mDeferBlend(false),
+	mPendingBlend(false),
+	mLastUpdateInterpolated(false),
+	mAnimationLOD(ANIM_LOD_FULL)
 {
 }
 
@@ -544,6 +548,26 @@ void LLMotionController::updateIdleActiveMotions()
 	}
 }
 
+//-----------------------------------------------------------------------------
+// updateIdleMotionsByType()
+// Minimal updates (stop events, ease out and deactivation) for the active
+// motions of a given blend type which are not evaluated this frame
+//-----------------------------------------------------------------------------
+void LLMotionController::updateIdleMotionsByType(LLMotion::LLMotionBlendType anim_type)
+{
+	for (motion_list_t::iterator iter = mActiveMotions.begin(),
+								 end = mActiveMotions.end();
+		 iter != end; )
+	{
+		motion_list_t::iterator curiter = iter++;
+		LLMotion* motionp = *curiter;
+		if (motionp->getBlendType() == anim_type)
+		{
+			updateIdleMotion(motionp);
+		}
+	}
+}
+
 //-----------------------------------------------------------------------------
 // updateMotionsByType()
 //-----------------------------------------------------------------------------
@@ -814,6 +838,11 @@ void LLMotionController::updateMotions(bool force_update)
 	F32 delta_time = cur_time - mPrevTimerElapsed;
 	mPrevTimerElapsed = cur_time;
 	mLastTime = mAnimTime;
+	mLastUpdateInterpolated = false;
+
+	// A deferred blend that was never flushed must land before the joint
+	// states get overwritten by this update.
+	applyPendingBlend();
 
 	// Always cap the number of loaded motions
 	purgeExcessMotions();
@@ -839,6 +868,7 @@ void LLMotionController::updateMotions(bool force_update)
 				}
 
 				updateLoadingMotions();
+				mLastUpdateInterpolated = true;
 				return;
 			}
 			
@@ -866,9 +896,18 @@ void LLMotionController::updateMotions(bool force_update)
 	}
 	else
 	{
-		// update additive motions
-		updateAdditiveMotions();
-		resetJointSignatures();
+		// update additive motions, unless the character is too small on
+		// screen for them to be noticed, in which case they still need to
+		// get stopped and deactivated when their time is up
+		if (mAnimationLOD < ANIM_LOD_LOW)
+		{
+			updateAdditiveMotions();
+			resetJointSignatures();
+		}
+		else
+		{
+			updateIdleMotionsByType(LLMotion::ADDITIVE_BLEND);
+		}
 
 		// update all regular motions
 		updateRegularMotions();
@@ -877,6 +916,10 @@ void LLMotionController::updateMotions(bool force_update)
 		{
 			mPoseBlender.blendAndCache(TRUE);
 		}
+		else if (mDeferBlend)
+		{
+			mPendingBlend = true;
+		}
 		else
 		{
 			mPoseBlender.blendAndApply();
@@ -887,6 +930,20 @@ void LLMotionController::updateMotions(bool force_update)
 //	llinfos << "Motion controller time " << motionTimer.getElapsedTimeF32() << llendl;
 }
 
+//-----------------------------------------------------------------------------
+// applyPendingBlend()
+// May be called from a worker thread, provided no other thread touches this
+// controller or its character's joints meanwhile.
+//-----------------------------------------------------------------------------
+void LLMotionController::applyPendingBlend()
+{
+	if (mPendingBlend)
+	{
+		mPendingBlend = false;
+		mPoseBlender.blendAndApply();
+	}
+}
+
 //-----------------------------------------------------------------------------
 // updateMotionsMinimal()
 // minimal update (e.g. while hidden)
@@ -1039,6 +1096,7 @@ LLMotion* LLMotionController::findMotion(const LLUUID& id) const
 //-----------------------------------------------------------------------------
 void LLMotionController::deactivateAllMotions()
 {
+	applyPendingBlend();
 	for (motion_map_t::iterator iter = mAllMotions.begin(),
 								end = mAllMotions.end();
 		 iter != end; ++iter)
@@ -1053,6 +1111,7 @@ void LLMotionController::deactivateAllMotions()
 //-----------------------------------------------------------------------------
 void LLMotionController::flushAllMotions()
 {
+	applyPendingBlend();
 	std::vector<std::pair<LLUUID, F32> > active_motions;
 	active_motions.reserve(mActiveMotions.size());
 	for (motion_list_t::iterator iter = mActiveMotions.begin(),
@@ -142,6 +142,29 @@ public:
 
 	void clearBlenders()				{ mPoseBlender.clearBlenders(); }
 
+	// Animation level of detail, set by the character each frame. At
+	// ANIM_LOD_LOW, additive motions are not updated and keyframe motions
+	// skip their constraints.
+	enum EAnimationLOD
+	{
+		ANIM_LOD_FULL = 0,
+		ANIM_LOD_REDUCED,
+		ANIM_LOD_LOW,
+		ANIM_LOD_COUNT
+	};
+	void setAnimationLOD(U32 lod)		{ mAnimationLOD = lod; }
+	U32 getAnimationLOD() const			{ return mAnimationLOD; }
+	// True when the last updateMotions() call only interpolated the pose
+	// cached for the current time step.
+	bool lastUpdateInterpolated() const	{ return mLastUpdateInterpolated; }
+
+	// When deferred, updateMotions() leaves the final pose blending to a
+	// later applyPendingBlend() call, which only touches this character's
+	// joints and may therefore run on a worker thread.
+	void setDeferredBlend(bool deferred)	{ mDeferBlend = deferred; }
+	bool hasPendingBlend() const		{ return mPendingBlend; }
+	void applyPendingBlend();
+
 	// flush motions
 	// releases all motion instances
 	void flushAllMotions();
@@ -185,6 +208,7 @@ protected:
 	void updateMotionsByType(LLMotion::LLMotionBlendType motion_type);
 	void updateIdleMotion(LLMotion* motionp);
 	void updateIdleActiveMotions();
+	void updateIdleMotionsByType(LLMotion::LLMotionBlendType motion_type);
 	void purgeExcessMotions();
 	void deactivateStoppedMotions();
 
@@ -221,6 +245,10 @@ protected:
 	F32					mTimeStep;
 	S32					mTimeStepCount;
 	F32					mLastInterp;
+	bool				mDeferBlend;
+	bool				mPendingBlend;
+	bool				mLastUpdateInterpolated;
+	U32					mAnimationLOD;
 
 	U8					mJointSignature[2][LL_CHARACTER_MAX_JOINTS];
 };
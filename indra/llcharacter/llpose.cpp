@@ -40,11 +40,22 @@
 #include "llmotion.h"
 #include "llmath.h"
 #include "llstl.h"
+#if LL_POSE_BLEND_STATS
+# include "llfasttimer.h"
+#endif
 
 //-----------------------------------------------------------------------------
 // Static
 //-----------------------------------------------------------------------------
 
+// Returns the joint number of jointp when it may be used as an index in the
+// per joint number arrays, or -1.
+static S32 get_joint_index(const LLJoint* jointp)
+{
+	S32 joint_num = jointp ? jointp->getJointNum() : -1;
+	return joint_num < LL_CHARACTER_MAX_SKELETON_JOINTS ? joint_num : -1;
+}
+
 //-----------------------------------------------------------------------------
 // LLPose
 //-----------------------------------------------------------------------------
@@ -57,14 +68,14 @@ LLPose::~LLPose()
 //-----------------------------------------------------------------------------
 LLJointState* LLPose::getFirstJointState()
 {
-	mListIter = mJointMap.begin();
-	if (mListIter == mJointMap.end())
+	mListIndex = 0;
+	if (mJointStates.empty())
 	{
 		return NULL;
 	}
 	else
 	{
-		return mListIter->second;
+		return mJointStates[0];
 	}
 }
 
@@ -73,14 +84,13 @@ LLJointState* LLPose::getFirstJointState()
 //-----------------------------------------------------------------------------
 LLJointState *LLPose::getNextJointState()
 {
-	mListIter++;
-	if (mListIter == mJointMap.end())
+	if (++mListIndex >= (S32)mJointStates.size())
 	{
 		return NULL;
 	}
 	else
 	{
-		return mListIter->second;
+		return mJointStates[mListIndex];
 	}
 }
 
@@ -89,10 +99,30 @@ LLJointState *LLPose::getNextJointState()
 //-----------------------------------------------------------------------------
 BOOL LLPose::addJointState(const LLPointer<LLJointState>& jointState)
 {
-	if (mJointMap.find(jointState->getJoint()->getName()) == mJointMap.end())
+	LLJointState* jsp = jointState.get();
+	const LLJoint* joint = jsp->getJoint();
+	if (findJointState(joint))
 	{
-		mJointMap[jointState->getJoint()->getName()] = jointState;
+		return TRUE;
+	}
+
+	mJointStates.push_back(jointState);
+
+	S32 joint_num = get_joint_index(joint);
+	if (joint_num >= 0)
+	{
+		if (joint_num >= (S32)mJointStatesByNum.size())
+		{
+			mJointStatesByNum.resize(joint_num + 1, NULL);
+		}
+		if (!mJointStatesByNum[joint_num])
+		{
+			mJointStatesByNum[joint_num] = jsp;
+			return TRUE;
+		}
 	}
+	// No number, or another joint sharing this number got the slot
+	++mNumUnindexed;
 	return TRUE;
 }
 
@@ -101,7 +131,33 @@ BOOL LLPose::addJointState(const LLPointer<LLJointState>& jointState)
 //-----------------------------------------------------------------------------
 BOOL LLPose::removeJointState(const LLPointer<LLJointState>& jointState)
 {
-	mJointMap.erase(jointState->getJoint()->getName());
+	LLJointState* jsp = findJointState(jointState.get()->getJoint());
+	if (!jsp)
+	{
+		return TRUE;
+	}
+
+	S32 joint_num = get_joint_index(jsp->getJoint());
+	if (joint_num >= 0 && joint_num < (S32)mJointStatesByNum.size() &&
+		mJointStatesByNum[joint_num] == jsp)
+	{
+		mJointStatesByNum[joint_num] = NULL;
+	}
+	else
+	{
+		--mNumUnindexed;
+	}
+
+	for (joint_state_list_t::iterator iter = mJointStates.begin(),
+									  end = mJointStates.end();
+		 iter != end; ++iter)
+	{
+		if (iter->get() == jsp)
+		{
+			mJointStates.erase(iter);
+			break;
+		}
+	}
 	return TRUE;
 }
 
@@ -110,25 +166,42 @@ BOOL LLPose::removeJointState(const LLPointer<LLJointState>& jointState)
 //-----------------------------------------------------------------------------
 BOOL LLPose::removeAllJointStates()
 {
-	mJointMap.clear();
+	mJointStates.clear();
+	mJointStatesByNum.clear();
+	mNumUnindexed = 0;
 	return TRUE;
 }
 
 //-----------------------------------------------------------------------------
 // findJointState()
 //-----------------------------------------------------------------------------
-LLJointState* LLPose::findJointState(LLJoint *joint)
+LLJointState* LLPose::findJointState(const LLJoint* joint)
 {
-	joint_map_iterator iter = mJointMap.find(joint->getName());
-
-	if (iter == mJointMap.end())
+	S32 joint_num = get_joint_index(joint);
+	if (joint_num >= 0 && joint_num < (S32)mJointStatesByNum.size())
 	{
-		return NULL;
+		LLJointState* jsp = mJointStatesByNum[joint_num];
+		if (jsp && jsp->getJoint() == joint)
+		{
+			return jsp;
+		}
 	}
-	else
+
+	if (mNumUnindexed)
 	{
-		return iter->second;
+		// Joints not owning their number slot are seldom seen: a linear
+		// scan is good enough for them.
+		for (S32 i = 0, count = mJointStates.size(); i < count; ++i)
+		{
+			LLJointState* jsp = mJointStates[i];
+			if (jsp->getJoint() == joint)
+			{
+				return jsp;
+			}
+		}
 	}
+
+	return NULL;
 }
 
 //-----------------------------------------------------------------------------
@@ -136,16 +209,15 @@ LLJointState* LLPose::findJointState(LLJoint *joint)
 //-----------------------------------------------------------------------------
 LLJointState* LLPose::findJointState(const std::string &name)
 {
-	joint_map_iterator iter = mJointMap.find(name);
-
-	if (iter == mJointMap.end())
+	for (S32 i = 0, count = mJointStates.size(); i < count; ++i)
 	{
-		return NULL;
-	}
-	else
-	{
-		return iter->second;
+		LLJointState* jsp = mJointStates[i];
+		if (jsp->getJoint()->getName() == name)
+		{
+			return jsp;
+		}
 	}
+	return NULL;
 }
 
 //-----------------------------------------------------------------------------
@@ -153,12 +225,9 @@ LLJointState* LLPose::findJointState(const std::string &name)
 //-----------------------------------------------------------------------------
 void LLPose::setWeight(F32 weight)
 {
-	joint_map_iterator iter;
-	for(iter = mJointMap.begin(); 
-		iter != mJointMap.end();
-		++iter)
+	for (S32 i = 0, count = mJointStates.size(); i < count; ++i)
 	{
-		iter->second->setWeight(weight);
+		mJointStates[i]->setWeight(weight);
 	}
 	mWeight = weight;
 }
@@ -176,7 +245,7 @@ F32 LLPose::getWeight() const
 //-----------------------------------------------------------------------------
 S32 LLPose::getNumJointStates() const
 {
-	return (S32)mJointMap.size();
+	return (S32)mJointStates.size();
 }
 
 //-----------------------------------------------------------------------------
@@ -184,6 +253,8 @@ S32 LLPose::getNumJointStates() const
 //-----------------------------------------------------------------------------
 
 LLJointStateBlender::LLJointStateBlender()
+:	mJoint(NULL),
+	mActive(false)
 {
 	for(S32 i = 0; i < JSB_NUM_JOINT_STATES; i++)
 	{
@@ -461,50 +532,95 @@ void LLJointStateBlender::resetCachedJoint()
 
 LLPoseBlender::LLPoseBlender()
 	: mNextPoseSlot(0)
+#if LL_POSE_BLEND_STATS
+	, mStatsStartClocks(0)
+	, mStatsClocks(0)
+	, mStatsBlends(0)
+#endif
 {
 }
 
 LLPoseBlender::~LLPoseBlender()
 {
+	for_each(mJointStateBlenders.begin(), mJointStateBlenders.end(), DeletePointer());
 	for_each(mJointStateBlenderPool.begin(), mJointStateBlenderPool.end(), DeletePairedPointer());
 }
 
 //-----------------------------------------------------------------------------
-// addMotion()
+// getJointStateBlender()
 //-----------------------------------------------------------------------------
-BOOL LLPoseBlender::addMotion(LLMotion* motion)
+LLJointStateBlender* LLPoseBlender::getJointStateBlender(LLJoint* jointp)
 {
-	LLPose* pose = motion->getPose();
-
-	for(LLJointState* jsp = pose->getFirstJointState(); jsp; jsp = pose->getNextJointState())
+	// Skeleton joints are numbered densely, so their blenders are simply
+	// indexed by joint number. Joints sharing a number with a joint that
+	// already got its slot (e.g. unnumbered ones) use the map instead.
+	S32 joint_num = get_joint_index(jointp);
+	if (joint_num >= 0)
 	{
-		LLJoint *jointp = jsp->getJoint();
-		LLJointStateBlender* joint_blender;
-		if (mJointStateBlenderPool.find(jointp) == mJointStateBlenderPool.end())
+		if (joint_num >= (S32)mJointStateBlenders.size())
+		{
+			mJointStateBlenders.resize(joint_num + 1, NULL);
+		}
+		LLJointStateBlender*& joint_blender = mJointStateBlenders[joint_num];
+		if (!joint_blender)
 		{
-			// this is the first time we are animating this joint
-			// so create new jointblender and add it to our pool
 			joint_blender = new LLJointStateBlender();
-			mJointStateBlenderPool[jointp] = joint_blender;
+			joint_blender->mJoint = jointp;
+			return joint_blender;
 		}
-		else
+		if (joint_blender->mJoint == jointp)
 		{
-			joint_blender = mJointStateBlenderPool[jointp];
+			return joint_blender;
 		}
+	}
+
+	blender_map_t::iterator iter = mJointStateBlenderPool.find(jointp);
+	if (iter != mJointStateBlenderPool.end())
+	{
+		return iter->second;
+	}
+	LLJointStateBlender* joint_blender = new LLJointStateBlender();
+	joint_blender->mJoint = jointp;
+	mJointStateBlenderPool[jointp] = joint_blender;
+	return joint_blender;
+}
+
+//-----------------------------------------------------------------------------
+// addMotion()
+//-----------------------------------------------------------------------------
+BOOL LLPoseBlender::addMotion(LLMotion* motion)
+{
+	LLPose* pose = motion->getPose();
+	S32 motion_priority = motion->getPriority();
+	BOOL additive = motion->getBlendType() == LLMotion::ADDITIVE_BLEND;
+#if LL_POSE_BLEND_STATS
+	if (mActiveBlenders.empty())
+	{
+		mStatsStartClocks = get_cpu_clock_count();
+	}
+#endif
+
+	for (S32 i = 0, count = pose->getNumJointStates(); i < count; ++i)
+	{
+		const LLPointer<LLJointState>& jsp = pose->getJointState(i);
+		// Note: get() since the const LLPointer only gives a const joint
+		LLJointStateBlender* joint_blender =
+			getJointStateBlender(jsp.get()->getJoint());
 
 		if (jsp->getPriority() == LLJoint::USE_MOTION_PRIORITY)
 		{
-			joint_blender->addJointState(jsp, motion->getPriority(), motion->getBlendType() == LLMotion::ADDITIVE_BLEND);
+			joint_blender->addJointState(jsp, motion_priority, additive);
 		}
 		else
 		{
-			joint_blender->addJointState(jsp, jsp->getPriority(), motion->getBlendType() == LLMotion::ADDITIVE_BLEND);
+			joint_blender->addJointState(jsp, jsp->getPriority(), additive);
 		}
 
 		// add it to our list of active blenders
-		if (std::find(mActiveBlenders.begin(), mActiveBlenders.end(), joint_blender) == mActiveBlenders.end())
+		if (!joint_blender->mActive)
 		{
-			mActiveBlenders.push_front(joint_blender);
+			joint_blender->mActive = true;
+			mActiveBlenders.push_back(joint_blender);
 		}
 	}
 	return TRUE;
@@ -515,15 +631,29 @@ BOOL LLPoseBlender::addMotion(LLMotion* motion)
 //-----------------------------------------------------------------------------
 void LLPoseBlender::blendAndApply()
 {
-	for (blender_list_t::iterator iter = mActiveBlenders.begin();
-		 iter != mActiveBlenders.end(); )
+	for (S32 i = 0, count = mActiveBlenders.size(); i < count; ++i)
 	{
-		LLJointStateBlender* jsbp = *iter++;
+		LLJointStateBlender* jsbp = mActiveBlenders[i];
 		jsbp->blendJointStates();
+		jsbp->mActive = false;
 	}
 
 	// we're done now so there are no more active blenders for this frame
 	mActiveBlenders.clear();
+
+#if LL_POSE_BLEND_STATS
+	mStatsClocks += get_cpu_clock_count() - mStatsStartClocks;
+	if (++mStatsBlends == 1024)
+	{
+		llinfos << "Pose blender " << std::hex << (intptr_t)this << std::dec
+				<< ": " << 1000000.0 * (F64)mStatsClocks /
+						   ((F64)mStatsBlends *
+							(F64)LLFastTimer::countsPerSecond())
+				<< " us per blend" << llendl;
+		mStatsClocks = 0;
+		mStatsBlends = 0;
+	}
+#endif
 }
 
 //-----------------------------------------------------------------------------
@@ -531,10 +661,9 @@ void LLPoseBlender::blendAndApply()
 //-----------------------------------------------------------------------------
 void LLPoseBlender::blendAndCache(BOOL reset_cached_joints)
 {
-	for (blender_list_t::iterator iter = mActiveBlenders.begin();
-		 iter != mActiveBlenders.end(); ++iter)
+	for (S32 i = 0, count = mActiveBlenders.size(); i < count; ++i)
 	{
-		LLJointStateBlender* jsbp = *iter;
+		LLJointStateBlender* jsbp = mActiveBlenders[i];
 		if (reset_cached_joints)
 		{
 			jsbp->resetCachedJoint();
@@ -548,10 +677,9 @@ void LLPoseBlender::blendAndCache(BOOL reset_cached_joints)
 //-----------------------------------------------------------------------------
 void LLPoseBlender::interpolate(F32 u)
 {
-	for (blender_list_t::iterator iter = mActiveBlenders.begin();
-		 iter != mActiveBlenders.end(); ++iter)
+	for (S32 i = 0, count = mActiveBlenders.size(); i < count; ++i)
 	{
-		LLJointStateBlender* jsbp = *iter;
+		LLJointStateBlender* jsbp = mActiveBlenders[i];
 		jsbp->interpolate(u);
 	}
 }
@@ -561,11 +689,11 @@ void LLPoseBlender::interpolate(F32 u)
 //-----------------------------------------------------------------------------
 void LLPoseBlender::clearBlenders()
 {
-	for (blender_list_t::iterator iter = mActiveBlenders.begin();
-		 iter != mActiveBlenders.end(); ++iter)
+	for (S32 i = 0, count = mActiveBlenders.size(); i < count; ++i)
 	{
-		LLJointStateBlender* jsbp = *iter;
+		LLJointStateBlender* jsbp = mActiveBlenders[i];
 		jsbp->clear();
+		jsbp->mActive = false;
 	}
 
 	mActiveBlenders.clear();
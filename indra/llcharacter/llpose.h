@@ -45,6 +45,7 @@
 
 #include <map>
 #include <string>
+#include <vector>
 
 
 //-----------------------------------------------------------------------------
@@ -54,22 +55,32 @@ class LLPose
 {
 	friend class LLPoseBlender;
 protected:
-	typedef std::map<std::string, LLPointer<LLJointState> > joint_map;
-	typedef joint_map::iterator joint_map_iterator;
-	typedef joint_map::value_type joint_map_value_type;
-	
-	joint_map					mJointMap;
+	// Joint states are kept in a flat array, in insertion order; there is at
+	// most one joint state per joint.
+	typedef std::vector<LLPointer<LLJointState> > joint_state_list_t;
+
+	joint_state_list_t			mJointStates;
+	// Joint states indexed by joint number, for the joints owning their
+	// number slot (sized to the highest joint number seen so far).
+	std::vector<LLJointState*>	mJointStatesByNum;
+	// Number of joint states which are not in mJointStatesByNum
+	S32							mNumUnindexed;
 	F32							mWeight;
-	joint_map_iterator			mListIter;
+	S32							mListIndex;
 public:
 	// Iterate through jointStates
 	LLJointState* getFirstJointState();
 	LLJointState* getNextJointState();
-	LLJointState* findJointState(LLJoint *joint);
+	LLJointState* findJointState(const LLJoint* joint);
 	LLJointState* findJointState(const std::string &name);
+	// Direct access, for 0 <= index < getNumJointStates()
+	const LLPointer<LLJointState>& getJointState(S32 index) const
+	{
+		return mJointStates[index];
+	}
 public:
 	// Constructor
-	LLPose() : mWeight(0.f) {}
+	LLPose() : mWeight(0.f), mListIndex(0), mNumUnindexed(0) {}
 	// Destructor
 	~LLPose();
 	// add a joint state in this pose
@@ -105,17 +116,36 @@ public:
 
 public:
 	LLJoint mJointCache;
+	// Joint this blender was created for, and whether it is in the active
+	// blenders list of its LLPoseBlender.
+	LLJoint* mJoint;
+	bool mActive;
 };
 
 class LLMotion;
 
+// Set to 1 to log the average cost of the pose blending (motion joint states
+// gathering plus blending), per pose blender (i.e. per avatar).
+#define LL_POSE_BLEND_STATS 0
+
 class LLPoseBlender
 {
 protected:
-	typedef std::list<LLJointStateBlender*> blender_list_t;
+	LLJointStateBlender* getJointStateBlender(LLJoint* jointp);
+
+protected:
+	typedef std::vector<LLJointStateBlender*> blender_list_t;
+	// Blenders of the skeleton joints, indexed by joint number
+	blender_list_t mJointStateBlenders;
+	// Blenders of any joint that does not own its joint number slot
 	typedef std::map<LLJoint*,LLJointStateBlender*> blender_map_t;
 	blender_map_t mJointStateBlenderPool;
 	blender_list_t mActiveBlenders;
+#if LL_POSE_BLEND_STATS
+	U64 mStatsStartClocks;
+	U64 mStatsClocks;
+	U32 mStatsBlends;
+#endif
 
 	S32			mNextPoseSlot;
 	LLPose		mBlendedPose;
@@ -33,7 +33,11 @@
 
 #include "llfasttimer.h"
 
+#include "llapr.h"
+#include "llfile.h"
+#include "llformat.h"
 #include "llprocessor.h"
+#include "llthread.h"
 
 #if LL_WINDOWS
 #elif LL_LINUX || LL_SOLARIS
@@ -52,12 +56,12 @@
 LLFastTimer::EFastTimerType LLFastTimer::sCurType = LLFastTimer::FTM_OTHER;
 int LLFastTimer::sCurDepth = 0;
 U64 LLFastTimer::sStart[LLFastTimer::FTM_MAX_DEPTH];
-U64 LLFastTimer::sCounter[LLFastTimer::FTM_NUM_TYPES];
-U64 LLFastTimer::sCountHistory[LLFastTimer::FTM_HISTORY_NUM][LLFastTimer::FTM_NUM_TYPES];
-U64 LLFastTimer::sCountAverage[LLFastTimer::FTM_NUM_TYPES];
-U64 LLFastTimer::sCalls[LLFastTimer::FTM_NUM_TYPES];
-U64 LLFastTimer::sCallHistory[LLFastTimer::FTM_HISTORY_NUM][LLFastTimer::FTM_NUM_TYPES];
-U64 LLFastTimer::sCallAverage[LLFastTimer::FTM_NUM_TYPES];
+U64 LLFastTimer::sCounter[LLFastTimer::FTM_MAX_TYPES];
+U64 LLFastTimer::sCountHistory[LLFastTimer::FTM_HISTORY_NUM][LLFastTimer::FTM_MAX_TYPES];
+U64 LLFastTimer::sCountAverage[LLFastTimer::FTM_MAX_TYPES];
+U64 LLFastTimer::sCalls[LLFastTimer::FTM_MAX_TYPES];
+U64 LLFastTimer::sCallHistory[LLFastTimer::FTM_HISTORY_NUM][LLFastTimer::FTM_MAX_TYPES];
+U64 LLFastTimer::sCallAverage[LLFastTimer::FTM_MAX_TYPES];
 S32 LLFastTimer::sCurFrameIndex = -1;
 S32 LLFastTimer::sLastFrameIndex = -1;
 int LLFastTimer::sPauseHistory = 0;
@@ -71,6 +75,393 @@ U64 LLFastTimer::sClockResolution = 1000000000; // 1e9, Nanosecond resolution
 U64 LLFastTimer::sClockResolution = 1000000; // 1e6, Microsecond resolution
 #endif
 
+bool LLFastTimer::sTracing = false;
+
+// Names of the timers, for traces
+static const char* sTimerNames[LLFastTimer::FTM_MAX_TYPES];
+// Number of timers declared with DeclareTimer
+static S32 sDeclaredTimers = 0;
+
+//////////////////////////////////////////////////////////////////////////////
+// Per-thread data
+//
+// Each thread only ever writes to its own ThreadData, so that no lock is
+// needed when timing: the main thread only reads the (monotonic) totals of
+// the other threads to compute their per-frame statistics, and their trace
+// events once published by incrementing mEventCount.
+// The main thread timers keep using the static counters above (for
+// LLFastTimerView), its ThreadData only being used for tracing.
+
+struct LLFastTimerEvent
+{
+	U64	mStart;
+	U64	mEnd;
+	U32	mType;
+};
+
+class LLFastTimer::ThreadData
+{
+public:
+	ThreadData(const std::string& name, U32 id, bool ignore = false)
+	:	mName(name),
+		mID(id),
+		mDepth(0),
+		mBusy(0),
+		mLastBusy(0),
+		mLastCalls(0),
+		mFrameBusy(0),
+		mFrameCalls(0),
+		mEvents(NULL),
+		mTraceGeneration(0),
+		mIgnore(ignore)
+	{
+		memset(mCalls, 0, sizeof(mCalls));
+		mEventCount = 0;
+	}
+
+	std::string		mName;
+	U32				mID;
+
+	// Written by the owning thread only
+	S32				mDepth;
+	U64				mStart[FTM_MAX_DEPTH];
+	U64				mCalls[FTM_MAX_TYPES];
+	U64				mBusy;		// Time spent in top level timers
+
+	// Written by the main thread only, in reset()
+	U64				mLastBusy;
+	U64				mLastCalls;
+	U64				mFrameBusy;
+	U64				mFrameCalls;
+
+	// Trace buffer, allocated by the owning thread on its first event
+	LLFastTimerEvent* mEvents;
+	LLAtomicU32		mEventCount;
+	S32				mTraceGeneration;
+
+	// true for the threads which timers cannot be accounted for
+	bool			mIgnore;
+};
+
+static LLFastTimer::ThreadData sMainThreadDataInstance("Main thread", 0);
+LLFastTimer::ThreadData* LLFastTimer::sMainThreadData = &sMainThreadDataInstance;
+
+// Registered threads, other than the main one. The slots are reserved with an
+// atomic increment and filled afterwards, so the readers must skip NULL ones.
+static LLFastTimer::ThreadData* sThreads[LLFastTimer::FTM_MAX_THREADS];
+static LLAtomicS32 sThreadsCount;
+static LLFastTimer::ThreadData sIgnoredThreadData("Ignored", 0, true);
+
+// Captured during static initialization, which happens in the main thread.
+static U32 sMainThreadID = LLThread::currentID();
+
+// Tracing
+static S32 sTraceGeneration = 0;
+static S32 sTraceFrames = 0;
+static U64 sTraceStart = 0;
+static std::string sTraceFilename;
+
+#if !LL_DARWIN
+static ll_thread_local LLFastTimer::ThreadData* sThreadData = NULL;
+#endif
+
+static LLFastTimer::ThreadData* create_thread_data(const std::string& name)
+{
+	S32 slot = sThreadsCount++;
+	if (slot >= LLFastTimer::FTM_MAX_THREADS)
+	{
+		// Too many threads: do not account for this one.
+		return &sIgnoredThreadData;
+	}
+	LLFastTimer::ThreadData* data =
+		new LLFastTimer::ThreadData(name.empty() ? llformat("Thread %d", slot + 1)
+												 : name,
+									slot + 1);
+	sThreads[slot] = data;
+	return data;
+}
+
+//static
+LLFastTimer::ThreadData* LLFastTimer::getThreadData()
+{
+#if LL_DARWIN
+	// No thread local storage: only the main thread timers are accounted for.
+	return LLThread::currentID() == sMainThreadID ? sMainThreadData
+												  : &sIgnoredThreadData;
+#else
+	ThreadData* data = sThreadData;
+	if (!data)
+	{
+		if (LLThread::currentID() == sMainThreadID)
+		{
+			data = sMainThreadData;
+		}
+		else
+		{
+			data = create_thread_data(std::string());
+		}
+		sThreadData = data;
+	}
+	return data;
+#endif
+}
+
+//static
+void LLFastTimer::setThreadName(const std::string& name)
+{
+#if !LL_DARWIN
+	if (!sThreadData && LLThread::currentID() != sMainThreadID)
+	{
+		sThreadData = create_thread_data(name);
+	}
+#endif
+}
+
+void LLFastTimer::startThreadTimer()
+{
+	ThreadData* data = mThreadData;
+	if (data->mIgnore || data->mDepth >= FTM_MAX_DEPTH)
+	{
+		return;
+	}
+	data->mStart[data->mDepth++] = mStart;
+}
+
+void LLFastTimer::stopThreadTimer(U64 end)
+{
+	ThreadData* data = mThreadData;
+	if (data->mIgnore || data->mDepth <= 0)
+	{
+		return;
+	}
+	--data->mDepth;
+	data->mCalls[mType]++;
+	if (data->mDepth == 0)
+	{
+		data->mBusy += end - mStart;
+	}
+}
+
+void LLFastTimer::recordEvent(U64 end)
+{
+	ThreadData* data = mThreadData;
+	if (data->mIgnore)
+	{
+		return;
+	}
+	S32 generation = sTraceGeneration;
+	if (data->mTraceGeneration != generation)
+	{
+		// First event of this thread for this trace
+		if (!data->mEvents)
+		{
+			data->mEvents = new LLFastTimerEvent[FTM_MAX_TRACE_EVENTS];
+		}
+		data->mEventCount = 0;
+		data->mTraceGeneration = generation;
+	}
+	U32 count = data->mEventCount;
+	if (count < (U32)FTM_MAX_TRACE_EVENTS)
+	{
+		LLFastTimerEvent& event = data->mEvents[count];
+		event.mStart = mStart;
+		event.mEnd = end;
+		event.mType = (U32)mType;
+		// Publish the event
+		data->mEventCount = count + 1;
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Declared timers
+
+LLFastTimer::DeclareTimer::DeclareTimer(const char* name)
+{
+	if (sDeclaredTimers < FTM_MAX_DECLARED)
+	{
+		mType = (EFastTimerType)(FTM_NUM_TYPES + sDeclaredTimers++);
+		sTimerNames[mType] = name;
+	}
+	else
+	{
+		// Too many declared timers: account for this one as "Other" (this
+		// happens during static initialization, so do not attempt to log it).
+		mType = FTM_OTHER;
+	}
+}
+
+//static
+void LLFastTimer::setTimerName(EFastTimerType type, const char* name)
+{
+	if ((S32)type >= 0 && (S32)type < (S32)FTM_MAX_TYPES)
+	{
+		sTimerNames[type] = name;
+	}
+}
+
+//static
+const char* LLFastTimer::getTimerName(EFastTimerType type)
+{
+	if ((S32)type >= 0 && (S32)type < (S32)FTM_MAX_TYPES && sTimerNames[type])
+	{
+		return sTimerNames[type];
+	}
+	return "Unnamed";
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Threads statistics
+
+//static
+S32 LLFastTimer::getThreadCount()
+{
+	return llmin((S32)sThreadsCount, (S32)FTM_MAX_THREADS);
+}
+
+//static
+bool LLFastTimer::getThreadStats(S32 index, std::string& name, F64& busy_ms,
+								 U64& calls)
+{
+	if (index < 0 || index >= getThreadCount() || !sThreads[index])
+	{
+		return false;
+	}
+	ThreadData* data = sThreads[index];
+	name = data->mName;
+	busy_ms = (F64)data->mFrameBusy * 1000.0 / (F64)countsPerSecond();
+	calls = data->mFrameCalls;
+	return true;
+}
+
+static void update_threads_stats()
+{
+	for (S32 i = 0, count = LLFastTimer::getThreadCount(); i < count; ++i)
+	{
+		LLFastTimer::ThreadData* data = sThreads[i];
+		if (!data)
+		{
+			continue;	// Not yet registered
+		}
+		// Note: these are read without lock while the thread may update them;
+		// this is fine for statistics purpose.
+		U64 busy = data->mBusy;
+		U64 calls = 0;
+		for (S32 j = 0; j < LLFastTimer::FTM_MAX_TYPES; ++j)
+		{
+			calls += data->mCalls[j];
+		}
+		data->mFrameBusy = busy - data->mLastBusy;
+		data->mFrameCalls = calls - data->mLastCalls;
+		data->mLastBusy = busy;
+		data->mLastCalls = calls;
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Tracing
+
+//static
+void LLFastTimer::startTrace(const std::string& filename, S32 frames)
+{
+	if (sTracing)
+	{
+		llwarns << "A trace is already in progress, ignoring request." << llendl;
+		return;
+	}
+	sTraceFilename = filename;
+	sTraceFrames = llmax(frames, 1);
+	sTraceStart = get_cpu_clock_count();
+	++sTraceGeneration;
+	sTracing = true;
+	llinfos << "Tracing fast timers for " << sTraceFrames << " frames into: "
+			<< filename << llendl;
+}
+
+//static
+void LLFastTimer::stopTrace()
+{
+	if (sTracing)
+	{
+		sTracing = false;
+		writeTrace();
+	}
+}
+
+static void write_trace_string(LLFILE* fp, const char* str)
+{
+	fputc('"', fp);
+	for ( ; *str; ++str)
+	{
+		if (*str == '"' || *str == '\\')
+		{
+			fputc('\\', fp);
+		}
+		if ((U8)*str >= 0x20)
+		{
+			fputc(*str, fp);
+		}
+	}
+	fputc('"', fp);
+}
+
+static void write_trace_events(LLFILE* fp, LLFastTimer::ThreadData* data,
+							   bool& first)
+{
+	if (data->mTraceGeneration != sTraceGeneration || !data->mEvents)
+	{
+		return;	// No event for this trace
+	}
+
+	fprintf(fp, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":",
+			first ? "" : ",", data->mID);
+	write_trace_string(fp, data->mName.c_str());
+	fputs("}}", fp);
+	first = false;
+
+	F64 us_per_count = 1000000.0 / (F64)LLFastTimer::countsPerSecond();
+	for (U32 i = 0, count = data->mEventCount; i < count; ++i)
+	{
+		const LLFastTimerEvent& event = data->mEvents[i];
+		if (event.mStart < sTraceStart)
+		{
+			continue;	// Timer started before the trace
+		}
+		fputs(",\n{\"name\":", fp);
+		write_trace_string(fp,
+						   LLFastTimer::getTimerName((LLFastTimer::EFastTimerType)event.mType));
+		fprintf(fp, ",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+				data->mID, (F64)(event.mStart - sTraceStart) * us_per_count,
+				(F64)(event.mEnd - event.mStart) * us_per_count);
+	}
+}
+
+//static
+bool LLFastTimer::writeTrace()
+{
+	LLFILE* fp = LLFile::fopen(sTraceFilename, "w");
+	if (!fp)
+	{
+		llwarns << "Could not open trace file: " << sTraceFilename << llendl;
+		return false;
+	}
+
+	fputs("{\"traceEvents\":[", fp);
+	bool first = true;
+	write_trace_events(fp, sMainThreadData, first);
+	for (S32 i = 0, count = getThreadCount(); i < count; ++i)
+	{
+		if (sThreads[i])
+		{
+			write_trace_events(fp, sThreads[i], first);
+		}
+	}
+	fputs("\n],\"displayTimeUnit\":\"ms\"}\n", fp);
+	LLFile::close(fp);
+
+	llinfos << "Fast timers trace written to: " << sTraceFilename << llendl;
+	return true;
+}
+
 //////////////////////////////////////////////////////////////////////////////
 
 //
@@ -167,7 +558,7 @@ void LLFastTimer::reset()
 	else if (sCurFrameIndex >= 0)
 	{
 		S32 hidx = sCurFrameIndex % FTM_HISTORY_NUM;
-		for (S32 i = 0; i < FTM_NUM_TYPES; i++)
+		for (S32 i = 0; i < FTM_MAX_TYPES; i++)
 		{
 			sCountHistory[hidx][i] = sCounter[i];
 			sCountAverage[i] = (sCountAverage[i] * sCurFrameIndex + sCounter[i]) / (sCurFrameIndex + 1);
@@ -178,7 +569,7 @@ void LLFastTimer::reset()
 	}
 	else
 	{
-		for (S32 i = 0; i < FTM_NUM_TYPES; i++)
+		for (S32 i = 0; i < FTM_MAX_TYPES; i++)
 		{
 			sCountAverage[i] = 0;
 			sCallAverage[i] = 0;
@@ -187,12 +578,19 @@ void LLFastTimer::reset()
 	
 	sCurFrameIndex++;
 	
-	for (S32 i = 0; i < FTM_NUM_TYPES; i++)
+	for (S32 i = 0; i < FTM_MAX_TYPES; i++)
 	{
 		sCounter[i] = 0;
 		sCalls[i] = 0;
 	}
 	sCurDepth = 0;
+
+	update_threads_stats();
+
+	if (sTracing && --sTraceFrames <= 0)
+	{
+		stopTrace();
+	}
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -33,6 +33,8 @@
 #ifndef LL_LLFASTTIMER_H
 #define LL_LLFASTTIMER_H
 
+#include <string>
+
 #define FAST_TIMER_ON 1
 
 LL_COMMON_API U64 get_cpu_clock_count();
@@ -170,6 +172,7 @@ public:
 		FTM_OBJECTLIST_UPDATE,
 		FTM_AVATAR_UPDATE,
 		FTM_JOINT_UPDATE,
+		FTM_AVATAR_ANIM_FLUSH,
 		FTM_PHYSICS_UPDATE,
 		FTM_ATTACHMENT_UPDATE,
 		FTM_LOD_UPDATE,
@@ -245,7 +248,38 @@ public:
 	};
 	enum { FTM_HISTORY_NUM = 60 };
 	enum { FTM_MAX_DEPTH = 64 };
-	
+	// Maximum number of timers declared with DeclareTimer, which types are
+	// numbered from FTM_NUM_TYPES upwards.
+	enum { FTM_MAX_DECLARED = 64 };
+	enum { FTM_MAX_TYPES = FTM_NUM_TYPES + FTM_MAX_DECLARED };
+	// Maximum number of threads (other than the main one) using fast timers
+	enum { FTM_MAX_THREADS = 32 };
+	// Maximum number of events recorded per thread while tracing
+	enum { FTM_MAX_TRACE_EVENTS = 65536 };
+
+	// Declares a new timer type at run time (the declaration should happen at
+	// file scope, i.e. during static initialization). Such timers are counted
+	// like the others and appear in the traces, but since they are not known
+	// to LLFastTimerView, their time spent on the main thread is accounted for
+	// in its "Other" bar.
+	// Usage:
+	//	static LLFastTimer::DeclareTimer FTM_MY_TIMER("My timer");
+	//	...
+	//	LLFastTimer t(FTM_MY_TIMER);
+	class LL_COMMON_API DeclareTimer
+	{
+	public:
+		DeclareTimer(const char* name);
+
+		operator EFastTimerType() const			{ return mType; }
+
+	private:
+		EFastTimerType mType;
+	};
+
+	// Per-thread timers data. Opaque outside of llfasttimer.cpp.
+	class ThreadData;
+
 public:
 	static EFastTimerType sCurType;
 
@@ -253,16 +287,22 @@ public:
 	{
 #if FAST_TIMER_ON
 		mType = type;
-		sCurType = type;
 		// These don't get counted, because they use CPU clockticks
 		//gTimerBins[gCurTimerBin]++;
 		//LLTimer::sNumTimerCalls++;
 
-		U64 cpu_clocks = get_cpu_clock_count();
-
-		sStart[sCurDepth] = cpu_clocks;
-		sCurDepth++;
-		assert_main_thread();
+		mThreadData = getThreadData();
+		mStart = get_cpu_clock_count();
+		if (mThreadData == sMainThreadData)
+		{
+			sCurType = type;
+			sStart[sCurDepth] = mStart;
+			sCurDepth++;
+		}
+		else
+		{
+			startThreadTimer();
+		}
 #endif
 	}
 
@@ -277,40 +317,85 @@ public:
 		//LLTimer::sNumTimerCalls++;
 		end = get_cpu_clock_count();
 
-		sCurDepth--;
-		delta = end - sStart[sCurDepth];
-		sCounter[mType] += delta;
-		sCalls[mType]++;
-		// Subtract delta from parents
-		for (i = 0; i < sCurDepth; i++)
+		if (mThreadData == sMainThreadData)
 		{
-			sStart[i] += delta;
+			sCurDepth--;
+			delta = end - sStart[sCurDepth];
+			sCounter[mType] += delta;
+			sCalls[mType]++;
+			// Subtract delta from parents
+			for (i = 0; i < sCurDepth; i++)
+			{
+				sStart[i] += delta;
+			}
+		}
+		else
+		{
+			stopThreadTimer(end);
+		}
+		if (sTracing)
+		{
+			recordEvent(end);
 		}
-		assert_main_thread();
 #endif
 	}
 
 	static void reset();
 	static U64 countsPerSecond();
 
+	// Gives a name to a timer type, used in traces. The names of the
+	// EFastTimerType timers are set by LLFastTimerView.
+	static void setTimerName(EFastTimerType type, const char* name);
+	static const char* getTimerName(EFastTimerType type);
+
+	// Names the calling thread in traces and statistics (called by LLThread
+	// for its threads).
+	static void setThreadName(const std::string& name);
+
+	// Statistics for the threads other than the main one, as of the last
+	// reset() (i.e. for the last frame). Main thread only.
+	static S32 getThreadCount();
+	static bool getThreadStats(S32 index, std::string& name, F64& busy_ms,
+							   U64& calls);
+
+	// Records all timers, for all threads, during the next 'frames' frames
+	// (i.e. calls to reset()), then writes them as a Chrome trace (JSON) file
+	// (to be loaded in chrome://tracing or any compatible viewer). Main thread
+	// only.
+	static void startTrace(const std::string& filename, S32 frames);
+	static void stopTrace();
+	static bool isTracing()							{ return sTracing; }
+
+private:
+	static ThreadData* getThreadData();
+	void startThreadTimer();
+	void stopThreadTimer(U64 end);
+	void recordEvent(U64 end);
+	static bool writeTrace();
+
 public:
 	static int sCurDepth;
 	static U64 sStart[FTM_MAX_DEPTH];
-	static U64 sCounter[FTM_NUM_TYPES];
-	static U64 sCalls[FTM_NUM_TYPES];
-	static U64 sCountAverage[FTM_NUM_TYPES];
-	static U64 sCallAverage[FTM_NUM_TYPES];
-	static U64 sCountHistory[FTM_HISTORY_NUM][FTM_NUM_TYPES];
-	static U64 sCallHistory[FTM_HISTORY_NUM][FTM_NUM_TYPES];
+	static U64 sCounter[FTM_MAX_TYPES];
+	static U64 sCalls[FTM_MAX_TYPES];
+	static U64 sCountAverage[FTM_MAX_TYPES];
+	static U64 sCallAverage[FTM_MAX_TYPES];
+	static U64 sCountHistory[FTM_HISTORY_NUM][FTM_MAX_TYPES];
+	static U64 sCallHistory[FTM_HISTORY_NUM][FTM_MAX_TYPES];
 	static S32 sCurFrameIndex;
 	static S32 sLastFrameIndex;
 	static int sPauseHistory;
 	static int sResetHistory;
 	static F64 sCPUClockFrequency;
     static U64 sClockResolution;
-	
+
 private:
+	static ThreadData* sMainThreadData;
+	static bool sTracing;
+
 	EFastTimerType mType;
+	ThreadData* mThreadData;
+	U64 mStart;
 };
 
 #endif // LL_LLFASTTIMER_H
@@ -32,11 +32,14 @@
 #include "linden_common.h"
 #include "llqueuedthread.h"
 
+#include "llfasttimer.h"
 #include "llstl.h"
 #include "lltimer.h"	// ms_sleep()
 
 //============================================================================
 
+static LLFastTimer::DeclareTimer FTM_PROCESS_REQUEST("Process queued request");
+
 // MAIN THREAD
 LLQueuedThread::LLQueuedThread(const std::string& name,
 							   bool threaded,
@@ -452,7 +455,11 @@ S32 LLQueuedThread::processNextRequest()
 	if (req)
 	{
 		// process request
-		bool complete = req->processRequest();
+		bool complete;
+		{
+			LLFastTimer t(FTM_PROCESS_REQUEST);
+			complete = req->processRequest();
+		}
 
 		if (complete)
 		{
@@ -36,6 +36,7 @@
 
 #include "llthread.h"
 
+#include "llfasttimer.h"
 #include "lltimer.h"
 
 #if LL_LINUX || LL_SOLARIS
@@ -88,6 +89,9 @@ void *APR_THREAD_FUNC LLThread::staticRun(apr_thread_t *apr_threadp, void *datap
 	sThreadID = threadp->mID;
 #endif
 
+	// Name this thread in the fast timers statistics and traces
+	LLFastTimer::setThreadName(threadp->mName);
+
 	// Run the user supplied function
 	threadp->run();
 
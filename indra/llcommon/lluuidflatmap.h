@@ -0,0 +1,254 @@
+/**
+ * @file lluuidflatmap.h
+ * @brief A flat, open addressing UUID keyed map.
+ *
+ * $LicenseInfo:firstyear=2026&license=viewergpl$
+ *
+ * Copyright (c) 2026, Cool VL Viewer contributors.
+ *
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlifegrid.net/programs/open_source/licensing/gplv2
+ *
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlifegrid.net/programs/open_source/licensing/flossexception
+ *
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ *
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLUUIDFLATMAP_H
+#define LL_LLUUIDFLATMAP_H
+
+#include <string.h>
+#include <utility>
+#include <vector>
+
+#include "stdtypes.h"
+#include "lluuid.h"
+
+// LLUUIDFlatMap is a drop-in replacement for the subset of std::map<LLUUID, T>
+// used by large indices (find(), count(), operator[], erase(), iteration).
+// The values are stored contiguously (as std::pair<LLUUID, T>, so that the
+// iterators may be used like std::map ones) and are indexed by an open
+// addressing (linear probing) hash table of 32 bits indices.
+//
+// Differences with std::map:
+//  - the iteration order is the insertion order, as long as nothing is erased
+//    (erase() moves the last value into the erased one's place);
+//  - operator[] and erase() invalidate the iterators, references and pointers
+//    to the values (the values themselves are copied around).
+
+template <class T>
+class LLUUIDFlatMap
+{
+public:
+	typedef LLUUID key_type;
+	typedef T mapped_type;
+	typedef std::pair<LLUUID, T> value_type;
+	typedef typename std::vector<value_type>::iterator iterator;
+	typedef typename std::vector<value_type>::const_iterator const_iterator;
+
+	LLUUIDFlatMap()
+	:	mMask(0)
+	{
+	}
+
+	size_t size() const						{ return mValues.size(); }
+	bool empty() const						{ return mValues.empty(); }
+
+	iterator begin()						{ return mValues.begin(); }
+	iterator end()							{ return mValues.end(); }
+	const_iterator begin() const			{ return mValues.begin(); }
+	const_iterator end() const				{ return mValues.end(); }
+
+	iterator find(const LLUUID& id)
+	{
+		S32 slot = findSlot(id);
+		return slot < 0 ? mValues.end() : mValues.begin() + mSlots[slot];
+	}
+
+	const_iterator find(const LLUUID& id) const
+	{
+		S32 slot = findSlot(id);
+		return slot < 0 ? mValues.end() : mValues.begin() + mSlots[slot];
+	}
+
+	size_t count(const LLUUID& id) const	{ return findSlot(id) < 0 ? 0 : 1; }
+
+	T& operator[](const LLUUID& id)
+	{
+		if ((mValues.size() + 1) * 4 > mSlots.size() * 3)
+		{
+			rehash(mSlots.empty() ? MIN_SLOTS : mSlots.size() * 2);
+		}
+		U32 slot = hash(id) & mMask;
+		while (true)
+		{
+			U32 index = mSlots[slot];
+			if (index == (U32)EMPTY)
+			{
+				mSlots[slot] = mValues.size();
+				mValues.push_back(value_type(id, T()));
+				return mValues.back().second;
+			}
+			if (mValues[index].first == id)
+			{
+				return mValues[index].second;
+			}
+			slot = (slot + 1) & mMask;
+		}
+	}
+
+	size_t erase(const LLUUID& id)
+	{
+		S32 slot = findSlot(id);
+		if (slot < 0)
+		{
+			return 0;
+		}
+		U32 index = mSlots[slot];
+		removeSlot(slot);
+		U32 last = mValues.size() - 1;
+		if (index != last)
+		{
+			// Move the last value in the hole
+			mSlots[findSlot(mValues[last].first)] = index;
+			mValues[index] = mValues[last];
+		}
+		mValues.pop_back();
+		return 1;
+	}
+
+	void clear()
+	{
+		mValues.clear();
+		mSlots.clear();
+		mMask = 0;
+	}
+
+	// Pre-allocates room for 'count' values
+	void reserve(size_t count)
+	{
+		mValues.reserve(count);
+		size_t slots = MIN_SLOTS;
+		while (count * 4 > slots * 3)
+		{
+			slots *= 2;
+		}
+		if (slots > mSlots.size())
+		{
+			rehash(slots);
+		}
+	}
+
+private:
+	enum
+	{
+		MIN_SLOTS = 16,
+		EMPTY = 0xffffffff
+	};
+
+	// Most UUIDs are random, but some (e.g. the library or system ones) are
+	// not: mix all their bits.
+	static inline U32 hash(const LLUUID& id)
+	{
+		U32 words[4];
+		memcpy(words, id.mData, sizeof(words));
+		U32 h = words[0] ^ (words[1] * 0x9e3779b1) ^ (words[2] * 0x85ebca6b) ^
+				(words[3] * 0xc2b2ae35);
+		h ^= h >> 16;
+		h *= 0x7feb352d;
+		h ^= h >> 15;
+		return h;
+	}
+
+	S32 findSlot(const LLUUID& id) const
+	{
+		if (mSlots.empty())
+		{
+			return -1;
+		}
+		U32 slot = hash(id) & mMask;
+		while (true)
+		{
+			U32 index = mSlots[slot];
+			if (index == (U32)EMPTY)
+			{
+				return -1;
+			}
+			if (mValues[index].first == id)
+			{
+				return (S32)slot;
+			}
+			slot = (slot + 1) & mMask;
+		}
+	}
+
+	// Backward shift deletion, so that no tombstone is needed
+	void removeSlot(U32 hole)
+	{
+		U32 next = (hole + 1) & mMask;
+		while (mSlots[next] != (U32)EMPTY)
+		{
+			U32 ideal = hash(mValues[mSlots[next]].first) & mMask;
+			if (((next - ideal) & mMask) >= ((next - hole) & mMask))
+			{
+				mSlots[hole] = mSlots[next];
+				hole = next;
+			}
+			next = (next + 1) & mMask;
+		}
+		mSlots[hole] = (U32)EMPTY;
+	}
+
+	void rehash(size_t slots)
+	{
+		mSlots.assign(slots, (U32)EMPTY);
+		mMask = slots - 1;
+		for (U32 index = 0, count = mValues.size(); index < count; ++index)
+		{
+			U32 slot = hash(mValues[index].first) & mMask;
+			while (mSlots[slot] != (U32)EMPTY)
+			{
+				slot = (slot + 1) & mMask;
+			}
+			mSlots[slot] = index;
+		}
+	}
+
+private:
+	std::vector<value_type>	mValues;
+	std::vector<U32>		mSlots;
+	U32						mMask;
+};
+
+// Same as the llstl.h helpers for std::map
+
+template <typename T>
+inline T* get_ptr_in_map(const LLUUIDFlatMap<T*>& inmap, const LLUUID& key)
+{
+	typename LLUUIDFlatMap<T*>::const_iterator iter = inmap.find(key);
+	return iter == inmap.end() ? NULL : iter->second;
+}
+
+template <typename T>
+inline bool is_in_map(const LLUUIDFlatMap<T>& inmap, const LLUUID& key)
+{
+	return inmap.count(key) != 0;
+}
+
+#endif	// LL_LLUUIDFLATMAP_H
@@ -33,6 +33,8 @@
 #ifndef LL_LLIMAGE_H
 #define LL_LLIMAGE_H
 
+#include <vector>
+
 #include "lluuid.h"
 #include "llstring.h"
 //#include "llmemory.h"
@@ -55,6 +57,11 @@ const S32 MAX_IMAGE_DATA_SIZE = MAX_IMAGE_AREA * MAX_IMAGE_COMPONENTS;
 const S32 FIRST_PACKET_SIZE = 600;
 const S32 MAX_IMG_PACKET_SIZE = 1000;
 
+// Set to 1 to compare the results of the LLImageRaw scaling code with the
+// (slow) reference per-line implementation, and to log the time spent in
+// both.
+#define LL_IMAGE_SCALE_CHECK 0
+
 // Base classes for images.
 // There are two major parts for the image:
 // The compressed representation, and the decompressed representation.
@@ -235,9 +242,39 @@ protected:
 	// Create an image from a local file (generally used in tools)
 	bool createFromFile(const std::string& filename, bool j2c_lowest_mip_only = false);
 
+	// Box filter footprint of an output pixel along one axis: first and last
+	// input pixels and their partial weights (mFract1 is 0 when the last input
+	// pixel does not contribute).
+	struct ScaleTap
+	{
+		S32 mIndex0;
+		S32 mIndex1;
+		F32 mFract0;
+		F32 mFract1;
+	};
+	typedef std::vector<ScaleTap> scale_taps_t;
+
+	// Fills 'taps' and returns the normalization factor
+	static F32 buildScaleTaps(S32 in_pixel_len, S32 out_pixel_len,
+							  scale_taps_t& taps);
+	// Scales 'in_rows' rows of 'row_len' bytes into 'out_rows' rows
+	static void scaleRows(const U8* in, U8* out, S32 row_len, S32 in_rows,
+						  S32 out_rows);
+	void scaleRow(const U8* in, U8* out, const scale_taps_t& taps, F32 norm);
+	void compositeScaledRow4onto3(const U8* in, U8* out,
+								  const scale_taps_t& taps, F32 norm);
+
+	// Reference (unvectorized, per line) implementations
 	void copyLineScaled( U8* in, U8* out, S32 in_pixel_len, S32 out_pixel_len, S32 in_pixel_step, S32 out_pixel_step );
 	void compositeRowScaled4onto3( U8* in, U8* out, S32 in_pixel_len, S32 out_pixel_len );
 
+#if LL_IMAGE_SCALE_CHECK
+	// Compares 'out' with the result of the reference implementation and logs
+	// the timings.
+	void checkScaled(const U8* in, S32 in_width, S32 in_height, const U8* out,
+					 S32 out_width, S32 out_height, U64 clocks);
+#endif
+
 	U8	fastFractionalMult(U8 a,U8 b);
 
 public:
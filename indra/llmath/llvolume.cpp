@@ -2392,7 +2392,7 @@ LLProfile::~LLProfile()
 	}
 }
 
-S32 LLVolume::sNumMeshPoints = 0;
+LLAtomicS32 LLVolume::sNumMeshPoints(0);
 
 LLVolume::LLVolume(const LLVolumeParams &params, const F32 detail, const BOOL generate_single_face, const BOOL is_unique)
 	: mParams(params)
@@ -6095,26 +6095,51 @@ bool LLVolumeFace::VertexMapData::ComparePosition::operator()(const LLVector3& a
 	return a.mV[2] < b.mV[2];
 }
 
+// Vertex welder: duplicate vertices are found via a hash table of their
+// quantized positions. All the bookkeeping (quantized keys, hash chains and
+// remapping tables) lives in a single arena allocation, and the new face data
+// is allocated once, at its final size.
 void LLVolumeFace::optimize(F32 angle_cutoff)
 {
-	LLVolumeFace new_face;
-
-	// map of points to vector of vertices at that point
-	std::map<U64, std::vector<VertexMapData> > point_map;
-
 	LLVector4a range;
 	range.setSub(mExtents[1], mExtents[0]);
 
+	U32 table_size = 16;
+	while (table_size < 2 * (U32)mNumVertices)
+	{
+		table_size <<= 1;
+	}
+	const U32 table_mask = table_size - 1;
+
+	// Arena layout: quantized position of each new vertex, head and tail of
+	// each hash chain, next new vertex in chain, source (old) index of each
+	// new vertex, and the new indices. There cannot be more new vertices than
+	// there are indices.
+	const size_t keys_size = sizeof(U64) * mNumIndices;
+	const size_t chains_size = sizeof(S32) * (2 * table_size + mNumIndices);
+	const size_t remap_size = sizeof(U16) * 2 * mNumIndices;
+	U8* arena = (U8*)ll_aligned_malloc_16(keys_size + chains_size +
+										  remap_size);
+	U64* keys = (U64*)arena;
+	S32* heads = (S32*)(arena + keys_size);
+	S32* tails = heads + table_size;
+	S32* links = tails + table_size;
+	U16* src_index = (U16*)(links + mNumIndices);
+	U16* new_indices = src_index + mNumIndices;
+
+	for (U32 i = 0; i < table_size; ++i)
+	{
+		heads[i] = tails[i] = -1;
+	}
+
 	//remove redundant vertices
+	S32 num_new_verts = 0;
+	LLVolumeFace::VertexData cv, tv;
 	for (U32 i = 0; i < mNumIndices; ++i)
 	{
 		U16 index = mIndices[i];
-
-		LLVolumeFace::VertexData cv;
 		getVertexData(index, cv);
 
-		BOOL found = FALSE;
-
 		LLVector4a pos;
 		pos.setSub(mPositions[index], mExtents[0]);
 		pos.div(range);
@@ -6125,44 +6150,80 @@ void LLVolumeFace::optimize(F32 angle_cutoff)
 		pos64 = pos64 | (((U64)(pos[1] * 65535)) << 16);
 		pos64 = pos64 | (((U64)(pos[2] * 65535)) << 32);
 
-		std::map<U64, std::vector<VertexMapData> >::iterator point_iter = point_map.find(pos64);
+		U32 hash = (U32)pos64 * 2654435761U;
+		hash ^= (U32)(pos64 >> 32) * 2246822519U;
+		hash ^= hash >> 15;
+		U32 bucket = hash & table_mask;
 
-		if (point_iter != point_map.end())
-		{	// Duplicate point might exist
-			for (U32 j = 0; j < point_iter->second.size(); ++j)
-			{
-				LLVolumeFace::VertexData& tv = (point_iter->second)[j];
+		// Candidates are visited in insertion order, so that the first
+		// matching vertex wins
+		S32 found = -1;
+		for (S32 j = heads[bucket]; j != -1; j = links[j])
+		{
+			if (keys[j] == pos64)
+			{	// Duplicate point might exist
+				getVertexData(src_index[j], tv);
 				if (tv.compareNormal(cv, angle_cutoff))
 				{
-					found = TRUE;
-					new_face.pushIndex((point_iter->second)[j].mIndex);
+					found = j;
 					break;
 				}
 			}
 		}
 
-		if (!found)
+		if (found == -1)
 		{
-			new_face.pushVertex(cv);
-			U16 index = (U16)new_face.mNumVertices - 1;
-			new_face.pushIndex(index);
-
-			VertexMapData d;
-			d.setPosition(cv.getPosition());
-			d.mTexCoord = cv.mTexCoord;
-			d.setNormal(cv.getNormal());
-			d.mIndex = index;
-			if (point_iter != point_map.end())
+			found = num_new_verts++;
+			keys[found] = pos64;
+			src_index[found] = index;
+			links[found] = -1;
+			if (tails[bucket] == -1)
 			{
-				point_iter->second.push_back(d);
+				heads[bucket] = found;
 			}
 			else
 			{
-				point_map[pos64].push_back(d);
+				links[tails[bucket]] = found;
 			}
+			tails[bucket] = found;
+		}
+
+		new_indices[i] = (U16)found;
+	}
+
+	LLVolumeFace new_face;
+	new_face.resizeVertices(num_new_verts);
+	new_face.resizeIndices(mNumIndices);
+
+	for (S32 i = 0; i < num_new_verts; ++i)
+	{
+		U16 index = src_index[i];
+		new_face.mPositions[i] = mPositions[index];
+		if (mNormals)
+		{
+			new_face.mNormals[i] = mNormals[index];
+		}
+		else
+		{
+			new_face.mNormals[i].clear();
+		}
+		if (mTexCoords)
+		{
+			new_face.mTexCoords[i] = mTexCoords[index];
+		}
+		else
+		{
+			new_face.mTexCoords[i].clear();
 		}
 	}
 
+	if (mNumIndices)
+	{
+		memcpy(new_face.mIndices, new_indices, sizeof(U16) * mNumIndices);
+	}
+
+	ll_aligned_free_16(arena);
+
 	llassert(new_face.mNumIndices == mNumIndices);
 	llassert(new_face.mNumVertices <= mNumVertices);
 
@@ -6181,406 +6242,326 @@ void LLVolumeFace::optimize(F32 angle_cutoff)
 	swapData(new_face);
 }
 
-class LLVCacheTriangleData;
-
-class LLVCacheVertexData
-{
-public:
-	S32 mIdx;
-	S32 mCacheTag;
-	F32 mScore;
-	U32 mActiveTriangles;
-	std::vector<LLVCacheTriangleData*> mTriangles;
-
-	LLVCacheVertexData()
-	{
-		mCacheTag = -1;
-		mScore = 0.f;
-		mActiveTriangles = 0;
-		mIdx = -1;
-	}
-};
-
-class LLVCacheTriangleData
-{
-public:
-	bool mActive;
-	F32 mScore;
-	LLVCacheVertexData* mVertex[3];
-
-	LLVCacheTriangleData()
-	{
-		mActive = true;
-		mScore = 0.f;
-		mVertex[0] = mVertex[1] = mVertex[2] = NULL;
-	}
-
-	void complete()
-	{
-		mActive = false;
-		for (S32 i = 0; i < 3; ++i)
-		{
-			if (mVertex[i])
-			{
-				llassert_always(mVertex[i]->mActiveTriangles > 0);
-				mVertex[i]->mActiveTriangles--;
-			}
-		}
-	}
-
-	bool operator<(const LLVCacheTriangleData& rhs) const
-	{ //highest score first
-		return rhs.mScore < mScore;
-	}
-};
-
 const F32 FindVertexScore_CacheDecayPower = 1.5f;
 const F32 FindVertexScore_LastTriScore = 0.75f;
 const F32 FindVertexScore_ValenceBoostScale = 2.0f;
 const F32 FindVertexScore_ValenceBoostPower = 0.5f;
 const U32 MaxSizeVertexCache = 32;
 
-F32 find_vertex_score(LLVCacheVertexData& data)
-{
-	if (data.mActiveTriangles == 0)
-	{	// No triangle references this vertex
-		return -1.f;
-	}
-
-	F32 score = 0.f;
-
-	S32 cache_idx = data.mCacheTag;
-
-	if (cache_idx < 0)
-	{
-		// not in cache
-	}
-	else
-	{
-		if (cache_idx < 3)
-		{	// Vertex was in the last triangle
-			score = FindVertexScore_LastTriScore;
-		}
-		else
-		{	// More points for being higher in the cache
-			F32 scaler = 1.f/(MaxSizeVertexCache-3);
-			score = 1.f-((cache_idx-3)*scaler);
-			score = powf(score, FindVertexScore_CacheDecayPower);
-		}
-	}
+// Set to 1 to log, for each optimized face, the time taken by cacheOptimize()
+// and the average cache miss ratio (ACMR) before and after optimization, as
+// seen by a FIFO cache of MaxSizeVertexCache entries.
+#define LL_VCACHE_ACMR_REPORT 0
 
-	// bonus points for having low valence
-	F32 valence_boost = powf((F32)data.mActiveTriangles,
-							 -FindVertexScore_ValenceBoostPower);
-	score += FindVertexScore_ValenceBoostScale * valence_boost;
+const U32 MaxValenceVertexScore = 64;
 
-	return score;
-}
-
-class LLVCacheFIFO
+// Vertex scoring with the powf() results precomputed for each cache position
+// and for the common valences.
+class LLVCacheScorer
 {
 public:
-	LLVCacheVertexData* mCache[MaxSizeVertexCache];
-	U32 mMisses;
-
-	LLVCacheFIFO()
+	LLVCacheScorer()
 	{
-		mMisses = 0;
 		for (U32 i = 0; i < MaxSizeVertexCache; ++i)
 		{
-			mCache[i] = NULL;
-		}
-	}
-
-	void addVertex(LLVCacheVertexData* data)
-	{
-		if (data->mCacheTag == -1)
-		{
-			mMisses++;
-
-			S32 end = MaxSizeVertexCache - 1;
-
-			if (mCache[end])
-			{
-				mCache[end]->mCacheTag = -1;
+			if (i < 3)
+			{	// Vertex was in the last triangle
+				mCacheScore[i] = FindVertexScore_LastTriScore;
 			}
-
-			for (S32 i = end; i > 0; --i)
-			{
-				mCache[i] = mCache[i - 1];
-				if (mCache[i])
-				{
-					mCache[i]->mCacheTag = i;
-				}
+			else
+			{	// More points for being higher in the cache
+				F32 scaler = 1.f / (MaxSizeVertexCache - 3);
+				F32 score = 1.f - ((i - 3) * scaler);
+				mCacheScore[i] = powf(score, FindVertexScore_CacheDecayPower);
 			}
-
-			mCache[0] = data;
-			data->mCacheTag = 0;
 		}
-	}
-};
-
-class LLVCacheLRU
-{
-public:
-	LLVCacheVertexData* mCache[MaxSizeVertexCache + 3];
-
-	LLVCacheTriangleData* mBestTriangle;
-
-	U32 mMisses;
 
-	LLVCacheLRU()
-	{
-		for (U32 i = 0; i < MaxSizeVertexCache + 3; ++i)
+		mValenceScore[0] = 0.f;
+		for (U32 i = 1; i < MaxValenceVertexScore; ++i)
 		{
-			mCache[i] = NULL;
+			mValenceScore[i] = getValenceScore(i);
 		}
-
-		mBestTriangle = NULL;
-		mMisses = 0;
 	}
 
-	void addVertex(LLVCacheVertexData* data)
+	// cache_pos is the position of the vertex in the LRU cache (-1 when not
+	// in cache) and active_tris the number of triangles not yet emitted that
+	// use it.
+	F32 getScore(S32 cache_pos, U32 active_tris) const
 	{
-		S32 end = MaxSizeVertexCache + 2;
-		if (data->mCacheTag != -1)
-		{	// just moving a vertex to the front of the cache
-			end = data->mCacheTag;
-		}
-		else
-		{
-			mMisses++;
-			if (mCache[end])
-			{	// adding a new vertex, vertex at end of cache falls off
-				mCache[end]->mCacheTag = -1;
-			}
+		if (active_tris == 0)
+		{	// No triangle references this vertex
+			return -1.f;
 		}
 
-		for (S32 i = end; i > 0; --i)
-		{	// adjust cache pointers and tags
-			mCache[i] = mCache[i - 1];
-
-			if (mCache[i])
-			{
-				mCache[i]->mCacheTag = i;
-			}
-		}
+		F32 score = cache_pos < 0 ? 0.f : mCacheScore[cache_pos];
 
-		mCache[0] = data;
-		mCache[0]->mCacheTag = 0;
+		// bonus points for having low valence
+		score += active_tris < MaxValenceVertexScore ? mValenceScore[active_tris]
+													 : getValenceScore(active_tris);
+		return score;
 	}
 
-	void addTriangle(LLVCacheTriangleData* data)
+private:
+	static F32 getValenceScore(U32 active_tris)
 	{
-		addVertex(data->mVertex[0]);
-		addVertex(data->mVertex[1]);
-		addVertex(data->mVertex[2]);
+		F32 valence_boost = powf((F32)active_tris,
+								 -FindVertexScore_ValenceBoostPower);
+		return FindVertexScore_ValenceBoostScale * valence_boost;
 	}
 
-	void updateScores()
-	{
-		for (U32 i = MaxSizeVertexCache; i < MaxSizeVertexCache + 3; ++i)
-		{	// trailing 3 vertices aren't actually in the cache for scoring
-			// purposes
-			if (mCache[i])
-			{
-				mCache[i]->mCacheTag = -1;
-			}
-		}
-
-		for (U32 i = 0; i < MaxSizeVertexCache; ++i)
-		{	// update scores of vertices in cache
-			if (mCache[i])
-			{
-				mCache[i]->mScore = find_vertex_score(*(mCache[i]));
-				llassert_always(mCache[i]->mCacheTag == i);
-			}
-		}
-
-		mBestTriangle = NULL;
-		// update triangle scores
-		for (U32 i = 0; i < MaxSizeVertexCache + 3; ++i)
-		{
-			if (mCache[i])
-			{
-				for (U32 j = 0; j < mCache[i]->mTriangles.size(); ++j)
-				{
-					LLVCacheTriangleData* tri = mCache[i]->mTriangles[j];
-					if (tri->mActive)
-					{
-						tri->mScore = tri->mVertex[0]->mScore;
-						tri->mScore += tri->mVertex[1]->mScore;
-						tri->mScore += tri->mVertex[2]->mScore;
-
-						if (!mBestTriangle || mBestTriangle->mScore < tri->mScore)
-						{
-							mBestTriangle = tri;
-						}
-					}
-				}
-			}
-		}
+private:
+	F32 mCacheScore[MaxSizeVertexCache];
+	F32 mValenceScore[MaxValenceVertexScore];
+};
 
-		// knock trailing 3 vertices off the cache
-		for (U32 i = MaxSizeVertexCache; i < MaxSizeVertexCache + 3; ++i)
+#if LL_VCACHE_ACMR_REPORT
+// Returns the average cache miss ratio of an index buffer for a FIFO cache.
+// A vertex is in the cache when it missed within the last MaxSizeVertexCache
+// misses.
+static F32 calc_fifo_acmr(const U16* indices, U32 num_indices, U32 num_verts)
+{
+	std::vector<U32> miss_stamp(num_verts, 0);
+	U32 misses = 0;
+	for (U32 i = 0; i < num_indices; ++i)
+	{
+		U32& stamp = miss_stamp[indices[i]];
+		if (!stamp || misses - stamp >= MaxSizeVertexCache)
 		{
-			if (mCache[i])
-			{
-				llassert_always(mCache[i]->mCacheTag == -1);
-				mCache[i] = NULL;
-			}
+			stamp = ++misses;
 		}
 	}
-};
+	return num_indices >= 3 ? (F32)misses / (num_indices / 3) : 0.f;
+}
+#endif
 
 // Optimize for vertex cache according to Forsyth method: 
 // http://home.comcast.net/~tom_forsyth/papers/fast_vert_cache_opt.html
+// The vertex to triangles adjacency is kept in compressed row form and all
+// the bookkeeping lives in a single arena allocation. Only the triangles
+// using vertices in the cache are rescored after each emitted triangle, and
+// dead ends resume at the next triangle not yet emitted, so that the whole
+// optimization runs in linear time.
 void LLVolumeFace::cacheOptimize()
 {
-	LLVCacheLRU cache;
-
-	if (mNumVertices < 3)
+	if (mNumVertices < 3 || mNumIndices < 3)
 	{	// nothing to do
 		return;
 	}
 
-	// mapping of vertices to triangles and indices
-	std::vector<LLVCacheVertexData> vertex_data;
-
-	// mapping of triangles do vertices
-	std::vector<LLVCacheTriangleData> triangle_data;
+	const U32 num_verts = mNumVertices;
+	const U32 num_tris = mNumIndices / 3;
+	const U32 num_indices = num_tris * 3;
 
-	triangle_data.resize(mNumIndices / 3);
-	vertex_data.resize(mNumVertices);
+#if LL_VCACHE_ACMR_REPORT
+	LLTimer timer;
+	F32 pre_acmr = calc_fifo_acmr(mIndices, num_indices, num_verts);
+#endif
 
-	for (U32 i = 0; i < mNumIndices; i++)
-	{	// populate vertex data and triangle data arrays
-		U16 idx = mIndices[i];
-		U32 tri_idx = i / 3;
+	// Arena layout: per vertex score, cache position, count of active
+	// triangles and adjacency start, then the adjacency list, new indices
+	// and per triangle "emitted" flag.
+	const size_t verts_size = (sizeof(F32) + sizeof(S32) + sizeof(U32)) *
+							  num_verts + sizeof(U32) * (num_verts + 1);
+	const size_t tris_size = (sizeof(U32) * 3 + sizeof(U16) * 3 +
+							  sizeof(U8)) * num_tris;
+	U8* arena = (U8*)ll_aligned_malloc_16(verts_size + tris_size);
+	F32* vert_score = (F32*)arena;
+	S32* cache_pos = (S32*)(vert_score + num_verts);
+	U32* active_tris = (U32*)(cache_pos + num_verts);
+	U32* adj_start = active_tris + num_verts;
+	U32* adj = adj_start + num_verts + 1;
+	U16* new_indices = (U16*)(adj + num_indices);
+	U8* tri_done = (U8*)(new_indices + num_indices);
 
-		vertex_data[idx].mTriangles.push_back(&(triangle_data[tri_idx]));
-		vertex_data[idx].mIdx = idx;
-		triangle_data[tri_idx].mVertex[i%3] = &(vertex_data[idx]);
+	// build the vertex to triangles adjacency
+	memset(active_tris, 0, sizeof(U32) * num_verts);
+	for (U32 i = 0; i < num_indices; ++i)
+	{
+		++active_tris[mIndices[i]];
 	}
 
-#if 0
-	F32 pre_acmr = 1.f;
-	// measure cache misses from before rebuild
+	adj_start[0] = 0;
+	for (U32 i = 0; i < num_verts; ++i)
 	{
-		LLVCacheFIFO test_cache;
-		for (U32 i = 0; i < mNumIndices; ++i)
-		{
-			test_cache.addVertex(&vertex_data[mIndices[i]]);
-		}
-
-		for (U32 i = 0; i < mNumVertices; i++)
-		{
-			vertex_data[i].mCacheTag = -1;
-		}
+		adj_start[i + 1] = adj_start[i] + active_tris[i];
+		// cache_pos is used as the fill cursor for now
+		cache_pos[i] = adj_start[i];
+	}
 
-		pre_acmr = (F32) test_cache.mMisses / (mNumIndices / 3);
+	for (U32 i = 0; i < num_indices; ++i)
+	{
+		adj[cache_pos[mIndices[i]]++] = i / 3;
 	}
-#endif
 
-	for (U32 i = 0; i < mNumVertices; i++)
-	{	// initialize score values (no cache -- might try a fifo cache here)
-		vertex_data[i].mScore = find_vertex_score(vertex_data[i]);
-		vertex_data[i].mActiveTriangles = vertex_data[i].mTriangles.size();
+	// initialize score values
+	LLVCacheScorer scorer;
+	for (U32 i = 0; i < num_verts; ++i)
+	{
+		cache_pos[i] = -1;
+		vert_score[i] = scorer.getScore(-1, active_tris[i]);
+	}
 
-		for (U32 j = 0; j < vertex_data[i].mTriangles.size(); ++j)
+	// start with the highest scoring triangle
+	S32 tri = 0;
+	F32 best_score = -1.f;
+	for (U32 i = 0; i < num_tris; ++i)
+	{
+		const U16* idx = mIndices + i * 3;
+		F32 score = vert_score[idx[0]] + vert_score[idx[1]] +
+					vert_score[idx[2]];
+		tri_done[i] = 0;
+		if (score > best_score)
 		{
-			vertex_data[i].mTriangles[j]->mScore += vertex_data[i].mScore;
+			tri = i;
+			best_score = score;
 		}
 	}
 
-	// sort triangle data by score
-	std::sort(triangle_data.begin(), triangle_data.end());
-
-	std::vector<U16> new_indices;
-
-	LLVCacheTriangleData* tri;
-
-	//prime pump by adding first triangle to cache;
-	tri = &(triangle_data[0]);
-	cache.addTriangle(tri);
-	new_indices.push_back(tri->mVertex[0]->mIdx);
-	new_indices.push_back(tri->mVertex[1]->mIdx);
-	new_indices.push_back(tri->mVertex[2]->mIdx);
-	tri->complete();
+	// LRU cache, with 3 extra trailing entries that do not count for scoring
+	const S32 cache_size = MaxSizeVertexCache + 3;
+	S32 cache[MaxSizeVertexCache + 3];
+	for (S32 i = 0; i < cache_size; ++i)
+	{
+		cache[i] = -1;
+	}
 
+	U32 next_unused = 0;
 	U32 breaks = 0;
-	for (U32 i = 1; i < mNumIndices / 3; ++i)
+	for (U32 n = 0; n < num_tris; ++n)
 	{
-		cache.updateScores();
-		tri = cache.mBestTriangle;
-		if (!tri)
-		{
+		if (tri < 0)
+		{	// dead end: resume with the next triangle not yet emitted
 			breaks++;
-			for (U32 j = 0; j < triangle_data.size(); ++j)
+			while (tri_done[next_unused])
 			{
-				if (triangle_data[j].mActive)
+				++next_unused;
+			}
+			tri = next_unused;
+		}
+
+		const U16* idx = mIndices + tri * 3;
+		tri_done[tri] = 1;
+
+		for (U32 k = 0; k < 3; ++k)
+		{	// emit the triangle and add its vertices to the cache
+			S32 v = idx[k];
+			new_indices[n * 3 + k] = v;
+
+			S32 end = cache_size - 1;
+			if (cache_pos[v] != -1)
+			{	// just moving a vertex to the front of the cache
+				end = cache_pos[v];
+			}
+			else if (cache[end] != -1)
+			{	// adding a new vertex, vertex at end of cache falls off
+				cache_pos[cache[end]] = -1;
+			}
+
+			for (S32 i = end; i > 0; --i)
+			{	// adjust cache entries and positions
+				cache[i] = cache[i - 1];
+				if (cache[i] != -1)
 				{
-					tri = &(triangle_data[j]);
-					break;
+					cache_pos[cache[i]] = i;
 				}
 			}
+
+			cache[0] = v;
+			cache_pos[v] = 0;
 		}
 
-		cache.addTriangle(tri);
-		new_indices.push_back(tri->mVertex[0]->mIdx);
-		new_indices.push_back(tri->mVertex[1]->mIdx);
-		new_indices.push_back(tri->mVertex[2]->mIdx);
-		tri->complete();
-	}
+		for (U32 k = 0; k < 3; ++k)
+		{
+			llassert(active_tris[idx[k]] > 0);
+			--active_tris[idx[k]];
+		}
 
-	for (U32 i = 0; i < mNumIndices; ++i)
-	{
-		mIndices[i] = new_indices[i];
-	}
+		// trailing 3 vertices aren't actually in the cache for scoring
+		// purposes
+		for (S32 i = MaxSizeVertexCache; i < cache_size; ++i)
+		{
+			if (cache[i] != -1)
+			{
+				cache_pos[cache[i]] = -1;
+			}
+		}
 
-#if 0
-	F32 post_acmr = 1.f;
-	//measure cache misses from after rebuild
-	{
-		LLVCacheFIFO test_cache;
-		for (U32 i = 0; i < mNumVertices; i++)
+		// update scores of vertices in cache
+		for (S32 i = 0; i < (S32)MaxSizeVertexCache; ++i)
 		{
-			vertex_data[i].mCacheTag = -1;
+			if (cache[i] != -1)
+			{
+				vert_score[cache[i]] = scorer.getScore(i,
+													   active_tris[cache[i]]);
+			}
 		}
 
-		for (U32 i = 0; i < mNumIndices; ++i)
+		// update scores of the triangles using cached vertices, and pick the
+		// best one
+		tri = -1;
+		best_score = 0.f;
+		for (S32 i = 0; i < cache_size; ++i)
 		{
-			test_cache.addVertex(&vertex_data[mIndices[i]]);
+			if (cache[i] == -1)
+			{
+				continue;
+			}
+
+			for (U32 j = adj_start[cache[i]], end = adj_start[cache[i] + 1];
+				 j < end; ++j)
+			{
+				U32 t = adj[j];
+				if (!tri_done[t])
+				{
+					const U16* tidx = mIndices + t * 3;
+					F32 score = vert_score[tidx[0]] + vert_score[tidx[1]] +
+								vert_score[tidx[2]];
+					if (tri < 0 || best_score < score)
+					{
+						tri = t;
+						best_score = score;
+					}
+				}
+			}
 		}
 
-		post_acmr = (F32)test_cache.mMisses / (mNumIndices / 3);
+		// knock trailing 3 vertices off the cache
+		for (S32 i = MaxSizeVertexCache; i < cache_size; ++i)
+		{
+			cache[i] = -1;
+		}
 	}
-#endif
+
+	memcpy(mIndices, new_indices, sizeof(U16) * num_indices);
 
 	// optimize for pre-TnL cache
 
 	// allocate space for new buffer
-	S32 num_verts = mNumVertices;
-	LLVector4a* pos = (LLVector4a*)ll_aligned_malloc_16(sizeof(LLVector4a) * num_verts);
-	LLVector4a* norm = (LLVector4a*)ll_aligned_malloc_16(sizeof(LLVector4a) * num_verts);
-	S32 size = ((num_verts * sizeof(LLVector2)) + 0xF) & ~0xF;
+	S32 num_new_verts = mNumVertices;
+	LLVector4a* pos = (LLVector4a*)ll_aligned_malloc_16(sizeof(LLVector4a) * num_new_verts);
+	LLVector4a* norm = (LLVector4a*)ll_aligned_malloc_16(sizeof(LLVector4a) * num_new_verts);
+	S32 size = ((num_new_verts * sizeof(LLVector2)) + 0xF) & ~0xF;
 	LLVector2* tc = (LLVector2*) ll_aligned_malloc_16(size);
 
 	LLVector4a* wght = NULL;
 	if (mWeights)
 	{
-		wght = (LLVector4a*) ll_aligned_malloc_16(sizeof(LLVector4a) * num_verts);
+		wght = (LLVector4a*) ll_aligned_malloc_16(sizeof(LLVector4a) * num_new_verts);
 	}
 
 	LLVector4a* binorm = NULL;
 	if (mBinormals)
 	{
-		binorm = (LLVector4a*) ll_aligned_malloc_16(sizeof(LLVector4a) * num_verts);
+		binorm = (LLVector4a*) ll_aligned_malloc_16(sizeof(LLVector4a) * num_new_verts);
 	}
 
-	//allocate mapping of old indices to new indices
-	std::vector<S32> new_idx;
-	new_idx.resize(mNumVertices, -1);
+	// mapping of old indices to new indices (reusing the cache positions
+	// array)
+	S32* new_idx = cache_pos;
+	for (U32 i = 0; i < num_verts; ++i)
+	{
+		new_idx[i] = -1;
+	}
 
 	S32 cur_idx = 0;
 	for (U32 i = 0; i < mNumIndices; ++i)
@@ -6612,6 +6593,8 @@ void LLVolumeFace::cacheOptimize()
 		mIndices[i] = new_idx[mIndices[i]];
 	}
 
+	ll_aligned_free_16(arena);
+
 	ll_aligned_free_16(mPositions);
 	ll_aligned_free_16(mNormals);
 	ll_aligned_free_16(mTexCoords);
@@ -6624,11 +6607,11 @@ void LLVolumeFace::cacheOptimize()
 	mWeights = wght;
 	mBinormals = binorm;
 
-#if 0
-	std::string result = llformat("ACMR pre/post: %.3f/%.3f  --  %d triangles %d breaks",
-								  pre_acmr, post_acmr, mNumIndices / 3,
-								  breaks);
-	llinfos << result << llendl;
+#if LL_VCACHE_ACMR_REPORT
+	F32 post_acmr = calc_fifo_acmr(mIndices, num_indices, num_verts);
+	llinfos << llformat("ACMR pre/post: %.3f/%.3f  --  %d triangles %d breaks, %.3fms",
+						pre_acmr, post_acmr, num_tris, breaks,
+						timer.getElapsedTimeF32() * 1000.f) << llendl;
 #endif
 }
 
@@ -7270,6 +7253,142 @@ BOOL LLVolumeFace::createCap(LLVolume* volume, BOOL partial_build)
 	return TRUE;
 }
 
+// Number of triangles processed per block by the normal and binormal
+// generation loops below: the per-triangle results for a block are computed
+// into a small, cache-resident scratch array before being accumulated into
+// the vertices.
+#define LL_VOLUME_TRI_BLOCK 256
+
+// Computes the (non-normalized) normals of 'count' triangles into 'out', four
+// triangles at a time in structure of arrays form (one SSE lane per triangle).
+// The result for each triangle is bit-identical to the (v0 - v1) x (v0 - v2)
+// cross product computed with LLVector4a::setCross3().
+static void calc_triangle_normals(const LLVector4a* pos, const U16* idx,
+								  U32 count, LLVector4a* out)
+{
+	U32 i = 0;
+	for ( ; i + 4 <= count; i += 4, idx += 12)
+	{
+		LLQuad a0 = _mm_sub_ps(pos[idx[0]], pos[idx[1]]);
+		LLQuad b0 = _mm_sub_ps(pos[idx[0]], pos[idx[2]]);
+		LLQuad a1 = _mm_sub_ps(pos[idx[3]], pos[idx[4]]);
+		LLQuad b1 = _mm_sub_ps(pos[idx[3]], pos[idx[5]]);
+		LLQuad a2 = _mm_sub_ps(pos[idx[6]], pos[idx[7]]);
+		LLQuad b2 = _mm_sub_ps(pos[idx[6]], pos[idx[8]]);
+		LLQuad a3 = _mm_sub_ps(pos[idx[9]], pos[idx[10]]);
+		LLQuad b3 = _mm_sub_ps(pos[idx[9]], pos[idx[11]]);
+
+		// After transposition, a0/a1/a2 (resp. b0/b1/b2) hold the x/y/z
+		// components of the four triangles' edge vectors.
+		_MM_TRANSPOSE4_PS(a0, a1, a2, a3);
+		_MM_TRANSPOSE4_PS(b0, b1, b2, b3);
+
+		LLQuad nx = _mm_sub_ps(_mm_mul_ps(a1, b2), _mm_mul_ps(a2, b1));
+		LLQuad ny = _mm_sub_ps(_mm_mul_ps(a2, b0), _mm_mul_ps(a0, b2));
+		LLQuad nz = _mm_sub_ps(_mm_mul_ps(a0, b1), _mm_mul_ps(a1, b0));
+		LLQuad nw = _mm_setzero_ps();
+		_MM_TRANSPOSE4_PS(nx, ny, nz, nw);
+
+		out[i] = nx;
+		out[i + 1] = ny;
+		out[i + 2] = nz;
+		out[i + 3] = nw;
+	}
+
+	// Left over triangles
+	for ( ; i < count; ++i, idx += 3)
+	{
+		LLVector4a a, b;
+		a.setSub(pos[idx[0]], pos[idx[1]]);
+		b.setSub(pos[idx[0]], pos[idx[2]]);
+		out[i].setCross3(a, b);
+	}
+}
+
+// Same as calc_binormal_from_triangle() for 'count' triangles, four at a time
+// in structure of arrays form. Results are bit-identical to the scalar
+// version, degenerate texture coordinates included.
+static void calc_triangle_binormals(const LLVector4a* pos, const LLVector2* tc,
+									const U16* idx, U32 count,
+									LLVector4a* out)
+{
+	const LLQuad zero = _mm_setzero_ps();
+	const LLQuad sign = _mm_set1_ps(-0.f);
+	const LLQuad one = _mm_set1_ps(1.f);
+
+	U32 i = 0;
+	for ( ; i + 4 <= count; i += 4, idx += 12)
+	{
+		LLQuad p1x = _mm_sub_ps(pos[idx[0]], pos[idx[1]]);
+		LLQuad p2x = _mm_sub_ps(pos[idx[0]], pos[idx[2]]);
+		LLQuad p1y = _mm_sub_ps(pos[idx[3]], pos[idx[4]]);
+		LLQuad p2y = _mm_sub_ps(pos[idx[3]], pos[idx[5]]);
+		LLQuad p1z = _mm_sub_ps(pos[idx[6]], pos[idx[7]]);
+		LLQuad p2z = _mm_sub_ps(pos[idx[6]], pos[idx[8]]);
+		LLQuad p1w = _mm_sub_ps(pos[idx[9]], pos[idx[10]]);
+		LLQuad p2w = _mm_sub_ps(pos[idx[9]], pos[idx[11]]);
+		_MM_TRANSPOSE4_PS(p1x, p1y, p1z, p1w);
+		_MM_TRANSPOSE4_PS(p2x, p2y, p2z, p2w);
+
+		const LLVector2& t00 = tc[idx[0]];
+		const LLVector2& t01 = tc[idx[1]];
+		const LLVector2& t02 = tc[idx[2]];
+		const LLVector2& t10 = tc[idx[3]];
+		const LLVector2& t11 = tc[idx[4]];
+		const LLVector2& t12 = tc[idx[5]];
+		const LLVector2& t20 = tc[idx[6]];
+		const LLVector2& t21 = tc[idx[7]];
+		const LLVector2& t22 = tc[idx[8]];
+		const LLVector2& t30 = tc[idx[9]];
+		const LLVector2& t31 = tc[idx[10]];
+		const LLVector2& t32 = tc[idx[11]];
+
+		LLQuad u0 = _mm_setr_ps(t00.mV[VX], t10.mV[VX], t20.mV[VX], t30.mV[VX]);
+		LLQuad v0 = _mm_setr_ps(t00.mV[VY], t10.mV[VY], t20.mV[VY], t30.mV[VY]);
+		LLQuad du1 = _mm_sub_ps(u0, _mm_setr_ps(t01.mV[VX], t11.mV[VX],
+												t21.mV[VX], t31.mV[VX]));
+		LLQuad dv1 = _mm_sub_ps(v0, _mm_setr_ps(t01.mV[VY], t11.mV[VY],
+												t21.mV[VY], t31.mV[VY]));
+		LLQuad du2 = _mm_sub_ps(u0, _mm_setr_ps(t02.mV[VX], t12.mV[VX],
+												t22.mV[VX], t32.mV[VX]));
+		LLQuad dv2 = _mm_sub_ps(v0, _mm_setr_ps(t02.mV[VY], t12.mV[VY],
+												t22.mV[VY], t32.mV[VY]));
+
+		// Texture space determinant (the X component of the cross products
+		// in calc_binormal_from_triangle(), identical for all three axes)
+		LLQuad det = _mm_sub_ps(_mm_mul_ps(du1, dv2), _mm_mul_ps(dv1, du2));
+		LLQuad valid = _mm_cmpneq_ps(det, zero);
+
+		LLQuad bx = _mm_sub_ps(_mm_mul_ps(p1x, du2), _mm_mul_ps(du1, p2x));
+		LLQuad by = _mm_sub_ps(_mm_mul_ps(p1y, du2), _mm_mul_ps(du1, p2y));
+		LLQuad bz = _mm_sub_ps(_mm_mul_ps(p1z, du2), _mm_mul_ps(du1, p2z));
+		bx = _mm_div_ps(_mm_xor_ps(bx, sign), det);
+		by = _mm_div_ps(_mm_xor_ps(by, sign), det);
+		bz = _mm_div_ps(_mm_xor_ps(bz, sign), det);
+
+		// Degenerate texture coordinates give a (0, 1, 0) binormal
+		bx = _mm_and_ps(valid, bx);
+		by = _mm_or_ps(_mm_and_ps(valid, by), _mm_andnot_ps(valid, one));
+		bz = _mm_and_ps(valid, bz);
+		LLQuad bw = _mm_setzero_ps();
+		_MM_TRANSPOSE4_PS(bx, by, bz, bw);
+
+		out[i] = bx;
+		out[i + 1] = by;
+		out[i + 2] = bz;
+		out[i + 3] = bw;
+	}
+
+	// Left over triangles
+	for ( ; i < count; ++i, idx += 3)
+	{
+		calc_binormal_from_triangle(out[i],
+									pos[idx[0]], tc[idx[0]],
+									pos[idx[1]], tc[idx[1]],
+									pos[idx[2]], tc[idx[2]]);
+	}
+}
+
 void LLVolumeFace::createBinormals()
 {
 	LLMemType m1(LLMemType::MTYPE_VOLUME);
@@ -7291,32 +7410,38 @@ void LLVolumeFace::createBinormals()
 
 		binorm = mBinormals;
 
-		for (U32 i = 0; i < mNumIndices / 3; i++) 
-		{	//for each triangle
-			const U16& i0 = mIndices[i * 3];
-			const U16& i1 = mIndices[i * 3 + 1];
-			const U16& i2 = mIndices[i * 3 + 2];
-
-			// calculate binormal
-			LLVector4a binormal;
-			calc_binormal_from_triangle(binormal,
-										pos[i0], tc[i0],
-										pos[i1], tc[i1],
-										pos[i2], tc[i2]);
+		LLVector4a tri_binorm[LL_VOLUME_TRI_BLOCK];
+		U32 num_tris = mNumIndices / 3;
+		for (U32 first = 0; first < num_tris; first += LL_VOLUME_TRI_BLOCK)
+		{
+			U32 count = llmin(num_tris - first, (U32)LL_VOLUME_TRI_BLOCK);
 
-			// add triangle normal to vertices
-			binorm[i0].add(binormal);
-			binorm[i1].add(binormal);
-			binorm[i2].add(binormal);
+			// calculate the binormals for this block of triangles
+			calc_triangle_binormals(pos, tc, mIndices + first * 3, count,
+									tri_binorm);
 
-			// even out quad contributions
-			if (i % 2 == 0) 
-			{
-				binorm[i2].add(binormal);
-			}
-			else 
+			// add them to the vertices, in triangle order
+			for (U32 j = 0; j < count; j++)
 			{
+				U32 i = first + j;
+				const U16& i0 = mIndices[i * 3];
+				const U16& i1 = mIndices[i * 3 + 1];
+				const U16& i2 = mIndices[i * 3 + 2];
+				const LLVector4a& binormal = tri_binorm[j];
+
+				binorm[i0].add(binormal);
 				binorm[i1].add(binormal);
+				binorm[i2].add(binormal);
+
+				// even out quad contributions
+				if (i % 2 == 0) 
+				{
+					binorm[i2].add(binormal);
+				}
+				else 
+				{
+					binorm[i1].add(binormal);
+				}
 			}
 		}
 
@@ -7771,28 +7896,30 @@ BOOL LLVolumeFace::createSide(LLVolume* volume, BOOL partial_build)
 		mNormals[i].clear();
 	}
 
-	// generate normals 
-	for (U32 i = 0; i < mNumIndices / 3; i++)	// for each triangle
+	// generate normals, one block of triangles at a time
+	LLVector4a tri_norm[LL_VOLUME_TRI_BLOCK];
+	U32 num_tris = mNumIndices / 3;
+	for (U32 first = 0; first < num_tris; first += LL_VOLUME_TRI_BLOCK)
 	{
-		const U16* idx = &(mIndices[i * 3]);
-
-		LLVector4a* v[] = {	pos + idx[0], pos + idx[1], pos + idx[2] };
-
-		LLVector4a* n[] = { norm + idx[0], norm + idx[1], norm + idx[2] };
+		U32 count = llmin(num_tris - first, (U32)LL_VOLUME_TRI_BLOCK);
 
-		// calculate triangle normal
-		LLVector4a a, b, c;
+		// calculate triangle normals
+		calc_triangle_normals(pos, mIndices + first * 3, count, tri_norm);
 
-		a.setSub(*v[0], *v[1]);
-		b.setSub(*v[0], *v[2]);
-		c.setCross3(a,b);
+		// add them to the vertices, in triangle order
+		for (U32 j = 0; j < count; j++)
+		{
+			U32 i = first + j;
+			const U16* idx = &(mIndices[i * 3]);
+			const LLVector4a& c = tri_norm[j];
 
-		n[0]->add(c);
-		n[1]->add(c);
-		n[2]->add(c);
+			norm[idx[0]].add(c);
+			norm[idx[1]].add(c);
+			norm[idx[2]].add(c);
 
-		// even out quad contributions
-		n[i % 2 + 1]->add(c);
+			// even out quad contributions
+			norm[idx[i % 2 + 1]].add(c);
+		}
 	}
 
 	// adjust normals based on wrapping and stitching
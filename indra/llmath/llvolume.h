@@ -48,6 +48,7 @@ class LLVolumeFace;
 class LLVolume;
 class LLVolumeTriangle;
 
+#include "llapr.h"		// for LLAtomicS32
 #include "lldarray.h"
 #include "lluuid.h"
 #include "v4color.h"
@@ -1037,7 +1038,8 @@ public:
 	LLFaceID generateFaceMask();
 
 	BOOL isFaceMaskValid(LLFaceID face_mask);
-	static S32 sNumMeshPoints;
+	// Atomic since volumes may be generated by LLVolumeGenThread workers
+	static LLAtomicS32 sNumMeshPoints;
 
 	friend std::ostream& operator<<(std::ostream &s, const LLVolume &volume);
 	friend std::ostream& operator<<(std::ostream &s, const LLVolume *volumep);		// HACK to bypass Windoze confusion over 
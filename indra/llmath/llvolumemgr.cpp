@@ -68,6 +68,8 @@ LLVolumeMgr::~LLVolumeMgr()
 
 BOOL LLVolumeMgr::cleanup()
 {
+	stopGenThreads();
+
 	BOOL no_refs = TRUE;
 	if (mDataMutex)
 	{
@@ -166,7 +168,9 @@ void LLVolumeMgr::unrefVolume(LLVolume *volumep)
 		LLVolumeLODGroup* volgroupp = iter->second;
 
 		volgroupp->derefLOD(volumep);
-		if (volgroupp->getNumRefs() == 0)
+		// Note: groups with LODs being generated are deleted when their
+		// generation completes, in updateGenThreads().
+		if (volgroupp->getNumRefs() == 0 && volgroupp->mPendingGens == 0)
 		{
 			mVolumeLODGroups.erase(params);
 			delete volgroupp;
@@ -226,6 +230,216 @@ void LLVolumeMgr::useMutex()
 	}
 }
 
+void LLVolumeMgr::startGenThreads(U32 count)
+{
+	stopGenThreads();
+	for (U32 i = 0; i < count; ++i)
+	{
+		mGenThreads.push_back(new LLVolumeGenThread(llformat("volumegen%d", i)));
+	}
+	if (count)
+	{
+		llinfos << "Started " << count << " volume generation threads" << llendl;
+	}
+}
+
+void LLVolumeMgr::stopGenThreads()
+{
+	if (mGenThreads.empty())
+	{
+		return;
+	}
+
+	// Shut down the threads first: this deletes all pending requests.
+	for (U32 i = 0, count = mGenThreads.size(); i < count; ++i)
+	{
+		mGenThreads[i]->shutdown();
+	}
+
+	if (mDataMutex)
+	{
+		mDataMutex->lock();
+	}
+	for (std::set<LLVolumeLODGroup*>::iterator iter = mPendingGenGroups.begin(),
+											   end = mPendingGenGroups.end();
+		 iter != end; ++iter)
+	{
+		LLVolumeLODGroup* volgroupp = *iter;
+		for (S32 i = 0; i < LLVolumeLODGroup::NUM_LODS; ++i)
+		{
+			volgroupp->mGenHandles[i] = LLQueuedThread::nullHandle();
+			volgroupp->mGenThreads[i] = -1;
+		}
+		volgroupp->mPendingGens = 0;
+		if (volgroupp->getNumRefs() == 0)
+		{
+			mVolumeLODGroups.erase(volgroupp->getVolumeParams());
+			delete volgroupp;
+		}
+	}
+	mPendingGenGroups.clear();
+	if (mDataMutex)
+	{
+		mDataMutex->unlock();
+	}
+
+	for (U32 i = 0, count = mGenThreads.size(); i < count; ++i)
+	{
+		delete mGenThreads[i];
+	}
+	mGenThreads.clear();
+}
+
+bool LLVolumeMgr::requestVolume(const LLVolumeParams& volume_params,
+								S32 detail, U16 sculpt_width,
+								U16 sculpt_height, S8 sculpt_components,
+								const U8* sculpt_data, S32 sculpt_level)
+{
+	if (mGenThreads.empty())
+	{
+		return true;
+	}
+
+	bool available = false;
+	if (mDataMutex)
+	{
+		mDataMutex->lock();
+	}
+	volume_lod_group_map_t::iterator iter = mVolumeLODGroups.find(&volume_params);
+	if (iter == mVolumeLODGroups.end())
+	{
+		// Nothing to display meanwhile: let refVolume() create it.
+		available = true;
+	}
+	else
+	{
+		LLVolumeLODGroup* volgroupp = iter->second;
+		if (volgroupp->hasLOD(detail))
+		{
+			available = true;
+		}
+		else if (volgroupp->mGenHandles[detail] == LLQueuedThread::nullHandle())
+		{
+			// Dispatch to the least busy thread
+			S32 thread_idx = 0;
+			S32 min_pending = mGenThreads[0]->getPending();
+			for (S32 i = 1, count = mGenThreads.size(); i < count; ++i)
+			{
+				S32 pending = mGenThreads[i]->getPending();
+				if (pending < min_pending)
+				{
+					min_pending = pending;
+					thread_idx = i;
+				}
+			}
+
+			F32 scale = LLVolumeLODGroup::getVolumeScaleFromDetail(detail);
+			LLQueuedThread::handle_t handle =
+				mGenThreads[thread_idx]->generateVolume(volume_params, scale,
+														sculpt_width,
+														sculpt_height,
+														sculpt_components,
+														sculpt_data,
+														sculpt_level);
+			if (handle == LLQueuedThread::nullHandle())
+			{
+				// Could not queue the request: let refVolume() generate the
+				// LOD synchronously.
+				available = true;
+			}
+			else
+			{
+				volgroupp->mGenHandles[detail] = handle;
+				volgroupp->mGenThreads[detail] = thread_idx;
+				++volgroupp->mPendingGens;
+				mPendingGenGroups.insert(volgroupp);
+			}
+		}
+		// else: already being generated
+	}
+	if (mDataMutex)
+	{
+		mDataMutex->unlock();
+	}
+
+	return available;
+}
+
+S32 LLVolumeMgr::updateGenThreads()
+{
+	if (mGenThreads.empty())
+	{
+		return 0;
+	}
+
+	for (U32 i = 0, count = mGenThreads.size(); i < count; ++i)
+	{
+		mGenThreads[i]->update(1);	// unpauses the thread
+	}
+
+	S32 pending = 0;
+	if (mDataMutex)
+	{
+		mDataMutex->lock();
+	}
+	for (std::set<LLVolumeLODGroup*>::iterator iter = mPendingGenGroups.begin();
+		 iter != mPendingGenGroups.end(); )
+	{
+		std::set<LLVolumeLODGroup*>::iterator cur_iter = iter++;
+		LLVolumeLODGroup* volgroupp = *cur_iter;
+
+		for (S32 i = 0; i < LLVolumeLODGroup::NUM_LODS; ++i)
+		{
+			LLQueuedThread::handle_t handle = volgroupp->mGenHandles[i];
+			if (handle == LLQueuedThread::nullHandle())
+			{
+				continue;
+			}
+
+			LLVolumeGenThread* threadp = mGenThreads[volgroupp->mGenThreads[i]];
+			LLQueuedThread::status_t status = threadp->getRequestStatus(handle);
+			if (status == LLQueuedThread::STATUS_QUEUED ||
+				status == LLQueuedThread::STATUS_INPROGRESS)
+			{
+				++pending;
+				continue;
+			}
+
+			if (status == LLQueuedThread::STATUS_COMPLETE)
+			{
+				LLVolumeGenThread::GenRequest* req =
+					(LLVolumeGenThread::GenRequest*)threadp->getRequest(handle);
+				// Only swap in if refVolume() did not generate it meanwhile
+				if (req && req->getVolume() && volgroupp->mVolumeLODs[i].isNull())
+				{
+					volgroupp->mVolumeLODs[i] = req->getVolume();
+				}
+			}
+			threadp->completeRequest(handle);
+
+			volgroupp->mGenHandles[i] = LLQueuedThread::nullHandle();
+			volgroupp->mGenThreads[i] = -1;
+			--volgroupp->mPendingGens;
+		}
+
+		if (volgroupp->mPendingGens == 0)
+		{
+			mPendingGenGroups.erase(cur_iter);
+			if (volgroupp->getNumRefs() == 0)
+			{
+				mVolumeLODGroups.erase(volgroupp->getVolumeParams());
+				delete volgroupp;
+			}
+		}
+	}
+	if (mDataMutex)
+	{
+		mDataMutex->unlock();
+	}
+
+	return pending;
+}
+
 std::ostream& operator<<(std::ostream& s, const LLVolumeMgr& volume_mgr)
 {
 	s << "{ numLODgroups=" << volume_mgr.mVolumeLODGroups.size() << ", ";
@@ -255,12 +469,15 @@ std::ostream& operator<<(std::ostream& s, const LLVolumeMgr& volume_mgr)
 
 LLVolumeLODGroup::LLVolumeLODGroup(const LLVolumeParams &params)
 	: mVolumeParams(params),
-	  mRefs(0)
+	  mRefs(0),
+	  mPendingGens(0)
 {
 	for (S32 i = 0; i < NUM_LODS; i++)
 	{
 		mLODRefs[i] = 0;
 		mAccessCount[i] = 0;
+		mGenHandles[i] = LLQueuedThread::nullHandle();
+		mGenThreads[i] = -1;
 	}
 }
 
@@ -415,3 +632,75 @@ std::ostream& operator<<(std::ostream& s, const LLVolumeLODGroup& volgroup)
 	return s;
 }
 
+
+//============================================================================
+// LLVolumeGenThread class
+//============================================================================
+
+// MAIN THREAD
+LLVolumeGenThread::LLVolumeGenThread(const std::string& name)
+:	LLQueuedThread(name)
+{
+}
+
+// MAIN THREAD
+LLVolumeGenThread::handle_t LLVolumeGenThread::generateVolume(const LLVolumeParams& params,
+															  F32 detail,
+															  U16 sculpt_width,
+															  U16 sculpt_height,
+															  S8 sculpt_components,
+															  const U8* sculpt_data,
+															  S32 sculpt_level)
+{
+	handle_t handle = generateHandle();
+	GenRequest* req = new GenRequest(handle, params, detail, sculpt_width,
+									 sculpt_height, sculpt_components,
+									 sculpt_data, sculpt_level);
+	if (!addRequest(req))
+	{
+		req->deleteRequest();
+		return nullHandle();
+	}
+	return handle;
+}
+
+LLVolumeGenThread::GenRequest::GenRequest(handle_t handle,
+										  const LLVolumeParams& params,
+										  F32 detail, U16 sculpt_width,
+										  U16 sculpt_height,
+										  S8 sculpt_components,
+										  const U8* sculpt_data,
+										  S32 sculpt_level)
+:	LLQueuedThread::QueuedRequest(handle, LLQueuedThread::PRIORITY_NORMAL),
+	mParams(params),
+	mDetail(detail),
+	mSculptWidth(sculpt_width),
+	mSculptHeight(sculpt_height),
+	mSculptComponents(sculpt_components),
+	mSculptLevel(sculpt_level)
+{
+	if (sculpt_data && sculpt_width && sculpt_height && sculpt_components)
+	{
+		mSculptData.assign(sculpt_data,
+						   sculpt_data + (S32)sculpt_width * (S32)sculpt_height *
+										 (S32)sculpt_components);
+	}
+}
+
+LLVolumeGenThread::GenRequest::~GenRequest()
+{
+	mVolume = NULL;
+}
+
+// WORKER THREAD
+bool LLVolumeGenThread::GenRequest::processRequest()
+{
+	LLVolume* volumep = new LLVolume(mParams, mDetail);
+	if (!mSculptData.empty())
+	{
+		volumep->sculpt(mSculptWidth, mSculptHeight, mSculptComponents,
+						&mSculptData[0], mSculptLevel);
+	}
+	mVolume = volumep;
+	return true;
+}
@@ -34,9 +34,12 @@
 #define LL_LLVOLUMEMGR_H
 
 #include <map>
+#include <set>
+#include <vector>
 
 #include "llvolume.h"
 #include "llpointer.h"
+#include "llqueuedthread.h"
 #include "llthread.h"
 
 class LLVolumeParams;
@@ -64,6 +67,8 @@ public:
 	LLVolume* refLOD(const S32 detail);
 	BOOL derefLOD(LLVolume *volumep);
 	S32 getNumRefs() const { return mRefs; }
+
+	bool hasLOD(const S32 detail) const { return mVolumeLODs[detail].notNull(); }
 	
 	const LLVolumeParams* getVolumeParams() const { return &mVolumeParams; };
 
@@ -79,6 +84,55 @@ protected:
 	static F32 mDetailThresholds[NUM_LODS];
 	static F32 mDetailScales[NUM_LODS];
 	S32		mAccessCount[NUM_LODS];
+
+	// Asynchronous generation bookkeeping, see LLVolumeMgr::requestVolume()
+	friend class LLVolumeMgr;
+	LLQueuedThread::handle_t mGenHandles[NUM_LODS];
+	S32		mGenThreads[NUM_LODS];
+	S32		mPendingGens;
+};
+
+// Worker thread generating (and sculpting) LLVolumes off the main thread.
+// Requests are queued and their results collected by LLVolumeMgr.
+class LLVolumeGenThread : public LLQueuedThread
+{
+public:
+	class GenRequest : public LLQueuedThread::QueuedRequest
+	{
+		friend class LLVolumeGenThread;
+
+	protected:
+		virtual ~GenRequest(); // use deleteRequest()
+
+	public:
+		GenRequest(handle_t handle, const LLVolumeParams& params, F32 detail,
+				   U16 sculpt_width, U16 sculpt_height, S8 sculpt_components,
+				   const U8* sculpt_data, S32 sculpt_level);
+
+		/*virtual*/ bool processRequest();
+
+		// MAIN THREAD, once the request completed
+		LLVolume* getVolume()					{ return mVolume; }
+
+	private:
+		LLVolumeParams		mParams;
+		F32					mDetail;
+		std::vector<U8>		mSculptData;
+		U16					mSculptWidth;
+		U16					mSculptHeight;
+		S8					mSculptComponents;
+		S32					mSculptLevel;
+		LLPointer<LLVolume>	mVolume;
+	};
+
+public:
+	LLVolumeGenThread(const std::string& name);
+
+	// MAIN THREAD
+	handle_t generateVolume(const LLVolumeParams& params, F32 detail,
+							U16 sculpt_width, U16 sculpt_height,
+							S8 sculpt_components, const U8* sculpt_data,
+							S32 sculpt_level);
 };
 
 class LLVolumeMgr
@@ -101,6 +155,28 @@ public:
 	// manually call this for mutex magic
 	void useMutex();
 
+	// Asynchronous volume generation. Until startGenThreads() is called with
+	// a non-zero count, requestVolume() always returns true.
+	void startGenThreads(U32 count);
+	void stopGenThreads();
+	bool hasGenThreads() const					{ return !mGenThreads.empty(); }
+
+	// MAIN THREAD: returns true when the LOD for these parameters is already
+	// generated (so that refVolume() will not block) or cannot be generated
+	// asynchronously. Else, queues its generation (only once for identical
+	// parameters and detail) and returns false. For sculpties, the sculpt
+	// data (which gets copied) is applied in the worker thread too.
+	bool requestVolume(const LLVolumeParams& volume_params, S32 detail,
+					   U16 sculpt_width = 0, U16 sculpt_height = 0,
+					   S8 sculpt_components = 0, const U8* sculpt_data = NULL,
+					   S32 sculpt_level = -2);
+
+	// MAIN THREAD: swaps the volumes generated by the worker threads into
+	// their LOD group. Returns the number of volumes still being generated.
+	S32 updateGenThreads();
+
+	U32 getPendingGens() const					{ return mPendingGenGroups.size(); }
+
 	friend std::ostream& operator<<(std::ostream& s, const LLVolumeMgr& volume_mgr);
 
 protected:
@@ -113,6 +189,11 @@ protected:
 	volume_lod_group_map_t mVolumeLODGroups;
 
 	LLMutex* mDataMutex;
+
+	std::vector<LLVolumeGenThread*> mGenThreads;
+	// Groups with at least one LOD being generated; they are kept alive
+	// until their generations complete.
+	std::set<LLVolumeLODGroup*> mPendingGenGroups;
 };
 
 #endif // LL_LLVOLUMEMGR_H
@@ -98,6 +98,7 @@ bool     LLCurl::sNotQuitting = true;
 F32      LLCurl::sCurlRequestTimeOut = 120.f; //seconds
 S32      LLCurl::sMaxHandles = 256; // max number of handles, (multi handles and easy handles combined).
 S32      LLCurl::sMaxFreeHandles = 64; // max number of free handles.
+LLCurl::Stats LLCurl::sStats;
 
 void check_curl_code(CURLcode code)
 {
@@ -757,9 +758,79 @@ CURLMsg* LLCurl::Multi::info_read(S32* msgs_in_queue)
 	LLMutexLock lock(mMutexp);
 
 	CURLMsg* curlmsg = curl_multi_info_read(mCurlMultiHandle, msgs_in_queue);
+	if (curlmsg && curlmsg->msg == CURLMSG_DONE)
+	{
+		double total_time = 0.0;
+		curl_easy_getinfo(curlmsg->easy_handle, CURLINFO_TOTAL_TIME,
+						  &total_time);
+
+		LLMutexLock lock(LLCurl::sHandleMutexp);
+		if (curlmsg->data.result == CURLE_OK)
+		{
+			++LLCurl::sStats.mSucceeded;
+		}
+		else
+		{
+			++LLCurl::sStats.mFailed;
+		}
+		LLCurl::sStats.mTotalTime += total_time;
+		if (total_time > LLCurl::sStats.mMaxTime)
+		{
+			LLCurl::sStats.mMaxTime = total_time;
+		}
+	}
 	return curlmsg;
 }
 
+// Returns true when curl_multi_perform() has got something to do, i.e. when
+// one of the sockets of the multi handle is ready, when a curl timer is due,
+// or when we cannot tell. This is a zero timeout select() on the sockets of
+// all the transfers, which is much cheaper than letting curl_multi_perform()
+// check every transfer in turn when most of them are just waiting for the
+// server reply.
+bool LLCurl::Multi::needsPerform()
+{
+	long timeout_ms = -1;
+	if (curl_multi_timeout(mCurlMultiHandle, &timeout_ms) != CURLM_OK ||
+		timeout_ms == 0)
+	{
+		return true;
+	}
+
+	fd_set read_fds;
+	fd_set write_fds;
+	fd_set exc_fds;
+	FD_ZERO(&read_fds);
+	FD_ZERO(&write_fds);
+	FD_ZERO(&exc_fds);
+	int max_fd = -1;
+	if (curl_multi_fdset(mCurlMultiHandle, &read_fds, &write_fds, &exc_fds,
+						 &max_fd) != CURLM_OK)
+	{
+		return true;
+	}
+	if (max_fd < 0)
+	{
+		// No socket to wait on (e.g. a transfer which has not started yet):
+		// let curl decide.
+		return true;
+	}
+#if !LL_WINDOWS
+	if (max_fd >= FD_SETSIZE)
+	{
+		// select() cannot deal with it
+		return true;
+	}
+#endif
+
+	struct timeval tv;
+	tv.tv_sec = 0;
+	tv.tv_usec = 0;
+	// Note: a select() error is dealt with as "ready": curl_multi_perform()
+	// will then report the problem on the faulty transfer, if any.
+	return select(max_fd + 1, &read_fds, &write_fds, &exc_fds, &tv) != 0;
+}
+
 // return true if dead
 bool LLCurl::Multi::doPerform()
 {
@@ -776,12 +847,20 @@ bool LLCurl::Multi::doPerform()
 	{
 		setState(STATE_PERFORMING);
 
-		S32 q = 0;
-		CURLMcode code;
+		S32 q = mQueued;
+		CURLMcode code = CURLM_OK;
 		{
 			LLMutexLock lock(mMutexp);
 
-			for (S32 call_count = 0; call_count < MULTI_PERFORM_CALL_REPEAT;
+			bool perform = needsPerform();
+			if (!perform)
+			{
+				LLMutexLock lock(LLCurl::sHandleMutexp);
+				++LLCurl::sStats.mSkippedPerforms;
+			}
+
+			for (S32 call_count = 0;
+				 perform && call_count < MULTI_PERFORM_CALL_REPEAT;
 				 ++call_count)
 			{
 				// WARNING: curl_multi_perform will block for many hundreds of
@@ -911,6 +990,11 @@ bool LLCurl::Multi::addEasy(Easy* easy)
 	CURLMcode mcode = curl_multi_add_handle(mCurlMultiHandle,
 											easy->getCurlHandle());
 	check_curl_multi_code(mcode);
+	if (mcode == CURLM_OK)
+	{
+		LLMutexLock lock(LLCurl::sHandleMutexp);
+		++LLCurl::sStats.mStarted;
+	}
 	//if (mcode != CURLM_OK)
 	//{
 	//	llwarns << "Curl Error: " << curl_multi_strerror(mcode) << llendl;
@@ -1571,6 +1655,8 @@ void LLCurl::cleanupClass()
 {
 	sNotQuitting = false; // set quitting
 
+	logStats();
+
 	// shut down curl thread
 	while (true)
 	{
@@ -1608,6 +1694,29 @@ void LLCurl::cleanupClass()
 	//llassert(Easy::sActiveHandles.empty());
 }
 
+//static
+void LLCurl::getStats(Stats& stats)
+{
+	LLMutexLock lock(sHandleMutexp);
+	stats = sStats;
+}
+
+//static
+void LLCurl::logStats()
+{
+	Stats stats;
+	getStats(stats);
+	U32 done = stats.mSucceeded + stats.mFailed;
+	llinfos << "HTTP requests: " << stats.mStarted << " started, "
+			<< stats.mSucceeded << " succeeded, " << stats.mFailed
+			<< " failed, " << (S32)(stats.mStarted - done)
+			<< " in flight. Average transfer time: "
+			<< (done ? stats.mTotalTime / (F64)done : 0.0)
+			<< "s, longest: " << stats.mMaxTime
+			<< "s. Skipped curl_multi_perform() calls: "
+			<< stats.mSkippedPerforms << llendl;
+}
+
 //static 
 CURLM* LLCurl::newMultiHandle()
 {
@@ -193,6 +193,26 @@ public:
 
 	static LLCurlThread* getCurlThread() { return sCurlThread; }
 
+	// HTTP requests statistics, for all the multi handles
+	struct Stats
+	{
+		Stats()
+		:	mStarted(0), mSucceeded(0), mFailed(0), mSkippedPerforms(0),
+			mTotalTime(0.0), mMaxTime(0.0)
+		{
+		}
+
+		U32 mStarted;			// Requests added to a multi handle
+		U32 mSucceeded;			// Requests done with CURLE_OK
+		U32 mFailed;			// Requests done with an error
+		U32 mSkippedPerforms;	// curl_multi_perform() calls avoided
+		F64 mTotalTime;			// Cumulated transfer time, in seconds
+		F64 mMaxTime;			// Longest transfer time, in seconds
+	};
+
+	static void getStats(Stats& stats);
+	static void logStats();
+
 	static CURLM*		newMultiHandle();
 	static CURLMcode	deleteMultiHandle(CURLM* handle);
 	static CURL*		newEasyHandle();
@@ -209,6 +229,9 @@ private:
 	static S32      sMaxHandles;
 	static S32      sMaxFreeHandles;
 
+	// Protected by sHandleMutexp
+	static Stats	sStats;
+
 public:
 	static bool     sNotQuitting;
 	static F32      sCurlRequestTimeOut;	
@@ -296,6 +319,7 @@ private:
 
 	void markDead();
 	bool doPerform();
+	bool needsPerform();
 
 public:
 	typedef enum
@@ -177,6 +177,8 @@ LLPumpIO::LLPumpIO(apr_pool_t* pool)
 	mRebuildPollset(false),
 	mPollset(NULL),
 	mPollsetClientID(0),
+	mPollsetCount(0),
+	mPollsetCapacity(0),
 	mNextLock(0),
 	mPool(NULL),
 	mCurrentPool(NULL),
@@ -343,9 +345,9 @@ bool LLPumpIO::setConditional(LLIOPipe* pipe, const apr_pollfd_t* poll)
 		LLChainInfo::pipe_conditional_t& value = (*it);
 		if (pipe_ptr == value.first)
 		{
+			removeFromPollset(&value.second);
 			ll_delete_apr_pollset_fd_client_data()(value);
 			it = (*mCurrentChain).mDescriptors.erase(it);
-			mRebuildPollset = true;
 		}
 		else
 		{
@@ -355,7 +357,6 @@ bool LLPumpIO::setConditional(LLIOPipe* pipe, const apr_pollfd_t* poll)
 
 	if (!poll)
 	{
-		mRebuildPollset = true;
 		return true;
 	}
 	LLChainInfo::pipe_conditional_t value;
@@ -371,7 +372,7 @@ bool LLPumpIO::setConditional(LLIOPipe* pipe, const apr_pollfd_t* poll)
 	}
 	value.second.client_data = new S32(++mPollsetClientID);
 	(*mCurrentChain).mDescriptors.push_back(value);
-	mRebuildPollset = true;
+	addToPollset(&value.second);
 	return true;
 }
 
@@ -454,6 +455,13 @@ void LLPumpIO::pump()
 
 LLPumpIO::current_chain_t LLPumpIO::removeRunningChain(LLPumpIO::current_chain_t& run_chain) 
 {
+	for (LLChainInfo::conditionals_t::iterator
+			it = (*run_chain).mDescriptors.begin(),
+			end = (*run_chain).mDescriptors.end();
+		 it != end; ++it)
+	{
+		removeFromPollset(&((*it).second));
+	}
 	std::for_each((*run_chain).mDescriptors.begin(),
 				  (*run_chain).mDescriptors.end(),
 				  ll_delete_apr_pollset_fd_client_data());
@@ -538,7 +546,7 @@ void LLPumpIO::pump(const S32& poll_timeout)
 	typedef std::map<S32, S32> signal_client_t;
 	signal_client_t signalled_client;
 	const apr_pollfd_t* poll_fd = NULL;
-	if (mPollset)
+	if (mPollset && mPollsetCount)
 	{
 		PUMP_DEBUG;
 		//llinfos << "polling" << llendl;
@@ -724,11 +732,9 @@ void LLPumpIO::pump(const S32& poll_timeout)
 
 			PUMP_DEBUG;
 			// This chain is done. Clean up any allocated memory and
-			// erase the chain info.
+			// erase the chain info (this also removes its descriptors
+			// from the pollset).
 			run_chain = removeRunningChain(run_chain);
-
-			// *NOTE: may not always need to rebuild the pollset.
-			mRebuildPollset = true;
 		}
 		else
 		{
@@ -875,6 +881,7 @@ void LLPumpIO::cleanup()
 		apr_pollset_destroy(mPollset);
 		mPollset = NULL;
 	}
+	mPollsetCount = mPollsetCapacity = 0;
 	if (mCurrentPool)
 	{
 		apr_pool_destroy(mCurrentPool);
@@ -893,6 +900,7 @@ void LLPumpIO::rebuildPollset()
 		apr_pollset_destroy(mPollset);
 		mPollset = NULL;
 	}
+	mPollsetCount = mPollsetCapacity = 0;
 	U32 size = 0;
 	running_chains_t::iterator run_it = mRunningChains.begin();
 	running_chains_t::iterator run_end = mRunningChains.end();
@@ -918,23 +926,71 @@ void LLPumpIO::rebuildPollset()
 			(void)ll_apr_warn_status(status);
 		}
 
+		// Leave room for the descriptors to come, so that they can be added
+		// in place instead of causing another rebuild.
+		const U32 MIN_POLLSET_CAPACITY = 32;
+		U32 capacity = llmax(size * 2, MIN_POLLSET_CAPACITY);
+
 		// add all of the file descriptors
 		run_it = mRunningChains.begin();
 		LLChainInfo::conditionals_t::iterator fd_it;
 		LLChainInfo::conditionals_t::iterator fd_end;
-		apr_pollset_create(&mPollset, size, mCurrentPool, 0);
+		apr_status_t status = apr_pollset_create(&mPollset, capacity,
+												 mCurrentPool, 0);
+		if (ll_apr_warn_status(status))
+		{
+			mPollset = NULL;
+			return;
+		}
+		mPollsetCapacity = capacity;
 		for ( ; run_it != run_end; ++run_it)
 		{
 			fd_it = (*run_it).mDescriptors.begin();
 			fd_end = (*run_it).mDescriptors.end();
 			for ( ; fd_it != fd_end; ++fd_it)
 			{
-				apr_pollset_add(mPollset, &((*fd_it).second));
+				if (apr_pollset_add(mPollset, &((*fd_it).second)) == APR_SUCCESS)
+				{
+					++mPollsetCount;
+				}
 			}
 		}
 	}
 }
 
+void LLPumpIO::addToPollset(const apr_pollfd_t* poll)
+{
+	if (mRebuildPollset)
+	{
+		// The rebuild will add it.
+		return;
+	}
+	if (!mPollset || mPollsetCount >= mPollsetCapacity ||
+		apr_pollset_add(mPollset, poll) != APR_SUCCESS)
+	{
+		mRebuildPollset = true;
+		return;
+	}
+	++mPollsetCount;
+}
+
+void LLPumpIO::removeFromPollset(const apr_pollfd_t* poll)
+{
+	if (mRebuildPollset || !mPollset)
+	{
+		// Nothing to remove from, or the pollset is to be rebuilt anyway.
+		return;
+	}
+	if (apr_pollset_remove(mPollset, poll) == APR_SUCCESS)
+	{
+		--mPollsetCount;
+	}
+	else
+	{
+		mRebuildPollset = true;
+	}
+}
+
 void LLPumpIO::processChain(LLChainInfo& chain)
 {
 	PUMP_DEBUG;
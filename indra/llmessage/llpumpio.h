@@ -180,6 +180,9 @@ public:
 	 * @brief Set up file descriptors for for the running chain.
 	 * @see rebuildPollset()
 	 *
+	 * The pollset is updated in place (one add and/or remove), and only
+	 * gets rebuilt when it is full or when an update failed.
+	 *
 	 * There is currently a limit of one conditional per pipe.
 	 * *NOTE: The internal mechanism for building a pollset based on
 	 * pipe/pollfd/chain generates an epoll error on linux (and
@@ -347,6 +350,9 @@ protected:
 	bool mRebuildPollset;
 	apr_pollset_t* mPollset;
 	S32 mPollsetClientID;
+	// Number of descriptors in mPollset, and how many it may hold
+	U32 mPollsetCount;
+	U32 mPollsetCapacity;
 	S32 mNextLock;
 	std::set<S32> mClearLocks;
 
@@ -419,6 +425,15 @@ protected:
 	 */
 	void rebuildPollset();
 
+	/** 
+	 * @brief Incremental pollset updates.
+	 *
+	 * These flag a full rebuild of the pollset on the next pump() when
+	 * they cannot update it in place (no or full pollset, APR error).
+	 */
+	void addToPollset(const apr_pollfd_t* poll);
+	void removeFromPollset(const apr_pollfd_t* poll);
+
 	/** 
 	 * @brief Process the chain passed in.
 	 *
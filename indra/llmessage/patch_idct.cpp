@@ -37,6 +37,10 @@
 #include "v3math.h"
 #include "patch_dct.h"
 
+// Set to 1 to compare the results of the vectorized IDCT with the ones of the
+// reference implementation, for each decoded patch.
+#define LL_PATCH_IDCT_CHECK 0
+
 LLGroupHeader	*gGOPP;
 
 void set_group_of_patch_header(LLGroupHeader *gopp)
@@ -59,7 +63,7 @@ void build_patch_dequantize_table(S32 size)
 
 S32	gCurrentDeSize = 0;
 
-F32	gPatchICosines[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE];
+LL_ALIGN_16(F32 gPatchICosines[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE]);
 
 void setup_patch_icosines(S32 size)
 {
@@ -152,453 +156,178 @@ void init_patch_decompressor(S32 size)
 	}
 }
 
-inline void idct_line(F32 *linein, F32 *lineout, S32 line)
+// Reference (scalar) IDCT of a patch, kept for the LL_PATCH_IDCT_CHECK mode
+// and for patch sizes other than 16 and 32.
+static void idct_patch_reference(F32 *block, S32 size)
 {
-	S32 n;
-	F32 total;
+	F32 temp[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE];
 	F32 *pcp = gPatchICosines;
+	F32 total;
+	S32 n, u, line, column;
 
-#ifdef _PATCH_SIZE_16_AND_32_ONLY
-	F32 oosob = 2.f/16.f;
-	S32	line_size = line*NORMAL_PATCH_SIZE;
-	F32 *tlinein, *tpcp;
-
-
-	for (n = 0; n < NORMAL_PATCH_SIZE; n++)
+	// Columns
+	for (column = 0; column < size; column++)
 	{
-		tpcp = pcp + n;
-		tlinein = linein + line_size;
-	
-		total = OO_SQRT2*(*(tlinein++));
-		total += *(tlinein++)*(*(tpcp += NORMAL_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += NORMAL_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += NORMAL_PATCH_SIZE));
-
-		total += *(tlinein++)*(*(tpcp += NORMAL_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += NORMAL_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += NORMAL_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += NORMAL_PATCH_SIZE));
-
-		total += *(tlinein++)*(*(tpcp += NORMAL_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += NORMAL_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += NORMAL_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += NORMAL_PATCH_SIZE));
-
-		total += *(tlinein++)*(*(tpcp += NORMAL_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += NORMAL_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += NORMAL_PATCH_SIZE));
-		total += *(tlinein)*(*(tpcp += NORMAL_PATCH_SIZE));
-
-		*(lineout + line_size + n) = total*oosob;
+		for (n = 0; n < size; n++)
+		{
+			total = OO_SQRT2*block[column];
+			for (u = 1; u < size; u++)
+			{
+				total += block[u*size + column]*pcp[u*size + n];
+			}
+			temp[size*n + column] = total;
+		}
 	}
-#else
+
+	// Lines
 	F32 oosob = 2.f/size;
-	S32	size = gGOPP->patch_size;
-	S32	line_size = line*size;
-	S32 u;
-	for (n = 0; n < size; n++)
+	for (line = 0; line < size; line++)
 	{
-		total = OO_SQRT2*linein[line_size];
-		for (u = 1; u < size; u++)
+		S32 line_size = line*size;
+		for (n = 0; n < size; n++)
 		{
-			total += linein[line_size + u]*pcp[u*size+n];
+			total = OO_SQRT2*temp[line_size];
+			for (u = 1; u < size; u++)
+			{
+				total += temp[line_size + u]*pcp[u*size + n];
+			}
+			block[line_size + n] = total*oosob;
 		}
-		lineout[line_size + n] = total*oosob;
 	}
-#endif
 }
 
-inline void idct_line_large_slow(F32 *linein, F32 *lineout, S32 line)
+// SSE2 IDCT of a SIZE x SIZE patch. Each pass computes 4 adjacent outputs at
+// once (they are contiguous, as are the coefficients of the columns pass and
+// the cosines of the lines pass for a given frequency), and the sums are done
+// in the same order as in idct_patch_reference(), so that the results are
+// identical. Only the first 'rows' lines and 'columns' columns of coefficients
+// may be non-zero: since the encoder stops at the last non-zero coefficient in
+// zig-zag order, most of the high frequencies are skipped this way (adding
+// the null products would not change the sums).
+template <S32 SIZE>
+static void idct_patch_simd(F32 *block, S32 rows, S32 columns)
 {
-	S32 n;
-	F32 total;
-	F32 *pcp = gPatchICosines;
-
-	F32 oosob = 2.f/32.f;
-	S32	line_size = line*LARGE_PATCH_SIZE;
-	F32 *tlinein, *tpcp;
-
-
-	for (n = 0; n < LARGE_PATCH_SIZE; n++)
+	const S32 VECTORS = SIZE/4;
+	LL_ALIGN_16(F32 temp[SIZE*SIZE]);
+	const __m128 oo_sqrt2 = _mm_set1_ps(OO_SQRT2);
+	__m128 total[VECTORS];
+	S32 n, u, i;
+
+	// Columns pass: temp[n][c] = OO_SQRT2*block[0][c] + sum(block[u][c]*cos[u][n])
+	for (n = 0; n < SIZE; n++)
 	{
-		tpcp = pcp + n;
-		tlinein = linein + line_size;
-	
-		total = OO_SQRT2*(*(tlinein++));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein)*(*(tpcp += LARGE_PATCH_SIZE));
-
-		*(lineout + line_size + n) = total*oosob;
+		for (i = 0; i < VECTORS; i++)
+		{
+			total[i] = _mm_mul_ps(oo_sqrt2, _mm_load_ps(block + 4*i));
+		}
+		for (u = 1; u < rows; u++)
+		{
+			const F32 *coeffs = block + u*SIZE;
+			const __m128 cosine = _mm_set1_ps(gPatchICosines[u*SIZE + n]);
+			for (i = 0; i < VECTORS; i++)
+			{
+				total[i] = _mm_add_ps(total[i],
+									  _mm_mul_ps(_mm_load_ps(coeffs + 4*i),
+												 cosine));
+			}
+		}
+		for (i = 0; i < VECTORS; i++)
+		{
+			_mm_store_ps(temp + n*SIZE + 4*i, total[i]);
+		}
 	}
-}
-
-// Nota Bene: assumes that coefficients beyond 128 are 0!
 
-void idct_line_large(F32 *linein, F32 *lineout, S32 line)
-{
-	S32 n;
-	F32 total;
-	F32 *pcp = gPatchICosines;
-
-	F32 oosob = 2.f/32.f;
-	S32	line_size = line*LARGE_PATCH_SIZE;
-	F32 *tlinein, *tpcp;
-	F32 *baselinein = linein + line_size;
-	F32 *baselineout = lineout + line_size;
-
-
-	for (n = 0; n < LARGE_PATCH_SIZE; n++)
+	// Lines pass: block[l][n] = (OO_SQRT2*temp[l][0] + sum(temp[l][u]*cos[u][n]))*oosob
+	const __m128 oosob = _mm_set1_ps(2.f/SIZE);
+	for (S32 line = 0; line < SIZE; line++)
 	{
-		tpcp = pcp++;
-		tlinein = baselinein;
-	
-		total = OO_SQRT2*(*(tlinein++));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein)*(*(tpcp));
-
-		*baselineout++ = total*oosob;
+		const F32 *coeffs = temp + line*SIZE;
+		const __m128 dc = _mm_mul_ps(oo_sqrt2, _mm_set1_ps(coeffs[0]));
+		for (i = 0; i < VECTORS; i++)
+		{
+			total[i] = dc;
+		}
+		for (u = 1; u < columns; u++)
+		{
+			const F32 *cosines = gPatchICosines + u*SIZE;
+			const __m128 coeff = _mm_set1_ps(coeffs[u]);
+			for (i = 0; i < VECTORS; i++)
+			{
+				total[i] = _mm_add_ps(total[i],
+									  _mm_mul_ps(coeff,
+												 _mm_load_ps(cosines + 4*i)));
+			}
+		}
+		F32 *out = block + line*SIZE;
+		for (i = 0; i < VECTORS; i++)
+		{
+			_mm_store_ps(out + 4*i, _mm_mul_ps(total[i], oosob));
+		}
 	}
 }
 
-inline void idct_column(F32 *linein, F32 *lineout, S32 column)
+// Dequantizes the coefficients of a patch into block (which must be 16 bytes
+// aligned) and transforms them back.
+static void decompress_block(F32 *block, S32 *cpatch, S32 size)
 {
-	S32 n;
-	F32 total;
-	F32 *pcp = gPatchICosines;
-
-#ifdef _PATCH_SIZE_16_AND_32_ONLY
-	F32 *tlinein, *tpcp;
-
-	for (n = 0; n < NORMAL_PATCH_SIZE; n++)
-	{
-		tpcp = pcp + n;
-		tlinein = linein + column;
-
-		total = OO_SQRT2*(*tlinein);
-		total += *(tlinein += NORMAL_PATCH_SIZE)*(*(tpcp += NORMAL_PATCH_SIZE));
-		total += *(tlinein += NORMAL_PATCH_SIZE)*(*(tpcp += NORMAL_PATCH_SIZE));
-		total += *(tlinein += NORMAL_PATCH_SIZE)*(*(tpcp += NORMAL_PATCH_SIZE));
-
-		total += *(tlinein += NORMAL_PATCH_SIZE)*(*(tpcp += NORMAL_PATCH_SIZE));
-		total += *(tlinein += NORMAL_PATCH_SIZE)*(*(tpcp += NORMAL_PATCH_SIZE));
-		total += *(tlinein += NORMAL_PATCH_SIZE)*(*(tpcp += NORMAL_PATCH_SIZE));
-		total += *(tlinein += NORMAL_PATCH_SIZE)*(*(tpcp += NORMAL_PATCH_SIZE));
-
-		total += *(tlinein += NORMAL_PATCH_SIZE)*(*(tpcp += NORMAL_PATCH_SIZE));
-		total += *(tlinein += NORMAL_PATCH_SIZE)*(*(tpcp += NORMAL_PATCH_SIZE));
-		total += *(tlinein += NORMAL_PATCH_SIZE)*(*(tpcp += NORMAL_PATCH_SIZE));
-		total += *(tlinein += NORMAL_PATCH_SIZE)*(*(tpcp += NORMAL_PATCH_SIZE));
-
-		total += *(tlinein += NORMAL_PATCH_SIZE)*(*(tpcp += NORMAL_PATCH_SIZE));
-		total += *(tlinein += NORMAL_PATCH_SIZE)*(*(tpcp += NORMAL_PATCH_SIZE));
-		total += *(tlinein += NORMAL_PATCH_SIZE)*(*(tpcp += NORMAL_PATCH_SIZE));
-		total += *(tlinein += NORMAL_PATCH_SIZE)*(*(tpcp += NORMAL_PATCH_SIZE));
-
-		*(lineout + (n<<4) + column) = total;
-	}
-
-#else
-	S32	size = gGOPP->patch_size;
-	S32 u;
-	S32 u_size;
+	F32     *dq = gPatchDequantizeTable;
+	S32		*decopy_matrix = gDeCopyMatrix;
 
-	for (n = 0; n < size; n++)
+	// Also find the extent of the non-zero coefficients
+	S32 rows = 1;
+	S32 columns = 1;
+	for (S32 j = 0; j < size; j++)
 	{
-		total = OO_SQRT2*linein[column];
-		for (u = 1; u < size; u++)
+		for (S32 i = 0; i < size; i++)
 		{
-			u_size = u*size;
-			total += linein[u_size + column]*pcp[u_size+n];
+			F32 coeff = *(cpatch + *(decopy_matrix++))*(*dq++);
+			*(block++) = coeff;
+			if (coeff != 0.f)
+			{
+				rows = llmax(rows, j + 1);
+				columns = llmax(columns, i + 1);
+			}
 		}
-		lineout[size*n + column] = total;
 	}
-#endif
-}
-
-inline void idct_column_large_slow(F32 *linein, F32 *lineout, S32 column)
-{
-	S32 n;
-	F32 total;
-	F32 *pcp = gPatchICosines;
+	block -= size*size;
 
-	F32 *tlinein, *tpcp;
+#if LL_PATCH_IDCT_CHECK
+	F32 ref_block[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE];
+	memcpy(ref_block, block, size*size*sizeof(F32));
+	idct_patch_reference(ref_block, size);
+#endif
 
-	for (n = 0; n < LARGE_PATCH_SIZE; n++)
+	if (size == NORMAL_PATCH_SIZE)
 	{
-		tpcp = pcp + n;
-		tlinein = linein + column;
-
-		total = OO_SQRT2*(*tlinein);
-		total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-
-		total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-
-		total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-
-		total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-
-		total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-
-		total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-
-		total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-
-		total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-
-		*(lineout + (n<<5) + column) = total;
+		idct_patch_simd<NORMAL_PATCH_SIZE>(block, rows, columns);
 	}
-}
-
-// Nota Bene: assumes that coefficients beyond 128 are 0!
-
-void idct_column_large(F32 *linein, F32 *lineout, S32 column)
-{
-	S32 n, m;
-	F32 total;
-	F32 *pcp = gPatchICosines;
-
-	F32 *tlinein, *tpcp;
-	F32 *baselinein = linein + column;
-	F32 *baselineout = lineout + column;
-
-	for (n = 0; n < LARGE_PATCH_SIZE; n++)
+	else if (size == LARGE_PATCH_SIZE)
 	{
-		tpcp = pcp++;
-		tlinein = baselinein;
-
-		total = OO_SQRT2*(*tlinein);
-		for (m = 1; m < NORMAL_PATCH_SIZE; m++)
-			total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-
-		*(baselineout + (n<<5)) = total;
+		idct_patch_simd<LARGE_PATCH_SIZE>(block, rows, columns);
 	}
-}
-
-inline void idct_patch(F32 *block)
-{
-	F32 temp[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE];
-
-#ifdef _PATCH_SIZE_16_AND_32_ONLY
-	idct_column(block, temp, 0);	
-	idct_column(block, temp, 1);	
-	idct_column(block, temp, 2);	
-	idct_column(block, temp, 3);	
-
-	idct_column(block, temp, 4);	
-	idct_column(block, temp, 5);	
-	idct_column(block, temp, 6);	
-	idct_column(block, temp, 7);	
-
-	idct_column(block, temp, 8);	
-	idct_column(block, temp, 9);	
-	idct_column(block, temp, 10);	
-	idct_column(block, temp, 11);	
-
-	idct_column(block, temp, 12);	
-	idct_column(block, temp, 13);	
-	idct_column(block, temp, 14);	
-	idct_column(block, temp, 15);	
-
-	idct_line(temp, block, 0);	
-	idct_line(temp, block, 1);	
-	idct_line(temp, block, 2);	
-	idct_line(temp, block, 3);	
-
-	idct_line(temp, block, 4);	
-	idct_line(temp, block, 5);	
-	idct_line(temp, block, 6);	
-	idct_line(temp, block, 7);	
-
-	idct_line(temp, block, 8);	
-	idct_line(temp, block, 9);	
-	idct_line(temp, block, 10);	
-	idct_line(temp, block, 11);	
-
-	idct_line(temp, block, 12);	
-	idct_line(temp, block, 13);	
-	idct_line(temp, block, 14);	
-	idct_line(temp, block, 15);	
-#else
-	S32 i;
-	S32	size = gGOPP->patch_size;
-	for (i = 0; i < size; i++)
+	else
 	{
-		idct_column(block, temp, i);	
+		idct_patch_reference(block, size);
 	}
-	for (i = 0; i < size; i++)
+
+#if LL_PATCH_IDCT_CHECK
+	if (memcmp(ref_block, block, size*size*sizeof(F32)))
 	{
-		idct_line(temp, block, i);	
+		llwarns << "Patch IDCT mismatch for size " << size << " (" << rows
+				<< " rows and " << columns << " columns of coefficients)"
+				<< llendl;
 	}
 #endif
 }
 
-inline void idct_patch_large(F32 *block)
-{
-	F32 temp[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE];
-
-	idct_column_large_slow(block, temp, 0);	
-	idct_column_large_slow(block, temp, 1);	
-	idct_column_large_slow(block, temp, 2);	
-	idct_column_large_slow(block, temp, 3);	
-
-	idct_column_large_slow(block, temp, 4);	
-	idct_column_large_slow(block, temp, 5);	
-	idct_column_large_slow(block, temp, 6);	
-	idct_column_large_slow(block, temp, 7);	
-
-	idct_column_large_slow(block, temp, 8);	
-	idct_column_large_slow(block, temp, 9);	
-	idct_column_large_slow(block, temp, 10);	
-	idct_column_large_slow(block, temp, 11);	
-
-	idct_column_large_slow(block, temp, 12);	
-	idct_column_large_slow(block, temp, 13);	
-	idct_column_large_slow(block, temp, 14);	
-	idct_column_large_slow(block, temp, 15);	
-
-	idct_column_large_slow(block, temp, 16);	
-	idct_column_large_slow(block, temp, 17);	
-	idct_column_large_slow(block, temp, 18);	
-	idct_column_large_slow(block, temp, 19);	
-
-	idct_column_large_slow(block, temp, 20);	
-	idct_column_large_slow(block, temp, 21);	
-	idct_column_large_slow(block, temp, 22);	
-	idct_column_large_slow(block, temp, 23);	
-
-	idct_column_large_slow(block, temp, 24);	
-	idct_column_large_slow(block, temp, 25);	
-	idct_column_large_slow(block, temp, 26);	
-	idct_column_large_slow(block, temp, 27);	
-
-	idct_column_large_slow(block, temp, 28);	
-	idct_column_large_slow(block, temp, 29);	
-	idct_column_large_slow(block, temp, 30);	
-	idct_column_large_slow(block, temp, 31);	
-
-	idct_line_large_slow(temp, block, 0);	
-	idct_line_large_slow(temp, block, 1);	
-	idct_line_large_slow(temp, block, 2);	
-	idct_line_large_slow(temp, block, 3);	
-
-	idct_line_large_slow(temp, block, 4);	
-	idct_line_large_slow(temp, block, 5);	
-	idct_line_large_slow(temp, block, 6);	
-	idct_line_large_slow(temp, block, 7);	
-
-	idct_line_large_slow(temp, block, 8);	
-	idct_line_large_slow(temp, block, 9);	
-	idct_line_large_slow(temp, block, 10);	
-	idct_line_large_slow(temp, block, 11);	
-
-	idct_line_large_slow(temp, block, 12);	
-	idct_line_large_slow(temp, block, 13);	
-	idct_line_large_slow(temp, block, 14);	
-	idct_line_large_slow(temp, block, 15);	
-
-	idct_line_large_slow(temp, block, 16);	
-	idct_line_large_slow(temp, block, 17);	
-	idct_line_large_slow(temp, block, 18);	
-	idct_line_large_slow(temp, block, 19);	
-
-	idct_line_large_slow(temp, block, 20);	
-	idct_line_large_slow(temp, block, 21);	
-	idct_line_large_slow(temp, block, 22);	
-	idct_line_large_slow(temp, block, 23);	
-
-	idct_line_large_slow(temp, block, 24);	
-	idct_line_large_slow(temp, block, 25);	
-	idct_line_large_slow(temp, block, 26);	
-	idct_line_large_slow(temp, block, 27);	
-
-	idct_line_large_slow(temp, block, 28);	
-	idct_line_large_slow(temp, block, 29);	
-	idct_line_large_slow(temp, block, 30);	
-	idct_line_large_slow(temp, block, 31);	
-}
-
 S32	gDitherNoise = 128;
 
 void decompress_patch(F32 *patch, S32 *cpatch, LLPatchHeader *ph)
 {
 	S32		i, j;
 
-	F32		block[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE], *tblock = block;
+	LL_ALIGN_16(F32 block[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE]);
+	F32		*tblock;
 	F32		*tpatch;
 
 	LLGroupHeader	*gopp = gGOPP;
@@ -610,33 +339,27 @@ void decompress_patch(F32 *patch, S32 *cpatch, LLPatchHeader *ph)
 	S32		stride = gopp->stride;
 
 	F32		ooq = 1.f/(F32)quantize;
-	F32     *dq = gPatchDequantizeTable;
-	S32		*decopy_matrix = gDeCopyMatrix;
 
 	F32		mult = ooq*range;
 	F32		addval = mult*(F32)(1<<(prequant - 1))+hmin;
 
-	for (i = 0; i < size*size; i++)
-	{
-		*(tblock++) = *(cpatch + *(decopy_matrix++))*(*dq++);
-	}
-
-	if (size == 16)
-	{
-		idct_patch(block);
-	}
-	else
-	{
-		idct_patch_large(block);
-	}
+	decompress_block(block, cpatch, size);
 
+	const __m128 multv = _mm_set1_ps(mult);
+	const __m128 addv = _mm_set1_ps(addval);
 	for (j = 0; j < size; j++)
 	{
 		tpatch = patch + j*stride;
 		tblock = block + j*size;
-		for (i = 0; i < size; i++)
+		for (i = 0; i + 4 <= size; i += 4)
 		{
-			*(tpatch++) = *(tblock++)*mult+addval;
+			_mm_storeu_ps(tpatch + i,
+						  _mm_add_ps(_mm_mul_ps(_mm_load_ps(tblock + i), multv),
+									 addv));
+		}
+		for ( ; i < size; i++)
+		{
+			tpatch[i] = tblock[i]*mult+addval;
 		}
 	}
 }
@@ -646,7 +369,8 @@ void decompress_patchv(LLVector3 *v, S32 *cpatch, LLPatchHeader *ph)
 {
 	S32		i, j;
 
-	F32			block[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE], *tblock = block;
+	LL_ALIGN_16(F32 block[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE]);
+	F32		*tblock;
 	LLVector3	*tvec;
 
 	LLGroupHeader	*gopp = gGOPP;
@@ -658,24 +382,11 @@ void decompress_patchv(LLVector3 *v, S32 *cpatch, LLPatchHeader *ph)
 	S32		stride = gopp->stride;
 
 	F32		ooq = 1.f/(F32)quantize;
-	F32     *dq = gPatchDequantizeTable;
-	S32		*decopy_matrix = gDeCopyMatrix;
 
 	F32		mult = ooq*range;
 	F32		addval = mult*(F32)(1<<(prequant - 1))+hmin;
 
-//	BOOL	b_diag = FALSE;
-//	BOOL	b_right = TRUE;
-
-	for (i = 0; i < size*size; i++)
-	{
-		*(tblock++) = *(cpatch + *(decopy_matrix++))*(*dq++);
-	}
-
-	if (size == 16)
-		idct_patch(block);
-	else
-		idct_patch_large(block);
+	decompress_block(block, cpatch, size);
 
 	for (j = 0; j < size; j++)
 	{
@@ -687,4 +398,3 @@ void decompress_patchv(LLVector3 *v, S32 *cpatch, LLPatchHeader *ph)
 		}
 	}
 }
-
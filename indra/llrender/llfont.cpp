@@ -140,6 +140,12 @@ LLFont::LLFont()
 	mFallbackFontp = NULL;
 	mIsFallback = FALSE;
 	mFTFace = NULL;
+	mHasKerning = FALSE;
+
+	for (S32 i = 0; i < GLYPH_PAGES; ++i)
+	{
+		mGlyphInfoPages[i] = NULL;
+	}
 
 	mRenderGlyphCount = 0;
 	mAddGlyphCount = 0;
@@ -157,6 +163,19 @@ LLFont::~LLFont()
 	mFTFace = NULL;
 
 	// Delete glyph info
+	for (S32 i = 0; i < GLYPH_PAGES; ++i)
+	{
+		LLFontGlyphInfo** page = mGlyphInfoPages[i];
+		if (page)
+		{
+			for (S32 j = 0; j < GLYPH_PAGE_SIZE; ++j)
+			{
+				delete page[j];
+			}
+			delete[] page;
+			mGlyphInfoPages[i] = NULL;
+		}
+	}
 	std::for_each(mCharGlyphInfoMap.begin(), mCharGlyphInfoMap.end(),
 				  DeletePairedPointer());
 
@@ -228,6 +247,7 @@ BOOL LLFont::loadFace(const std::string& filename, const F32 point_size,
 	mAscender = mFTFace->ascender * pixels_per_unit;
 	mDescender = -mFTFace->descender * pixels_per_unit;
 	mLineHeight = mFTFace->height * pixels_per_unit;
+	mHasKerning = FT_HAS_KERNING(mFTFace) ? TRUE : FALSE;
 
 	S32 max_char_width = llround(0.5f + x_max - x_min);
 	S32 max_char_height = llround(0.5f + y_max - y_min);
@@ -255,13 +275,28 @@ BOOL LLFont::loadFace(const std::string& filename, const F32 point_size,
 void LLFont::resetBitmapCache()
 {
 	// Iterate through glyphs and clear the mIsRendered flag
+	//FIXME: clearing mMetricsValid is only strictly necessary when resetting
+	//the entire font, not just flushing the bitmap
+	for (S32 i = 0; i < GLYPH_PAGES; ++i)
+	{
+		LLFontGlyphInfo** page = mGlyphInfoPages[i];
+		if (!page) continue;
+
+		for (S32 j = 0; j < GLYPH_PAGE_SIZE; ++j)
+		{
+			LLFontGlyphInfo* gi = page[j];
+			if (gi)
+			{
+				gi->mIsRendered = FALSE;
+				gi->mMetricsValid = FALSE;
+			}
+		}
+	}
 	for (char_glyph_info_map_t::iterator iter = mCharGlyphInfoMap.begin(),
 										 end = mCharGlyphInfoMap.end();
 		 iter != end; ++iter)
 	{
 		iter->second->mIsRendered = FALSE;
-		//FIXME: this is only strictly necessary when resetting the entire font,
-		//not just flushing the bitmap
 		iter->second->mMetricsValid = FALSE;
 	}
 	mFontBitmapCachep->reset();
@@ -278,16 +313,6 @@ void LLFont::resetBitmapCache()
 	}
 }
 
-LLFontGlyphInfo* LLFont::getGlyphInfo(const llwchar wch) const
-{
-	char_glyph_info_map_t::iterator iter = mCharGlyphInfoMap.find(wch);
-	if (iter != mCharGlyphInfoMap.end())
-	{
-		return iter->second;
-	}
-	return NULL;
-}
-
 BOOL LLFont::hasGlyph(const llwchar wch) const
 {
 	llassert(!mIsFallback);
@@ -334,8 +359,8 @@ BOOL LLFont::addChar(const llwchar wch) const
 		}
 	}
 
-	char_glyph_info_map_t::iterator iter = mCharGlyphInfoMap.find(wch);
-	if (iter == mCharGlyphInfoMap.end() || !(iter->second->mIsRendered))
+	const LLFontGlyphInfo* gi = getGlyphInfo(wch);
+	if (!gi || !gi->mIsRendered)
 	{
 		BOOL result = addGlyph(wch, glyph_index);
 		return result;
@@ -345,6 +370,26 @@ BOOL LLFont::addChar(const llwchar wch) const
 
 void LLFont::insertGlyphInfo(llwchar wch, LLFontGlyphInfo* gi) const
 {
+	if (wch < BMP_CHARS)
+	{
+		LLFontGlyphInfo**& page = mGlyphInfoPages[wch >> GLYPH_PAGE_BITS];
+		if (!page)
+		{
+			page = new LLFontGlyphInfo*[GLYPH_PAGE_SIZE];
+			for (S32 i = 0; i < GLYPH_PAGE_SIZE; ++i)
+			{
+				page[i] = NULL;
+			}
+		}
+		LLFontGlyphInfo*& entry = page[wch & GLYPH_PAGE_MASK];
+		if (entry != gi)
+		{
+			delete entry;
+			entry = gi;
+		}
+		return;
+	}
+
 	char_glyph_info_map_t::iterator iter = mCharGlyphInfoMap.find(wch);
 	if (iter != mCharGlyphInfoMap.end())
 	{
@@ -499,23 +544,23 @@ F32 LLFont::getXAdvance(const llwchar wch) const
 
 	if (glyph_index)
 	{
-		// This font has this glyph
-		fontp->renderGlyph(glyph_index);
+		// This font has this glyph. We only need its metrics here: there is
+		// no need to rasterize it (which is by far the most expensive part),
+		// and the bitmap will only be made (and uploaded to GL) when the
+		// glyph actually gets rendered, via addChar().
+		fontp->loadGlyphMetrics(glyph_index);
 
 		// Create the entry if it's not there
-		char_glyph_info_map_t::iterator iter2 = mCharGlyphInfoMap.find(wch);
-		if (iter2 == mCharGlyphInfoMap.end())
+		if (!gi)
 		{
 			gi = new LLFontGlyphInfo(glyph_index);
 			insertGlyphInfo(wch, gi);
 		}
-		else
-		{
-			gi = iter2->second;
-		}
 
-		gi->mWidth = fontp->mFTFace->glyph->bitmap.width;
-		gi->mHeight = fontp->mFTFace->glyph->bitmap.rows;
+		// Bitmap size estimate from the outline metrics: the exact values
+		// will be set when the glyph gets rendered.
+		gi->mWidth = (fontp->mFTFace->glyph->metrics.width + 63) >> 6;
+		gi->mHeight = (fontp->mFTFace->glyph->metrics.height + 63) >> 6;
 
 		// Convert these from 26.6 units to float pixels.
 		gi->mXAdvance = fontp->mFTFace->glyph->advance.x / 64.f;
@@ -525,7 +570,7 @@ F32 LLFont::getXAdvance(const llwchar wch) const
 	}
 	else
 	{
-		gi = get_if_there(mCharGlyphInfoMap, (llwchar)0, (LLFontGlyphInfo*)NULL);
+		gi = getGlyphInfo(0);
 		if (gi)
 		{
 			return gi->mXAdvance;
@@ -551,16 +596,25 @@ void LLFont::renderGlyph(const U32 glyph_index) const
 	llassert(!error);
 }
 
-F32 LLFont::getXKerning(const llwchar char_left, const llwchar char_right) const
+void LLFont::loadGlyphMetrics(const U32 glyph_index) const
 {
 	if (mFTFace == NULL)
+		return;
+
+	int error = FT_Load_Glyph(mFTFace, glyph_index, FT_LOAD_DEFAULT);
+	llassert(!error);
+}
+
+F32 LLFont::getXKerning(const llwchar char_left, const llwchar char_right) const
+{
+	if (mFTFace == NULL || !mHasKerning)
 		return 0.0;
 
 	llassert(!mIsFallback);
-	LLFontGlyphInfo* left_glyph_info = get_if_there(mCharGlyphInfoMap, char_left, (LLFontGlyphInfo*)NULL);
+	LLFontGlyphInfo* left_glyph_info = getGlyphInfo(char_left);
 	U32 left_glyph = left_glyph_info ? left_glyph_info->mGlyphIndex : 0;
 	// Kern this puppy.
-	LLFontGlyphInfo* right_glyph_info = get_if_there(mCharGlyphInfoMap, char_right, (LLFontGlyphInfo*)NULL);
+	LLFontGlyphInfo* right_glyph_info = getGlyphInfo(char_right);
 	U32 right_glyph = right_glyph_info ? right_glyph_info->mGlyphIndex : 0;
 
 	FT_Vector  delta;
@@ -159,10 +159,24 @@ protected:
 	virtual BOOL addGlyph(const llwchar wch, const U32 glyph_index) const;	// Add a new glyph to the existing font
 	virtual BOOL addGlyphFromFont(const LLFont *fontp, const llwchar wch, const U32 glyph_index) const;	// Add a glyph from this font to the other (returns the glyph_index, 0 if not found)
 
-	virtual LLFontGlyphInfo* getGlyphInfo(const llwchar wch) const;
+	// Returns the cached glyph info for wch, or NULL when not yet known.
+	// Characters of the Basic Multilingual Plane are looked up in a direct-
+	// indexed table; the (rare) others in mCharGlyphInfoMap.
+	inline LLFontGlyphInfo* getGlyphInfo(const llwchar wch) const
+	{
+		if (wch < BMP_CHARS)
+		{
+			LLFontGlyphInfo** page = mGlyphInfoPages[wch >> GLYPH_PAGE_BITS];
+			return page ? page[wch & GLYPH_PAGE_MASK] : NULL;
+		}
+		char_glyph_info_map_t::const_iterator iter = mCharGlyphInfoMap.find(wch);
+		return iter != mCharGlyphInfoMap.end() ? iter->second : NULL;
+	}
 
 	void insertGlyphInfo(llwchar wch, LLFontGlyphInfo* gi) const;
 	void renderGlyph(const U32 glyph_index) const;
+	// Loads the glyph metrics only, without rasterizing it
+	void loadGlyphMetrics(const U32 glyph_index) const;
 
 	void resetBitmapCache();
 
@@ -180,8 +194,26 @@ protected:
 	BOOL mIsFallback;
 	LLFontList *mFallbackFontp; // A list of fallback fonts to look for glyphs in (for Unicode chars)
 
+	// Information about glyph location in bitmap. The BMP table is split
+	// into 256 characters pages allocated on demand, so that a font only
+	// used for Latin text costs a couple of pages instead of a 64K entries
+	// table.
+	enum
+	{
+		BMP_CHARS = 0x10000,
+		GLYPH_PAGE_BITS = 8,
+		GLYPH_PAGE_SIZE = 1 << GLYPH_PAGE_BITS,
+		GLYPH_PAGE_MASK = GLYPH_PAGE_SIZE - 1,
+		GLYPH_PAGES = BMP_CHARS >> GLYPH_PAGE_BITS
+	};
+	mutable LLFontGlyphInfo** mGlyphInfoPages[GLYPH_PAGES];
+	// Glyph info for the characters outside of the BMP
 	typedef std::map<llwchar, LLFontGlyphInfo*> char_glyph_info_map_t;
-	mutable char_glyph_info_map_t mCharGlyphInfoMap; // Information about glyph location in bitmap
+	mutable char_glyph_info_map_t mCharGlyphInfoMap;
+
+	// FALSE when the face got no kerning table, so that we can skip the
+	// FT_Get_Kerning() calls altogether.
+	BOOL mHasKerning;
 
 	BOOL mValid;
 	void setSubImageLuminanceAlpha(const U32 x,
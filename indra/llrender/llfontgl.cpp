@@ -41,7 +41,10 @@
 #include "llgl.h"
 #include "llrender.h"
 #include "llstl.h"
+#include "lltimer.h"
+#include "v3math.h"
 #include "v4color.h"
+#include "v4coloru.h"
 
 const S32 BOLD_OFFSET = 1;
 
@@ -68,6 +71,29 @@ const F32 PIXEL_CORRECTION_DISTANCE = 0.01f;
 const F32 PAD_UVY = 0.5f; // half of vertical padding between glyphs in the glyph texture
 const F32 DROP_SHADOW_SOFT_STRENGTH = 0.3f;
 
+// Glyph quads are accumulated in a local vertex stream and sent to gGL in
+// one batch per texture change, instead of one begin()/end() per glyph.
+// 128 quads = 512 vertices: this keeps us well below the 4096 vertices
+// limit of LLRender's immediate mode buffer (which gets flushed by end()
+// once it holds more than 2048 vertices).
+const S32 GLYPH_BATCH_SIZE = 128;
+// Soft drop shadow needs 5 shadow quads plus the glyph quad
+const S32 MAX_QUADS_PER_GLYPH = 6;
+
+static void flush_glyph_batch(S32& quad_count, LLVector3* vertices,
+							  LLVector2* uvs, LLColor4U* colors)
+{
+	if (quad_count > 0)
+	{
+		gGL.begin(LLRender::QUADS);
+		{
+			gGL.vertexBatchPreTransformed(vertices, uvs, colors, quad_count * 4);
+		}
+		gGL.end();
+		quad_count = 0;
+	}
+}
+
 F32 llfont_round_x(F32 x)
 {
 	//return llfloor((x-LLFontGL::sCurOrigin.mX)/LLFontGL::sScaleX+0.5f)*LLFontGL::sScaleX+LLFontGL::sCurOrigin.mX;
@@ -515,6 +541,14 @@ S32 LLFontGL::render(const LLWString &wstr,
 	// Remember last-used texture to avoid unnecesssary bind calls.
 	LLImageGL *last_bound_texture = NULL;
 
+	LLColor4U text_color;
+	text_color.setVecScaleClamp(color);
+
+	S32 quad_count = 0;
+	LLVector3 vertices[GLYPH_BATCH_SIZE * 4];
+	LLVector2 uvs[GLYPH_BATCH_SIZE * 4];
+	LLColor4U colors[GLYPH_BATCH_SIZE * 4];
+
 	for (i = begin_offset; i < begin_offset + length; i++)
 	{
 		llwchar wch = wstr[i];
@@ -545,9 +579,14 @@ S32 LLFontGL::render(const LLWString &wstr,
 
 			if (last_bound_texture != ext_image)
 			{
+				flush_glyph_batch(quad_count, vertices, uvs, colors);
 				gGL.getTexUnit(0)->bind(ext_image);
 				last_bound_texture = ext_image;
 			}
+			else if (quad_count + MAX_QUADS_PER_GLYPH > GLYPH_BATCH_SIZE)
+			{
+				flush_glyph_batch(quad_count, vertices, uvs, colors);
+			}
 
 			// snap origin to whole screen pixel
 			const F32 ext_x = (F32)llround(cur_render_x + (EXT_X_BEARING * sScaleX));
@@ -555,10 +594,15 @@ S32 LLFontGL::render(const LLWString &wstr,
 
 			LLRectf uv_rect(0.f, 1.f, 1.f, 0.f);
 			LLRectf screen_rect(ext_x, ext_y + ext_height, ext_x + ext_width, ext_y);
-			drawGlyph(screen_rect, uv_rect, LLColor4::white, style, drop_shadow_strength);
+			drawGlyph(quad_count, vertices, uvs, colors, screen_rect, uv_rect,
+					  LLColor4U::white, style, drop_shadow_strength);
 
 			if (!label.empty())
 			{
+				// The label is rendered with another texture: send our
+				// pending quads first, and rebind afterwards.
+				flush_glyph_batch(quad_count, vertices, uvs, colors);
+				last_bound_texture = NULL;
 				gGL.pushMatrix();
 				//glLoadIdentity();
 				//gGL.translatef(sCurOrigin.mX, sCurOrigin.mY, 0.0f);
@@ -599,9 +643,14 @@ S32 LLFontGL::render(const LLWString &wstr,
 			LLImageGL *image_gl = mFontBitmapCachep->getImageGL(fgi->mBitmapNum);
 			if (last_bound_texture != image_gl)
 			{
+				flush_glyph_batch(quad_count, vertices, uvs, colors);
 				gGL.getTexUnit(0)->bind(image_gl);
 				last_bound_texture = image_gl;
 			}
+			else if (quad_count + MAX_QUADS_PER_GLYPH > GLYPH_BATCH_SIZE)
+			{
+				flush_glyph_batch(quad_count, vertices, uvs, colors);
+			}
 
 			if ((start_x + scaled_max_pixels) < (cur_x + fgi->mXBearing + fgi->mWidth))
 			{
@@ -621,7 +670,8 @@ S32 LLFontGL::render(const LLWString &wstr,
 					    llround(cur_render_x + (F32)fgi->mXBearing) + (F32)fgi->mWidth,
 					    llround(cur_render_y + (F32)fgi->mYBearing) - (F32)fgi->mHeight);
 			
-			drawGlyph(screen_rect, uv_rect, color, style, drop_shadow_strength);
+			drawGlyph(quad_count, vertices, uvs, colors, screen_rect, uv_rect,
+					  text_color, style, drop_shadow_strength);
 
 			chars_drawn++;
 			cur_x += fgi->mXAdvance;
@@ -650,6 +700,9 @@ S32 LLFontGL::render(const LLWString &wstr,
 		}
 	}
 
+	flush_glyph_batch(quad_count, vertices, uvs, colors);
+	gGL.color4fv(color.mV);
+
 	if (right_x)
 	{
 		*right_x = cur_x / sScaleX;
@@ -777,6 +830,56 @@ F32 LLFontGL::getWidthF32(const llwchar* wchars, const S32 begin_offset, const S
 
 
 
+#if LL_FONT_GL_BENCHMARK
+//static
+void LLFontGL::benchmark()
+{
+	const S32 WIDTH_LOOPS = 100;
+	const S32 RENDER_LOOPS = 20;
+
+	LLFontGL* font = getFontSansSerif();
+	if (!font)
+	{
+		return;
+	}
+
+	const LLWString sentence = utf8str_to_wstring(std::string("The quick brown fox jumps over the lazy dog. Voix ambigu\xc3\xab d'un c\xc5\x93ur qui au z\xc3\xa9phyr pr\xc3\xa9f\xc3\xa8re les jattes de kiwis. "));
+	LLWString text;
+	while (text.size() < 64 * 1024)
+	{
+		text += sentence;
+	}
+
+	LLTimer timer;
+	F32 width = 0.f;
+	for (S32 i = 0; i < WIDTH_LOOPS; ++i)
+	{
+		width += font->getWidthF32(text.c_str());
+	}
+	F32 width_time = timer.getElapsedTimeF32() / (F32)WIDTH_LOOPS;
+
+	// Render the string in small chunks, the way the UI does it
+	const S32 chunk = 128;
+	timer.reset();
+	for (S32 i = 0; i < RENDER_LOOPS; ++i)
+	{
+		for (S32 offset = 0; offset < (S32)text.size(); offset += chunk)
+		{
+			font->render(text, offset, 0.f, 0.f, LLColor4::white, LEFT,
+						 BASELINE, NORMAL, chunk);
+		}
+	}
+	gGL.flush();
+	glFinish();
+	F32 render_time = timer.getElapsedTimeF32() / (F32)RENDER_LOOPS;
+
+	llinfos << "Font benchmark: " << text.size() << " characters ("
+			<< width / (F32)WIDTH_LOOPS << " pixels wide) - getWidth: "
+			<< width_time * 1000.f << "ms - render: " << render_time * 1000.f
+			<< "ms" << llendl;
+}
+#endif
+
 // Returns the max number of complete characters from text (up to max_chars) that can be drawn in max_pixels
 S32 LLFontGL::maxDrawableChars(const llwchar* wchars, F32 max_pixels, S32 max_chars,
 							   BOOL end_on_word_boundary, const BOOL use_embedded,
@@ -1097,97 +1200,119 @@ void LLFontGL::removeEmbeddedChar( llwchar wc ) const
 }
 
 
-void LLFontGL::renderQuad(const LLRectf& screen_rect, const LLRectf& uv_rect, F32 slant_amt) const
+void LLFontGL::renderQuad(LLVector3* vertex_out, LLVector2* uv_out,
+						  LLColor4U* colors_out, const LLRectf& screen_rect,
+						  const LLRectf& uv_rect, const LLColor4U& color,
+						  F32 slant_amt) const
 {
-	gGL.texCoord2f(uv_rect.mRight, uv_rect.mTop);
-	gGL.vertex2f(llfont_round_x(screen_rect.mRight), 
-				llfont_round_y(screen_rect.mTop));
-
-	gGL.texCoord2f(uv_rect.mLeft, uv_rect.mTop);
-	gGL.vertex2f(llfont_round_x(screen_rect.mLeft), 
-				llfont_round_y(screen_rect.mTop));
-
-	gGL.texCoord2f(uv_rect.mLeft, uv_rect.mBottom);
-	gGL.vertex2f(llfont_round_x(screen_rect.mLeft + slant_amt), 
-				llfont_round_y(screen_rect.mBottom));
-
-	gGL.texCoord2f(uv_rect.mRight, uv_rect.mBottom);
-	gGL.vertex2f(llfont_round_x(screen_rect.mRight + slant_amt), 
-				llfont_round_y(screen_rect.mBottom));
+	S32 index = 0;
+
+	vertex_out[index].set(llfont_round_x(screen_rect.mRight),
+						  llfont_round_y(screen_rect.mTop), 0.f);
+	uv_out[index].set(uv_rect.mRight, uv_rect.mTop);
+	colors_out[index++] = color;
+
+	vertex_out[index].set(llfont_round_x(screen_rect.mLeft),
+						  llfont_round_y(screen_rect.mTop), 0.f);
+	uv_out[index].set(uv_rect.mLeft, uv_rect.mTop);
+	colors_out[index++] = color;
+
+	vertex_out[index].set(llfont_round_x(screen_rect.mLeft + slant_amt),
+						  llfont_round_y(screen_rect.mBottom), 0.f);
+	uv_out[index].set(uv_rect.mLeft, uv_rect.mBottom);
+	colors_out[index++] = color;
+
+	vertex_out[index].set(llfont_round_x(screen_rect.mRight + slant_amt),
+						  llfont_round_y(screen_rect.mBottom), 0.f);
+	uv_out[index].set(uv_rect.mRight, uv_rect.mBottom);
+	colors_out[index] = color;
 }
 
-void LLFontGL::drawGlyph(const LLRectf& screen_rect, const LLRectf& uv_rect, const LLColor4& color, U8 style, F32 drop_shadow_strength) const
+void LLFontGL::drawGlyph(S32& quad_count, LLVector3* vertex_out,
+						 LLVector2* uv_out, LLColor4U* colors_out,
+						 const LLRectf& screen_rect, const LLRectf& uv_rect,
+						 const LLColor4U& color, U8 style,
+						 F32 drop_shadow_strength) const
 {
 	F32 slant_offset;
 	slant_offset = ((style & ITALIC) ? ( -mAscender * 0.2f) : 0.f);
 
-	gGL.begin(LLRender::QUADS);
+	//FIXME: bold and drop shadow are mutually exclusive only for convenience
+	//Allow both when we need them.
+	if (style & BOLD)
 	{
-		//FIXME: bold and drop shadow are mutually exclusive only for convenience
-		//Allow both when we need them.
-		if (style & BOLD)
+		for (S32 pass = 0; pass < 2; pass++)
 		{
-			gGL.color4fv(color.mV);
-			for (S32 pass = 0; pass < 2; pass++)
-			{
-				LLRectf screen_rect_offset = screen_rect;
+			LLRectf screen_rect_offset = screen_rect;
 
-				screen_rect_offset.translate((F32)(pass * BOLD_OFFSET), 0.f);
-				renderQuad(screen_rect_offset, uv_rect, slant_offset);
-			}
+			screen_rect_offset.translate((F32)(pass * BOLD_OFFSET), 0.f);
+			renderQuad(&vertex_out[quad_count * 4], &uv_out[quad_count * 4],
+					   &colors_out[quad_count * 4], screen_rect_offset,
+					   uv_rect, color, slant_offset);
+			quad_count++;
 		}
-		else if (style & DROP_SHADOW_SOFT)
+	}
+	else if (style & DROP_SHADOW_SOFT)
+	{
+		LLColor4U shadow_color;
+		shadow_color.setVecScaleClamp(LLFontGL::sShadowColor);
+		shadow_color.mV[VALPHA] = U8(color.mV[VALPHA] * drop_shadow_strength * DROP_SHADOW_SOFT_STRENGTH);
+		for (S32 pass = 0; pass < 5; pass++)
 		{
-			LLColor4 shadow_color = LLFontGL::sShadowColor;
-			shadow_color.mV[VALPHA] = color.mV[VALPHA] * drop_shadow_strength * DROP_SHADOW_SOFT_STRENGTH;
-			gGL.color4fv(shadow_color.mV);
-			for (S32 pass = 0; pass < 5; pass++)
-			{
-				LLRectf screen_rect_offset = screen_rect;
+			LLRectf screen_rect_offset = screen_rect;
 
-				switch(pass)
-				{
-				case 0:
-					screen_rect_offset.translate(-1.f, -1.f);
-					break;
-				case 1:
-					screen_rect_offset.translate(1.f, -1.f);
-					break;
-				case 2:
-					screen_rect_offset.translate(1.f, 1.f);
-					break;
-				case 3:
-					screen_rect_offset.translate(-1.f, 1.f);
-					break;
-				case 4:
-					screen_rect_offset.translate(0, -2.f);
-					break;
-				}
-			
-				renderQuad(screen_rect_offset, uv_rect, slant_offset);
+			switch(pass)
+			{
+			case 0:
+				screen_rect_offset.translate(-1.f, -1.f);
+				break;
+			case 1:
+				screen_rect_offset.translate(1.f, -1.f);
+				break;
+			case 2:
+				screen_rect_offset.translate(1.f, 1.f);
+				break;
+			case 3:
+				screen_rect_offset.translate(-1.f, 1.f);
+				break;
+			case 4:
+				screen_rect_offset.translate(0, -2.f);
+				break;
 			}
-			gGL.color4fv(color.mV);
-			renderQuad(screen_rect, uv_rect, slant_offset);
-		}
-		else if (style & DROP_SHADOW)
-		{
-			LLColor4 shadow_color = LLFontGL::sShadowColor;
-			shadow_color.mV[VALPHA] = color.mV[VALPHA] * drop_shadow_strength;
-			gGL.color4fv(shadow_color.mV);
-			LLRectf screen_rect_shadow = screen_rect;
-			screen_rect_shadow.translate(1.f, -1.f);
-			renderQuad(screen_rect_shadow, uv_rect, slant_offset);
-			gGL.color4fv(color.mV);
-			renderQuad(screen_rect, uv_rect, slant_offset);
-		}
-		else // normal rendering
-		{
-			gGL.color4fv(color.mV);
-			renderQuad(screen_rect, uv_rect, slant_offset);
-		}
 
+			renderQuad(&vertex_out[quad_count * 4], &uv_out[quad_count * 4],
+					   &colors_out[quad_count * 4], screen_rect_offset,
+					   uv_rect, shadow_color, slant_offset);
+			quad_count++;
+		}
+		renderQuad(&vertex_out[quad_count * 4], &uv_out[quad_count * 4],
+				   &colors_out[quad_count * 4], screen_rect, uv_rect, color,
+				   slant_offset);
+		quad_count++;
+	}
+	else if (style & DROP_SHADOW)
+	{
+		LLColor4U shadow_color;
+		shadow_color.setVecScaleClamp(LLFontGL::sShadowColor);
+		shadow_color.mV[VALPHA] = U8(color.mV[VALPHA] * drop_shadow_strength);
+		LLRectf screen_rect_shadow = screen_rect;
+		screen_rect_shadow.translate(1.f, -1.f);
+		renderQuad(&vertex_out[quad_count * 4], &uv_out[quad_count * 4],
+				   &colors_out[quad_count * 4], screen_rect_shadow, uv_rect,
+				   shadow_color, slant_offset);
+		quad_count++;
+		renderQuad(&vertex_out[quad_count * 4], &uv_out[quad_count * 4],
+				   &colors_out[quad_count * 4], screen_rect, uv_rect, color,
+				   slant_offset);
+		quad_count++;
+	}
+	else // normal rendering
+	{
+		renderQuad(&vertex_out[quad_count * 4], &uv_out[quad_count * 4],
+				   &colors_out[quad_count * 4], screen_rect, uv_rect, color,
+				   slant_offset);
+		quad_count++;
 	}
-	gGL.end();
 }
 
 std::string LLFontGL::nameFromFont(const LLFontGL* fontp)
@@ -43,7 +43,13 @@
 #include "lltexture.h"
 #include "v2math.h"
 
+// Set to 1 to time the width measurement and rendering of long strings at
+// viewer startup.
+#define LL_FONT_GL_BENCHMARK 0
+
 class LLColor4;
+class LLColor4U;
+class LLVector3;
 
 // Key used to request a font.
 class LLFontDescriptor;
@@ -210,6 +216,11 @@ public:
 
 	static void setFontDisplay(BOOL flag) { sDisplayFont = flag; }
 
+#if LL_FONT_GL_BENCHMARK
+	// Times getWidth() and render() on long strings. Needs a GL context.
+	static void benchmark();
+#endif
+
 protected:
 	struct embedded_data_t
 	{
@@ -220,8 +231,16 @@ protected:
 	const embedded_data_t* getEmbeddedCharData(const llwchar wch) const;
 	F32 getEmbeddedCharAdvance(const embedded_data_t* ext_data) const;
 	void clearEmbeddedChars();
-	void renderQuad(const LLRectf& screen_rect, const LLRectf& uv_rect, F32 slant_amt) const;
-	void drawGlyph(const LLRectf& screen_rect, const LLRectf& uv_rect, const LLColor4& color, U8 style, F32 drop_shadow_fade) const;
+	// These append the glyph quad(s) to the vertex stream of the string being
+	// rendered; drawGlyph() increments quad_count accordingly (by up to 6).
+	void renderQuad(LLVector3* vertex_out, LLVector2* uv_out,
+					LLColor4U* colors_out, const LLRectf& screen_rect,
+					const LLRectf& uv_rect, const LLColor4U& color,
+					F32 slant_amt) const;
+	void drawGlyph(S32& quad_count, LLVector3* vertex_out, LLVector2* uv_out,
+				   LLColor4U* colors_out, const LLRectf& screen_rect,
+				   const LLRectf& uv_rect, const LLColor4U& color, U8 style,
+				   F32 drop_shadow_fade) const;
 
 public:
 	static F32 sVertDPI;
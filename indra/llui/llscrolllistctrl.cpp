@@ -589,6 +589,9 @@ LLScrollListCtrl::LLScrollListCtrl(const std::string& name,
 	mCanSelect(TRUE),
 	mDisplayColumnHeaders(FALSE),
 	mColumnsDirty(FALSE),
+	mIDIndexDirty(false),
+	mFirstColumnSorted(true),
+	mContentWidthsDirty(true),
 	mMaxItemCount(INT_MAX),
 	mMaxContentWidth(0),
 	mBackgroundVisible(TRUE),
@@ -713,6 +716,10 @@ void LLScrollListCtrl::clearRows()
 	std::for_each(mItemList.begin(), mItemList.end(), DeletePointer());
 	mItemList.clear();
 	//mItemCount = 0;
+	mIDIndex.clear();
+	mIDIndexDirty = false;
+	mFirstColumnSorted = true;
+	mContentWidthsDirty = true;
 
 	// Scroll the bar back up to the top.
 	mScrollbar->setDocParams(0, 0);
@@ -834,23 +841,33 @@ std::vector<LLScrollListItem*> LLScrollListCtrl::getAllData() const
 	return ret;
 }
 
-// returns first matching item
-LLScrollListItem* LLScrollListCtrl::getItem(const LLSD& sd) const
+std::vector<LLScrollListItem*> LLScrollListCtrl::getAllDataByID(const LLUUID& id) const
 {
-	std::string string_val = sd.asString();
-
-	for (item_list::const_iterator iter = mItemList.begin(),
+	std::vector<LLScrollListItem*> ret;
+	S32 index = getIDIndex(id);
+	if (index < 0)
+	{
+		return ret;
+	}
+	for (item_list::const_iterator iter = mItemList.begin() + index,
 								   end = mItemList.end();
 		 iter != end; ++iter)
 	{
 		LLScrollListItem* item  = *iter;
-		// assumes string representation is good enough for comparison
-		if (item->getValue().asString() == string_val)
+		if (item->getUUID() == id)
 		{
-			return item;
+			ret.push_back(item);
 		}
 	}
-	return NULL;
+	return ret;
+}
+
+// returns first matching item
+LLScrollListItem* LLScrollListCtrl::getItem(const LLSD& sd) const
+{
+	// assumes string representation is good enough for comparison
+	S32 index = getValueIndex(sd.asString(), false);
+	return index >= 0 ? mItemList[index] : NULL;
 }
 
 void LLScrollListCtrl::reshape(S32 width, S32 height, BOOL called_from_parent)
@@ -884,7 +901,7 @@ void LLScrollListCtrl::updateLayout()
 	mScrollbar->setDocSize(getItemCount());
 	mScrollbar->setVisible(scrollbar_visible);
 
-	dirtyColumns();
+	dirtyLayout();
 }
 
 // Attempt to size the control to show all items.
@@ -916,6 +933,8 @@ BOOL LLScrollListCtrl::addItem(LLScrollListItem* item, EAddPosition pos,
 		{
 			case ADD_TOP:
 				mItemList.push_front(item);
+				mIDIndexDirty = true;
+				mFirstColumnSorted = false;
 				setSorted(FALSE);
 				break;
 
@@ -924,10 +943,35 @@ BOOL LLScrollListCtrl::addItem(LLScrollListItem* item, EAddPosition pos,
 				// sort by column 0, in ascending order
 				std::vector<sort_column_t> single_sort_column;
 				single_sort_column.push_back(std::make_pair(0, TRUE));
+				SortScrollListItem comparator(single_sort_column);
 
-				mItemList.push_back(item);
-				std::stable_sort(mItemList.begin(), mItemList.end(),
-								 SortScrollListItem(single_sort_column));
+				bool inserted = false;
+				if (mFirstColumnSorted)
+				{
+					// Insert after the equivalent rows, like the stable sort
+					// below would do, but in O(log(n)) comparisons
+					item_list::iterator it = std::upper_bound(mItemList.begin(),
+															  mItemList.end(),
+															  item,
+															  comparator);
+					// Cells may have been edited in place without our
+					// knowledge: make sure the insertion point neighbours
+					// are actually in order, else do a full sort.
+					if ((it == mItemList.begin() || !comparator(item, *(it - 1))) &&
+						(it == mItemList.end() || !comparator(*it, item)))
+					{
+						mItemList.insert(it, item);
+						inserted = true;
+					}
+				}
+				if (!inserted)
+				{
+					mItemList.push_back(item);
+					std::stable_sort(mItemList.begin(), mItemList.end(),
+									 comparator);
+					mFirstColumnSorted = true;
+				}
+				mIDIndexDirty = true;
 
 				// ADD_SORTED just sorts by first column...
 				// this might not match user sort criteria, so flag list as
@@ -937,13 +981,18 @@ BOOL LLScrollListCtrl::addItem(LLScrollListItem* item, EAddPosition pos,
 			}
 
 			case ADD_BOTTOM:
-				mItemList.push_back(item);
-				setSorted(FALSE);
-				break;
-
 			default:
-				llassert(0);
+				llassert(pos == ADD_BOTTOM);
 				mItemList.push_back(item);
+				if (!mIDIndexDirty)
+				{
+					LLUUID id = item->getUUID();
+					if (!mIDIndex.count(id))
+					{
+						mIDIndex[id] = mItemList.size() - 1;
+					}
+				}
+				mFirstColumnSorted = mItemList.size() == 1;
 				setSorted(FALSE);
 				break;
 		}
@@ -959,6 +1008,7 @@ BOOL LLScrollListCtrl::addItem(LLScrollListItem* item, EAddPosition pos,
 		}
 
 		updateLineHeightInsert(item);
+		updateContentWidthsInsert(item);
 
 		updateLayout();
 	}
@@ -966,14 +1016,40 @@ BOOL LLScrollListCtrl::addItem(LLScrollListItem* item, EAddPosition pos,
 	return not_too_big;
 }
 
-// NOTE: This is *very* expensive for large lists, especially when we are
-// dirtying the list every frame while receiving a long list of names.
-// *TODO: Use bookkeeping to make this an incremental cost with item additions
-void LLScrollListCtrl::calcColumnWidths()
+static const S32 HEADING_TEXT_PADDING = 25;
+static const S32 COLUMN_TEXT_PADDING = 10;
+
+// Grows the columns content widths to fit the cells of a new or modified row,
+// so that calcColumnWidths() does not need to scan all the rows again.
+void LLScrollListCtrl::updateContentWidthsInsert(LLScrollListItem* itemp)
 {
-	const S32 HEADING_TEXT_PADDING = 25;
-	const S32 COLUMN_TEXT_PADDING = 10;
+	if (mContentWidthsDirty)
+	{
+		// Full rescan pending anyway
+		return;
+	}
+
+	const LLFontGL* font = LLFontGL::getFontSansSerifSmall();
+	for (ordered_columns_t::iterator column_itor = mColumnsIndexed.begin(),
+									 end = mColumnsIndexed.end();
+		 column_itor != end; ++column_itor)
+	{
+		LLScrollListColumn* column = *column_itor;
+		if (!column) continue;
+
+		LLScrollListCell* cellp = itemp->getColumn(column->mIndex);
+		if (!cellp) continue;
 
+		column->mMaxContentWidth = llmax(font->getWidth(cellp->getValue().asString()) + mColumnPadding + COLUMN_TEXT_PADDING,
+										 column->mMaxContentWidth);
+	}
+}
+
+// NOTE: the content widths are only recomputed from all the items when
+// mContentWidthsDirty is set (i.e. after a removal or a change in the columns);
+// insertions are accounted for as they happen by updateContentWidthsInsert().
+void LLScrollListCtrl::calcColumnWidths()
+{
 	mMaxContentWidth = 0;
 
 	S32 max_item_width = 0;
@@ -998,24 +1074,29 @@ void LLScrollListCtrl::calcColumnWidths()
 
 		column->setWidth(new_width);
 
-		// update max content width for this column, by looking at all items
-		column->mMaxContentWidth = column->mHeader ? LLFontGL::getFontSansSerifSmall()->getWidth(column->mLabel) + mColumnPadding + HEADING_TEXT_PADDING
-												   : 0;
-		for (item_list::iterator iter = mItemList.begin(),
-								 end = mItemList.end();
-			 iter != end; ++iter)
+		if (mContentWidthsDirty)
 		{
-			LLScrollListCell* cellp = (*iter)->getColumn(column->mIndex);
-			if (!cellp) continue;
+			// update max content width for this column, by looking at all
+			// items
+			column->mMaxContentWidth = column->mHeader ? LLFontGL::getFontSansSerifSmall()->getWidth(column->mLabel) + mColumnPadding + HEADING_TEXT_PADDING
+													   : 0;
+			for (item_list::iterator iter = mItemList.begin(),
+									 end = mItemList.end();
+				 iter != end; ++iter)
+			{
+				LLScrollListCell* cellp = (*iter)->getColumn(column->mIndex);
+				if (!cellp) continue;
 
-			column->mMaxContentWidth = llmax(LLFontGL::getFontSansSerifSmall()->getWidth(cellp->getValue().asString()) + mColumnPadding + COLUMN_TEXT_PADDING,
-											 column->mMaxContentWidth);
+				column->mMaxContentWidth = llmax(LLFontGL::getFontSansSerifSmall()->getWidth(cellp->getValue().asString()) + mColumnPadding + COLUMN_TEXT_PADDING,
+												 column->mMaxContentWidth);
+			}
 		}
 
 		max_item_width += column->mMaxContentWidth;
 	}
 
 	mMaxContentWidth = max_item_width;
+	mContentWidthsDirty = false;
 }
 
 const S32 SCROLL_LIST_ROW_PAD = 2;
@@ -1200,6 +1281,7 @@ BOOL LLScrollListCtrl::selectItemRange(S32 first_index, S32 last_index)
 		if (!itemp)
 		{
 			iter = mItemList.erase(iter);
+			mIDIndexDirty = true;
 			continue;
 		}
 
@@ -1239,6 +1321,8 @@ void LLScrollListCtrl::swapWithNext(S32 index)
 	LLScrollListItem *cur_itemp = mItemList[index];
 	mItemList[index] = mItemList[index + 1];
 	mItemList[index + 1] = cur_itemp;
+	mIDIndexDirty = true;
+	mFirstColumnSorted = false;
 }
 
 void LLScrollListCtrl::swapWithPrevious(S32 index)
@@ -1251,6 +1335,8 @@ void LLScrollListCtrl::swapWithPrevious(S32 index)
 	LLScrollListItem *cur_itemp = mItemList[index];
 	mItemList[index] = mItemList[index - 1];
 	mItemList[index - 1] = cur_itemp;
+	mIDIndexDirty = true;
+	mFirstColumnSorted = false;
 }
 
 void LLScrollListCtrl::deleteSingleItem(S32 target_index)
@@ -1268,17 +1354,26 @@ void LLScrollListCtrl::deleteSingleItem(S32 target_index)
 	}
 	delete itemp;
 	mItemList.erase(mItemList.begin() + target_index);
+	mIDIndexDirty = true;
 	dirtyColumns();
 }
 
 //FIXME: refactor item deletion
 void LLScrollListCtrl::deleteItems(const LLSD& sd)
 {
+	std::string value = sd.asString();
+	S32 first = getValueIndex(value, false);
+	if (first < 0)
+	{
+		// Nothing to delete
+		return;
+	}
+
 	item_list::iterator iter;
-	for (iter = mItemList.begin(); iter < mItemList.end(); )
+	for (iter = mItemList.begin() + first; iter < mItemList.end(); )
 	{
 		LLScrollListItem* itemp = *iter;
-		if (itemp->getValue().asString() == sd.asString())
+		if (itemp->getValue().asString() == value)
 		{
 			if (itemp == mLastSelected)
 			{
@@ -1293,6 +1388,7 @@ void LLScrollListCtrl::deleteItems(const LLSD& sd)
 		}
 	}
 
+	mIDIndexDirty = true;
 	dirtyColumns();
 }
 
@@ -1313,6 +1409,7 @@ void LLScrollListCtrl::deleteSelectedItems()
 		}
 	}
 	mLastSelected = NULL;
+	mIDIndexDirty = true;
 	dirtyColumns();
 }
 
@@ -1355,15 +1452,66 @@ S32	LLScrollListCtrl::selectMultiple(LLDynamicArray<LLUUID> ids)
 	return count;
 }
 
-S32 LLScrollListCtrl::getItemIndex(LLScrollListItem* target_item) const
+S32 LLScrollListCtrl::getIDIndex(const LLUUID& id) const
+{
+	if (mIDIndexDirty)
+	{
+		mIDIndex.clear();
+		mIDIndex.reserve(mItemList.size());
+		S32 index = 0;
+		for (item_list::const_iterator iter = mItemList.begin(),
+									   end = mItemList.end();
+			 iter != end; ++iter)
+		{
+			LLUUID item_id = (*iter)->getUUID();
+			if (!mIDIndex.count(item_id))
+			{
+				mIDIndex[item_id] = index;
+			}
+			++index;
+		}
+		mIDIndexDirty = false;
+	}
+
+	id_index_t::const_iterator it = mIDIndex.find(id);
+	return it == mIDIndex.end() ? -1 : it->second;
+}
+
+S32 LLScrollListCtrl::getValueIndex(const std::string& value,
+									bool enabled_only) const
 {
+	// Rows keyed on a non-null UUID (avatars, groups, objects...) are found
+	// via the rows index. Any row matching 'value' as a string also matches
+	// its UUID, so a miss in the index means there is no such row. A hit only
+	// needs to be checked for the exact string (the UUID parsing is not case
+	// sensitive) and enabled state, before falling back to a scan.
+	if (LLUUID::validate(value))
+	{
+		LLUUID id(value);
+		if (id.notNull())
+		{
+			S32 index = getIDIndex(id);
+			if (index < 0)
+			{
+				return -1;
+			}
+			LLScrollListItem* itemp = mItemList[index];
+			if ((!enabled_only || itemp->getEnabled()) &&
+				itemp->getValue().asString() == value)
+			{
+				return index;
+			}
+		}
+	}
+
 	S32 index = 0;
 	for (item_list::const_iterator iter = mItemList.begin(),
 								   end = mItemList.end();
 		 iter != end; ++iter)
 	{
 		LLScrollListItem* itemp = *iter;
-		if (target_item == itemp)
+		if ((!enabled_only || itemp->getEnabled()) &&
+			itemp->getValue().asString() == value)
 		{
 			return index;
 		}
@@ -1372,15 +1520,32 @@ S32 LLScrollListCtrl::getItemIndex(LLScrollListItem* target_item) const
 	return -1;
 }
 
-S32 LLScrollListCtrl::getItemIndex(const LLUUID& target_id) const
+S32 LLScrollListCtrl::getItemIndex(LLScrollListItem* target_item) const
 {
-	S32 index = 0;
+	if (!target_item)
+	{
+		return -1;
+	}
+
+	// The index holds the first row with this UUID, which is our item unless
+	// several rows share the same UUID.
+	S32 index = getIDIndex(target_item->getUUID());
+	if (index < 0)
+	{
+		return -1;
+	}
+	if (mItemList[index] == target_item)
+	{
+		return index;
+	}
+
+	index = 0;
 	for (item_list::const_iterator iter = mItemList.begin(),
 								   end = mItemList.end();
 		 iter != end; ++iter)
 	{
 		LLScrollListItem* itemp = *iter;
-		if (target_id == itemp->getUUID())
+		if (target_item == itemp)
 		{
 			return index;
 		}
@@ -1389,6 +1554,11 @@ S32 LLScrollListCtrl::getItemIndex(const LLUUID& target_id) const
 	return -1;
 }
 
+S32 LLScrollListCtrl::getItemIndex(const LLUUID& target_id) const
+{
+	return getIDIndex(target_id);
+}
+
 void LLScrollListCtrl::selectPrevItem(BOOL extend_selection)
 {
 	LLScrollListItem* prev_item = NULL;
@@ -1699,24 +1869,19 @@ BOOL LLScrollListCtrl::setSelectedByValue(const LLSD& value, BOOL selected)
 
 	if (selected && !mAllowMultipleSelection) deselectAllItems(TRUE);
 
-	for (item_list::iterator iter = mItemList.begin(), end = mItemList.end();
-		 iter != end; ++iter)
+	S32 index = getValueIndex(value.asString(), true);
+	if (index >= 0)
 	{
-		LLScrollListItem* item = *iter;
-		if (item->getEnabled() &&
-			item->getValue().asString() == value.asString())
+		LLScrollListItem* item = mItemList[index];
+		if (selected)
 		{
-			if (selected)
-			{
-				selectItem(item);
-			}
-			else
-			{
-				deselectItem(item);
-			}
-			found = TRUE;
-			break;
+			selectItem(item);
+		}
+		else
+		{
+			deselectItem(item);
 		}
+		found = TRUE;
 	}
 
 	if (mCommitOnSelectionChange)
@@ -1729,17 +1894,8 @@ BOOL LLScrollListCtrl::setSelectedByValue(const LLSD& value, BOOL selected)
 
 BOOL LLScrollListCtrl::isSelected(const LLSD& value) const
 {
-	for (item_list::const_iterator iter = mItemList.begin(),
-								   end = mItemList.end();
-		 iter != end; ++iter)
-	{
-		LLScrollListItem* item = *iter;
-		if (item->getValue().asString() == value.asString())
-		{
-			return item->getSelected();
-		}
-	}
-	return FALSE;
+	S32 index = getValueIndex(value.asString(), false);
+	return index >= 0 && mItemList[index]->getSelected();
 }
 
 LLUUID LLScrollListCtrl::getStringUUIDSelectedItem() const
@@ -1796,11 +1952,14 @@ void LLScrollListCtrl::drawItems()
 												   LLUI::sTypeAheadTimeout, 0.4f,
 												   0.f);
 
-		for (item_list::iterator iter = mItemList.begin(),
-								 end = mItemList.end();
-			 iter != end; ++iter)
+		// Only visit the rows that are actually visible: this keeps the
+		// drawing cost independent of the number of rows in the list.
+		S32 first_line = llclamp(mScrollLines, 0, (S32)mItemList.size());
+		S32 last_line = llmin(mScrollLines + num_page_lines,
+							  (S32)mItemList.size());
+		for (line = first_line; line < last_line; ++line)
 		{
-			LLScrollListItem* item = *iter;
+			LLScrollListItem* item = mItemList[line];
 
 			item_rect.setOriginAndSize(x, cur_y, mItemListRect.getWidth(),
 									   mLineHeight);
@@ -1814,42 +1973,36 @@ void LLScrollListCtrl::drawItems()
 
 			max_columns = llmax(max_columns, item->getNumColumns());
 
-			LLColor4 fg_color;
 			LLColor4 bg_color(LLColor4::transparent);
-
-			if (mScrollLines <= line && line < mScrollLines + num_page_lines)
+			LLColor4 fg_color = item->getEnabled() ? mFgUnselectedColor
+												   : mFgDisabledColor;
+			if (item->getSelected() && mCanSelect)
 			{
-				fg_color = item->getEnabled() ? mFgUnselectedColor
+				bg_color = mBgSelectedColor;
+				fg_color = item->getEnabled() ? mFgSelectedColor
 											  : mFgDisabledColor;
-				if (item->getSelected() && mCanSelect)
-				{
-					bg_color = mBgSelectedColor;
-					fg_color = item->getEnabled() ? mFgSelectedColor
-												  : mFgDisabledColor;
-				}
-				else if (mHighlightedItem == line && mCanSelect)
-				{
-					bg_color = mHighlightedColor;
-				}
-				else
+			}
+			else if (mHighlightedItem == line && mCanSelect)
+			{
+				bg_color = mHighlightedColor;
+			}
+			else
+			{
+				if (mDrawStripes && line % 2 == 0 /*&& max_columns > 1*/)
 				{
-					if (mDrawStripes && line % 2 == 0 /*&& max_columns > 1*/)
-					{
-						bg_color = mBgStripeColor;
-					}
+					bg_color = mBgStripeColor;
 				}
+			}
 
-				if (!item->getEnabled())
-				{
-					bg_color = mBgReadOnlyColor;
-				}
+			if (!item->getEnabled())
+			{
+				bg_color = mBgReadOnlyColor;
+			}
 
-				item->draw(item_rect, fg_color, bg_color, highlight_color,
-						   mColumnPadding);
+			item->draw(item_rect, fg_color, bg_color, highlight_color,
+					   mColumnPadding);
 
-				cur_y -= mLineHeight;
-			}
-			++line;
+			cur_y -= mLineHeight;
 		}
 	}
 }
@@ -2706,6 +2859,8 @@ void LLScrollListCtrl::sortItems()
 	// do stable sort to preserve any previous sorts
 	std::stable_sort(mItemList.begin(), mItemList.end(),
 					 SortScrollListItem(mSortColumns));
+	mIDIndexDirty = true;
+	mFirstColumnSorted = false;
 	setSorted(TRUE);
 }
 
@@ -2718,9 +2873,29 @@ void LLScrollListCtrl::sortOnce(S32 column, BOOL ascending)
 	// do stable sort to preserve any previous sorts
 	std::stable_sort(mItemList.begin(), mItemList.end(),
 					 SortScrollListItem(sort_column));
+	mIDIndexDirty = true;
+	mFirstColumnSorted = false;
 }
 
 void LLScrollListCtrl::dirtyColumns()
+{
+	mContentWidthsDirty = true;
+	// Cells may have been edited in place
+	mFirstColumnSorted = false;
+	dirtyLayout();
+}
+
+void LLScrollListCtrl::dirtyItemColumns(LLScrollListItem* itemp)
+{
+	if (itemp)
+	{
+		updateContentWidthsInsert(itemp);
+	}
+	mFirstColumnSorted = false;
+	dirtyLayout();
+}
+
+void LLScrollListCtrl::dirtyLayout()
 {
 	mColumnsDirty = TRUE;
 
@@ -3319,6 +3494,7 @@ void LLScrollListCtrl::setColumnLabel(const std::string& column,
 		if (itor->second.mHeader)
 		{
 			itor->second.mHeader->setLabel(label);
+			dirtyColumns();
 		}
 	}
 }
@@ -3641,6 +3817,83 @@ void LLScrollListCtrl::onFocusLost()
 	LLUICtrl::onFocusLost();
 }
 
+#if LL_SCROLL_LIST_BENCHMARK
+// Times the operations done by the avatar, area search or group members lists
+// on a list of 'row_count' rows. The columns are recomputed every 100 added
+// rows, to simulate the draw() calls happening while the rows are received.
+//static
+void LLScrollListCtrl::benchmark(S32 row_count)
+{
+	LLScrollListCtrl* list = new LLScrollListCtrl("benchmark",
+												  LLRect(0, 400, 400, 0),
+												  NULL, NULL, TRUE);
+	LLSD column;
+	column["name"] = "name";
+	column["dynamicwidth"] = TRUE;
+	list->addColumn(column);
+
+	std::vector<LLUUID> ids(row_count);
+	for (S32 i = 0; i < row_count; ++i)
+	{
+		ids[i].generate();
+	}
+
+	LLTimer timer;
+	LLSD row;
+	for (S32 i = 0; i < row_count; ++i)
+	{
+		row["id"] = ids[i];
+		row["columns"][0]["column"] = "name";
+		row["columns"][0]["value"] = llformat("Row %d", i);
+		list->addElement(row);
+		if (i % 100 == 0)
+		{
+			list->updateColumns();
+		}
+	}
+	F32 insert_time = timer.getElapsedTimeF32();
+
+	timer.reset();
+	S32 found = 0;
+	for (S32 i = 0; i < row_count; ++i)
+	{
+		LLScrollListItem* item = list->getItem(LLSD(ids[i]));
+		if (item && list->getItemIndex(item) >= 0)
+		{
+			LLScrollListCell* cell = item->getColumn(0);
+			cell->setValue(llformat("Updated row %d", i));
+			list->dirtyItemColumns(item);
+			++found;
+		}
+		if (i % 100 == 0)
+		{
+			list->updateColumns();
+		}
+	}
+	F32 update_time = timer.getElapsedTimeF32();
+
+	timer.reset();
+	list->sortByColumnIndex(0, TRUE);
+	F32 sort_time = timer.getElapsedTimeF32();
+
+	const S32 deletions = llmin(row_count, 1000);
+	timer.reset();
+	for (S32 i = 0; i < deletions; ++i)
+	{
+		list->deleteItems(LLSD(ids[i]));
+	}
+	F32 delete_time = timer.getElapsedTimeF32();
+
+	llinfos << "Scroll list benchmark with " << row_count << " rows: insert: "
+			<< insert_time * 1000.f << "ms - look-up and update (" << found
+			<< " rows found): " << update_time * 1000.f << "ms - sort: "
+			<< sort_time * 1000.f << "ms - " << deletions << " deletions: "
+			<< delete_time * 1000.f << "ms" << llendl;
+
+	delete list;
+}
+#endif
+
 LLColumnHeader::LLColumnHeader(const std::string& label,
 							   const LLRect &rect, LLScrollListColumn* column,
 							   const LLFontGL* fontp)
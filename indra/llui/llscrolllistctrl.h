@@ -49,6 +49,11 @@
 #include "llstring.h"
 #include "llui.h"
 #include "lluictrl.h"
+#include "lluuidflatmap.h"
+
+// Set to 1 to time the insertion, look-up, update and deletion of a large
+// number of rows at viewer startup.
+#define LL_SCROLL_LIST_BENCHMARK 0
 
 /*
  * Represents a cell in a scrollable table.
@@ -528,6 +533,8 @@ public:
 	LLScrollListItem*	getFirstData() const;
 	LLScrollListItem*	getLastData() const;
 	std::vector<LLScrollListItem*>	getAllData() const;
+	// Returns all the items whose getUUID() is 'id', in the list order.
+	std::vector<LLScrollListItem*>	getAllDataByID(const LLUUID& id) const;
 
 	LLScrollListItem*	getItem(const LLSD& sd) const;
 
@@ -639,6 +646,14 @@ public:
 	void			setSorted(BOOL sorted)				{ mSorted = sorted; }
 	// some operation has potentially affected column layout or ordering
 	void			dirtyColumns();
+	// Cheaper than dirtyColumns() when the only change is the contents of
+	// 'itemp' cells: the columns content widths are then only grown to fit
+	// them instead of being recomputed from all the rows.
+	void			dirtyItemColumns(LLScrollListItem* itemp);
+
+#if LL_SCROLL_LIST_BENCHMARK
+	static void		benchmark(S32 row_count);
+#endif
 
 protected:
 	// "Full" interface: use this when you're creating a list that has one or
@@ -663,7 +678,8 @@ protected:
 							BOOL requires_column = TRUE);
 
 	typedef std::deque<LLScrollListItem *> item_list;
-	item_list&		getItemList()						{ return mItemList; }
+	// Since the caller may reorder the rows, this dirties the rows index.
+	item_list&		getItemList()						{ mIDIndexDirty = true; return mItemList; }
 
 private:
 	void			selectPrevItem(BOOL extend_selection);
@@ -679,6 +695,16 @@ private:
 	void			commitIfChanged();
 	BOOL			setSort(S32 column, BOOL ascending);
 
+	// Returns the index of the first row whose getUUID() is 'id', or -1.
+	S32				getIDIndex(const LLUUID& id) const;
+	// Returns the index of the first (enabled when 'enabled_only' is true)
+	// row whose value matches 'value' as a string, or -1.
+	S32				getValueIndex(const std::string& value,
+								  bool enabled_only) const;
+	void			updateContentWidthsInsert(LLScrollListItem* itemp);
+	// Flags the columns layout for an update, without recomputing their
+	// content widths from all the rows.
+	void			dirtyLayout();
 
 	S32				mCurIndex;			// For get[First/Next]Data
 	S32				mCurSelectedIndex;  // For get[First/Next]Selected
@@ -701,6 +727,23 @@ private:
 
 	item_list		mItemList;
 
+	// Index of the first row holding each UUID: it is kept up to date on
+	// bottom insertions and lazily rebuilt after any other change to the
+	// rows order.
+	typedef LLUUIDFlatMap<S32> id_index_t;
+	mutable id_index_t	mIDIndex;
+	mutable bool	mIDIndexDirty;
+
+	// true when the rows are sorted on their first column, so that ADD_SORTED
+	// insertions may be done with a binary search. Since cells may be edited
+	// in place without the list knowing about it, this is only a hint, and
+	// addItem() falls back to a full sort when it finds rows out of order.
+	bool			mFirstColumnSorted;
+
+	// true when the columns content widths must be recomputed from all the
+	// rows (i.e. after a row removal or a change in the columns).
+	bool			mContentWidthsDirty;
+
 	LLScrollListItem *mLastSelected;
 
 	S32				mMaxItemCount;
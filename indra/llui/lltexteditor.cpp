@@ -315,6 +315,9 @@ LLTextEditor::LLTextEditor(const std::string& name,
 	mMouseDownY(0),
 	mLastSelectionX(-1),
 	mLastSelectionY(-1),
+	mLayoutLength(0),
+	mReflowStartPos(0),
+	mReflowTailLength(0),
 	mReflowNeeded(FALSE),
 	mScrollNeeded(FALSE),
 	mParseHTML(FALSE),
@@ -409,6 +412,60 @@ LLTextEditor::~LLTextEditor()
 	LLView::deleteViewByHandle(mPopupMenuHandle);
 }
 
+#if LL_TEXT_EDITOR_BENCHMARK
+// Lays out a 1MB text, then appends colored lines to it and reflows after each
+// of them, like a chat history would do on new messages.
+//static
+void LLTextEditor::benchmark()
+{
+	const S32 APPENDS = 1000;
+	const S32 FULL_REFLOWS = 10;
+
+	LLTextEditor* editor = new LLTextEditor("benchmark",
+											LLRect(0, 400, 400, 0), S32_MAX,
+											LLStringUtil::null);
+	editor->setWordWrap(TRUE);
+
+	const std::string line = "The quick brown fox jumps over the lazy dog, over and over again.\n";
+	std::string text;
+	text.reserve(1024 * 1024 + line.size());
+	while (text.size() < 1024 * 1024)
+	{
+		text += line;
+	}
+	editor->setText(text);
+
+	LLTimer timer;
+	editor->updateLineStartList();
+	F32 layout_time = timer.getElapsedTimeF32();
+	S32 lines = editor->getLineCount();
+
+	timer.reset();
+	for (S32 i = 0; i < FULL_REFLOWS; ++i)
+	{
+		editor->appendColoredText(line, false, false, LLColor4::white);
+		editor->updateLineStartList();
+	}
+	F32 full_time = timer.getElapsedTimeF32() / (F32)FULL_REFLOWS;
+
+	timer.reset();
+	for (S32 i = 0; i < APPENDS; ++i)
+	{
+		editor->appendColoredText(line, false, false, LLColor4::white);
+		editor->updateLineStartList(editor->getLength());
+	}
+	F32 incremental_time = timer.getElapsedTimeF32() / (F32)APPENDS;
+
+	llinfos << "Text editor benchmark: initial layout of " << text.size()
+			<< " characters (" << lines << " lines): " << layout_time * 1000.f
+			<< "ms - append with full reflow: " << full_time * 1000.f
+			<< "ms - append with incremental reflow: "
+			<< incremental_time * 1000.f << "ms" << llendl;
+
+	delete editor;
+}
+#endif
+
 void LLTextEditor::context_selectall(void* data)
 {
 	LLTextEditor* line = (LLTextEditor*)data;
@@ -493,7 +550,7 @@ void LLTextEditor::spellReplace(SpellMenuBind* data)
 		LLWString clean_string = utf8str_to_wstring(data->mWord);
 		insert(data->mWordPositionStart, clean_string, FALSE);
 		mCursorPos += clean_string.length() - length;
-		needsReflow();
+		needsScroll();
 	}
 }
 
@@ -621,6 +678,20 @@ void LLTextEditor::setShadowColor(const LLColor4& color)
 
 void LLTextEditor::updateLineStartList(S32 startpos)
 {
+	S32 text_len = getLength();
+	// Number of characters at the end of the text left untouched since the
+	// last layout: when not flagged for reflow, assume a full reflow is
+	// wanted.
+	S32 unchanged_tail = 0;
+	if (mReflowNeeded)
+	{
+		startpos = llmin(startpos, mReflowStartPos);
+		unchanged_tail = llmin(mReflowTailLength, text_len, mLayoutLength);
+		mReflowNeeded = FALSE;
+	}
+	// Shift of the unchanged characters since the last layout
+	S32 delta = text_len - mLayoutLength;
+
 	updateSegments();
 
 	bindEmbeddedChars(mGLFont);
@@ -629,22 +700,114 @@ void LLTextEditor::updateLineStartList(S32 startpos)
 	S32 seg_idx = 0;
 	S32 seg_offset = 0;
 
+	// The line breaks depend on the segment boundaries, so the layout must
+	// also be redone from the first boundary which moved since the last one
+	// (keywords highlighting and appended text styles may change them) and
+	// up to the last boundary which did not just get shifted by the edits.
+	S32 old_seg_num = mLayoutSegments.size();
+	S32 converge_pos = text_len - unchanged_tail;
+	S32 i = seg_num - 1;
+	S32 j = old_seg_num - 1;
+	while (i >= 0 && j >= 0 &&
+		   mSegments[i]->getStart() == mLayoutSegments[j].first + delta &&
+		   mSegments[i]->getEnd() == mLayoutSegments[j].second + delta)
+	{
+		--i;
+		--j;
+	}
+	if (i >= 0 && j >= 0)
+	{
+		if (mSegments[i]->getEnd() != mLayoutSegments[j].second + delta)
+		{
+			converge_pos = llmax(converge_pos, mSegments[i]->getEnd(),
+								 mLayoutSegments[j].second + delta);
+		}
+		else
+		{
+			converge_pos = llmax(converge_pos, mSegments[i]->getStart(),
+								 mLayoutSegments[j].first + delta);
+		}
+	}
+	else if (i >= 0)
+	{
+		converge_pos = llmax(converge_pos, mSegments[i]->getEnd());
+	}
+	else if (j >= 0)
+	{
+		converge_pos = llmax(converge_pos, mLayoutSegments[j].second + delta);
+	}
+
+	i = 0;
+	while (i < seg_num && i < old_seg_num &&
+		   mSegments[i]->getStart() == mLayoutSegments[i].first &&
+		   mSegments[i]->getEnd() == mLayoutSegments[i].second)
+	{
+		++i;
+	}
+	if (i < seg_num && i < old_seg_num)
+	{
+		if (mSegments[i]->getStart() != mLayoutSegments[i].first)
+		{
+			startpos = llmin(startpos, mSegments[i]->getStart(),
+							 mLayoutSegments[i].first);
+		}
+		else
+		{
+			startpos = llmin(startpos, mSegments[i]->getEnd(),
+							 mLayoutSegments[i].second);
+		}
+	}
+	else if (i < seg_num)
+	{
+		startpos = llmin(startpos, mSegments[i]->getStart());
+	}
+	else if (i < old_seg_num)
+	{
+		startpos = llmin(startpos, mLayoutSegments[i].first);
+	}
+
+	// Old line starts after the restart point, which the new layout may
+	// converge to.
+	line_list_t old_lines;
 	if (!mLineStartList.empty())
 	{
-		getSegmentAndOffset(startpos, &seg_idx, &seg_offset);
-		line_info t(seg_idx, seg_offset);
+		// Keep the lines before the one holding startpos. The previous line
+		// is wrapped again too, since the first word of the changed line may
+		// now fit at its end.
 		line_list_t::iterator iter = std::upper_bound(mLineStartList.begin(),
-													  mLineStartList.end(), t,
-													  line_info_compare());
+													  mLineStartList.end(),
+													  startpos);
+		if (iter != mLineStartList.begin()) --iter;
 		if (iter != mLineStartList.begin()) --iter;
-		seg_idx = iter->mSegment;
-		seg_offset = iter->mOffset;
+		getSegmentAndOffset(llmin(*iter, text_len), &seg_idx, &seg_offset);
+		if (unchanged_tail > 0)
+		{
+			old_lines.assign(iter + 1, mLineStartList.end());
+		}
 		mLineStartList.erase(iter, mLineStartList.end());
 	}
 
 	while (seg_idx < seg_num)
 	{
-		mLineStartList.push_back(line_info(seg_idx,seg_offset));
+		S32 line_start = mSegments[seg_idx]->getStart() + seg_offset;
+		if (line_start >= converge_pos && !old_lines.empty())
+		{
+			// Past the edits, a line starting where one used to start is laid
+			// out like it was, and so are the next ones: reuse them.
+			line_list_t::iterator iter = std::lower_bound(old_lines.begin(),
+														  old_lines.end(),
+														  line_start - delta);
+			if (iter != old_lines.end() && *iter == line_start - delta)
+			{
+				for (line_list_t::iterator end = old_lines.end();
+					 iter != end; ++iter)
+				{
+					mLineStartList.push_back(*iter + delta);
+				}
+				break;
+			}
+		}
+		mLineStartList.push_back(line_start);
 		BOOL line_ended = FALSE;
 		S32 start_x = mShowLineNumbers ? UI_TEXTEDITOR_LINE_NUMBER_MARGIN : 0;
 		S32 line_width = start_x;
@@ -710,6 +873,14 @@ void LLTextEditor::updateLineStartList(S32 startpos)
 
 	unbindEmbeddedChars(mGLFont);
 
+	mLayoutSegments.resize(seg_num);
+	for (i = 0; i < seg_num; ++i)
+	{
+		mLayoutSegments[i].first = mSegments[i]->getStart();
+		mLayoutSegments[i].second = mSegments[i]->getEnd();
+	}
+	mLayoutLength = text_len;
+
 	mScrollbar->setDocSize(getLineCount());
 
 	if (mHideScrollbarForShortDocs)
@@ -1039,15 +1210,12 @@ S32 LLTextEditor::getLineStart(S32 line) const
     }
 
 	line = llclamp(line, 0, num_lines-1);
-	S32 segidx = mLineStartList[line].mSegment;
-	S32 segoffset = mLineStartList[line].mOffset;
-	LLTextSegment* seg = mSegments[segidx];
-	S32 res = seg->getStart() + segoffset;
-	if (res > seg->getEnd())
+	S32 res = mLineStartList[line];
+	if (res > getLength())
 	{
 		llwarns << "Text length (" << res << ") greater than text end ("
-				<< seg->getEnd() << ")." << llendl;
-		res = seg->getEnd();
+				<< getLength() << ")." << llendl;
+		res = getLength();
 	}
 	return res;
 }
@@ -1063,18 +1231,12 @@ void LLTextEditor::getLineAndOffset(S32 startpos, S32* linep, S32* offsetp) cons
 	}
 	else
 	{
-		S32 seg_idx, seg_offset;
-		getSegmentAndOffset(startpos, &seg_idx, &seg_offset);
-
-		line_info tline(seg_idx, seg_offset);
 		line_list_t::const_iterator iter = std::upper_bound(mLineStartList.begin(),
 															mLineStartList.end(),
-															tline,
-															line_info_compare());
+															startpos);
 		if (iter != mLineStartList.begin()) --iter;
 		*linep = iter - mLineStartList.begin();
-		S32 line_start = mSegments[iter->mSegment]->getStart() + iter->mOffset;
-		*offsetp = startpos - line_start;
+		*offsetp = startpos - *iter;
 	}
 }
 
@@ -2341,7 +2503,7 @@ void LLTextEditor::cut()
 	gClipboard.copyFromSubstring(mWText, left_pos, length, mSourceID);
 	deleteSelection(FALSE);
 
-	needsReflow();
+	needsScroll();
 
 	if (mKeystrokeCallback)
 	{
@@ -2449,7 +2611,7 @@ void LLTextEditor::pasteHelper(bool is_primary)
 	setCursorPos(mCursorPos + insert(mCursorPos, clean_string, FALSE));
 	deselect();
 
-	needsReflow();
+	needsScroll();
 
 	if (mKeystrokeCallback)
 	{
@@ -2732,7 +2894,6 @@ BOOL LLTextEditor::handleKeyHere(KEY key, MASK mask)
 	BOOL handled = FALSE;
 	BOOL selection_modified = FALSE;
 	BOOL return_key_hit = FALSE;
-	BOOL text_may_have_changed = TRUE;
 
 	// Key presses are not being passed to the Popup menu.
 	// A proper fix is non-trivial so instead just close the menu.
@@ -2752,10 +2913,6 @@ BOOL LLTextEditor::handleKeyHere(KEY key, MASK mask)
 		}
 
 		handled = handleNavigationKey(key, mask);
-		if (handled)
-		{
-			text_may_have_changed = FALSE;
-		}
 
 		if (!handled)
 		{
@@ -2781,7 +2938,6 @@ BOOL LLTextEditor::handleKeyHere(KEY key, MASK mask)
 			if (handled)
 			{
 				selection_modified = TRUE;
-				text_may_have_changed = TRUE;
 			}
 		}
 
@@ -2807,7 +2963,6 @@ BOOL LLTextEditor::handleKeyHere(KEY key, MASK mask)
 				if (handled)
 				{
 					selection_modified = TRUE;
-					text_may_have_changed = TRUE;
 				}
 			}
 		}
@@ -2823,10 +2978,7 @@ BOOL LLTextEditor::handleKeyHere(KEY key, MASK mask)
 				deselect();
 			}
 
-			if (text_may_have_changed)
-			{
-				needsReflow();
-			}
+			// Any text change got flagged for reflow by the *NoUndo() methods
 			needsScroll();
 		}
 	}
@@ -2870,7 +3022,7 @@ BOOL LLTextEditor::handleUnicodeCharHere(llwchar uni_char)
 			// will.
 			deselect();
 
-			needsReflow();
+			needsScroll();
 		}
 	}
 
@@ -2927,7 +3079,7 @@ void LLTextEditor::doDelete()
 		}
 	}
 
-	needsReflow();
+	needsScroll();
 
 	if (mKeystrokeCallback)
 	{
@@ -2984,7 +3136,7 @@ void LLTextEditor::undo()
 	while (mLastCmd && mLastCmd->groupWithNext());
 
 	setCursorPos(pos);
-	needsReflow();
+	needsScroll();
 }
 
 BOOL LLTextEditor::canRedo() const
@@ -3034,7 +3186,7 @@ void LLTextEditor::redo()
 		   mLastCmd != mUndoStack.front());
 
 	setCursorPos(pos);
-	needsReflow();
+	needsScroll();
 }
 
 void LLTextEditor::onFocusReceived()
@@ -3917,8 +4069,7 @@ void LLTextEditor::draw()
 	// do on-demand reflow
 	if (mReflowNeeded)
 	{
-		updateLineStartList();
-		mReflowNeeded = FALSE;
+		updateLineStartList(mReflowStartPos);
 	}
 
 	// then update scroll position, as cursor may have moved
@@ -4344,7 +4495,7 @@ void LLTextEditor::insertText(const std::string &new_text)
 	setCursorPos(mCursorPos + insert(mCursorPos, utf8str_to_wstring(new_text),
 				 FALSE));
 
-	needsReflow();
+	needsScroll();
 
 	setEnabled(enabled);
 }
@@ -4514,7 +4665,7 @@ void LLTextEditor::appendText(const std::string &new_text, bool allow_undo,
 		mSegments.push_back(segment);
 	}
 
-	needsReflow();
+	needsScroll();
 
 	// Set the cursor and scroll position
 	// Maintain the scroll position unless the scroll was at the end of the doc
@@ -4566,8 +4717,9 @@ void LLTextEditor::removeTextFromEnd(S32 num_chars)
 
 	pruneSegments();
 
-	// pruneSegments will invalidate mLineStartList.
-	updateLineStartList();
+	// pruneSegments changed the last segment, which is taken into account
+	// by updateLineStartList().
+	updateLineStartList(len);
 	needsScroll();
 }
 
@@ -4587,6 +4739,12 @@ S32 LLTextEditor::insertStringNoUndo(const S32 pos, const LLWString &wstr)
 		// The user's not getting everything he's hoping for
 		make_ui_sound("UISndBadKeystroke");
 		insert_len = mWText.length() - old_len;
+		// The end of the text got cut
+		needsReflow(pos);
+	}
+	else
+	{
+		needsReflow(pos, old_len - pos);
 	}
 
 	return insert_len;
@@ -4596,6 +4754,7 @@ S32 LLTextEditor::removeStringNoUndo(S32 pos, S32 length)
 {
 	mWText.erase(pos, length);
 	mTextIsUpToDate = FALSE;
+	needsReflow(pos, mWText.length() - pos);
 	// This will be wrong if someone calls removeStringNoUndo with an excessive
 	// length
 	return -length;
@@ -4609,6 +4768,7 @@ S32 LLTextEditor::overwriteCharNoUndo(S32 pos, llwchar wc)
 	}
 	mWText[pos] = wc;
 	mTextIsUpToDate = FALSE;
+	needsReflow(pos, llmax(0, (S32)mWText.length() - pos - 1));
 	return 1;
 }
 
@@ -4670,7 +4830,7 @@ BOOL LLTextEditor::tryToRevertToPristineState()
 			}
 		}
 
-		needsReflow();
+		needsScroll();
 	}
 
 	return isPristine(); // TRUE => success
@@ -5454,7 +5614,7 @@ void LLTextEditor::updatePreedit(const LLWString &preedit_string,
 
 	mPreeditStandouts = preedit_standouts;
 
-	needsReflow();
+	needsScroll();
 	setCursorPos(insert_preedit_at + caret_position);
 
 	// Update of the preedit should be caused by some key strokes.
@@ -45,6 +45,10 @@
 
 #include "llpreeditor.h"
 
+// Set to 1 to time the full and incremental layouts of a large text at viewer
+// startup.
+#define LL_TEXT_EDITOR_BENCHMARK 0
+
 class LLFontGL;
 class LLScrollbar;
 class LLViewBorder;
@@ -72,6 +76,10 @@ public:
 
 	virtual ~LLTextEditor();
 
+#if LL_TEXT_EDITOR_BENCHMARK
+	static void benchmark();
+#endif
+
 	virtual LLXMLNodePtr getXML(bool save_children = true) const;
 	static LLView*	fromXML(LLXMLNodePtr node, LLView* parent,
 							class LLUICtrlFactory* factory);
@@ -349,6 +357,8 @@ protected:
 										S32* offsetp) const;
 	void			drawPreeditMarker();
 
+	// Wraps again the lines from the one before 'startpos' (or before any
+	// pending change or change in the segments, whichever comes first).
 	void			updateLineStartList(S32 startpos = 0);
 	void			updateScrollFromCursor();
 	void			updateTextRect();
@@ -555,9 +565,20 @@ private:
 									   S32 selection_left, S32 selection_right,
 									   const LLStyleSP& color, F32* right_x);
 
-	void			needsReflow() 
-	{ 
-		mReflowNeeded = TRUE; 
+	// Only the lines from the one before 'startpos' need to be wrapped again,
+	// and the wrapping may stop as soon as it reaches an unchanged line start
+	// in the last 'unchanged_tail' characters of the text.
+	void			needsReflow(S32 startpos = 0, S32 unchanged_tail = 0)
+	{
+		if (!mReflowNeeded || startpos < mReflowStartPos)
+		{
+			mReflowStartPos = startpos;
+		}
+		if (!mReflowNeeded || unchanged_tail < mReflowTailLength)
+		{
+			mReflowTailLength = unchanged_tail;
+		}
+		mReflowNeeded = TRUE;
 		// cursor might have moved, need to scroll
 		mScrollNeeded = TRUE;
 	}
@@ -609,41 +630,22 @@ private:
 
 	S32				mDesiredXPixel;			// X pixel position where the user wants the cursor to be
 	LLRect			mTextRect;				// The rect in which text is drawn. Excludes borders.
-	// List of offsets and segment index of the start of each line. Always has
-	// at least one node (0).
-	struct line_info
-	{
-		line_info(S32 segment, S32 offset)
-		:	mSegment(segment),
-			mOffset(offset)
-		{
-		}
-
-		S32 mSegment;
-		S32 mOffset;
-	};
-
-	struct line_info_compare
-	{
-		bool operator()(const line_info& a, const line_info& b) const
-		{
-			if (a.mSegment < b.mSegment)
-			{
-				return true;
-			}
-			else if (a.mSegment > b.mSegment)
-			{
-				return false;
-			}
-			else
-			{
-				return a.mOffset < b.mOffset;
-			}
-		}
-	};
-
-	typedef std::vector<line_info> line_list_t;
+	// Text offsets of the start of each line, in increasing order, so that
+	// the position to line mapping is a binary search. Always has at least one
+	// node (0) once laid out.
+	typedef std::vector<S32> line_list_t;
 	line_list_t		mLineStartList;
+	// Start and end offsets of the segments the lines were laid out with, so
+	// that updateLineStartList() can find the first one which changed.
+	typedef std::vector<std::pair<S32, S32> > segment_bounds_t;
+	segment_bounds_t mLayoutSegments;
+	// Text length at the last layout
+	S32				mLayoutLength;
+	// Lowest text offset changed since the last layout
+	S32				mReflowStartPos;
+	// Number of characters at the end of the text unchanged since the last
+	// layout
+	S32				mReflowTailLength;
 	BOOL			mReflowNeeded;
 	BOOL			mScrollNeeded;
 
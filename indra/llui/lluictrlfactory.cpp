@@ -75,6 +75,9 @@ const S32 FLOATER_H_MARGIN = 15;
 const S32 MIN_WIDGET_HEIGHT = 10;
 
 std::vector<std::string> LLUICtrlFactory::sXUIPaths;
+LLUICtrlFactory::xml_node_cache_t LLUICtrlFactory::sXMLNodeCache;
+U32 LLUICtrlFactory::sXMLNodeCacheHits = 0;
+U32 LLUICtrlFactory::sXMLNodeCacheMisses = 0;
 
 // UI Ctrl class for padding
 class LLUICtrlLocate : public LLUICtrl
@@ -138,6 +141,8 @@ void LLUICtrlFactory::setupPaths()
 	LLXMLNodePtr root;
 	BOOL success  = LLXMLNode::parseFile(filename, root, NULL);
 	sXUIPaths.clear();
+	// The cached trees depend on the paths
+	clearXMLNodeCache();
 
 	if (success)
 	{
@@ -175,9 +180,58 @@ const std::vector<std::string>& LLUICtrlFactory::getXUIPaths()
 //-----------------------------------------------------------------------------
 // getLayeredXMLNode()
 //-----------------------------------------------------------------------------
+// static
 bool LLUICtrlFactory::getLayeredXMLNode(const std::string& xui_filename,
-										LLXMLNodePtr& root)
+										LLXMLNodePtr& root, bool use_cache)
 {
+	use_cache = use_cache && LLUI::sConfigGroup &&
+				LLUI::sConfigGroup->getBOOL("XUICacheParsedFiles");
+	if (use_cache)
+	{
+		xml_node_cache_t::iterator it = sXMLNodeCache.find(xui_filename);
+		if (it != sXMLNodeCache.end())
+		{
+			++sXMLNodeCacheHits;
+			// The widgets may alter the tree they are built from, so never
+			// hand out the cached tree itself.
+			root = it->second->deepCopy();
+			return true;
+		}
+		++sXMLNodeCacheMisses;
+	}
+
+	bool cacheable = false;
+	if (!parseLayeredXMLNode(xui_filename, root, cacheable))
+	{
+		return false;
+	}
+
+	if (use_cache && cacheable)
+	{
+		sXMLNodeCache[xui_filename] = root->deepCopy();
+	}
+
+	return true;
+}
+
+// static
+void LLUICtrlFactory::clearXMLNodeCache()
+{
+	if (!sXMLNodeCache.empty())
+	{
+		LL_DEBUGS("XUICache") << "Flushing " << sXMLNodeCache.size()
+							  << " cached XUI trees. Hits: "
+							  << sXMLNodeCacheHits << " - Misses: "
+							  << sXMLNodeCacheMisses << LL_ENDL;
+		sXMLNodeCache.clear();
+	}
+}
+
+// static
+bool LLUICtrlFactory::parseLayeredXMLNode(const std::string& xui_filename,
+										  LLXMLNodePtr& root, bool& cacheable)
+{
+	cacheable = true;
 	std::string full_filename = gDirUtilp->findSkinnedFilename(sXUIPaths.front(),
 															   xui_filename);
 	if (full_filename.empty())
@@ -187,6 +241,8 @@ bool LLUICtrlFactory::getLayeredXMLNode(const std::string& xui_filename,
 		if (gDirUtilp->fileExists(xui_filename))
 		{
 			full_filename = xui_filename;
+			// User-supplied files may change between two loads
+			cacheable = false;
 		}
 		else
 		{
@@ -249,12 +305,14 @@ void LLUICtrlFactory::buildFloater(LLFloater* floaterp,
 								   const LLCallbackMap::map_t* factory_map,
 								   BOOL open) /* Flawfinder: ignore */
 {
+	LLTimer build_timer;
 	LLXMLNodePtr root;
 
-	if (!LLUICtrlFactory::getLayeredXMLNode(filename, root))
+	if (!LLUICtrlFactory::getLayeredXMLNode(filename, root, true))
 	{
 		return;
 	}
+	F32 tree_time = build_timer.getElapsedTimeF32();
 
 	// root must be called floater
 	if (!(root->hasName("floater") || root->hasName("multi_floater")))
@@ -283,6 +341,11 @@ void LLUICtrlFactory::buildFloater(LLFloater* floaterp,
 
 	LLHandle<LLFloater> handle = floaterp->getHandle();
 	mBuiltFloaters[handle] = filename;
+
+	LL_DEBUGS("XUICache") << "Built floater from " << filename << " in "
+						  << build_timer.getElapsedTimeF32() * 1000.f
+						  << "ms (XUI tree: " << tree_time * 1000.f << "ms)"
+						  << LL_ENDL;
 }
 
 //-----------------------------------------------------------------------------
@@ -313,13 +376,15 @@ S32 LLUICtrlFactory::saveToXML(LLView* viewp, const std::string& filename)
 BOOL LLUICtrlFactory::buildPanel(LLPanel* panelp, const std::string& filename,
 								 const LLCallbackMap::map_t* factory_map)
 {
+	LLTimer build_timer;
 	BOOL didPost = FALSE;
 	LLXMLNodePtr root;
 
-	if (!LLUICtrlFactory::getLayeredXMLNode(filename, root))
+	if (!LLUICtrlFactory::getLayeredXMLNode(filename, root, true))
 	{
 		return didPost;
 	}
+	F32 tree_time = build_timer.getElapsedTimeF32();
 
 	// root must be called panel
 	if (!root->hasName("panel"))
@@ -349,6 +414,11 @@ BOOL LLUICtrlFactory::buildPanel(LLPanel* panelp, const std::string& filename,
 		mFactoryStack.pop_front();
 	}
 
+	LL_DEBUGS("XUICache") << "Built panel from " << filename << " in "
+						  << build_timer.getElapsedTimeF32() * 1000.f
+						  << "ms (XUI tree: " << tree_time * 1000.f << "ms)"
+						  << LL_ENDL;
+
 	return didPost;
 }
 
@@ -433,6 +503,9 @@ LLPieMenu* LLUICtrlFactory::buildPieMenu(const std::string& filename,
 //-----------------------------------------------------------------------------
 void LLUICtrlFactory::rebuild()
 {
+	// Re-read the XUI files, since rebuilding is used to see their changes
+	clearXMLNodeCache();
+
 	built_panel_t::iterator built_panel_it;
 	for (built_panel_it = mBuiltPanels.begin();
 		 built_panel_it != mBuiltPanels.end(); ++built_panel_it)
@@ -78,13 +78,25 @@ public:
 	virtual LLView* createCtrlWidget(LLPanel *parent, LLXMLNodePtr node);
 	virtual LLView* createWidget(LLPanel *parent, LLXMLNodePtr node);
 
-	static bool getLayeredXMLNode(const std::string &filename, LLXMLNodePtr& root);
+	// Returns the parsed XUI file, merged with its localized versions. With
+	// 'use_cache' TRUE (floaters and panels, which get rebuilt each time they
+	// are opened), the merged tree is cached (see clearXMLNodeCache()) and a
+	// private copy of it, that the caller may modify, is returned.
+	static bool getLayeredXMLNode(const std::string &filename, LLXMLNodePtr& root,
+								  bool use_cache = false);
+
+	// Flushes the cached XUI trees. Called by setupPaths(), i.e. whenever the
+	// skin or language paths change.
+	static void clearXMLNodeCache();
 
 	static const std::vector<std::string>& getXUIPaths();
 
 private:
 	bool getLayeredXMLNodeImpl(const std::string &filename, LLXMLNodePtr& root);
 
+	static bool parseLayeredXMLNode(const std::string& xui_filename,
+									LLXMLNodePtr& root, bool& cacheable);
+
 	typedef std::map<LLHandle<LLPanel>, std::string> built_panel_t;
 	built_panel_t mBuiltPanels;
 
@@ -95,6 +107,11 @@ private:
 
 	static std::vector<std::string> sXUIPaths;
 
+	typedef std::map<std::string, LLXMLNodePtr> xml_node_cache_t;
+	static xml_node_cache_t sXMLNodeCache;
+	static U32 sXMLNodeCacheHits;
+	static U32 sXMLNodeCacheMisses;
+
 	LLPanel* mDummyPanel;
 };
 
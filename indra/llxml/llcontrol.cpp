@@ -145,7 +145,10 @@ LLControlVariable::LLControlVariable(const std::string& name, eControlType type,
 	mComment(comment),
 	mType(type),
 	mPersist(persist),
-	mHideFromSettingsEditor(hidefromsettingseditor)
+	mHideFromSettingsEditor(hidefromsettingseditor),
+	mIntValue(0),
+	mRealValue(0.f),
+	mLookupCount(0)
 {
 	if (mPersist && mComment.empty())
 	{
@@ -153,12 +156,33 @@ LLControlVariable::LLControlVariable(const std::string& name, eControlType type,
 	}
 	//Push back versus setValue'ing here, since we don't want to call a signal yet
 	mValues.push_back(initial);
+	updateNativeValue();
 }
 
 LLControlVariable::~LLControlVariable()
 {
 }
 
+void LLControlVariable::updateNativeValue()
+{
+	const LLSD& value = mValues.back();
+	switch (mType)
+	{
+	case TYPE_U32:
+	case TYPE_S32:
+		mIntValue = value.asInteger();
+		break;
+	case TYPE_BOOLEAN:
+		mIntValue = value.asBoolean() ? 1 : 0;
+		break;
+	case TYPE_F32:
+		mRealValue = (F32)value.asReal();
+		break;
+	default:
+		break;
+	}
+}
+
 LLSD LLControlVariable::getComparableValue(const LLSD& value)
 {
 	// *FIX:MEP - The following is needed to make the LLSD::ImplString 
@@ -240,6 +264,7 @@ void LLControlVariable::setValue(const LLSD& new_value, bool saved_value)
 			mValues.push_back(storable_value);
 		}
 	}
+	updateNativeValue();
 
 	if (value_changed)
 	{
@@ -258,6 +283,7 @@ void LLControlVariable::setDefaultValue(const LLSD& value)
 	bool value_changed = (llsd_compare(getValue(), comparable_value) == FALSE);
 	resetToDefault(false);
 	mValues[0] = comparable_value;
+	updateNativeValue();
 	if (value_changed)
 	{
 		firePropertyChanged();
@@ -287,6 +313,7 @@ void LLControlVariable::resetToDefault(bool fire_signal)
 	{
 		mValues.pop_back();
 	}
+	updateNativeValue();
 
 	if (fire_signal) 
 	{
@@ -308,10 +335,58 @@ LLSD LLControlVariable::getSaveValue() const
 	return mValues[0];
 }
 
+// static
+bool LLControlGroup::sCountLookups = false;
+
 LLControlVariablePtr LLControlGroup::getControl(const std::string& name)
+{
+	return LLControlVariablePtr(findControl(name));
+}
+
+LLControlVariable* LLControlGroup::findControl(const std::string& name)
 {
 	ctrl_name_table_t::iterator iter = mNameTable.find(name);
-	return iter == mNameTable.end() ? LLControlVariablePtr() : iter->second;
+	if (iter == mNameTable.end())
+	{
+		return NULL;
+	}
+	LLControlVariable* control = iter->second.get();
+	if (sCountLookups)
+	{
+		++control->mLookupCount;
+	}
+	return control;
+}
+
+static bool more_lookups(const LLControlVariable* a, const LLControlVariable* b)
+{
+	return a->getLookupCount() > b->getLookupCount();
+}
+
+void LLControlGroup::logHottestLookups(U32 max_count)
+{
+	std::vector<LLControlVariable*> controls;
+	controls.reserve(mNameTable.size());
+	for (ctrl_name_table_t::iterator iter = mNameTable.begin(),
+									 end = mNameTable.end();
+		 iter != end; ++iter)
+	{
+		if (iter->second->mLookupCount)
+		{
+			controls.push_back(iter->second);
+		}
+	}
+	U32 count = llmin(max_count, (U32)controls.size());
+	std::partial_sort(controls.begin(), controls.begin() + count,
+					  controls.end(), more_lookups);
+
+	llinfos << "Most looked up controls by name in group " << getKey()
+			<< ":" << llendl;
+	for (U32 i = 0; i < count; ++i)
+	{
+		llinfos << controls[i]->getName() << ": "
+				<< controls[i]->mLookupCount << llendl;
+	}
 }
 
 ////////////////////////////////////////////////////////////////////////////
@@ -445,23 +520,47 @@ BOOL LLControlGroup::declareLLSD(const std::string& name, const LLSD &initial_va
 	return declareControl(name, TYPE_LLSD, initial_val, comment, persist);
 }
 
+// For the scalar types, the native value of the control is returned when it
+// is of the requested type. The generic getter is only used to deal with the
+// missing controls and type mismatches.
+
 BOOL LLControlGroup::getBOOL(const std::string& name)
 {
+	LLControlVariable* control = findControl(name);
+	if (control && control->mType == TYPE_BOOLEAN)
+	{
+		return control->getBOOL();
+	}
 	return (BOOL)get<bool>(name);
 }
 
 S32 LLControlGroup::getS32(const std::string& name)
 {
+	LLControlVariable* control = findControl(name);
+	if (control && control->mType == TYPE_S32)
+	{
+		return control->getS32();
+	}
 	return get<S32>(name);
 }
 
 U32 LLControlGroup::getU32(const std::string& name)
 {
+	LLControlVariable* control = findControl(name);
+	if (control && control->mType == TYPE_U32)
+	{
+		return control->getU32();
+	}
 	return get<U32>(name);
 }
 
 F32 LLControlGroup::getF32(const std::string& name)
 {
+	LLControlVariable* control = findControl(name);
+	if (control && control->mType == TYPE_F32)
+	{
+		return control->getF32();
+	}
 	return get<F32>(name);
 }
 
@@ -502,12 +601,9 @@ LLColor4 LLControlGroup::getColor(const std::string& name)
 {
 	LL_DEBUGS("GetControlCalls") << "Requested control: " << name << LL_ENDL;
 
-	ctrl_name_table_t::const_iterator i = mNameTable.find(name);
-
-	if (i != mNameTable.end())
+	LLControlVariable* control = findControl(name);
+	if (control)
 	{
-		LLControlVariable* control = i->second;
-
 		switch (control->mType)
 		{
 			case TYPE_COL4:
@@ -554,8 +650,7 @@ LLSD LLControlGroup::getLLSD(const std::string& name)
 
 BOOL LLControlGroup::controlExists(const std::string& name)
 {
-	ctrl_name_table_t::iterator iter = mNameTable.find(name);
-	return iter != mNameTable.end();
+	return mNameTable.find(name) != mNameTable.end();
 }
 
 //-------------------------------------------------------------------
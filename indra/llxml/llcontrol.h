@@ -56,6 +56,7 @@
 #endif
 
 #include "boost/bind.hpp"
+#include "boost/unordered_map.hpp"
 
 #if LL_WINDOWS
 	#pragma warning (push)
@@ -114,6 +115,16 @@ private:
 	bool			mHideFromSettingsEditor;
 	std::vector<LLSD> mValues;
 
+	// Native copy of the current value for the U32, S32, BOOLEAN (mIntValue)
+	// and F32 (mRealValue) types, kept in sync with mValues.back(), so that
+	// typed reads do not go through LLSD.
+	S32				mIntValue;
+	F32				mRealValue;
+
+	// Number of look-ups by name of this control (approximate, since it is
+	// not protected against concurrent accesses from other threads).
+	U32				mLookupCount;
+
 	commit_signal_t mCommitSignal;
 	validate_signal_t mValidateSignal;
 
@@ -145,6 +156,18 @@ public:
 	LLSD getDefault()	const	{ return mValues.front(); }
 	LLSD getSaveValue() const;
 
+	// Typed, lock-free reads of the current value. These are only valid for
+	// a control of the corresponding type: keep the LLControlVariablePtr
+	// returned by LLControlGroup::getControl() (the pointer stays valid for
+	// the life of the group) to read a setting in a hot path without any
+	// name look-up, and use getSignal() to get told about changes.
+	bool getBOOL() const		{ return mIntValue != 0; }
+	S32 getS32() const			{ return mIntValue; }
+	U32 getU32() const			{ return (U32)mIntValue; }
+	F32 getF32() const			{ return mRealValue; }
+
+	U32 getLookupCount() const	{ return mLookupCount; }
+
 	void set(const LLSD& val)	{ setValue(val); }
 	void setValue(const LLSD& value, bool saved_value = TRUE);
 	void setDefaultValue(const LLSD& value);
@@ -157,6 +180,7 @@ public:
 		mCommitSignal(this, mValues.back());
 	}
 private:
+	void updateNativeValue();
 	LLSD getComparableValue(const LLSD& value);
 	bool llsd_compare(const LLSD& a, const LLSD & b);
 
@@ -190,7 +214,9 @@ T convert_from_llsd(const LLSD& sd, eControlType type, const std::string& contro
 class LLControlGroup : public LLInstanceTracker<LLControlGroup, std::string>
 {
 protected:
-	typedef std::map<std::string, LLControlVariablePtr> ctrl_name_table_t;
+	// Hashed for faster look-ups by name. Note: it is not sorted, so users
+	// needing the controls in alphabetical order must sort them.
+	typedef boost::unordered_map<std::string, LLControlVariablePtr> ctrl_name_table_t;
 	ctrl_name_table_t mNameTable;
 	std::set<std::string> mWarnings;
 	std::string mTypeString[TYPE_COUNT];
@@ -207,6 +233,17 @@ public:
 
 	LLControlVariablePtr getControl(const std::string& name);
 
+	// Same as getControl(), but without the reference counting
+	LLControlVariable* findControl(const std::string& name);
+
+	// Logs the max_count controls which got looked up by name the most
+	// often, so that the corresponding call sites may be changed to use
+	// LLCachedControl or a kept LLControlVariablePtr instead. The look-ups
+	// are only counted while sCountLookups is true.
+	void logHottestLookups(U32 max_count = 50);
+
+	static bool sCountLookups;
+
 	struct ApplyFunctor
 	{
 		virtual ~ApplyFunctor() {};
@@ -250,7 +287,7 @@ public:
 	template<typename T> T get(const std::string& name)
 	{
 		LL_DEBUGS("GetControlCalls") << "Requested control: " << name << LL_ENDL;
-		LLControlVariable* control = getControl(name);
+		LLControlVariable* control = findControl(name);
 		LLSD value;
 		eControlType type = TYPE_COUNT;
 
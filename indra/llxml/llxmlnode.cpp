@@ -46,6 +46,7 @@
 #include "v4math.h"
 #include "llquaternion.h"
 #include "llstring.h"
+#include "lltimer.h"
 #include "lluuid.h"
 
 const S32 MAX_COLUMN_WIDTH = 80;
@@ -149,10 +150,12 @@ LLXMLNodePtr LLXMLNode::deepCopy()
 	LLXMLNodePtr newnode = LLXMLNodePtr(new LLXMLNode(*this));
 	if (mChildren.notNull())
 	{
-		for (LLXMLChildList::iterator iter = mChildren->map.begin();
-			 iter != mChildren->map.end(); ++iter)
+		// Walk the children list rather than the (name sorted) children map,
+		// so to preserve the order of the children in the copy.
+		for (LLXMLNodePtr child = mChildren->head; child.notNull();
+			 child = child->mNext)
 		{
-			newnode->addChild(iter->second->deepCopy());
+			newnode->addChild(child->deepCopy());
 		}
 	}
 	for (LLXMLAttribList::iterator iter = mAttributes.begin();
@@ -433,80 +436,81 @@ void XMLCALL StartXMLNode(void* userData,
 	XML_Parser *parser = parent->mParser;
 	XML_SetUserData(*parser, (void *)new_node_ptr);
 
-	// Parse attributes
+	// Parse attributes. Note: expat passes them as C strings, so avoid
+	// making std::string copies of them unless needed.
 	U32 pos = 0;
 	while (atts[pos] != NULL)
 	{
-		std::string attr_name = atts[pos];
-		std::string attr_value = atts[pos+1];
+		const char* attr_name = atts[pos];
+		const char* attr_value = atts[pos+1];
 
 		// Special cases
-		if ('i' == attr_name[0] && "id" == attr_name)
+		if ('i' == attr_name[0] && !strcmp(attr_name, "id"))
 		{
 			new_node->mID = attr_value;
 		}
-		else if ('v' == attr_name[0] && "version" == attr_name)
+		else if ('v' == attr_name[0] && !strcmp(attr_name, "version"))
 		{
 			U32 version_major = 0;
 			U32 version_minor = 0;
-			if (sscanf(attr_value.c_str(), "%d.%d", &version_major,
+			if (sscanf(attr_value, "%d.%d", &version_major,
 					   &version_minor) > 0)
 			{
 				new_node->mVersionMajor = version_major;
 				new_node->mVersionMinor = version_minor;
 			}
 		}
-		else if (('s' == attr_name[0] && "size" == attr_name) ||
-				 ('l' == attr_name[0] && "length" == attr_name))
+		else if (('s' == attr_name[0] && !strcmp(attr_name, "size")) ||
+				 ('l' == attr_name[0] && !strcmp(attr_name, "length")))
 		{
 			U32 length;
-			if (sscanf(attr_value.c_str(), "%d", &length) > 0)
+			if (sscanf(attr_value, "%d", &length) > 0)
 			{
 				new_node->mLength = length;
 			}
 		}
-		else if ('p' == attr_name[0] && "precision" == attr_name)
+		else if ('p' == attr_name[0] && !strcmp(attr_name, "precision"))
 		{
 			U32 precision;
-			if (sscanf(attr_value.c_str(), "%d", &precision) > 0)
+			if (sscanf(attr_value, "%d", &precision) > 0)
 			{
 				new_node->mPrecision = precision;
 			}
 		}
-		else if ('t' == attr_name[0] && "type" == attr_name)
+		else if ('t' == attr_name[0] && !strcmp(attr_name, "type"))
 		{
-			if ("boolean" == attr_value)
+			if (!strcmp(attr_value, "boolean"))
 			{
 				new_node->mType = LLXMLNode::TYPE_BOOLEAN;
 			}
-			else if ("integer" == attr_value)
+			else if (!strcmp(attr_value, "integer"))
 			{
 				new_node->mType = LLXMLNode::TYPE_INTEGER;
 			}
-			else if ("float" == attr_value)
+			else if (!strcmp(attr_value, "float"))
 			{
 				new_node->mType = LLXMLNode::TYPE_FLOAT;
 			}
-			else if ("string" == attr_value)
+			else if (!strcmp(attr_value, "string"))
 			{
 				new_node->mType = LLXMLNode::TYPE_STRING;
 			}
-			else if ("uuid" == attr_value)
+			else if (!strcmp(attr_value, "uuid"))
 			{
 				new_node->mType = LLXMLNode::TYPE_UUID;
 			}
-			else if ("noderef" == attr_value)
+			else if (!strcmp(attr_value, "noderef"))
 			{
 				new_node->mType = LLXMLNode::TYPE_NODEREF;
 			}
 		}
-		else if ('e' == attr_name[0] && "encoding" == attr_name)
+		else if ('e' == attr_name[0] && !strcmp(attr_name, "encoding"))
 		{
-			if ("decimal" == attr_value)
+			if (!strcmp(attr_value, "decimal"))
 			{
 				new_node->mEncoding = LLXMLNode::ENCODING_DECIMAL;
 			}
-			else if ("hex" == attr_value)
+			else if (!strcmp(attr_value, "hex"))
 			{
 				new_node->mEncoding = LLXMLNode::ENCODING_HEX;
 			}
@@ -516,14 +520,16 @@ void XMLCALL StartXMLNode(void* userData,
 			}*/
 		}
 
-		// only one attribute child per description
+		// only one attribute child per description. Intern the name only once
+		// for both the look-up and the creation.
+		LLStringTableEntry* attr_entry = gStringTable.addStringEntry(attr_name);
 		LLXMLNodePtr attr_node;
-		if (!new_node->getAttribute(attr_name.c_str(), attr_node, FALSE))
+		if (!new_node->getAttribute(attr_entry, attr_node, FALSE))
 		{
-			attr_node = new LLXMLNode(attr_name.c_str(), TRUE);
+			attr_node = new LLXMLNode(attr_entry, TRUE);
 			attr_node->setLineNumber(XML_GetCurrentLineNumber(*new_node_ptr->mParser));
 		}
-		attr_node->setValue(attr_value);
+		attr_node->setValue(std::string(attr_value));
 		new_node->addChild(attr_node);
 
 		pos += 2;
@@ -544,7 +550,7 @@ void XMLCALL EndXMLNode(void* userData, const XML_Char* name)
 	// SJB: total hack:
 	if (LLXMLNode::sStripWhitespaceValues)
 	{
-		std::string value = node->getValue();
+		const std::string& value = node->getValue();
 		BOOL is_empty = TRUE;
 		for (std::string::size_type s = 0; s < value.length(); s++)
 		{
@@ -555,18 +561,18 @@ void XMLCALL EndXMLNode(void* userData, const XML_Char* name)
 				break;
 			}
 		}
-		if (is_empty)
+		if (is_empty && !value.empty())
 		{
-			value.clear();
-			node->setValue(value);
+			node->setValue(LLStringUtil::null);
 		}
 	}
 }
 
 void XMLCALL XMLData(void* userData, const XML_Char* s, int len)
 {
+	// Note: expat calls this for each line of text, so the value is appended
+	// to in place (copying it on each call made large values quadratic).
 	LLXMLNode* current_node = (LLXMLNode*)userData;
-	std::string value = current_node->getValue();
 	if (LLXMLNode::sStripEscapedStrings)
 	{
 		if (s[0] == '\"' && s[len-1] == '\"')
@@ -590,13 +596,12 @@ void XMLCALL XMLData(void* userData, const XML_Char* s, int len)
 					unescaped_string.append(&s[pos], 1);
 				}
 			}
-			value.append(unescaped_string);
-			current_node->setValue(value);
+			current_node->appendValue(unescaped_string.data(),
+									  unescaped_string.size());
 			return;
 		}
 	}
-	value.append(std::string(s, len));
-	current_node->setValue(value);
+	current_node->appendValue(s, len);
 }
 
 // static 
@@ -706,6 +711,7 @@ bool LLXMLNode::parseFile(const std::string& filename,
 {
 	// Read file
 	LL_DEBUGS("XMLNode") << "parsing XML file: " << filename << LL_ENDL;
+	LLTimer parse_timer;
 	LLFILE* fp = LLFile::fopen(filename, "rb");		/* Flawfinder: ignore */
 	if (fp == NULL)
 	{
@@ -723,6 +729,9 @@ bool LLXMLNode::parseFile(const std::string& filename,
 
 	bool rv = parseBuffer(buffer, nread, node, defaults_tree);
 	delete [] buffer;
+	LL_DEBUGS("XMLNode") << "Parsed " << nread << " bytes from " << filename
+						 << " in " << parse_timer.getElapsedTimeF32() * 1000.f
+						 << "ms" << LL_ENDL;
 	return rv;
 }
 
@@ -2697,6 +2706,15 @@ void LLXMLNode::setValue(const std::string& value)
 	mValue = value;
 }
 
+void LLXMLNode::appendValue(const char* data, size_t length)
+{
+	if (TYPE_CONTAINER == mType)
+	{
+		mType = TYPE_UNKNOWN;
+	}
+	mValue.append(data, length);
+}
+
 void LLXMLNode::setDefault(LLXMLNode* default_node)
 {
 	mDefault = default_node;
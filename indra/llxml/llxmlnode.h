@@ -271,6 +271,8 @@ public:
 	void setUUIDValue(U32 length, const LLUUID *array);
 	void setNodeRefValue(U32 length, const LLXMLNode **array);
 	void setValue(const std::string& value);
+	// Appends to the value, avoiding the copies of getValue()/setValue()
+	void appendValue(const char* data, size_t length);
 	void setName(const std::string& name);
 	void setName(LLStringTableEntry* name);
 
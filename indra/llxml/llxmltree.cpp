@@ -40,6 +40,7 @@
 #include "v3dmath.h"
 #include "v4math.h"
 #include "llquaternion.h"
+#include "lltimer.h"
 #include "lluuid.h"
 
 //////////////////////////////////////////////////////////////
@@ -72,6 +73,7 @@ BOOL LLXmlTree::parseFile(const std::string &path, BOOL keep_contents)
 	delete mRoot;
 	mRoot = NULL;
 
+	LLTimer parse_timer;
 	LLXmlTreeParser parser(this);
 	BOOL success = parser.parseFile( path, &mRoot, keep_contents );
 	if( !success )
@@ -80,6 +82,13 @@ BOOL LLXmlTree::parseFile(const std::string &path, BOOL keep_contents)
 		const char* error =  parser.getErrorString();
 		llwarns << "LLXmlTree parse failed.  Line " << line_number << ": " << error << llendl;
 	}
+	else
+	{
+		// These trees are used for the few large definition files loaded at
+		// startup (avatar_lad.xml, avatar_skeleton.xml, etc): log their timing.
+		llinfos << "Parsed " << path << " in "
+				<< parse_timer.getElapsedTimeF32() * 1000.f << "ms" << llendl;
+	}
 	return success;
 }
 
@@ -613,8 +622,14 @@ void LLXmlTreeParser::endElement(const char* name)
 
 void LLXmlTreeParser::characterData(const char *s, int len) 
 {
-	std::string str;
-	if (s) str = std::string(s, len);
+	// Most trees are parsed without keeping their contents: do not bother
+	// building a string for each chunk of (mostly white space) text then.
+	if (!s || (!mDump && !mKeepContents))
+	{
+		return;
+	}
+
+	std::string str(s, len);
 	if( mDump )
 	{
 		llinfos << tabs() << "CharacterData " << str << llendl;
@@ -43,6 +43,7 @@
 #include "llprimitive.h"
 #include "llpumpio.h"
 #include "llrender.h"
+#include "llscrolllistctrl.h"
 #include "llsingleton.h"
 #include "llspellcheck.h"
 #include "llsys.h"
@@ -853,6 +854,16 @@ bool LLAppViewer::init()
 	// fonts
 	LLFolderViewItem::initClass();
 
+#if LL_SCROLL_LIST_BENCHMARK
+	LLScrollListCtrl::benchmark(50000);
+#endif
+#if LL_TEXT_EDITOR_BENCHMARK
+	LLTextEditor::benchmark();
+#endif
+#if LL_FONT_GL_BENCHMARK
+	LLFontGL::benchmark();
+#endif
+
 	gGLManager.getGLInfo(gDebugInfo);
 	gGLManager.printGLInfoString();
 
@@ -991,10 +1002,20 @@ bool LLAppViewer::mainLoop()
 	S32 garbage_collector_cnt = -3000;
 //mk
 
+	static LLCachedControl<U32> trace_frames(gSavedSettings,
+											 "FastTimersTraceFrames");
+
 	// Handle messages
 	while (!LLApp::isExiting())
 	{
 		LLFastTimer::reset(); // Should be outside of any timer instances
+		if (trace_frames)
+		{
+			LLFastTimer::startTrace(gDirUtilp->getExpandedFilename(LL_PATH_LOGS,
+																   "fast_timers_trace.json"),
+									trace_frames);
+			gSavedSettings.setU32("FastTimersTraceFrames", 0);
+		}
 		try
 		{
 			LLFastTimer t(LLFastTimer::FTM_FRAME);
@@ -1671,6 +1692,11 @@ bool LLAppViewer::cleanup()
 	llinfos << "User settings saved again to update closed floaters rects"
 			<< llendflush;
 
+	if (LLControlGroup::sCountLookups)
+	{
+		gSavedSettings.logHottestLookups();
+	}
+
 	// Shut down the VFS's AFTER the decode manager cleans up (since it cleans
 	// up vfiles). Also after viewerwindow is deleted, since it may have image
 	// pointers (which have vfiles). Also after shutting down the messaging
@@ -2164,6 +2190,9 @@ bool LLAppViewer::initConfiguration()
 	// - apply command line settings
 	clp.notify();
 
+	// Count the settings look-ups by name, to log the hottest ones on exit
+	LLControlGroup::sCountLookups = gSavedSettings.getBOOL("LogSettingsLookups");
+
 	// Register the core crash option as soon as we can
 	// if we want gdb post-mortum on cores we need to be up and running
 	// ASAP or we might miss init issue etc.
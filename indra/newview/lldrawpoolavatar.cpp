@@ -65,6 +65,8 @@ LLGLSLShader* LLDrawPoolAvatar::sVertexProgram = NULL;
 BOOL	LLDrawPoolAvatar::sSkipOpaque = FALSE;
 BOOL	LLDrawPoolAvatar::sSkipTransparent = FALSE;
 S32 LLDrawPoolAvatar::sDiffuseChannel = 0;
+U32 LLDrawPoolAvatar::sSkinCacheHits = 0;
+U32 LLDrawPoolAvatar::sSkinCacheMisses = 0;
 
 static bool is_deferred_render = false;
 
@@ -1263,6 +1265,9 @@ void LLDrawPoolAvatar::updateRiggedFaceVertexBuffer(LLVOAvatar* avatar, LLFace*
 	LLVector4a* weight = vol_face.mWeights;
 	if (!weight)
 	{
+		// Still keep the palette in sync with the current pose and LOD, since
+		// renderRigged() uploads it for whatever buffer this face holds.
+		updateSkinningPalette(avatar, face, skin, vobj->getLOD());
 		return;
 	}
 
@@ -1300,6 +1305,10 @@ void LLDrawPoolAvatar::updateRiggedFaceVertexBuffer(LLVOAvatar* avatar, LLFace*
 		face->setSize(vol_face.mNumVertices, vol_face.mNumIndices);
 		face->setVertexBuffer(buffer);
 
+		// buffer now holds the bind pose: force a full re-skin
+		face->mSkinPaletteValid = false;
+		face->mSoftwareSkinned = false;
+
 		U16 offset = 0;
 
 		LLMatrix4 mat_vert = skin->mBindShapeMatrix;
@@ -1332,7 +1341,13 @@ void LLDrawPoolAvatar::updateRiggedFaceVertexBuffer(LLVOAvatar* avatar, LLFace*
 								mat_normal, offset, true);
 	}
 
-	if (sShaderLevel <= 0 && face->mLastSkinTime < avatar->getLastSkinTime())
+	bool cache_hit = updateSkinningPalette(avatar, face, skin, vobj->getLOD());
+
+	if (sShaderLevel > 0)
+	{
+		face->mSoftwareSkinned = false;
+	}
+	else if (!cache_hit || !face->mSoftwareSkinned)
 	{	// perform software vertex skinning for this face
 		LLStrider<LLVector3> position;
 		LLStrider<LLVector3> normal;
@@ -1349,18 +1364,11 @@ void LLDrawPoolAvatar::updateRiggedFaceVertexBuffer(LLVOAvatar* avatar, LLFace*
 
 		LLVector4a* norm = has_normal ? (LLVector4a*) normal.get() : NULL;
 
-		//build matrix palette
+		// aligned copy of the cached matrix palette
 		LLMatrix4a mp[64];
-		LLMatrix4* mat = (LLMatrix4*) mp;
-
-		for (U32 j = 0, count = skin->mJointNames.size(); j < count; ++j)
+		for (U32 j = 0, count = face->mSkinPalette.size(); j < count; ++j)
 		{
-			LLJoint* joint = avatar->getJoint(skin->mJointNames[j]);
-			if (joint)
-			{
-				mat[j] = skin->mInvBindMatrix[j];
-				mat[j] *= joint->getWorldMatrix();
-			}
+			mp[j].loadu(face->mSkinPalette[j]);
 		}
 
 		LLMatrix4a bind_shape_matrix;
@@ -1412,6 +1420,8 @@ void LLDrawPoolAvatar::updateRiggedFaceVertexBuffer(LLVOAvatar* avatar, LLFace*
 				norm[j] = dst;
 			}
 		}
+
+		face->mSoftwareSkinned = true;
 	}
 
 	if (drawable && face->getTEOffset() == drawable->getNumFaces() - 1)
@@ -1420,6 +1430,47 @@ void LLDrawPoolAvatar::updateRiggedFaceVertexBuffer(LLVOAvatar* avatar, LLFace*
 	}
 }
 
+//static
+bool LLDrawPoolAvatar::updateSkinningPalette(LLVOAvatar* avatar, LLFace* face,
+											 const LLMeshSkinInfo* skin, S32 lod)
+{
+	U32 count = llmin((U32)skin->mJointNames.size(), (U32)64);
+
+	if (face->mSkinPaletteValid && face->mSkinLOD == lod &&
+		face->mSkinPoseVersion == avatar->getPoseVersion() &&
+		face->mSkinPalette.size() == count)
+	{
+		++sSkinCacheHits;
+		return true;
+	}
+
+	++sSkinCacheMisses;
+
+	face->mSkinPalette.resize(count);
+	for (U32 j = 0; j < count; ++j)
+	{
+		LLMatrix4& mat = face->mSkinPalette[j];
+		LLJoint* joint = avatar->getJoint(skin->mJointNames[j]);
+		if (joint)
+		{
+			mat = skin->mInvBindMatrix[j];
+			mat *= joint->getWorldMatrix();
+		}
+		else
+		{
+			mat.setIdentity();
+		}
+	}
+
+	// Note: getWorldMatrix() may have updated dirty joints, so the pose
+	// version must be sampled after the palette got built.
+	face->mSkinPoseVersion = avatar->getPoseVersion();
+	face->mSkinLOD = lod;
+	face->mSkinPaletteValid = true;
+
+	return false;
+}
+
 void LLDrawPoolAvatar::renderRigged(LLVOAvatar* avatar, U32 type, bool glow)
 {
 	if (avatar->isSelf() && !gAgent.needsRenderAvatar() || !gMeshRepo.meshRezEnabled())
@@ -1479,25 +1530,24 @@ void LLDrawPoolAvatar::renderRigged(LLVOAvatar* avatar, U32 type, bool glow)
 		{
 			if (sShaderLevel > 0)
 			{ //upload matrix palette to shader
-				LLMatrix4 mat[64];
-
-				for (U32 i = 0; i < skin->mJointNames.size(); ++i)
+				// (cached by updateRiggedFaceVertexBuffer() above)
+				const std::vector<LLMatrix4>& palette = face->mSkinPalette;
+				if (!face->mSkinPaletteValid ||
+					face->mSkinLOD != vobj->getLOD())
 				{
-					LLJoint* joint = avatar->getJoint(skin->mJointNames[i]);
-					if (joint)
-					{
-						mat[i] = skin->mInvBindMatrix[i];
-						mat[i] *= joint->getWorldMatrix();
-					}
+					// Never draw with a palette from another LOD
+					continue;
 				}
+				if (!palette.empty())
+				{
+					stop_glerror();
 
-				stop_glerror();
-
-				LLDrawPoolAvatar::sVertexProgram->uniformMatrix4fv("matrixPalette",
-																   skin->mJointNames.size(),
-																   FALSE,
-																   (GLfloat*) mat[0].mMatrix);
-				stop_glerror();
+					LLDrawPoolAvatar::sVertexProgram->uniformMatrix4fv("matrixPalette",
+																	   palette.size(),
+																	   FALSE,
+																	   (GLfloat*) palette[0].mMatrix);
+					stop_glerror();
+				}
 			}
 			else
 			{
@@ -142,6 +142,11 @@ public:
 									  const LLVolumeFace& vol_face,
 									  LLVOVolume* vobj);
 
+	// Rebuilds facep->mSkinPalette unless the avatar pose and the LOD did not
+	// change since it was last computed. Returns true on a cache hit.
+	static bool updateSkinningPalette(LLVOAvatar* avatar, LLFace* facep,
+									  const LLMeshSkinInfo* skin, S32 lod);
+
 	void renderRigged(LLVOAvatar* avatar, U32 type, bool glow = false);
 	void renderRiggedSimple(LLVOAvatar* avatar);
 	void renderRiggedAlpha(LLVOAvatar* avatar);
@@ -222,6 +227,10 @@ public:
 	static S32 sDiffuseChannel;
 
 	static LLGLSLShader* sVertexProgram;
+
+	// Rigged faces skinning cache statistics
+	static U32 sSkinCacheHits;
+	static U32 sSkinCacheMisses;
 };
 
 class LLVertexBufferAvatar : public LLVertexBuffer
@@ -154,7 +154,10 @@ void LLFace::init(LLDrawable* drawablep, LLViewerObject* objp)
 {
 	mLastUpdateTime	= gFrameTimeSeconds;
 	mLastMoveTime	= 0.f;
-	mLastSkinTime	= gFrameTimeSeconds;
+	mSkinPoseVersion = 0;
+	mSkinLOD		= -1;
+	mSkinPaletteValid = false;
+	mSoftwareSkinned = false;
 	mVSize = 0.f;
 	mPixelArea = 16.f;
 	mState      = GLOBAL;
@@ -247,8 +247,16 @@ public:
 	LLVector2	mTexExtents[2];
 	F32			mDistance;
 	F32			mLastUpdateTime;
-	F32			mLastSkinTime;
 	F32			mLastMoveTime;
+
+	// Rigged mesh skinning cache: the matrix palette and (for software
+	// skinning) the skinned vertices are only recomputed when the avatar pose
+	// version or the volume LOD differ from the ones recorded here.
+	std::vector<LLMatrix4> mSkinPalette;
+	U32			mSkinPoseVersion;
+	S32			mSkinLOD;
+	bool		mSkinPaletteValid;
+	bool		mSoftwareSkinned;
 	LLMatrix4*	mTextureMatrix;
 	LLDrawInfo* mDrawInfo;
 
@@ -110,6 +110,7 @@ static struct ft_display_info ft_display_table[] =
 	{ LLFastTimer::FTM_ATTACHMENT_UPDATE,	"    Attachments",		&LLColor4::purple4, 0 },
 	{ LLFastTimer::FTM_UPDATE_ANIMATION,	"    Animation",		&LLColor4::purple5, 0 },
 	{ LLFastTimer::FTM_UPDATE_HIDDEN_ANIMATION, "    Hidden Anim",	&LLColor4::purple, 0 },
+	{ LLFastTimer::FTM_AVATAR_ANIM_FLUSH,	"   Avatar Anim Flush",	&LLColor4::purple6, 0 },
 	{ LLFastTimer::FTM_FLEXIBLE_UPDATE,		"   Flex Update",		&LLColor4::pink2, 0 },
 	{ LLFastTimer::FTM_LOD_UPDATE,			"   LOD Update",		&LLColor4::magenta1, 0 },
 	{ LLFastTimer::FTM_UPDATE_RIGGED_VOLUME,"   Update Rigged",		&LLColor4::blue1, 1 },
@@ -306,6 +307,8 @@ LLFastTimerView::LLFastTimerView(const std::string& name, const LLRect& rect)
 			llassert(level < FTV_DISPLAY_NUM);
 			ft_display_table[i].desc = text;
 			ft_display_table[i].level = level;
+			LLFastTimer::setTimerName((LLFastTimer::EFastTimerType)ft_display_table[i].timer,
+									  text);
 			if (level > 0)
 			{
 				ft_display_table[i].parent = pidx[level-1];
@@ -532,9 +535,11 @@ void LLFastTimerView::draw()
 	// Make sure all timers are accounted for
 	// Set 'FTM_OTHER' to unaccounted ticks last frame
 	{
-		S32 display_timer[LLFastTimer::FTM_NUM_TYPES];
+		// Note: the run-time declared timers are not in the display table and
+		// are therefore accounted for in FTM_OTHER.
+		S32 display_timer[LLFastTimer::FTM_MAX_TYPES];
 		S32 hidx = LLFastTimer::sLastFrameIndex % LLFastTimer::FTM_HISTORY_NUM;
-		for (S32 i = 0; i < LLFastTimer::FTM_NUM_TYPES; ++i)
+		for (S32 i = 0; i < LLFastTimer::FTM_MAX_TYPES; ++i)
 		{
 			display_timer[i] = 0;
 		}
@@ -545,7 +550,7 @@ void LLFastTimerView::draw()
 		}
 		LLFastTimer::sCountHistory[hidx][LLFastTimer::FTM_OTHER] = 0;
 		LLFastTimer::sCallHistory[hidx][LLFastTimer::FTM_OTHER] = 0;
-		for (S32 tidx = 0; tidx < LLFastTimer::FTM_NUM_TYPES; ++tidx)
+		for (S32 tidx = 0; tidx < LLFastTimer::FTM_MAX_TYPES; ++tidx)
 		{
 			U64 counts = LLFastTimer::sCountHistory[hidx][tidx];
 			if (counts > 0 && display_timer[tidx] == 0)
@@ -602,6 +607,24 @@ void LLFastTimerView::draw()
 
 		x = xleft, y -= (texth + 2);
 		tdesc = llformat("Justification = %s [CTRL-Click to toggle]",centerdesc[mDisplayCenter]);
+
+		// Append the last frame busy time of the other threads
+		std::string thread_name;
+		F64 busy_ms;
+		U64 calls;
+		for (S32 i = 0, count = LLFastTimer::getThreadCount(); i < count; ++i)
+		{
+			if (LLFastTimer::getThreadStats(i, thread_name, busy_ms, calls) &&
+				calls > 0)
+			{
+				tdesc += llformat("  %s: %.2fms", thread_name.c_str(), busy_ms);
+			}
+		}
+		if (LLFastTimer::isTracing())
+		{
+			tdesc += "  [TRACING]";
+		}
+
 		LLFontGL::getFontMonospace()->renderUTF8(tdesc, 0, x, y, LLColor4::white, LLFontGL::LEFT, LLFontGL::TOP);
 		y -= (texth + 2);
 
@@ -154,6 +154,7 @@ LLFolderViewItem::LLFolderViewItem(const std::string& name, LLUIImagePtr icon,
 								   LLFolderViewEventListener* listener) :
 	LLUICtrl(name, LLRect(0, 0, 0, 0), TRUE, NULL, NULL, FOLLOWS_LEFT|FOLLOWS_TOP|FOLLOWS_RIGHT),
 	mLabel(name),
+	mSearchableFlags(U32_MAX),
 	mLabelWidth(0),
 	mCreationDate(creation_date),
 	mParentFolder(NULL),
@@ -316,7 +317,11 @@ void LLFolderViewItem::refreshFromListener()
 				LLStringUtil::toUpper(desc);
 			}
 		}
-		mSearchableLabelDesc = desc;
+		if (mSearchableLabelDesc != desc)
+		{
+			mSearchableLabelDesc = desc;
+			mSearchableFlags = U32_MAX;	// Rebuild mSearchable
+		}
 
 		std::string creator_name;
 		if (item)
@@ -327,7 +332,11 @@ void LLFolderViewItem::refreshFromListener()
 				LLStringUtil::toUpper(creator_name);
 			}
 		}
-		mSearchableLabelCreator = creator_name;
+		if (mSearchableLabelCreator != creator_name)
+		{
+			mSearchableLabelCreator = creator_name;
+			mSearchableFlags = U32_MAX;	// Rebuild mSearchable
+		}
 	}
 }
 
@@ -342,6 +351,7 @@ void LLFolderViewItem::refresh()
 	if (mSearchableLabel.compare(searchable_label))
 	{
 		mSearchableLabel.assign(searchable_label);
+		mSearchableFlags = U32_MAX;	// Rebuild mSearchable
 		dirtyFilter();
 		// some part of label has changed, so overall width has potentially changed
 		if (mParentFolder)
@@ -643,8 +653,17 @@ void LLFolderViewItem::rename(const std::string& new_name)
 
 std::string& LLFolderViewItem::getSearchableLabel()
 {
-	mSearchable = "";
+	// This is called for each item on each filter pass, so only rebuild the
+	// (already upper-cased) searchable string when one of its parts or the
+	// search type changed.
 	U32 flags = mRoot->getSearchType();
+	if (flags == mSearchableFlags)
+	{
+		return mSearchable;
+	}
+	mSearchableFlags = flags;
+
+	mSearchable.clear();
 	if (flags == 0 || (flags & 1))
 	{
 		mSearchable = mSearchableLabel;
@@ -2666,6 +2685,12 @@ LLFolderView::LLFolderView(const std::string& name,
 	mSignalSelectCallback(0),
 	mMinWidth(0),
 	mDragAndDropThisFrame(FALSE)
+#if LL_FOLDER_VIEW_FILTER_BENCHMARK
+	, mBenchGeneration(-1),
+	mBenchItems(0),
+	mBenchSlices(0),
+	mBenchTime(0.0)
+#endif
 {
 	LLRect new_rect(rect.mLeft, rect.mBottom + getRect().getHeight(),
 					rect.mLeft + getRect().getWidth(), rect.mBottom);
@@ -2997,13 +3022,40 @@ void LLFolderView::filter(LLInventoryFilter& filter)
 	LLFastTimer t2(LLFastTimer::FTM_FILTER);
 	static LLCachedControl<S32> filter_items_per_frame(gSavedSettings,
 													   "FilterItemsPerFrame");
-	filter.setFilterCount(llclamp((S32)filter_items_per_frame, 1, 5000));
+	static LLCachedControl<F32> filter_max_time(gSavedSettings,
+												"FilterMaxTimePerFrame");
 
 	if (getCompletedFilterGeneration() < filter.getCurrentGeneration())
 	{
+		S32 max_items = llclamp((S32)filter_items_per_frame, 1, 5000);
+		filter.startFilterSlice(max_items,
+								llmax((F32)filter_max_time, 0.f) * 0.001f);
+#if LL_FOLDER_VIEW_FILTER_BENCHMARK
+		if (mBenchGeneration != filter.getCurrentGeneration())
+		{
+			mBenchGeneration = filter.getCurrentGeneration();
+			mBenchItems = mBenchSlices = 0;
+			mBenchTime = 0.0;
+		}
+		LLTimer bench_timer;
+#endif
+
 		mFiltered = FALSE;
 		mMinWidth = 0;
 		LLFolderViewFolder::filter(filter);
+
+#if LL_FOLDER_VIEW_FILTER_BENCHMARK
+		mBenchTime += bench_timer.getElapsedTimeF64();
+		mBenchItems += max_items - llmax(filter.getFilterCount(), 0);
+		++mBenchSlices;
+		if (getCompletedFilterGeneration() >= mBenchGeneration)
+		{
+			llinfos << "Filter generation " << mBenchGeneration << " of "
+					<< getName() << ": " << mBenchItems << " items checked in "
+					<< mBenchSlices << " frames, " << mBenchTime * 1000.0
+					<< "ms total" << llendl;
+		}
+#endif
 	}
 }
 
@@ -4842,6 +4894,9 @@ LLInventoryFilter::LLInventoryFilter(const std::string& name) :
 	mMinRequiredGeneration = 0;
 	mFilterCount = 0;
 	mNextFilterGeneration = mFilterGeneration + 1;
+	mMaxFilterTime = 0.f;
+	mEarliestDate = 0;
+	mSliceIsActive = FALSE;
 
 	mLastLogoff = gSavedPerAccountSettings.getU32("LastLogoff");
 	mFilterBehavior = FILTER_NONE;
@@ -4860,12 +4915,14 @@ BOOL LLInventoryFilter::check(LLFolderViewItem* item)
 	if (!listener) return FALSE;
 
 	const LLUUID& item_id = listener->getUUID();
-	const LLInventoryObject* obj = gInventory.getObject(item_id);
-
-	if (isActive() && obj && obj->getIsLinkType())
+	if (mSliceIsActive)
 	{
-		// When filtering is active, omit links.
-		return FALSE;
+		const LLInventoryObject* obj = gInventory.getObject(item_id);
+		if (obj && obj->getIsLinkType())
+		{
+			// When filtering is active, omit links.
+			return FALSE;
+		}
 	}
 
 	LLInventoryType::EType object_type = listener->getInventoryType();
@@ -4893,16 +4950,7 @@ BOOL LLInventoryFilter::check(LLFolderViewItem* item)
 		return FALSE;
 	}
 
-	time_t earliest = time_corrected() - mFilterOps.mHoursAgo * 3600;
-	if (mFilterOps.mMinDate > time_min() && mFilterOps.mMinDate < earliest)
-	{
-		earliest = mFilterOps.mMinDate;
-	}
-	else if (!mFilterOps.mHoursAgo)
-	{
-		earliest = 0;
-	}
-	if (listener->getCreationDate() < earliest ||
+	if (listener->getCreationDate() < mEarliestDate ||
 		listener->getCreationDate() > mFilterOps.mMaxDate)
 	{
 		return FALSE;
@@ -4925,6 +4973,26 @@ BOOL LLInventoryFilter::check(LLFolderViewItem* item)
 	return TRUE;
 }
 
+void LLInventoryFilter::startFilterSlice(S32 max_items, F32 max_time)
+{
+	mFilterCount = max_items;
+	mMaxFilterTime = max_time;
+	mFilterTimer.reset();
+
+	// These do not depend on the checked item and used to be recomputed for
+	// each of them in check()
+	mSliceIsActive = isActive();
+	mEarliestDate = time_corrected() - mFilterOps.mHoursAgo * 3600;
+	if (mFilterOps.mMinDate > time_min() && mFilterOps.mMinDate < mEarliestDate)
+	{
+		mEarliestDate = mFilterOps.mMinDate;
+	}
+	else if (!mFilterOps.mHoursAgo)
+	{
+		mEarliestDate = 0;
+	}
+}
+
 const std::string LLInventoryFilter::getFilterSubString(BOOL trim)
 {
 	return mFilterSubString;
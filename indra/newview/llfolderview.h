@@ -60,6 +60,11 @@
 
 class LLMenuGL;
 
+// Set to 1 to log, for each completed filter generation, the number of checked
+// items, of frames (time slices) and the total time it took to filter the
+// inventory.
+#define LL_FOLDER_VIEW_FILTER_BENCHMARK 0
+
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 // Class LLFolderViewEventListener
 //
@@ -232,7 +237,23 @@ public:
 
 	void setFilterCount(S32 count) { mFilterCount = count; }
 	S32 getFilterCount() { return mFilterCount; }
-	void decrementFilterCount() { mFilterCount--; }
+	void decrementFilterCount()
+	{
+		// Check the time budget every 32 items only: when exhausted, the
+		// filter count is forced negative so that the traversal stops, the
+		// same way as when running out of items for this frame.
+		if (--mFilterCount > 0 && !(mFilterCount & 31) && mMaxFilterTime > 0.f &&
+			mFilterTimer.getElapsedTimeF32() > mMaxFilterTime)
+		{
+			mFilterCount = -1;
+		}
+	}
+
+	// Starts a new time slice of filtering for this frame, with at most
+	// 'max_items' checked items and 'max_time' seconds (0 for no time limit).
+	// Also computes the parameters of check() that do not depend on the
+	// checked items.
+	void startFilterSlice(S32 max_items, F32 max_time);
 
 	void markDefault();
 	void resetDefault();
@@ -273,6 +294,12 @@ protected:
 	S32				mNextFilterGeneration;
 	EFilterBehavior mFilterBehavior;
 
+	// Per time slice data (see startFilterSlice())
+	LLTimer			mFilterTimer;
+	F32				mMaxFilterTime;
+	time_t			mEarliestDate;
+	BOOL			mSliceIsActive;
+
 private:
 	U32 mLastLogoff;
 	BOOL mModified;
@@ -346,7 +373,9 @@ protected:
 	std::string					mSearchableLabel;
 	std::string					mSearchableLabelDesc;
 	std::string					mSearchableLabelCreator;
+	// Concatenation of the searchable labels selected by mSearchableFlags
 	std::string					mSearchable;
+	U32							mSearchableFlags;
 	std::string					mType;
 	S32							mLabelWidth;
 	U32							mCreationDate;
@@ -955,6 +984,13 @@ protected:
 	std::map<LLUUID, LLFolderViewItem*> mItemMap;
 	BOOL							mDragAndDropThisFrame;
 
+#if LL_FOLDER_VIEW_FILTER_BENCHMARK
+	S32								mBenchGeneration;
+	S32								mBenchItems;
+	S32								mBenchSlices;
+	F64								mBenchTime;
+#endif
+
 };
 
 bool sort_item_name(LLFolderViewItem* a, LLFolderViewItem* b);
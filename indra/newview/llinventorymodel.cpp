@@ -65,6 +65,7 @@ const S32 LLInventoryModel::sCurrentInvCacheVersion = 2;
 
 //BOOL decompress_file(const char* src_filename, const char* dst_filename);
 const char CACHE_FORMAT_STRING[] = "%s.inv"; 
+const char BINARY_CACHE_FORMAT_STRING[] = "%s.invb";
 
 struct InventoryIDPtrLess
 {
@@ -543,14 +544,25 @@ void LLInventoryModel::collectDescendentsIf(const LLUUID& id,
 											BOOL include_trash,
 											LLInventoryCollectFunctor& add)
 {
-	// Start with categories
+	// Look up the trash only once instead of at each level of the recursion
+	LLUUID trash_id;
 	if (!include_trash)
 	{
-		const LLUUID trash_id = findCategoryUUIDForType(LLFolderType::FT_TRASH);
-		if (trash_id.notNull() && trash_id == id)
-		{
-			return;
-		}
+		trash_id = findCategoryUUIDForType(LLFolderType::FT_TRASH);
+	}
+	collectDescendentsIfHelper(id, cats, items, trash_id, add);
+}
+
+void LLInventoryModel::collectDescendentsIfHelper(const LLUUID& id,
+												  cat_array_t& cats,
+												  item_array_t& items,
+												  const LLUUID& trash_id,
+												  LLInventoryCollectFunctor& add)
+{
+	// Start with categories
+	if (trash_id.notNull() && trash_id == id)
+	{
+		return;
 	}
 	cat_array_t* cat_array = get_ptr_in_map(mParentChildCategoryTree, id);
 	if (cat_array)
@@ -563,8 +575,8 @@ void LLInventoryModel::collectDescendentsIf(const LLUUID& id,
 			{
 				cats.put(cat);
 			}
-			collectDescendentsIf(cat->getUUID(), cats, items, include_trash,
-								 add);
+			collectDescendentsIfHelper(cat->getUUID(), cats, items, trash_id,
+									   add);
 		}
 	}
 
@@ -1225,9 +1237,27 @@ void LLInventoryModel::cache(const LLUUID& parent_folder_id,
 	agent_id.toString(agent_id_str);
 	std::string path(gDirUtilp->getExpandedFilename(LL_PATH_CACHE, agent_id_str));
 	inventory_filename = llformat(CACHE_FORMAT_STRING, path.c_str());
-	saveToFile(inventory_filename, categories, items);
 	std::string gzip_filename(inventory_filename);
 	gzip_filename.append(".gz");
+	std::string binary_filename = llformat(BINARY_CACHE_FORMAT_STRING,
+										   path.c_str());
+
+	static LLCachedControl<bool> binary_cache(gSavedSettings,
+											  "InventoryBinaryCache");
+	if (binary_cache)
+	{
+		if (saveToBinaryFile(binary_filename, categories, items))
+		{
+			// The legacy cache, if any, is now stale (and converted).
+			LLFile::remove(gzip_filename);
+		}
+		return;
+	}
+
+	// The binary cache, if any, would take precedence over the legacy one on
+	// next login: remove it.
+	LLFile::remove(binary_filename);
+	saveToFile(inventory_filename, categories, items);
 	if (gzip_file(inventory_filename, gzip_filename))
 	{
 		LL_DEBUGS("Inventory") << "Successfully compressed "
@@ -1474,6 +1504,15 @@ bool LLInventoryModel::loadSkeleton(const LLSD& options, const LLUUID& owner_id)
 	LL_DEBUGS("LoadInventory") << "Importing inventory skeleton for "
 							   << owner_id << LL_ENDL;
 
+#if LL_INVENTORY_CACHE_BENCHMARK
+	static bool benchmarked = false;
+	if (!benchmarked)
+	{
+		benchmarked = true;
+		benchmarkCache(200000);
+	}
+#endif
+
 	typedef std::set<LLPointer<LLViewerInventoryCategory>, InventoryIDPtrLess> cat_set_t;
 	cat_set_t temp_cats;
 	bool rv = true;
@@ -1529,33 +1568,49 @@ bool LLInventoryModel::loadSkeleton(const LLSD& options, const LLUUID& owner_id)
 		const S32 NO_VERSION = LLViewerInventoryCategory::VERSION_UNKNOWN;
 		std::string gzip_filename(inventory_filename);
 		gzip_filename.append(".gz");
-		LLFILE* fp = LLFile::fopen(gzip_filename, "rb");
+		std::string binary_filename = llformat(BINARY_CACHE_FORMAT_STRING,
+											   path.c_str());
 		bool remove_inventory_file = false;
-		if (fp)
+		bool is_cache_obsolete = false;
+		bool loaded;
+		if (LLFile::isfile(binary_filename))
 		{
-			fclose(fp);
-			fp = NULL;
-			if (gunzip_file(gzip_filename, inventory_filename))
-			{
-				// we only want to remove the inventory file if it was
-				// gzipped before we loaded, and we successfully
-				// gunziped it.
-				remove_inventory_file = true;
-			}
-			else
+			loaded = loadFromBinaryFile(binary_filename, categories, items,
+										is_cache_obsolete);
+		}
+		else
+		{
+			// Legacy text cache, which will get converted to the binary
+			// format on next save, if InventoryBinaryCache is TRUE.
+			LLFILE* fp = LLFile::fopen(gzip_filename, "rb");
+			if (fp)
 			{
-				llinfos << "Unable to gunzip " << gzip_filename << llendl;
+				fclose(fp);
+				fp = NULL;
+				if (gunzip_file(gzip_filename, inventory_filename))
+				{
+					// we only want to remove the inventory file if it was
+					// gzipped before we loaded, and we successfully
+					// gunziped it.
+					remove_inventory_file = true;
+				}
+				else
+				{
+					llinfos << "Unable to gunzip " << gzip_filename << llendl;
+				}
 			}
+			loaded = loadFromFile(inventory_filename, categories, items,
+								  is_cache_obsolete);
 		}
-		bool is_cache_obsolete = false;
-		if (loadFromFile(inventory_filename, categories, items,
-						 is_cache_obsolete))
+		if (loaded)
 		{
 			// We were able to find a cache of files. So, use what we
 			// found to generate a set of categories we should add. We
 			// will go through each category loaded and if the version
 			// does not match, invalidate the version.
 			S32 count = categories.count();
+			mCategoryMap.reserve(mCategoryMap.size() + count);
+			mItemMap.reserve(mItemMap.size() + items.count());
 			cat_set_t::iterator not_cached = temp_cats.end();
 			std::set<LLUUID> cached_ids;
 			for (S32 i = 0; i < count; ++i)
@@ -1738,6 +1793,7 @@ bool LLInventoryModel::loadSkeleton(const LLSD& options, const LLUUID& owner_id)
 			// If out of date, remove the gzipped file too.
 			llwarns << "Inv cache out of date, removing" << llendl;
 			LLFile::remove(gzip_filename);
+			LLFile::remove(binary_filename);
 		}
 		categories.clear(); // will unref and delete entries
 	}
@@ -1788,6 +1844,9 @@ void LLInventoryModel::buildParentChildMap()
 	cat_array_t* catsp;
 	item_array_t* itemsp;
 
+	// One entry per category, plus the null UUID one for the root
+	mParentChildCategoryTree.reserve(mCategoryMap.size() + 1);
+	mParentChildItemTree.reserve(mCategoryMap.size());
 	for (cat_map_t::iterator cit = mCategoryMap.begin();
 		 cit != mCategoryMap.end(); ++cit)
 	{
@@ -1974,10 +2033,88 @@ void LLInventoryModel::buildParentChildMap()
 			llinfos << "Inventory initialized, notifying observers" << llendl;
 			addChangedMask(LLInventoryObserver::ALL, LLUUID::null);
 			notifyObservers();
+#if LL_INVENTORY_INDEX_BENCHMARK
+			benchmarkIndex();
+#endif
 		}
 	}
 }
 
+#if LL_INVENTORY_INDEX_BENCHMARK
+void LLInventoryModel::benchmarkIndex()
+{
+	const S32 LOOKUPS = 1000000;
+	const S32 item_count = mItemMap.size();
+	if (!item_count)
+	{
+		return;
+	}
+
+	std::vector<LLUUID> ids;
+	ids.reserve(item_count);
+	std::map<LLUUID, LLPointer<LLViewerInventoryItem> > std_map;
+	for (item_map_t::iterator it = mItemMap.begin(), end = mItemMap.end();
+		 it != end; ++it)
+	{
+		ids.push_back(it->first);
+	}
+
+	// Bulk updates
+	LLTimer timer;
+	for (S32 i = 0; i < item_count; ++i)
+	{
+		std_map[ids[i]] = mItemMap.find(ids[i])->second;
+	}
+	F32 std_insert = timer.getElapsedTimeAndResetF32();
+	item_map_t flat_map;
+	for (S32 i = 0; i < item_count; ++i)
+	{
+		flat_map[ids[i]] = mItemMap.find(ids[i])->second;
+	}
+	F32 flat_insert = timer.getElapsedTimeAndResetF32();
+
+	// Lookups, in a cache unfriendly order
+	S32 found = 0;
+	for (S32 i = 0; i < LOOKUPS; ++i)
+	{
+		found += std_map.count(ids[(i * 7919) % item_count]);
+	}
+	F32 std_lookup = timer.getElapsedTimeAndResetF32();
+	for (S32 i = 0; i < LOOKUPS; ++i)
+	{
+		found += flat_map.count(ids[(i * 7919) % item_count]);
+	}
+	F32 flat_lookup = timer.getElapsedTimeAndResetF32();
+
+	// Erasures
+	for (S32 i = 0; i < item_count; ++i)
+	{
+		std_map.erase(ids[i]);
+	}
+	F32 std_erase = timer.getElapsedTimeAndResetF32();
+	for (S32 i = 0; i < item_count; ++i)
+	{
+		flat_map.erase(ids[i]);
+	}
+	F32 flat_erase = timer.getElapsedTimeAndResetF32();
+
+	// Descendents collection over the whole inventory
+	cat_array_t cats;
+	item_array_t items;
+	collectDescendents(getRootFolderID(), cats, items, INCLUDE_TRASH);
+	F32 collect = timer.getElapsedTimeF32();
+
+	llinfos << "Inventory index benchmark with " << item_count
+			<< " items - Insertions: std::map " << std_insert
+			<< "s, flat map " << flat_insert << "s - " << LOOKUPS
+			<< " lookups: std::map " << std_lookup << "s, flat map "
+			<< flat_lookup << "s (" << found << " found) - Erasures: std::map "
+			<< std_erase << "s, flat map " << flat_erase
+			<< "s - Collection of " << cats.count() << " categories and "
+			<< items.count() << " items: " << collect << "s" << llendl;
+}
+#endif
+
 struct LLUUIDAndName
 {
 	LLUUIDAndName() {}
@@ -2153,6 +2290,481 @@ bool LLInventoryModel::saveToFile(const std::string& filename,
 	return true;
 }
 
+///----------------------------------------------------------------------------
+/// Binary inventory cache
+///----------------------------------------------------------------------------
+
+// The binary cache file is made of a header, followed by the categories and
+// items fixed size records, then by a string pool holding the names and
+// descriptions. Integers are stored in the host byte order (a foreign one is
+// detected thanks to the magic number, and causes the cache to be ignored).
+// Increment this whenever the layout of the records changes.
+const U32 INV_BINARY_CACHE_FORMAT = 1;
+const U32 INV_BINARY_CACHE_MAGIC = 0x4c4c4943;	// "CILL" in little endian
+
+struct LLInvCacheHeader
+{
+	U32 mMagic;
+	U32 mFormat;
+	S32 mCacheVersion;		// LLInventoryModel::sCurrentInvCacheVersion
+	U32 mCategoryCount;
+	U32 mItemCount;
+	U32 mStringPoolSize;
+};
+
+struct LLInvCacheString
+{
+	U32 mOffset;
+	U32 mLength;
+};
+
+struct LLInvCacheCategory
+{
+	U8					mUUID[UUID_BYTES];
+	U8					mParentUUID[UUID_BYTES];
+	U8					mOwnerID[UUID_BYTES];
+	LLInvCacheString	mName;
+	S32					mVersion;
+	S32					mPreferredType;
+};
+
+struct LLInvCacheItem
+{
+	U8					mUUID[UUID_BYTES];
+	U8					mParentUUID[UUID_BYTES];
+	U8					mAssetUUID[UUID_BYTES];
+	U8					mCreator[UUID_BYTES];
+	U8					mOwner[UUID_BYTES];
+	U8					mLastOwner[UUID_BYTES];
+	U8					mGroup[UUID_BYTES];
+	LLInvCacheString	mName;
+	LLInvCacheString	mDescription;
+	U32					mMaskBase;
+	U32					mMaskOwner;
+	U32					mMaskGroup;
+	U32					mMaskEveryone;
+	U32					mMaskNextOwner;
+	U32					mFlags;
+	S32					mCreationDate;
+	S32					mSalePrice;
+	S8					mType;
+	S8					mInventoryType;
+	U8					mSaleType;
+	U8					mPadding;
+};
+
+static LLInvCacheString add_cache_string(std::string& pool,
+										 const std::string& str)
+{
+	LLInvCacheString result;
+	result.mOffset = pool.size();
+	result.mLength = str.size();
+	pool.append(str);
+	return result;
+}
+
+static bool get_cache_string(const char* pool, U32 pool_size,
+							 const LLInvCacheString& str, std::string& result)
+{
+	if (str.mOffset > pool_size || str.mLength > pool_size - str.mOffset)
+	{
+		return false;
+	}
+	result.assign(pool + str.mOffset, str.mLength);
+	return true;
+}
+
+// static
+bool LLInventoryModel::loadFromBinaryFile(const std::string& filename,
+										  LLInventoryModel::cat_array_t& categories,
+										  LLInventoryModel::item_array_t& items,
+										  bool& is_cache_obsolete)
+{
+	if (filename.empty())
+	{
+		llerrs << "Filename is Null!" << llendl;
+		return false;
+	}
+	llinfos << "LLInventoryModel::loadFromBinaryFile(" << filename << ")"
+			<< llendl;
+	is_cache_obsolete = true;  		// Obsolete until proven current
+
+	LLFILE* file = LLFile::fopen(filename, "rb");		/*Flawfinder: ignore*/
+	if (!file)
+	{
+		llinfos << "Unable to load inventory from: " << filename << llendl;
+		return false;
+	}
+	// Read the whole file at once
+	std::vector<U8> buffer;
+	bool read_ok = false;
+	if (fseek(file, 0, SEEK_END) == 0)
+	{
+		long size = ftell(file);
+		if (size > 0 && fseek(file, 0, SEEK_SET) == 0)
+		{
+			buffer.resize(size);
+			read_ok = fread(&buffer[0], 1, size, file) == (size_t)size;
+		}
+	}
+	fclose(file);
+	if (!read_ok || buffer.size() < sizeof(LLInvCacheHeader))
+	{
+		llwarns << "Unable to read inventory cache: " << filename << llendl;
+		return false;
+	}
+
+	LLInvCacheHeader header;
+	memcpy(&header, &buffer[0], sizeof(LLInvCacheHeader));
+	if (header.mMagic != INV_BINARY_CACHE_MAGIC ||
+		header.mFormat != INV_BINARY_CACHE_FORMAT ||
+		header.mCacheVersion != sCurrentInvCacheVersion)
+	{
+		// Cache is out of date
+		return false;
+	}
+	const size_t cats_size = (size_t)header.mCategoryCount *
+							 sizeof(LLInvCacheCategory);
+	const size_t items_size = (size_t)header.mItemCount *
+							  sizeof(LLInvCacheItem);
+	if (buffer.size() != sizeof(LLInvCacheHeader) + cats_size + items_size +
+						 header.mStringPoolSize)
+	{
+		llwarns << "Truncated or corrupted inventory cache: " << filename
+				<< llendl;
+		return false;
+	}
+	is_cache_obsolete = false;
+
+	const U8* cats_data = &buffer[0] + sizeof(LLInvCacheHeader);
+	const U8* items_data = cats_data + cats_size;
+	const char* pool = (const char*)(items_data + items_size);
+	const U32 pool_size = header.mStringPoolSize;
+
+	std::string name;
+	LLUUID id, parent_id, owner_id;
+	categories.reserve(categories.size() + header.mCategoryCount);
+	for (U32 i = 0; i < header.mCategoryCount; ++i)
+	{
+		LLInvCacheCategory record;
+		memcpy(&record, cats_data + i * sizeof(LLInvCacheCategory),
+			   sizeof(LLInvCacheCategory));
+		if (!get_cache_string(pool, pool_size, record.mName, name))
+		{
+			llwarns << "Ignoring invalid inventory category record " << i
+					<< llendl;
+			continue;
+		}
+		memcpy(id.mData, record.mUUID, UUID_BYTES);
+		memcpy(parent_id.mData, record.mParentUUID, UUID_BYTES);
+		memcpy(owner_id.mData, record.mOwnerID, UUID_BYTES);
+		LLPointer<LLViewerInventoryCategory> inv_cat;
+		inv_cat = new LLViewerInventoryCategory(id, parent_id,
+												(LLFolderType::EType)record.mPreferredType,
+												name, owner_id);
+		inv_cat->setVersion(record.mVersion);
+		categories.put(inv_cat);
+	}
+
+	std::string desc;
+	LLUUID asset_id, creator_id, last_owner_id, group_id;
+	items.reserve(items.size() + header.mItemCount);
+	for (U32 i = 0; i < header.mItemCount; ++i)
+	{
+		LLInvCacheItem record;
+		memcpy(&record, items_data + i * sizeof(LLInvCacheItem),
+			   sizeof(LLInvCacheItem));
+		memcpy(id.mData, record.mUUID, UUID_BYTES);
+		if (id.isNull())
+		{
+			llwarns << "Ignoring inventory with null item id in record " << i
+					<< llendl;
+			continue;
+		}
+		if (!get_cache_string(pool, pool_size, record.mName, name) ||
+			!get_cache_string(pool, pool_size, record.mDescription, desc))
+		{
+			llwarns << "Ignoring invalid inventory item: " << id << llendl;
+			continue;
+		}
+		memcpy(parent_id.mData, record.mParentUUID, UUID_BYTES);
+		memcpy(asset_id.mData, record.mAssetUUID, UUID_BYTES);
+		memcpy(creator_id.mData, record.mCreator, UUID_BYTES);
+		memcpy(owner_id.mData, record.mOwner, UUID_BYTES);
+		memcpy(last_owner_id.mData, record.mLastOwner, UUID_BYTES);
+		memcpy(group_id.mData, record.mGroup, UUID_BYTES);
+
+		// Same as LLPermissions::importFile()
+		LLPermissions perm;
+		perm.init(creator_id, owner_id, last_owner_id, group_id);
+		perm.setMaskBase(record.mMaskBase);
+		perm.setMaskOwner(record.mMaskOwner);
+		perm.setMaskGroup(record.mMaskGroup);
+		perm.setMaskEveryone(record.mMaskEveryone);
+		perm.setMaskNext(record.mMaskNextOwner);
+		perm.fix();
+
+		// Same as LLInventoryItem::importFile(): deal with bad inventory
+		// types, before the constructor initializes the permission masks.
+		LLAssetType::EType asset_type = (LLAssetType::EType)record.mType;
+		LLInventoryType::EType inv_type =
+			(LLInventoryType::EType)record.mInventoryType;
+		if (inv_type == LLInventoryType::IT_NONE ||
+			!inventory_and_asset_types_match(inv_type, asset_type))
+		{
+			LL_DEBUGS("Inventory") << "Resetting inventory type for " << id
+								   << LL_ENDL;
+			inv_type = LLInventoryType::defaultForAssetType(asset_type);
+		}
+
+		LLPointer<LLViewerInventoryItem> inv_item;
+		inv_item = new LLViewerInventoryItem(id, parent_id, perm, asset_id,
+											 asset_type, inv_type,
+											 name, desc,
+											 LLSaleInfo((LLSaleInfo::EForSale)record.mSaleType,
+														record.mSalePrice),
+											 record.mFlags,
+											 record.mCreationDate);
+		// Like for importFileLocal()
+		inv_item->setComplete(FALSE);
+		items.put(inv_item);
+	}
+
+	return true;
+}
+
+// static
+bool LLInventoryModel::saveToBinaryFile(const std::string& filename,
+										const cat_array_t& categories,
+										const item_array_t& items)
+{
+	if (filename.empty())
+	{
+		llerrs << "Filename is Null!" << llendl;
+		return false;
+	}
+	llinfos << "LLInventoryModel::saveToBinaryFile(" << filename << ")"
+			<< llendl;
+
+	std::string pool;
+	std::vector<LLInvCacheCategory> cat_records;
+	cat_records.reserve(categories.count());
+	S32 count = categories.count();
+	S32 i;
+	for (i = 0; i < count; ++i)
+	{
+		LLViewerInventoryCategory* cat = categories[i];
+		if (cat->getVersion() == LLViewerInventoryCategory::VERSION_UNKNOWN)
+		{
+			continue;
+		}
+		LLInvCacheCategory record;
+		memcpy(record.mUUID, cat->getUUID().mData, UUID_BYTES);
+		memcpy(record.mParentUUID, cat->getParentUUID().mData, UUID_BYTES);
+		memcpy(record.mOwnerID, cat->getOwnerID().mData, UUID_BYTES);
+		record.mName = add_cache_string(pool, cat->getName());
+		record.mVersion = cat->getVersion();
+		record.mPreferredType = cat->getPreferredType();
+		cat_records.push_back(record);
+	}
+
+	// Note: the non-virtual accessors are used, so to store the actual data
+	// of link items (and not the data of the items they point to), like
+	// LLInventoryItem::exportFile() does.
+	std::vector<LLInvCacheItem> item_records;
+	count = items.count();
+	item_records.resize(count);
+	for (i = 0; i < count; ++i)
+	{
+		const LLViewerInventoryItem* item = items[i];
+		const LLPermissions& perm = item->LLInventoryItem::getPermissions();
+		const LLSaleInfo& sale_info = item->LLInventoryItem::getSaleInfo();
+		LLInvCacheItem& record = item_records[i];
+		memcpy(record.mUUID, item->LLInventoryObject::getUUID().mData,
+			   UUID_BYTES);
+		memcpy(record.mParentUUID, item->getParentUUID().mData, UUID_BYTES);
+		memcpy(record.mAssetUUID,
+			   item->LLInventoryItem::getAssetUUID().mData, UUID_BYTES);
+		memcpy(record.mCreator, perm.getCreator().mData, UUID_BYTES);
+		memcpy(record.mOwner, perm.getOwner().mData, UUID_BYTES);
+		memcpy(record.mLastOwner, perm.getLastOwner().mData, UUID_BYTES);
+		memcpy(record.mGroup, perm.getGroup().mData, UUID_BYTES);
+		record.mName = add_cache_string(pool,
+										item->LLInventoryObject::getName());
+		record.mDescription = add_cache_string(pool,
+											   item->LLInventoryItem::getDescription());
+		record.mMaskBase = perm.getMaskBase();
+		record.mMaskOwner = perm.getMaskOwner();
+		record.mMaskGroup = perm.getMaskGroup();
+		record.mMaskEveryone = perm.getMaskEveryone();
+		record.mMaskNextOwner = perm.getMaskNextOwner();
+		record.mFlags = item->LLInventoryItem::getFlags();
+		record.mCreationDate = (S32)item->LLInventoryItem::getCreationDate();
+		record.mSalePrice = sale_info.getSalePrice();
+		record.mType = (S8)item->getActualType();
+		record.mInventoryType = (S8)item->LLInventoryItem::getInventoryType();
+		record.mSaleType = (U8)sale_info.getSaleType();
+		record.mPadding = 0;
+	}
+
+	LLInvCacheHeader header;
+	header.mMagic = INV_BINARY_CACHE_MAGIC;
+	header.mFormat = INV_BINARY_CACHE_FORMAT;
+	header.mCacheVersion = sCurrentInvCacheVersion;
+	header.mCategoryCount = cat_records.size();
+	header.mItemCount = item_records.size();
+	header.mStringPoolSize = pool.size();
+
+	LLFILE* file = LLFile::fopen(filename, "wb");		/*Flawfinder: ignore*/
+	if (!file)
+	{
+		llwarns << "unable to save inventory to: " << filename << llendl;
+		return false;
+	}
+	bool success = fwrite(&header, sizeof(LLInvCacheHeader), 1, file) == 1;
+	if (success && !cat_records.empty())
+	{
+		success = fwrite(&cat_records[0], sizeof(LLInvCacheCategory),
+						 cat_records.size(), file) == cat_records.size();
+	}
+	if (success && !item_records.empty())
+	{
+		success = fwrite(&item_records[0], sizeof(LLInvCacheItem),
+						 item_records.size(), file) == item_records.size();
+	}
+	if (success && !pool.empty())
+	{
+		success = fwrite(pool.data(), 1, pool.size(), file) == pool.size();
+	}
+	fclose(file);
+
+	if (!success)
+	{
+		llwarns << "Failed to write inventory cache: " << filename << llendl;
+		// Do not leave a truncated cache behind
+		LLFile::remove(filename);
+	}
+	return success;
+}
+
+// static
+bool LLInventoryModel::convertLegacyCache(const std::string& gzip_filename,
+										  const std::string& binary_filename)
+{
+	size_t length = gzip_filename.size();
+	if (length <= 3 || gzip_filename.compare(length - 3, 3, ".gz") != 0)
+	{
+		llwarns << "Not a gzipped inventory cache: " << gzip_filename
+				<< llendl;
+		return false;
+	}
+	std::string inventory_filename(gzip_filename, 0, length - 3);
+	if (!gunzip_file(gzip_filename, inventory_filename))
+	{
+		llwarns << "Unable to gunzip " << gzip_filename << llendl;
+		return false;
+	}
+
+	cat_array_t categories;
+	item_array_t items;
+	bool is_cache_obsolete = false;
+	bool success = loadFromFile(inventory_filename, categories, items,
+								is_cache_obsolete) &&
+				   saveToBinaryFile(binary_filename, categories, items);
+	LLFile::remove(inventory_filename);
+	if (success)
+	{
+		llinfos << "Converted " << categories.count() << " categories and "
+				<< items.count() << " items from " << gzip_filename << llendl;
+	}
+	return success;
+}
+
+#if LL_INVENTORY_CACHE_BENCHMARK
+// static
+void LLInventoryModel::benchmarkCache(S32 item_count)
+{
+	const S32 ITEMS_PER_CATEGORY = 100;
+	const LLUUID& owner_id = gAgent.getID();
+	LLPermissions perm;
+	perm.init(owner_id, owner_id, LLUUID::null, LLUUID::null);
+
+	// Build a synthetic inventory
+	cat_array_t categories;
+	item_array_t items;
+	LLUUID root_id;
+	root_id.generate();
+	LLPointer<LLViewerInventoryCategory> cat;
+	for (S32 i = 0; i < item_count; ++i)
+	{
+		if (i % ITEMS_PER_CATEGORY == 0)
+		{
+			LLUUID cat_id;
+			cat_id.generate();
+			cat = new LLViewerInventoryCategory(cat_id, root_id,
+												LLFolderType::FT_NONE,
+												llformat("Folder %d", i),
+												owner_id);
+			cat->setVersion(1);
+			categories.put(cat);
+		}
+		LLUUID item_id, asset_id;
+		item_id.generate();
+		asset_id.generate();
+		items.put(new LLViewerInventoryItem(item_id, cat->getUUID(), perm,
+											asset_id, LLAssetType::AT_NOTECARD,
+											LLInventoryType::IT_NOTECARD,
+											llformat("Benchmark item %d", i),
+											"Synthetic item", LLSaleInfo::DEFAULT,
+											0, time_corrected()));
+	}
+
+	std::string path = gDirUtilp->getExpandedFilename(LL_PATH_CACHE,
+													  "inventory_benchmark");
+	std::string inventory_filename = path + ".inv";
+	std::string gzip_filename = inventory_filename + ".gz";
+	std::string binary_filename = path + ".invb";
+
+	LLTimer timer;
+	saveToFile(inventory_filename, categories, items);
+	gzip_file(inventory_filename, gzip_filename);
+	F32 legacy_save = timer.getElapsedTimeAndResetF32();
+
+	saveToBinaryFile(binary_filename, categories, items);
+	F32 binary_save = timer.getElapsedTimeAndResetF32();
+
+	convertLegacyCache(gzip_filename, binary_filename);
+	F32 convert = timer.getElapsedTimeAndResetF32();
+
+	cat_array_t loaded_cats;
+	item_array_t loaded_items;
+	bool is_cache_obsolete = false;
+	gunzip_file(gzip_filename, inventory_filename);
+	loadFromFile(inventory_filename, loaded_cats, loaded_items,
+				 is_cache_obsolete);
+	F32 legacy_load = timer.getElapsedTimeAndResetF32();
+	S32 legacy_count = loaded_items.count();
+	loaded_cats.clear();
+	loaded_items.clear();
+
+	loadFromBinaryFile(binary_filename, loaded_cats, loaded_items,
+					   is_cache_obsolete);
+	F32 binary_load = timer.getElapsedTimeAndResetF32();
+	S32 binary_count = loaded_items.count();
+
+	LLFile::remove(inventory_filename);
+	LLFile::remove(gzip_filename);
+	LLFile::remove(binary_filename);
+
+	llinfos << "Inventory cache benchmark with " << item_count
+			<< " items - Legacy: save " << legacy_save << "s, load "
+			<< legacy_load << "s (" << legacy_count
+			<< " items) - Binary: save " << binary_save << "s, load "
+			<< binary_load << "s (" << binary_count
+			<< " items) - Conversion: " << convert << "s" << llendl;
+}
+#endif
+
 // message handling functionality
 // static
 void LLInventoryModel::registerCallbacks(LLMessageSystem* msg)
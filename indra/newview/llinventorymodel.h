@@ -37,6 +37,7 @@
 #include "llfoldertype.h"
 #include "lldarray.h"
 #include "lluuid.h"
+#include "lluuidflatmap.h"
 #include "llpermissionsflags.h"
 #include "llstring.h"
 
@@ -45,6 +46,13 @@
 #include <string>
 #include <vector>
 
+// Set to 1 to benchmark the legacy and binary inventory caches with a
+// synthetic 200k items inventory on login.
+#define LL_INVENTORY_CACHE_BENCHMARK 0
+// Set to 1 to benchmark the inventory indices (lookups, descendents
+// collection and bulk updates) once the inventory is loaded.
+#define LL_INVENTORY_INDEX_BENCHMARK 0
+
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 // Class LLInventoryObserver
 //
@@ -196,14 +204,16 @@ private:
 	// Information for tracking the actual inventory. We index this
 	// information in a lot of different ways so we can access
 	// the inventory using several different identifiers.
-	// mCategoryMap and mItemMap store uuid->object mappings. 
-	typedef std::map<LLUUID, LLPointer<LLViewerInventoryCategory> > cat_map_t;
-	typedef std::map<LLUUID, LLPointer<LLViewerInventoryItem> > item_map_t;
+	// mCategoryMap and mItemMap store uuid->object mappings. They are flat
+	// hash maps, since they get huge with large inventories and lookups are
+	// done all the time.
+	typedef LLUUIDFlatMap<LLPointer<LLViewerInventoryCategory> > cat_map_t;
+	typedef LLUUIDFlatMap<LLPointer<LLViewerInventoryItem> > item_map_t;
 	cat_map_t mCategoryMap;
 	item_map_t mItemMap;
 	// This last set of indices is used to map parents to children.
-	typedef std::map<LLUUID, cat_array_t*> parent_cat_map_t;
-	typedef std::map<LLUUID, item_array_t*> parent_item_map_t;
+	typedef LLUUIDFlatMap<cat_array_t*> parent_cat_map_t;
+	typedef LLUUIDFlatMap<item_array_t*> parent_item_map_t;
 	parent_cat_map_t mParentChildCategoryTree;
 	parent_item_map_t mParentChildItemTree;
 
@@ -254,6 +264,15 @@ public:
 							  item_array_t& items,
 							  BOOL include_trash,
 							  LLInventoryCollectFunctor& add);
+private:
+	// Does the actual work for collectDescendentsIf(): trash_id is the UUID
+	// of the trash to skip (LLUUID::null to include the trash).
+	void collectDescendentsIfHelper(const LLUUID& id,
+									cat_array_t& categories,
+									item_array_t& items,
+									const LLUUID& trash_id,
+									LLInventoryCollectFunctor& add);
+public:
 
 	// Check if one object has a parent chain up to the category specified by UUID.
 	BOOL isObjectDescendentOf(const LLUUID& obj_id, const LLUUID& cat_id);
@@ -481,6 +500,27 @@ protected:
 	static bool saveToFile(const std::string& filename,
 						   const cat_array_t& categories,
 						   const item_array_t& items); 
+	// Binary cache format: fixed size records and a string pool, loaded
+	// with a single read and no parsing.
+	static bool loadFromBinaryFile(const std::string& filename,
+								   cat_array_t& categories,
+								   item_array_t& items,
+								   bool& is_cache_obsolete);
+	static bool saveToBinaryFile(const std::string& filename,
+								 const cat_array_t& categories,
+								 const item_array_t& items);
+public:
+	// Converts a (gzipped) legacy text cache into a binary one.
+	static bool convertLegacyCache(const std::string& gzip_filename,
+								   const std::string& binary_filename);
+#if LL_INVENTORY_CACHE_BENCHMARK
+	// Compares the legacy and binary caches load and save times with a
+	// synthetic inventory.
+	static void benchmarkCache(S32 item_count);
+#endif
+#if LL_INVENTORY_INDEX_BENCHMARK
+	void benchmarkIndex();
+#endif
 
 	//--------------------------------------------------------------------
 	// Message handling functionality
@@ -213,7 +213,7 @@ LLScrollListItem* LLNameListCtrl::addElement(const LLSD& value, EAddPosition pos
 	LLScrollListCell* cell = (LLScrollListCell*)item->getColumn(mNameColumnIndex);
 	((LLScrollListText*)cell)->setText(fullname);
 
-	dirtyColumns();
+	dirtyItemColumns(item);
 
 	// this column is resizable
 	LLScrollListColumn* columnp = getColumn(mNameColumnIndex);
@@ -243,22 +243,18 @@ void LLNameListCtrl::removeNameItem(const LLUUID& agent_id)
 void LLNameListCtrl::refresh(const LLUUID& id, const std::string& fullname,
 							 bool is_group)
 {
-	// TODO: scan items for that ID, fix if necessary
-	for (item_list::iterator iter = getItemList().begin(),
-							 end = getItemList().end();
+	// Note: this is called for each name received by the viewer, on all the
+	// name lists, so the rows are looked up via their UUID index.
+	std::vector<LLScrollListItem*> items = getAllDataByID(id);
+	for (std::vector<LLScrollListItem*>::iterator iter = items.begin(),
+												  end = items.end();
 		 iter != end; ++iter)
 	{
 		LLScrollListItem* item = *iter;
-		if (item->getUUID() == id)
-		{
-			LLScrollListCell* cell = (LLScrollListCell*)item->getColumn(0);
-			cell = (LLScrollListCell*)item->getColumn(mNameColumnIndex);
-
-			((LLScrollListText*)cell)->setText(fullname);
-		}
+		LLScrollListCell* cell = (LLScrollListCell*)item->getColumn(mNameColumnIndex);
+		((LLScrollListText*)cell)->setText(fullname);
+		dirtyItemColumns(item);
 	}
-
-	dirtyColumns();
 }
 
 // static
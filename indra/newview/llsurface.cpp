@@ -618,6 +618,13 @@ void LLSurface::updatePatchVisibilities(LLAgent &agent)
 
 BOOL LLSurface::idleUpdate(F32 max_update_time)
 {
+	// Upload the terrain texels composited in the background, if any.
+	LLVLComposition* compp = mRegionp ? mRegionp->getComposition() : NULL;
+	if (compp)
+	{
+		compp->updateTiles();
+	}
+
 	if (!gPipeline.hasRenderType(LLPipeline::RENDER_TYPE_TERRAIN))
 	{
 		return FALSE;
@@ -662,10 +669,19 @@ BOOL LLSurface::idleUpdate(F32 max_update_time)
 void LLSurface::decompressDCTPatch(LLBitPack& bitpack, LLGroupHeader* gopp,
 								   BOOL b_large_patch)
 {
+	// All the patches of the message are first decoded from the bit stream,
+	// then decompressed in a batch (which keeps the IDCT tables in the CPU
+	// caches), and finally the edges of the decompressed patches and of their
+	// neighbours are updated, once per patch.
+	static std::vector<LLPatchHeader> headers;
+	static std::vector<LLSurfacePatch*> patches;
+	static std::vector<S32> coeffs;
+	const S32 patch_coeffs = LARGE_PATCH_SIZE * LARGE_PATCH_SIZE;
+	headers.clear();
+	patches.clear();
+
 	LLPatchHeader  ph;
 	S32 j, i;
-	S32 patch[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE];
-	LLSurfacePatch *patchp;
 
 	init_patch_decompressor(gopp->patch_size);
 	gopp->stride = mGridsPerEdge;
@@ -693,29 +709,77 @@ void LLSurface::decompressDCTPatch(LLBitPack& bitpack, LLGroupHeader* gopp,
 			return;
 		}
 
-		patchp = &mPatchList[j*mPatchesPerEdge + i];
+		size_t count = headers.size();
+		if (coeffs.size() < (count + 1) * patch_coeffs)
+		{
+			coeffs.resize((count + 1) * patch_coeffs);
+		}
+		decode_patch(bitpack, &coeffs[count * patch_coeffs]);
+
+		headers.push_back(ph);
+		patches.push_back(&mPatchList[j*mPatchesPerEdge + i]);
+	}
 
-		decode_patch(bitpack, patch);
-		decompress_patch(patchp->getDataZ(), patch, &ph);
+	if (patches.empty())
+	{
+		return;
+	}
 
-		// Update edges for neighbors.  Need to guarantee that this gets done
-		// before we generate vertical stats.
-		patchp->updateNorthEdge();
-		patchp->updateEastEdge();
-		if (patchp->getNeighborPatch(WEST))
+	LLSurfacePatch *patchp;
+	for (size_t k = 0, count = patches.size(); k < count; k++)
+	{
+		patchp = patches[k];
+		decompress_patch(patchp->getDataZ(), &coeffs[k * patch_coeffs],
+						 &headers[k]);
+	}
+
+	// Update edges for neighbors.  Need to guarantee that this gets done
+	// before we generate vertical stats.
+	static std::vector<LLSurfacePatch*> east_edges;
+	static std::vector<LLSurfacePatch*> north_edges;
+	east_edges.clear();
+	north_edges.clear();
+	LLSurfacePatch *neighborp;
+	for (size_t k = 0, count = patches.size(); k < count; k++)
+	{
+		patchp = patches[k];
+		north_edges.push_back(patchp);
+		east_edges.push_back(patchp);
+		neighborp = patchp->getNeighborPatch(WEST);
+		if (neighborp)
 		{
-			patchp->getNeighborPatch(WEST)->updateEastEdge();
+			east_edges.push_back(neighborp);
 		}
-		if (patchp->getNeighborPatch(SOUTHWEST))
+		neighborp = patchp->getNeighborPatch(SOUTHWEST);
+		if (neighborp)
 		{
-			patchp->getNeighborPatch(SOUTHWEST)->updateEastEdge();
-			patchp->getNeighborPatch(SOUTHWEST)->updateNorthEdge();
+			east_edges.push_back(neighborp);
+			north_edges.push_back(neighborp);
 		}
-		if (patchp->getNeighborPatch(SOUTH))
+		neighborp = patchp->getNeighborPatch(SOUTH);
+		if (neighborp)
 		{
-			patchp->getNeighborPatch(SOUTH)->updateNorthEdge();
+			north_edges.push_back(neighborp);
 		}
+	}
+	std::sort(north_edges.begin(), north_edges.end());
+	north_edges.erase(std::unique(north_edges.begin(), north_edges.end()),
+					  north_edges.end());
+	std::sort(east_edges.begin(), east_edges.end());
+	east_edges.erase(std::unique(east_edges.begin(), east_edges.end()),
+					 east_edges.end());
+	for (size_t k = 0, count = north_edges.size(); k < count; k++)
+	{
+		north_edges[k]->updateNorthEdge();
+	}
+	for (size_t k = 0, count = east_edges.size(); k < count; k++)
+	{
+		east_edges[k]->updateEastEdge();
+	}
 
+	for (size_t k = 0, count = patches.size(); k < count; k++)
+	{
+		patchp = patches[k];
 		// Dirty patch statistics, and flag that the patch has data.
 		patchp->dirtyZ();
 		patchp->setHasReceivedData();
@@ -58,6 +58,8 @@ LLSurfacePatch::LLSurfacePatch() :
 	mDirty(FALSE),
 	mDirtyZStats(TRUE),
 	mHeightsGenerated(FALSE),
+	mTextureStamp(0),
+	mTextureDigest(0),
 	mDataOffset(0),
 	mDataZ(NULL),
 	mDataNorm(NULL),
@@ -738,15 +740,23 @@ void LLSurfacePatch::updateGL()
 
 	updateCompositionStats();
 	F32 tex_patch_size = meters_per_grid*grids_per_patch_edge;
-	if (comp->generateTexture((F32)origin_region[VX], (F32)origin_region[VY],
-							  tex_patch_size, tex_patch_size))
-	{
-		mSTexUpdate = FALSE;
+	// setTextureGenerated() gets called once the texels are up to date
+	comp->generateTexture((F32)origin_region[VX], (F32)origin_region[VY],
+						  tex_patch_size, tex_patch_size, this);
+}
 
-		// Also generate the water texture
-		mSurfacep->generateWaterTexture((F32)origin_region.mdV[VX], (F32)origin_region.mdV[VY],
-										tex_patch_size, tex_patch_size);
-	}
+void LLSurfacePatch::setTextureGenerated(U32 stamp, U32 digest)
+{
+	mSTexUpdate = FALSE;
+	mTextureStamp = stamp;
+	mTextureDigest = digest;
+
+	// Also generate the water texture
+	F32 tex_patch_size = getSurface()->getMetersPerGrid() *
+						 (F32)getSurface()->getGridsPerPatchEdge();
+	LLVector3d origin_region = getOriginGlobal() - getSurface()->getOriginGlobal();
+	mSurfacep->generateWaterTexture((F32)origin_region.mdV[VX], (F32)origin_region.mdV[VY],
+									tex_patch_size, tex_patch_size);
 }
 
 void LLSurfacePatch::dirtyZ()
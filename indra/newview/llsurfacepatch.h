@@ -92,6 +92,15 @@ public:
 	void updateVisibility();
 	void updateGL();
 
+	// Returns true when the surface texture texels of this patch were
+	// generated from the same inputs (see LLVLComposition::generateTexture()).
+	bool hasTexture(U32 stamp, U32 digest) const
+	{
+		return mTextureStamp == stamp && mTextureDigest == digest;
+	}
+	// Called by the composition once the texels of this patch are up to date
+	void setTextureGenerated(U32 stamp, U32 digest);
+
 	void dirtyZ(); // Dirty the z values of this patch
 	void setHasReceivedData();
 	BOOL getHasReceivedData() const;
@@ -156,6 +165,10 @@ protected:
 	BOOL mDirtyZStats;
 	BOOL mHeightsGenerated;
 
+	// Inputs of the last texture composition for this patch
+	U32 mTextureStamp;
+	U32 mTextureDigest;
+
 	U32 mDataOffset;
 	F32 *mDataZ;
 	LLVector3 *mDataNorm;
@@ -43,6 +43,7 @@
 #include "llagent.h"
 #include "llagentwearables.h"
 #include "llassetuploadresponders.h"
+#include "lltexlayercompositor.h"
 #include "lltexlayerparams.h"
 #include "llviewercontrol.h"
 #include "llviewerregion.h"
@@ -57,6 +58,10 @@ using namespace LLVOAvatarDefines;
 static const S32 BAKE_UPLOAD_ATTEMPTS = 7;
 static const F32 BAKE_UPLOAD_RETRY_DELAY = 2.f; // actual delay grows by power of 2 each attempt
 
+// Set to 1 to composite in software each bake done with GL, and log the
+// differences between both results.
+#define LL_TEXLAYER_COMPOSITOR_CHECK 0
+
 class LLTexLayerInfo
 {
 	friend class LLTexLayer;
@@ -124,6 +129,7 @@ LLTexLayerSetBuffer::LLTexLayerSetBuffer(LLTexLayerSet* const owner,
 	mNeedsUpload(FALSE),
 	mNumLowresUploads(0),
 	mUploadFailCount(0),
+	mSoftwareBakeFinal(false),
 	mNeedsUpdate(TRUE),
 	mNumLowresUpdates(0),
 	mTexLayerSet(owner)
@@ -180,6 +186,8 @@ void LLTexLayerSetBuffer::requestUpdate()
 
 void LLTexLayerSetBuffer::requestUpload()
 {
+	// Any software bake in progress is now outdated.
+	mSoftwareBake = NULL;
 	conditionalRestartUploadTimer();
 	mNeedsUpload = TRUE;
 	mNumLowresUploads = 0;
@@ -210,6 +218,7 @@ void LLTexLayerSetBuffer::restartUpdateTimer()
 
 void LLTexLayerSetBuffer::cancelUpload()
 {
+	mSoftwareBake = NULL;
 	mNeedsUpload = FALSE;
 	mUploadPending = FALSE;
 	mNeedsUploadTimer.pause();
@@ -242,6 +251,11 @@ BOOL LLTexLayerSetBuffer::needsRender()
 	llassert(mTexLayerSet->getAvatar() == gAgentAvatarp);
 	if (!isAgentAvatarValid()) return FALSE;
 
+	if (mSoftwareBake.notNull() && mSoftwareBake->isComposited())
+	{
+		finishSoftwareUpload();
+	}
+
 	const BOOL upload_now = mNeedsUpload && isReadyToUpload();
 	const BOOL update_now = mNeedsUpdate && isReadyToUpdate();
 
@@ -267,7 +281,19 @@ BOOL LLTexLayerSetBuffer::needsRender()
 	}
 
 	// Render if we have at least minimal level of detail for each local texture.
-	return mTexLayerSet->isLocalTextureDataAvailable();
+	if (!mTexLayerSet->isLocalTextureDataAvailable())
+	{
+		return FALSE;
+	}
+
+	// When only uploading, we do not need the GL composite and may bake in
+	// software instead.
+	if (upload_now && !update_now && startSoftwareUpload())
+	{
+		return FALSE;
+	}
+
+	return TRUE;
 }
 
 void LLTexLayerSetBuffer::preRender(BOOL clear_depth)
@@ -365,6 +391,7 @@ BOOL LLTexLayerSetBuffer::uploadInProgress() const
 
 BOOL LLTexLayerSetBuffer::isReadyToUpload() const
 {
+	if (mSoftwareBake.notNull()) return FALSE; // Already baking.
 	if (!gAgentQueryManager.hasNoPendingQueries()) return FALSE; // Can't upload if there are pending queries.
 	if (isAgentAvatarValid() && !gAgentAvatarp->isUsingBakedTextures()) return FALSE; // Don't upload if avatar is using composites.
 
@@ -446,10 +473,6 @@ BOOL LLTexLayerSetBuffer::requestUpdateImmediate()
 // back so we can switch to using it.
 void LLTexLayerSetBuffer::doUpload()
 {
-	llinfos << "Uploading baked " << mTexLayerSet->getBodyRegionName()
-			<< llendl;
-	LLViewerStats::getInstance()->incStat(LLViewerStats::ST_TEX_BAKES);
-
 	// Don't need caches since we're baked now (note: we won't *really* be baked
 	// until this image is sent to the server and the Avatar Appearance message
 	// is received).
@@ -488,6 +511,50 @@ void LLTexLayerSetBuffer::doUpload()
 		}
 	}
 
+	delete [] baked_color_data;
+
+#if LL_TEXLAYER_COMPOSITOR_CHECK
+	LLPointer<LLTexLayerCompositor> compositor =
+		new LLTexLayerCompositor(mFullWidth, mFullHeight);
+	if (mTexLayerSet->recordSoftwareBake(compositor))
+	{
+		compositor->composite();
+		const U8* soft_data = compositor->getBakedImage()->getData();
+		S32 max_diff[5] = { 0, 0, 0, 0, 0 };
+		F64 sum_diff[5] = { 0.0, 0.0, 0.0, 0.0, 0.0 };
+		S32 count = mFullWidth * mFullHeight;
+		for (S32 j = 0; j < count * 5; ++j)
+		{
+			S32 diff = abs((S32)baked_image_data[j] - (S32)soft_data[j]);
+			max_diff[j % 5] = llmax(max_diff[j % 5], diff);
+			sum_diff[j % 5] += (F64)diff;
+		}
+		llinfos << "Software bake of " << mTexLayerSet->getBodyRegionName()
+				<< " - Max/average differences per channel:";
+		for (S32 c = 0; c < 5; ++c)
+		{
+			llcont << " " << max_diff[c] << "/" << sum_diff[c] / (F64)count;
+		}
+		llcont << llendl;
+	}
+	else
+	{
+		llinfos << "Image data missing for software bake of "
+				<< mTexLayerSet->getBodyRegionName() << llendl;
+	}
+#endif
+
+	uploadBakedImage(baked_image, mTexLayerSet->isLocalTextureDataFinal());
+}
+
+// Encodes the 5 components baked image and sends it to the server.
+void LLTexLayerSetBuffer::uploadBakedImage(LLImageRaw* baked_image,
+										   bool highest_lod)
+{
+	llinfos << "Uploading baked " << mTexLayerSet->getBodyRegionName()
+			<< llendl;
+	LLViewerStats::getInstance()->incStat(LLViewerStats::ST_TEX_BAKES);
+
 	LLPointer<LLImageJ2C> compressedImage = new LLImageJ2C;
 	compressedImage->setRate(0.f);
 	// writes into baked_color_data. 5 channels (rgb, heightfield/alpha, mask)
@@ -518,7 +585,6 @@ void LLTexLayerSetBuffer::doUpload()
 
 			if (valid)
 			{
-				const bool highest_lod = mTexLayerSet->isLocalTextureDataFinal();
 				// Baked_upload_data is owned by the responder and deleted after the request completes.
 				LLBakedUploadData* baked_upload_data = new LLBakedUploadData(gAgentAvatarp,
 																			 this->mTexLayerSet,
@@ -589,8 +655,57 @@ void LLTexLayerSetBuffer::doUpload()
 		llinfos << "Unable to create baked upload file (reason: failed to write file)"
 				<< llendl;
 	}
+}
 
-	delete [] baked_color_data;
+// Records a bake of the layer set and queues it for compositing on the CPU.
+// Returns false when software baking is disabled, or when the image data it
+// needs is not (yet) all in memory, in which case the GL path must be used.
+bool LLTexLayerSetBuffer::startSoftwareUpload()
+{
+	static LLCachedControl<bool> software_baking(gSavedSettings,
+												 "AvatarSoftwareBaking");
+	if (!software_baking || mSoftwareBake.notNull())
+	{
+		return false;
+	}
+
+	LLPointer<LLTexLayerCompositor> compositor =
+		new LLTexLayerCompositor(mFullWidth, mFullHeight);
+	if (!mTexLayerSet->recordSoftwareBake(compositor))
+	{
+		LL_DEBUGS("Avatar") << "Image data missing for software bake of "
+							<< mTexLayerSet->getBodyRegionName()
+							<< ", using GL." << LL_ENDL;
+		return false;
+	}
+
+	if (!mTexLayerSet->isVisible())
+	{
+		mUploadPending = FALSE;
+		mNeedsUpload = FALSE;
+		mNeedsUploadTimer.pause();
+		mTexLayerSet->getAvatar()->setNewBakedTexture(mTexLayerSet->getBakedTexIndex(),
+													  IMG_INVISIBLE);
+		return true;
+	}
+
+	// Don't need caches since we're baked now
+	mTexLayerSet->deleteCaches();
+
+	mSoftwareBake = compositor;
+	mSoftwareBakeFinal = mTexLayerSet->isLocalTextureDataFinal();
+	LLTexLayerCompositor::queueComposite(compositor);
+	return true;
+}
+
+void LLTexLayerSetBuffer::finishSoftwareUpload()
+{
+	LLPointer<LLImageRaw> baked_image = mSoftwareBake->getBakedImage();
+	mSoftwareBake = NULL;
+	if (mNeedsUpload && baked_image.notNull())
+	{
+		uploadBakedImage(baked_image, mSoftwareBakeFinal);
+	}
 }
 
 // Mostly bookkeeping; don't need to actually "do" anything since
@@ -1142,6 +1257,139 @@ void LLTexLayerSet::renderAlphaMaskTextures(S32 x, S32 y, S32 width, S32 height,
 	gGL.setSceneBlendType(LLRender::BT_ALPHA);
 }
 
+BOOL LLTexLayerSet::recordSoftwareBake(LLTexLayerCompositor* compositor)
+{
+	// Color layers composite, as read back by LLTexLayerSetBuffer::doUpload()
+	BOOL success = renderSoftware(compositor);
+	compositor->snapshotColor();
+
+	// Morph masks, as gathered by gatherMorphMaskAlpha()
+	for (layer_list_t::iterator iter = mLayerList.begin(),
+								end = mLayerList.end();
+		 iter != end; ++iter)
+	{
+		LLTexLayerInterface* layer = *iter;
+		success &= layer->gatherAlphaMasksSoftware(compositor);
+	}
+
+	return success;
+}
+
+BOOL LLTexLayerSet::renderSoftware(LLTexLayerCompositor* compositor)
+{
+	BOOL success = TRUE;
+	mIsVisible = TRUE;
+
+	for (layer_list_t::iterator iter = mMaskLayerList.begin(),
+								end = mMaskLayerList.end();
+		 iter != end; ++iter)
+	{
+		LLTexLayerInterface* layer = *iter;
+		if (layer->isInvisibleAlphaMask())
+		{
+			mIsVisible = FALSE;
+		}
+	}
+
+	// LLGLSUIDefault state
+	compositor->setAlphaTest(true);
+	compositor->setSceneBlendType(LLRender::BT_ALPHA);
+	compositor->setTextureBlendType(LLTexUnit::TB_MULT);
+	compositor->setColorMask(true, true);
+
+	// clear buffer area
+	compositor->setAlphaTest(false);
+	compositor->color4f(0.f, 0.f, 0.f, 1.f);
+	compositor->drawRect();
+	compositor->setAlphaTest(true);
+
+	if (mIsVisible)
+	{
+		// composite color layers
+		for (layer_list_t::iterator iter = mLayerList.begin(),
+									end = mLayerList.end();
+			 iter != end; ++iter)
+		{
+			LLTexLayerInterface* layer = *iter;
+			if (layer->getRenderPass() == LLTexLayer::RP_COLOR ||
+				layer->getRenderPass() == LLTexLayer::RP_BUMP)
+			{
+				success &= layer->renderSoftware(compositor);
+			}
+		}
+
+		success &= renderAlphaMaskTexturesSoftware(compositor, false);
+	}
+	else
+	{
+		compositor->setSceneBlendType(LLRender::BT_REPLACE);
+		compositor->setAlphaTest(false);
+		compositor->color4f(0.f, 0.f, 0.f, 0.f);
+		compositor->drawRect();
+		compositor->setAlphaTest(true);
+		compositor->setSceneBlendType(LLRender::BT_ALPHA);
+	}
+
+	return success;
+}
+
+BOOL LLTexLayerSet::renderAlphaMaskTexturesSoftware(LLTexLayerCompositor* compositor,
+													bool force_clear)
+{
+	BOOL success = TRUE;
+	const LLTexLayerSetInfo* info = getInfo();
+
+	compositor->setColorMask(false, true);
+	compositor->setSceneBlendType(LLRender::BT_REPLACE);
+
+	// (Optionally) replace alpha with a single component image from a tga file.
+	if (!info->mStaticAlphaFileName.empty())
+	{
+		LLImageRaw* image = LLTexLayerStaticImageList::getInstance()->getImageRaw(info->mStaticAlphaFileName);
+		if (image)
+		{
+			bool alpha_test = compositor->getAlphaTest();
+			compositor->setAlphaTest(true);
+			compositor->setTextureBlendType(LLTexUnit::TB_REPLACE);
+			compositor->drawTexturedRect(image, true);
+			compositor->setAlphaTest(alpha_test);
+		}
+		else
+		{
+			success = FALSE;
+		}
+	}
+	else if (force_clear || info->mClearAlpha || mMaskLayerList.size() > 0)
+	{
+		// Set the alpha channel to one (clean up after previous blending)
+		bool alpha_test = compositor->getAlphaTest();
+		compositor->setAlphaTest(false);
+		compositor->color4f(0.f, 0.f, 0.f, 1.f);
+		compositor->drawRect();
+		compositor->setAlphaTest(alpha_test);
+	}
+
+	// (Optional) Mask out part of the baked texture with alpha masks
+	if (mMaskLayerList.size() > 0)
+	{
+		compositor->setSceneBlendType(LLRender::BT_MULT_ALPHA);
+		compositor->setTextureBlendType(LLTexUnit::TB_REPLACE);
+		for (layer_list_t::iterator iter = mMaskLayerList.begin(),
+									end = mMaskLayerList.end();
+			 iter != end; ++iter)
+		{
+			LLTexLayerInterface* layer = *iter;
+			success &= layer->blendAlphaTextureSoftware(compositor);
+		}
+	}
+
+	compositor->setTextureBlendType(LLTexUnit::TB_MULT);
+	compositor->setColorMask(true, true);
+	compositor->setSceneBlendType(LLRender::BT_ALPHA);
+
+	return success;
+}
+
 void LLTexLayerSet::applyMorphMask(U8* tex_data, S32 width, S32 height, S32 num_components)
 {
 	mAvatar->applyMorphMask(tex_data, width, height, num_components, mBakedTexIndex);
@@ -2062,6 +2310,257 @@ void LLTexLayer::addAlphaMask(U8* data, S32 originX, S32 originY, S32 width, S32
 	}
 }
 
+// Returns the decoded data of the local texture, when kept in memory. Asks for
+// it to be kept from now on, for the next bakes.
+LLImageRaw* LLTexLayer::getLocalTextureRaw() const
+{
+	LLViewerFetchedTexture* tex = mLocalTextureObject ? mLocalTextureObject->getImage()
+													  : NULL;
+	if (!tex)
+	{
+		return NULL;
+	}
+
+	tex->forceToSaveRawImage(0);
+	LLImageRaw* image = tex->getSavedRawImage();
+	return image && image->getData() ? image : NULL;
+}
+
+//virtual
+BOOL LLTexLayer::renderSoftware(LLTexLayerCompositor* compositor)
+{
+	LLColor4 net_color;
+	BOOL color_specified = findNetColor(&net_color);
+
+	if (mTexLayerSet->getAvatar()->mIsDummy)
+	{
+		color_specified = true;
+		net_color = LLVOAvatar::getDummyColor();
+	}
+
+	BOOL success = TRUE;
+
+	// If you can't see the layer, don't render it.
+	if (is_approx_zero(net_color.mV[VW]))
+	{
+		return success;
+	}
+
+	BOOL alpha_mask_specified = FALSE;
+	if (!mParamAlphaList.empty())
+	{
+		success &= renderMorphMasksSoftware(compositor, net_color);
+		alpha_mask_specified = TRUE;
+		compositor->blendFunc(LLRender::BF_DEST_ALPHA,
+							  LLRender::BF_ONE_MINUS_DEST_ALPHA);
+	}
+
+	compositor->color4fv(net_color.mV);
+
+	if (getInfo()->mWriteAllChannels)
+	{
+		compositor->setSceneBlendType(LLRender::BT_REPLACE);
+	}
+	else if (getInfo()->mUseLocalTextureAlphaOnly)
+	{
+		// Use the alpha channel only
+		compositor->setColorMask(false, true);
+	}
+
+	if (getInfo()->mLocalTexture != -1 && !getInfo()->mUseLocalTextureAlphaOnly &&
+		mLocalTextureObject && mLocalTextureObject->getImage() &&
+		mLocalTextureObject->getID() != IMG_DEFAULT_AVATAR)
+	{
+		LLImageRaw* image = getLocalTextureRaw();
+		if (image)
+		{
+			bool alpha_test = compositor->getAlphaTest();
+			if (getInfo()->mWriteAllChannels)
+			{
+				compositor->setAlphaTest(false);
+			}
+			compositor->drawTexturedRect(image);
+			compositor->setAlphaTest(alpha_test);
+		}
+		else
+		{
+			success = FALSE;
+		}
+	}
+
+	if (!getInfo()->mStaticImageFileName.empty())
+	{
+		LLImageRaw* image = LLTexLayerStaticImageList::getInstance()->getImageRaw(getInfo()->mStaticImageFileName);
+		if (image)
+		{
+			compositor->drawTexturedRect(image, getInfo()->mStaticImageIsMask);
+		}
+		else
+		{
+			success = FALSE;
+		}
+	}
+
+	if (color_specified && getInfo()->mStaticImageFileName.empty() &&
+		(getInfo()->mLocalTexture == -1 || getInfo()->mUseLocalTextureAlphaOnly))
+	{
+		bool alpha_test = compositor->getAlphaTest();
+		compositor->setAlphaTest(false);
+		compositor->color4fv(net_color.mV);
+		compositor->drawRect();
+		compositor->setAlphaTest(alpha_test);
+	}
+
+	if (alpha_mask_specified || getInfo()->mWriteAllChannels)
+	{
+		// Restore standard blend func value
+		compositor->setSceneBlendType(LLRender::BT_ALPHA);
+	}
+
+	if (getInfo()->mUseLocalTextureAlphaOnly)
+	{
+		// Restore color + alpha mode.
+		compositor->setColorMask(true, true);
+	}
+
+	return success;
+}
+
+BOOL LLTexLayer::renderMorphMasksSoftware(LLTexLayerCompositor* compositor,
+										  const LLColor4 &layer_color)
+{
+	BOOL success = TRUE;
+
+	llassert(!mParamAlphaList.empty());
+
+	compositor->setColorMask(false, true);
+
+	bool alpha_test = compositor->getAlphaTest();
+	compositor->setAlphaTest(false);
+
+	LLTexLayerParamAlpha* first_param = *mParamAlphaList.begin();
+	// Note: if the first param is a mulitply, multiply against the current
+	// buffer's alpha
+	if (!first_param || !first_param->getMultiplyBlend())
+	{
+		// Clear the alpha
+		compositor->setSceneBlendType(LLRender::BT_REPLACE);
+		compositor->color4f(0.f, 0.f, 0.f, 0.f);
+		compositor->drawRect();
+	}
+
+	// Accumulate alphas
+	compositor->color4f(1.f, 1.f, 1.f, 1.f);
+	for (param_alpha_list_t::iterator iter = mParamAlphaList.begin(),
+									  end = mParamAlphaList.end();
+		 iter != end; ++iter)
+	{
+		LLTexLayerParamAlpha* param = *iter;
+		success &= param->renderSoftware(compositor);
+	}
+
+	// Approximates a min() function
+	compositor->setSceneBlendType(LLRender::BT_MULT_ALPHA);
+
+	// Accumulate the alpha component of the texture
+	if (getInfo()->mLocalTexture != -1 && mLocalTextureObject)
+	{
+		LLViewerTexture* tex = mLocalTextureObject->getImage();
+		if (tex && tex->getComponents() == 4)
+		{
+			LLImageRaw* image = getLocalTextureRaw();
+			if (image)
+			{
+				compositor->drawTexturedRect(image);
+			}
+			else
+			{
+				success = FALSE;
+			}
+		}
+	}
+
+	if (!getInfo()->mStaticImageFileName.empty())
+	{
+		LLImageRaw* image = LLTexLayerStaticImageList::getInstance()->getImageRaw(getInfo()->mStaticImageFileName);
+		if (image &&
+			(image->getComponents() == 4 ||
+			 (image->getComponents() == 1 && getInfo()->mStaticImageIsMask)))
+		{
+			compositor->drawTexturedRect(image, getInfo()->mStaticImageIsMask);
+		}
+	}
+
+	// Draw a rectangle with the layer color to multiply the alpha by that
+	// color's alpha.
+	if (layer_color.mV[VW] != 1.f)
+	{
+		compositor->color4fv(layer_color.mV);
+		compositor->drawRect();
+	}
+
+	compositor->setAlphaTest(alpha_test);
+	compositor->setColorMask(true, true);
+
+	return success;
+}
+
+//virtual
+BOOL LLTexLayer::blendAlphaTextureSoftware(LLTexLayerCompositor* compositor)
+{
+	BOOL success = TRUE;
+
+	bool alpha_test = compositor->getAlphaTest();
+	compositor->setAlphaTest(false);
+
+	if (!getInfo()->mStaticImageFileName.empty())
+	{
+		LLImageRaw* image = LLTexLayerStaticImageList::getInstance()->getImageRaw(getInfo()->mStaticImageFileName);
+		if (image)
+		{
+			compositor->drawTexturedRect(image, getInfo()->mStaticImageIsMask);
+		}
+		else
+		{
+			success = FALSE;
+		}
+	}
+	else if (getInfo()->mLocalTexture >= 0 &&
+			 getInfo()->mLocalTexture < TEX_NUM_INDICES &&
+			 mLocalTextureObject && mLocalTextureObject->getImage())
+	{
+		LLImageRaw* image = getLocalTextureRaw();
+		if (image)
+		{
+			compositor->drawTexturedRect(image);
+		}
+		else
+		{
+			success = FALSE;
+		}
+	}
+
+	compositor->setAlphaTest(alpha_test);
+
+	return success;
+}
+
+//virtual
+BOOL LLTexLayer::gatherAlphaMasksSoftware(LLTexLayerCompositor* compositor)
+{
+	// Like addAlphaMask(): only morph masks get cached, and thus gathered.
+	if (!hasAlphaParams() || !hasMorph())
+	{
+		return TRUE;
+	}
+
+	LLColor4 net_color;
+	findNetColor(&net_color);
+	BOOL success = renderMorphMasksSoftware(compositor, net_color);
+	compositor->gatherAlpha();
+	return success;
+}
+
 //virtual
 BOOL LLTexLayer::isInvisibleAlphaMask() const
 {
@@ -2297,6 +2796,74 @@ BOOL LLTexLayerTemplate::isInvisibleAlphaMask() const
 	return FALSE;
 }
 
+//virtual
+BOOL LLTexLayerTemplate::renderSoftware(LLTexLayerCompositor* compositor)
+{
+	if (!mInfo)
+	{
+		return FALSE;
+	}
+
+	BOOL success = TRUE;
+	updateWearableCache();
+	for (wearable_cache_t::const_iterator iter = mWearableCache.begin(),
+										  end = mWearableCache.end();
+		 iter!= end; ++iter)
+	{
+		LLWearable* wearable = *iter;
+		LLLocalTextureObject* lto = NULL;
+		LLTexLayer* layer = NULL;
+		if (wearable)
+		{
+			lto = wearable->getLocalTextureObject(mInfo->mLocalTexture);
+		}
+		if (lto)
+		{
+			layer = lto->getTexLayer(getName());
+		}
+		if (layer)
+		{
+			wearable->writeToAvatar();
+			layer->setLTO(lto);
+			success &= layer->renderSoftware(compositor);
+		}
+	}
+
+	return success;
+}
+
+//virtual
+BOOL LLTexLayerTemplate::blendAlphaTextureSoftware(LLTexLayerCompositor* compositor)
+{
+	BOOL success = TRUE;
+	U32 num_wearables = updateWearableCache();
+	for (U32 i = 0; i < num_wearables; ++i)
+	{
+		LLTexLayer* layer = getLayer(i);
+		if (layer)
+		{
+			success &= layer->blendAlphaTextureSoftware(compositor);
+		}
+	}
+	return success;
+}
+
+//virtual
+BOOL LLTexLayerTemplate::gatherAlphaMasksSoftware(LLTexLayerCompositor* compositor)
+{
+	BOOL success = TRUE;
+	U32 num_wearables = updateWearableCache();
+	for (U32 i = 0; i < num_wearables; ++i)
+	{
+		LLTexLayer* layer = getLayer(i);
+		if (layer)
+		{
+			success &= layer->gatherAlphaMasksSoftware(compositor);
+		}
+	}
+	return success;
+}
+
 //-----------------------------------------------------------------------------
 // finds a specific layer based on a passed in name
 //-----------------------------------------------------------------------------
@@ -2358,6 +2925,7 @@ void LLTexLayerSet::cloneTemplates(LLLocalTextureObject* lto,
 LLTexLayerStaticImageList::LLTexLayerStaticImageList()
 :	mGLBytes(0),
 	mTGABytes(0),
+	mRawBytes(0),
 	mImageNames(16384)
 {
 }
@@ -2371,24 +2939,28 @@ void LLTexLayerStaticImageList::dumpByteCount() const
 {
 	llinfos << "Avatar Static Textures " <<
 		"KB GL:" << (mGLBytes / 1024) <<
-		"KB TGA:" << (mTGABytes / 1024) << "KB" << llendl;
+		"KB TGA:" << (mTGABytes / 1024) <<
+		"KB Raw:" << (mRawBytes / 1024) << "KB" << llendl;
 }
 
 void LLTexLayerStaticImageList::deleteCachedImages()
 {
-	if (mGLBytes || mTGABytes)
+	if (mGLBytes || mTGABytes || mRawBytes)
 	{
 		llinfos << "Clearing Static Textures " <<
 			"KB GL:" << (mGLBytes / 1024) <<
-			"KB TGA:" << (mTGABytes / 1024) << "KB" << llendl;
+			"KB TGA:" << (mTGABytes / 1024) <<
+			"KB Raw:" << (mRawBytes / 1024) << "KB" << llendl;
 
 		//mStaticImageLists uses LLPointers, clear() will cause deletion
 
 		mStaticImageListTGA.clear();
 		mStaticImageList.clear();
+		mStaticImageListRaw.clear();
 
 		mGLBytes = 0;
 		mTGABytes = 0;
+		mRawBytes = 0;
 	}
 }
 
@@ -2424,6 +2996,29 @@ LLImageTGA* LLTexLayerStaticImageList::getImageTGA(const std::string& file_name)
 	}
 }
 
+// Returns an LLImageRaw that contains the decoded data from a tga file named
+// file_name, for the software compositing of the layers. Caches the result to
+// speed identical subsequent requests.
+LLImageRaw* LLTexLayerStaticImageList::getImageRaw(const std::string& file_name)
+{
+	const char* namekey = mImageNames.addString(file_name);
+	image_raw_map_t::const_iterator iter = mStaticImageListRaw.find(namekey);
+	if (iter != mStaticImageListRaw.end())
+	{
+		return iter->second;
+	}
+
+	LLPointer<LLImageRaw> image_raw = new LLImageRaw;
+	if (loadImageRaw(file_name, image_raw))
+	{
+		mStaticImageListRaw[namekey] = image_raw;
+		mRawBytes += image_raw->getDataSize();
+		return image_raw;
+	}
+
+	return NULL;
+}
+
 // Returns a GL Image (without a backing ImageRaw) that contains the decoded
 // data from a tga file named file_name. Caches the result to speed identical
 // subsequent requests.
@@ -48,6 +48,7 @@ class LLTexLayerSet;
 class LLTexLayerSetInfo;
 class LLTexLayerInfo;
 class LLTexLayerSetBuffer;
+class LLTexLayerCompositor;
 class LLWearable;
 class LLViewerVisualParam;
 
@@ -76,6 +77,13 @@ public:
 	virtual BOOL			blendAlphaTexture(S32 x, S32 y, S32 width, S32 height) = 0;
 	virtual BOOL			isInvisibleAlphaMask() const = 0;
 
+	// Software compositing counterparts of render(), blendAlphaTexture() and
+	// gatherAlphaMasks(): they record into 'compositor' the operations the
+	// GL path performs, and return FALSE when some image data is missing.
+	virtual BOOL			renderSoftware(LLTexLayerCompositor* compositor) = 0;
+	virtual BOOL			blendAlphaTextureSoftware(LLTexLayerCompositor* compositor) = 0;
+	virtual BOOL			gatherAlphaMasksSoftware(LLTexLayerCompositor* compositor) = 0;
+
 	const LLTexLayerInfo* 	getInfo() const 			{ return mInfo; }
 	virtual BOOL			setInfo(const LLTexLayerInfo *info, LLWearable* wearable); // sets mInfo, calls initialization functions
 
@@ -130,6 +138,9 @@ public:
 	/*virtual*/ void		setHasMorph(BOOL newval);
 	/*virtual*/ void		deleteCaches();
 	/*virtual*/ BOOL		isInvisibleAlphaMask() const;
+	/*virtual*/ BOOL		renderSoftware(LLTexLayerCompositor* compositor);
+	/*virtual*/ BOOL		blendAlphaTextureSoftware(LLTexLayerCompositor* compositor);
+	/*virtual*/ BOOL		gatherAlphaMasksSoftware(LLTexLayerCompositor* compositor);
 protected:
 	U32 					updateWearableCache() const;
 	LLTexLayer* 			getLayer(U32 i) const;
@@ -164,12 +175,18 @@ public:
 	void					addAlphaMask(U8 *data, S32 originX, S32 originY, S32 width, S32 height);
 	/*virtual*/ BOOL		isInvisibleAlphaMask() const;
 
+	/*virtual*/ BOOL		renderSoftware(LLTexLayerCompositor* compositor);
+	/*virtual*/ BOOL		blendAlphaTextureSoftware(LLTexLayerCompositor* compositor);
+	/*virtual*/ BOOL		gatherAlphaMasksSoftware(LLTexLayerCompositor* compositor);
+	BOOL					renderMorphMasksSoftware(LLTexLayerCompositor* compositor, const LLColor4 &layer_color);
+
 	void					setLTO(LLLocalTextureObject *lto) 	{ mLocalTextureObject = lto; }
 	LLLocalTextureObject* 	getLTO() 							{ return mLocalTextureObject; }
 
 	static void 			calculateTexLayerColor(const param_color_list_t &param_list, LLColor4 &net_color);
 protected:
 	LLUUID					getUUID() const;
+	LLImageRaw*				getLocalTextureRaw() const;
 private:
 	typedef std::map<U32, U8*> alpha_cache_t;
 	alpha_cache_t			mAlphaCache;
@@ -195,6 +212,13 @@ public:
 	BOOL						render(S32 x, S32 y, S32 width, S32 height);
 	void						renderAlphaMaskTextures(S32 x, S32 y, S32 width, S32 height, bool forceClear = false);
 
+	// Records the operations of a full bake (what render() and then
+	// LLTexLayerSetBuffer::doUpload() do with GL) into 'compositor'. Returns
+	// FALSE when some of the needed image data is not available in memory.
+	BOOL						recordSoftwareBake(LLTexLayerCompositor* compositor);
+	BOOL						renderSoftware(LLTexLayerCompositor* compositor);
+	BOOL						renderAlphaMaskTexturesSoftware(LLTexLayerCompositor* compositor, bool force_clear);
+
 	BOOL						isBodyRegion(const std::string& region) const;
 	LLTexLayerSetBuffer*		getComposite();
 	const LLTexLayerSetBuffer* 	getComposite() const; // Do not create one if it doesn't exist.
@@ -298,6 +322,9 @@ private:
 public:
 	/*virtual*/ BOOL		needsRender();
 
+	// Whether a software bake of this layer set is being composited
+	bool					softwareBakePending() const		{ return mSoftwareBake.notNull(); }
+
 protected:
 	BOOL					render(S32 x, S32 y, S32 width, S32 height);
 	virtual void			preRender(BOOL clear_depth);
@@ -319,6 +346,9 @@ public:
 protected:
 	BOOL					isReadyToUpload() const;
 	void					doUpload(); 					// Does a read back and upload.
+	void					uploadBakedImage(LLImageRaw* baked_image, bool highest_lod);
+	bool					startSoftwareUpload();			// Queues a software bake for upload.
+	void					finishSoftwareUpload();
 	void					conditionalRestartUploadTimer();
 
 private:
@@ -329,6 +359,8 @@ private:
 	LLFrameTimer    		mNeedsUploadTimer; 				// Tracks time since upload was requested and performed.
 	S32						mUploadFailCount;				// Number of consecutive upload failures
 	LLFrameTimer    		mUploadRetryTimer; 				// Tracks time since last upload failure.
+	LLPointer<LLTexLayerCompositor> mSoftwareBake;			// Software bake being composited, if any.
+	bool					mSoftwareBakeFinal;				// Whether that bake uses the final LOD textures.
 
 	//--------------------------------------------------------------------
 	// Updates
@@ -357,6 +389,7 @@ public:
 	~LLTexLayerStaticImageList();
 	LLViewerTexture*	getTexture(const std::string& file_name, BOOL is_mask);
 	LLImageTGA*			getImageTGA(const std::string& file_name);
+	LLImageRaw*			getImageRaw(const std::string& file_name);
 	void				deleteCachedImages();
 	void				dumpByteCount() const;
 protected:
@@ -367,8 +400,11 @@ private:
 	texture_map_t 		mStaticImageList;
 	typedef std::map<const char*, LLPointer<LLImageTGA> > image_tga_map_t;
 	image_tga_map_t 	mStaticImageListTGA;
+	typedef std::map<const char*, LLPointer<LLImageRaw> > image_raw_map_t;
+	image_raw_map_t 	mStaticImageListRaw;
 	S32 				mGLBytes;
 	S32 				mTGABytes;
+	S32 				mRawBytes;
 };
 
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
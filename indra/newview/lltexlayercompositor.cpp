@@ -0,0 +1,578 @@
+/**
+ * @file lltexlayercompositor.cpp
+ * @brief Software compositing of texture layers. Used for avatar bakes.
+ *
+ * $LicenseInfo:firstyear=2026&license=viewergpl$
+ *
+ * Copyright (c) 2026, Cool VL Viewer contributors.
+ *
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlifegrid.net/programs/open_source/licensing/gplv2
+ *
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlifegrid.net/programs/open_source/licensing/flossexception
+ *
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ *
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+
+#include "lltexlayercompositor.h"
+
+#include "llqueuedthread.h"
+
+// Alpha value below (or at) which the default alpha test (GL_GREATER 0.01)
+// rejects a fragment.
+static const F32 ALPHA_TEST_THRESHOLD = 0.01f;
+
+//-----------------------------------------------------------------------------
+// LLTexLayerCompositorThread class
+// Worker thread used by LLTexLayerCompositor::queueComposite().
+//-----------------------------------------------------------------------------
+class LLTexLayerCompositorThread : public LLQueuedThread
+{
+public:
+	class CompositeRequest : public LLQueuedThread::QueuedRequest
+	{
+		friend class LLTexLayerCompositorThread;
+
+	protected:
+		virtual ~CompositeRequest()	{} // use deleteRequest()
+
+	public:
+		CompositeRequest(handle_t handle, LLTexLayerCompositor* compositor)
+		:	LLQueuedThread::QueuedRequest(handle,
+										  LLQueuedThread::PRIORITY_NORMAL,
+										  FLAG_AUTO_COMPLETE),
+			mCompositor(compositor)
+		{
+		}
+
+		// WORKER THREAD
+		/*virtual*/ bool processRequest()
+		{
+			mCompositor->composite();
+			return true;
+		}
+
+	private:
+		LLPointer<LLTexLayerCompositor> mCompositor;
+	};
+
+public:
+	LLTexLayerCompositorThread()
+	:	LLQueuedThread("texlayercompositor")
+	{
+	}
+
+	// MAIN THREAD
+	bool requestComposite(LLTexLayerCompositor* compositor)
+	{
+		CompositeRequest* req = new CompositeRequest(generateHandle(),
+													 compositor);
+		if (!addRequest(req))
+		{
+			req->deleteRequest();
+			return false;
+		}
+		return true;
+	}
+};
+
+static LLTexLayerCompositorThread* sCompositorThread = NULL;
+
+//-----------------------------------------------------------------------------
+// Helpers
+//-----------------------------------------------------------------------------
+
+// Computes the RGBA blend factor for 'factor', given the source and
+// destination colors.
+inline static void blend_factor(LLRender::eBlendFactor factor,
+								const F32* src, const F32* dst, F32* out)
+{
+	switch (factor)
+	{
+		case LLRender::BF_ONE:
+			out[0] = out[1] = out[2] = out[3] = 1.f;
+			break;
+
+		case LLRender::BF_ZERO:
+			out[0] = out[1] = out[2] = out[3] = 0.f;
+			break;
+
+		case LLRender::BF_DEST_COLOR:
+			out[0] = dst[0];
+			out[1] = dst[1];
+			out[2] = dst[2];
+			out[3] = dst[3];
+			break;
+
+		case LLRender::BF_SOURCE_COLOR:
+			out[0] = src[0];
+			out[1] = src[1];
+			out[2] = src[2];
+			out[3] = src[3];
+			break;
+
+		case LLRender::BF_ONE_MINUS_DEST_COLOR:
+			out[0] = 1.f - dst[0];
+			out[1] = 1.f - dst[1];
+			out[2] = 1.f - dst[2];
+			out[3] = 1.f - dst[3];
+			break;
+
+		case LLRender::BF_ONE_MINUS_SOURCE_COLOR:
+			out[0] = 1.f - src[0];
+			out[1] = 1.f - src[1];
+			out[2] = 1.f - src[2];
+			out[3] = 1.f - src[3];
+			break;
+
+		case LLRender::BF_DEST_ALPHA:
+			out[0] = out[1] = out[2] = out[3] = dst[3];
+			break;
+
+		case LLRender::BF_SOURCE_ALPHA:
+			out[0] = out[1] = out[2] = out[3] = src[3];
+			break;
+
+		case LLRender::BF_ONE_MINUS_DEST_ALPHA:
+			out[0] = out[1] = out[2] = out[3] = 1.f - dst[3];
+			break;
+
+		case LLRender::BF_ONE_MINUS_SOURCE_ALPHA:
+			out[0] = out[1] = out[2] = out[3] = 1.f - src[3];
+			break;
+
+		default:
+			llassert(false);
+			out[0] = out[1] = out[2] = out[3] = 1.f;
+	}
+}
+
+// Box filters 'src' down to half its size along each dimension for which
+// 'half_x' or 'half_y' is true.
+static LLImageRaw* halve_image(LLImageRaw* src, bool half_x, bool half_y)
+{
+	const S32 comps = src->getComponents();
+	const S32 src_width = src->getWidth();
+	const S32 src_height = src->getHeight();
+	const S32 width = half_x ? src_width / 2 : src_width;
+	const S32 height = half_y ? src_height / 2 : src_height;
+	const S32 step_x = half_x ? comps : 0;
+	const S32 step_y = half_y ? src_width * comps : 0;
+	const U32 shift = (half_x ? 1 : 0) + (half_y ? 1 : 0);
+	const U32 round = (1 << shift) >> 1;
+
+	LLImageRaw* dst = new LLImageRaw(width, height, comps);
+	const U8* in = src->getData();
+	U8* out = dst->getData();
+	for (S32 y = 0; y < height; ++y)
+	{
+		const U8* row = in + (half_y ? 2 * y : y) * src_width * comps;
+		for (S32 x = 0; x < width; ++x)
+		{
+			const U8* p = row + (half_x ? 2 * x : x) * comps;
+			for (S32 c = 0; c < comps; ++c)
+			{
+				U32 sum = p[c];
+				if (half_x)
+				{
+					sum += p[c + step_x];
+				}
+				if (half_y)
+				{
+					sum += p[c + step_y];
+					if (half_x)
+					{
+						sum += p[c + step_x + step_y];
+					}
+				}
+				*out++ = (U8)((sum + round) >> shift);
+			}
+		}
+	}
+
+	return dst;
+}
+
+//-----------------------------------------------------------------------------
+// LLTexLayerCompositor
+//-----------------------------------------------------------------------------
+
+LLTexLayerCompositor::LLTexLayerCompositor(S32 width, S32 height)
+:	mColor(1.f, 1.f, 1.f, 1.f),
+	mSrcFactor(LLRender::BF_SOURCE_ALPHA),
+	mDstFactor(LLRender::BF_ONE_MINUS_SOURCE_ALPHA),
+	mWriteColor(true),
+	mWriteAlpha(true),
+	mAlphaTest(true),
+	mReplace(false),
+	mWidth(width),
+	mHeight(height),
+	mComposited(0)
+{
+}
+
+LLTexLayerCompositor::~LLTexLayerCompositor()
+{
+}
+
+void LLTexLayerCompositor::setSceneBlendType(LLRender::eBlendType type)
+{
+	switch (type)
+	{
+		case LLRender::BT_ALPHA:
+			blendFunc(LLRender::BF_SOURCE_ALPHA,
+					  LLRender::BF_ONE_MINUS_SOURCE_ALPHA);
+			break;
+
+		case LLRender::BT_ADD:
+			blendFunc(LLRender::BF_ONE, LLRender::BF_ONE);
+			break;
+
+		case LLRender::BT_ADD_WITH_ALPHA:
+			blendFunc(LLRender::BF_SOURCE_ALPHA, LLRender::BF_ONE);
+			break;
+
+		case LLRender::BT_MULT:
+			blendFunc(LLRender::BF_DEST_COLOR, LLRender::BF_ZERO);
+			break;
+
+		case LLRender::BT_MULT_ALPHA:
+			blendFunc(LLRender::BF_DEST_ALPHA, LLRender::BF_ZERO);
+			break;
+
+		case LLRender::BT_MULT_X2:
+			blendFunc(LLRender::BF_DEST_COLOR, LLRender::BF_SOURCE_COLOR);
+			break;
+
+		case LLRender::BT_REPLACE:
+			blendFunc(LLRender::BF_ONE, LLRender::BF_ZERO);
+			break;
+
+		default:
+			llwarns << "Unknown scene blend type: " << type << llendl;
+	}
+}
+
+void LLTexLayerCompositor::blendFunc(LLRender::eBlendFactor sfactor,
+									 LLRender::eBlendFactor dfactor)
+{
+	mSrcFactor = sfactor;
+	mDstFactor = dfactor;
+}
+
+void LLTexLayerCompositor::setColorMask(bool write_color, bool write_alpha)
+{
+	mWriteColor = write_color;
+	mWriteAlpha = write_alpha;
+}
+
+void LLTexLayerCompositor::setTextureBlendType(LLTexUnit::eTextureBlendType type)
+{
+	// Only the modes used by the texture layers are supported.
+	llassert(type == LLTexUnit::TB_MULT || type == LLTexUnit::TB_REPLACE);
+	mReplace = type == LLTexUnit::TB_REPLACE;
+}
+
+void LLTexLayerCompositor::addOp(EOpType type, LLImageRaw* image,
+								 bool alpha_texture)
+{
+	llassert(!mComposited);
+	mOps.push_back(Op());
+	Op& op = mOps.back();
+	op.mImage = image;
+	op.mColor = mColor;
+	op.mType = type;
+	op.mSrcFactor = mSrcFactor;
+	op.mDstFactor = mDstFactor;
+	op.mWriteColor = mWriteColor;
+	op.mWriteAlpha = mWriteAlpha;
+	op.mAlphaTest = mAlphaTest;
+	op.mReplace = mReplace;
+	op.mAlphaTexture = alpha_texture;
+}
+
+void LLTexLayerCompositor::drawRect()
+{
+	addOp(OP_RECT);
+}
+
+void LLTexLayerCompositor::drawTexturedRect(LLImageRaw* image,
+											bool alpha_texture)
+{
+	if (image && image->getData() && image->getComponents() <= 4)
+	{
+		addOp(OP_TEXTURED_RECT, image, alpha_texture);
+	}
+	else
+	{
+		llwarns << "Invalid image, skipping draw operation" << llendl;
+	}
+}
+
+void LLTexLayerCompositor::snapshotColor()
+{
+	addOp(OP_SNAPSHOT);
+}
+
+void LLTexLayerCompositor::gatherAlpha()
+{
+	addOp(OP_GATHER_ALPHA);
+}
+
+// Returns 'image' filtered to the size of the target: halved with a box filter
+// while at least twice as large (like a mip-map would) then bilinearly
+// sampled at the target pixel centres with clamping at the edges, like a
+// GL_LINEAR, GL_CLAMP_TO_EDGE texture drawn over the full target.
+LLPointer<LLImageRaw> LLTexLayerCompositor::resample(LLImageRaw* image)
+{
+	for (S32 i = 0, count = mResampled.size(); i < count; ++i)
+	{
+		if (mResampled[i].first == image)
+		{
+			return mResampled[i].second;
+		}
+	}
+
+	LLPointer<LLImageRaw> src = image;
+	while (src->getWidth() >= 2 * mWidth || src->getHeight() >= 2 * mHeight)
+	{
+		src = halve_image(src, src->getWidth() >= 2 * mWidth,
+						  src->getHeight() >= 2 * mHeight);
+	}
+
+	const S32 src_width = src->getWidth();
+	const S32 src_height = src->getHeight();
+	if (src_width != mWidth || src_height != mHeight)
+	{
+		const S32 comps = src->getComponents();
+
+		std::vector<S32> x0(mWidth);
+		std::vector<S32> x1(mWidth);
+		std::vector<F32> fx(mWidth);
+		F32 scale = (F32)src_width / (F32)mWidth;
+		for (S32 x = 0; x < mWidth; ++x)
+		{
+			F32 u = llclamp(((F32)x + 0.5f) * scale - 0.5f, 0.f,
+							(F32)(src_width - 1));
+			x0[x] = (S32)u;
+			x1[x] = llmin(x0[x] + 1, src_width - 1);
+			fx[x] = u - (F32)x0[x];
+			x0[x] *= comps;
+			x1[x] *= comps;
+		}
+
+		LLPointer<LLImageRaw> dst = new LLImageRaw(mWidth, mHeight, comps);
+		const U8* in = src->getData();
+		U8* out = dst->getData();
+		scale = (F32)src_height / (F32)mHeight;
+		for (S32 y = 0; y < mHeight; ++y)
+		{
+			F32 v = llclamp(((F32)y + 0.5f) * scale - 0.5f, 0.f,
+							(F32)(src_height - 1));
+			S32 y0 = (S32)v;
+			S32 y1 = llmin(y0 + 1, src_height - 1);
+			F32 fy = v - (F32)y0;
+			const U8* row0 = in + y0 * src_width * comps;
+			const U8* row1 = in + y1 * src_width * comps;
+			for (S32 x = 0; x < mWidth; ++x)
+			{
+				const U8* p00 = row0 + x0[x];
+				const U8* p01 = row0 + x1[x];
+				const U8* p10 = row1 + x0[x];
+				const U8* p11 = row1 + x1[x];
+				for (S32 c = 0; c < comps; ++c)
+				{
+					F32 top = lerp((F32)p00[c], (F32)p01[c], fx[x]);
+					F32 bottom = lerp((F32)p10[c], (F32)p11[c], fx[x]);
+					*out++ = (U8)(lerp(top, bottom, fy) + 0.5f);
+				}
+			}
+		}
+		src = dst;
+	}
+
+	mResampled.push_back(std::make_pair(image, src));
+	return src;
+}
+
+// Blends one full target quad into the target, with the fixed function
+// pipeline rules: texture environment (modulate or replace) for the given
+// texture format, alpha test, blend function and color mask, then rounding
+// to the 8 bits per channel of the frame buffer.
+void LLTexLayerCompositor::blendOp(const Op& op, const U8* texels, S32 comps)
+{
+	static const F32 NORM = 1.f / 255.f;
+
+	// Which parts of the fragment color the texture provides
+	const bool has_color = texels && !(comps == 1 && op.mAlphaTexture);
+	const bool has_alpha = texels && (comps == 2 || comps == 4 ||
+									  (comps == 1 && op.mAlphaTexture));
+	const S32 color_offset = comps >= 3 ? 1 : 0;
+	const S32 alpha_offset = comps - 1;
+
+	F32 src[4] = { op.mColor.mV[0], op.mColor.mV[1], op.mColor.mV[2],
+				   op.mColor.mV[3] };
+	F32 dst[4];
+	F32 sf[4];
+	F32 df[4];
+
+	U8* data = mTarget->getData();
+	const S32 count = mWidth * mHeight;
+	for (S32 i = 0; i < count; ++i, data += 4)
+	{
+		if (texels)
+		{
+			const U8* t = texels + i * comps;
+			if (has_color)
+			{
+				for (S32 c = 0; c < 3; ++c)
+				{
+					F32 texel = (F32)t[c * color_offset] * NORM;
+					src[c] = op.mReplace ? texel : op.mColor.mV[c] * texel;
+				}
+			}
+			if (has_alpha)
+			{
+				F32 texel = (F32)t[alpha_offset] * NORM;
+				src[3] = op.mReplace ? texel : op.mColor.mV[3] * texel;
+			}
+		}
+
+		if (op.mAlphaTest && src[3] <= ALPHA_TEST_THRESHOLD)
+		{
+			continue;
+		}
+
+		dst[0] = (F32)data[0] * NORM;
+		dst[1] = (F32)data[1] * NORM;
+		dst[2] = (F32)data[2] * NORM;
+		dst[3] = (F32)data[3] * NORM;
+		blend_factor(op.mSrcFactor, src, dst, sf);
+		blend_factor(op.mDstFactor, src, dst, df);
+
+		S32 first = op.mWriteColor ? 0 : 3;
+		S32 last = op.mWriteAlpha ? 4 : 3;
+		for (S32 c = first; c < last; ++c)
+		{
+			F32 value = llclamp(src[c] * sf[c] + dst[c] * df[c], 0.f, 1.f);
+			data[c] = (U8)(value * 255.f + 0.5f);
+		}
+	}
+}
+
+void LLTexLayerCompositor::composite()
+{
+	if (mComposited)
+	{
+		return;
+	}
+
+	const S32 count = mWidth * mHeight;
+	mTarget = new LLImageRaw(mWidth, mHeight, 4);
+	memset(mTarget->getData(), 0, count * 4);
+	mBakedImage = new LLImageRaw(mWidth, mHeight, 5);
+	memset(mBakedImage->getData(), 0, count * 5);
+	mMask.assign(count, 255);
+
+	for (op_list_t::const_iterator it = mOps.begin(), end = mOps.end();
+		 it != end; ++it)
+	{
+		const Op& op = *it;
+		switch (op.mType)
+		{
+			case OP_RECT:
+				blendOp(op, NULL, 0);
+				break;
+
+			case OP_TEXTURED_RECT:
+			{
+				LLPointer<LLImageRaw> image = resample(op.mImage);
+				blendOp(op, image->getData(), image->getComponents());
+				break;
+			}
+
+			case OP_SNAPSHOT:
+			{
+				const U8* in = mTarget->getData();
+				U8* out = mBakedImage->getData();
+				for (S32 i = 0; i < count; ++i, in += 4, out += 5)
+				{
+					out[0] = in[0];
+					out[1] = in[1];
+					out[2] = in[2];
+					out[3] = in[3];
+				}
+				break;
+			}
+
+			case OP_GATHER_ALPHA:
+			{
+				const U8* in = mTarget->getData() + 3;
+				for (S32 i = 0; i < count; ++i, in += 4)
+				{
+					U16 alpha = mMask[i];
+					alpha *= *in + 1;
+					mMask[i] = (U8)(alpha >> 8);
+				}
+				break;
+			}
+		}
+	}
+
+	U8* out = mBakedImage->getData() + 4;
+	for (S32 i = 0; i < count; ++i, out += 5)
+	{
+		*out = mMask[i];
+	}
+
+	// Release everything but the result.
+	mOps.clear();
+	mResampled.clear();
+	mMask.clear();
+	mTarget = NULL;
+
+	mComposited = 1;
+}
+
+//static
+void LLTexLayerCompositor::queueComposite(LLTexLayerCompositor* compositor)
+{
+	if (!sCompositorThread)
+	{
+		sCompositorThread = new LLTexLayerCompositorThread();
+	}
+	if (!sCompositorThread->requestComposite(compositor))
+	{
+		// Do it now, then.
+		compositor->composite();
+	}
+}
+
+//static
+void LLTexLayerCompositor::cleanupClass()
+{
+	if (sCompositorThread)
+	{
+		sCompositorThread->shutdown();
+		delete sCompositorThread;
+		sCompositorThread = NULL;
+	}
+}
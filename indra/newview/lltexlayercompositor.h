@@ -0,0 +1,159 @@
+/**
+ * @file lltexlayercompositor.h
+ * @brief Software compositing of texture layers. Used for avatar bakes.
+ *
+ * $LicenseInfo:firstyear=2026&license=viewergpl$
+ *
+ * Copyright (c) 2026, Cool VL Viewer contributors.
+ *
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlifegrid.net/programs/open_source/licensing/gplv2
+ *
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlifegrid.net/programs/open_source/licensing/flossexception
+ *
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ *
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLTEXLAYERCOMPOSITOR_H
+#define LL_LLTEXLAYERCOMPOSITOR_H
+
+#include <vector>
+
+#include "llapr.h"
+#include "llimage.h"
+#include "llrender.h"
+#include "v4color.h"
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LLTexLayerCompositor
+//
+// CPU emulation of the fixed function GL operations LLTexLayerSet::render()
+// and LLTexLayerSetBuffer::doUpload() use to composite a baked texture: full
+// target quads, untextured or textured (modulated by or replacing the current
+// color), with a blend function, a color mask and the default alpha test.
+//
+// The operations are recorded on the main thread (where the layers, visual
+// params and textures may be accessed), with the same call sequence as the GL
+// code, then replayed by composite(), which only touches data owned by the
+// compositor and may therefore run on a worker thread. The result is the
+// 5 components (RGB, bump/alpha, morph mask) image ready for upload.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+class LLTexLayerCompositor : public LLThreadSafeRefCount
+{
+protected:
+	LOG_CLASS(LLTexLayerCompositor);
+
+	~LLTexLayerCompositor();
+
+public:
+	LLTexLayerCompositor(S32 width, S32 height);
+
+	S32 getWidth() const							{ return mWidth; }
+	S32 getHeight() const							{ return mHeight; }
+
+	// Recording functions, mirroring the LLRender calls of the GL path.
+
+	void setSceneBlendType(LLRender::eBlendType type);
+	void blendFunc(LLRender::eBlendFactor sfactor,
+				   LLRender::eBlendFactor dfactor);
+	void setColorMask(bool write_color, bool write_alpha);
+	void setTextureBlendType(LLTexUnit::eTextureBlendType type);
+	void setAlphaTest(bool enabled)					{ mAlphaTest = enabled; }
+	bool getAlphaTest() const						{ return mAlphaTest; }
+	void color4f(F32 r, F32 g, F32 b, F32 a)		{ mColor.setVec(r, g, b, a); }
+	void color4fv(const F32* color)					{ mColor.setVec(color); }
+
+	// Equivalent of gl_rect_2d_simple(width, height)
+	void drawRect();
+	// Equivalent of gl_rect_2d_simple_tex(width, height) with 'image' bound.
+	// When 'alpha_texture' is true, a single component image is used as an
+	// alpha (GL_ALPHA8) texture instead of a luminance one.
+	void drawTexturedRect(LLImageRaw* image, bool alpha_texture = false);
+
+	// Copies the RGBA contents of the target into the baked image.
+	void snapshotColor();
+	// Multiplies the morph mask by the alpha channel of the target, the same
+	// way LLTexLayer::addAlphaMask() does.
+	void gatherAlpha();
+
+	// Replays the recorded operations. May be called from any thread.
+	void composite();
+
+	bool isComposited()								{ return mComposited != 0; }
+	// Returns the baked image (NULL until composite() was called).
+	LLImageRaw* getBakedImage() const				{ return mBakedImage; }
+
+	// Worker thread used to composite bakes in the background
+	static void queueComposite(LLTexLayerCompositor* compositor);
+	static void cleanupClass();
+
+private:
+	enum EOpType
+	{
+		OP_RECT,
+		OP_TEXTURED_RECT,
+		OP_SNAPSHOT,
+		OP_GATHER_ALPHA
+	};
+
+	struct Op
+	{
+		LLPointer<LLImageRaw>	mImage;
+		LLColor4				mColor;
+		EOpType					mType;
+		LLRender::eBlendFactor	mSrcFactor;
+		LLRender::eBlendFactor	mDstFactor;
+		bool					mWriteColor;
+		bool					mWriteAlpha;
+		bool					mAlphaTest;
+		bool					mReplace;
+		bool					mAlphaTexture;
+	};
+
+	void addOp(EOpType type, LLImageRaw* image = NULL,
+			   bool alpha_texture = false);
+	void blendOp(const Op& op, const U8* texels, S32 comps);
+	LLPointer<LLImageRaw> resample(LLImageRaw* image);
+
+private:
+	typedef std::vector<Op> op_list_t;
+	op_list_t				mOps;
+
+	// Recording state
+	LLColor4				mColor;
+	LLRender::eBlendFactor	mSrcFactor;
+	LLRender::eBlendFactor	mDstFactor;
+	bool					mWriteColor;
+	bool					mWriteAlpha;
+	bool					mAlphaTest;
+	bool					mReplace;
+
+	const S32				mWidth;
+	const S32				mHeight;
+
+	// Compositing data
+	LLPointer<LLImageRaw>	mTarget;
+	LLPointer<LLImageRaw>	mBakedImage;
+	std::vector<U8>			mMask;
+	typedef std::vector<std::pair<LLImageRaw*, LLPointer<LLImageRaw> > > resampled_list_t;
+	resampled_list_t		mResampled;
+	LLAtomicS32				mComposited;
+};
+
+#endif  // LL_LLTEXLAYERCOMPOSITOR_H
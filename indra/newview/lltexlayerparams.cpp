@@ -39,6 +39,7 @@
 
 #include "llagent.h"
 #include "lltexlayer.h"
+#include "lltexlayercompositor.h"
 #include "llvoavatarself.h"
 #include "llwearable.h"
 
@@ -370,6 +371,73 @@ BOOL LLTexLayerParamAlpha::render(S32 x, S32 y, S32 width, S32 height)
 	return success;
 }
 
+BOOL LLTexLayerParamAlpha::renderSoftware(LLTexLayerCompositor* compositor)
+{
+	if (!mTexLayer)
+	{
+		return TRUE;
+	}
+
+	F32 effective_weight = (mTexLayer->getTexLayerSet()->getAvatar()->getSex() & getSex()) ? mCurWeight
+																						   : getDefaultWeight();
+	BOOL weight_changed = effective_weight != mCachedEffectiveWeight;
+	if (getSkip())
+	{
+		return TRUE;
+	}
+
+	LLTexLayerParamAlphaInfo* info = (LLTexLayerParamAlphaInfo*)getInfo();
+	if (info->mMultiplyBlend)
+	{
+		// Multiplication: approximates a min() function
+		compositor->blendFunc(LLRender::BF_DEST_ALPHA, LLRender::BF_ZERO);
+	}
+	else
+	{
+		// Addition: approximates a max() function
+		compositor->setSceneBlendType(LLRender::BT_ADD);
+	}
+
+	if (!info->mStaticImageFileName.empty() && !mStaticImageInvalid)
+	{
+		if (mStaticImageTGA.isNull())
+		{
+			mStaticImageTGA = LLTexLayerStaticImageList::getInstance()->getImageTGA(info->mStaticImageFileName);  
+			LLTexLayerSet::sHasCaches |= mStaticImageTGA.notNull() ? TRUE : FALSE;
+
+			if (mStaticImageTGA.isNull())
+			{
+				llwarns << "Unable to load static file: "
+						<< info->mStaticImageFileName << llendl;
+				mStaticImageInvalid = TRUE; // don't try again.
+				return FALSE;
+			}
+		}
+
+		if (weight_changed || mStaticImageRaw.isNull())
+		{
+			mCachedEffectiveWeight = effective_weight;
+
+			// Note: a new image is created (instead of reusing the old one)
+			// since the compositor may still hold the latter.
+			mStaticImageRaw = new LLImageRaw;
+			mStaticImageTGA->decodeAndProcess(mStaticImageRaw, info->mDomain,
+											  effective_weight);
+			// Let render() know it must refresh the GL texture
+			mNeedsCreateTexture = TRUE;
+		}
+
+		compositor->drawTexturedRect(mStaticImageRaw, true);
+	}
+	else
+	{
+		compositor->color4f(0.f, 0.f, 0.f, effective_weight);
+		compositor->drawRect();
+	}
+
+	return TRUE;
+}
+
 //-----------------------------------------------------------------------------
 // LLTexLayerParamAlphaInfo
 //-----------------------------------------------------------------------------
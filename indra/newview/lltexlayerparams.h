@@ -38,6 +38,7 @@
 class LLImageRaw;
 class LLImageTGA;
 class LLTexLayer;
+class LLTexLayerCompositor;
 class LLTexLayerInterface;
 class LLViewerTexture;
 class LLVOAvatar;
@@ -90,6 +91,7 @@ public:
 
 	// New functions
 	BOOL					render(S32 x, S32 y, S32 width, S32 height);
+	BOOL					renderSoftware(LLTexLayerCompositor* compositor);
 	BOOL					getSkip() const;
 	void					deleteCaches();
 	BOOL					getMultiplyBlend() const;
@@ -929,6 +929,9 @@ void LLViewerObjectList::update(LLAgent& agent, LLWorld& world)
 		}
 	}
 
+	// Apply the batched avatar pose updates before anything gets rendered
+	LLVOAvatar::flushAnimationUpdates();
+
 	fetchObjectCosts();
 	fetchPhysicsFlags();
 
@@ -124,7 +124,10 @@ void LLViewerPart::init(LLPointer<LLViewerPartSource> sourcep, LLViewerTexture *
 
 
 LLViewerPartGroup::LLViewerPartGroup(const LLVector3 &center_agent, const F32 box_side, bool hud)
- : mHud(hud)
+ : mHud(hud),
+   mStreams(NULL),
+   mPartFlags(NULL),
+   mCapacity(0)
 {
 	LLMemType mt(LLMemType::MTYPE_PARTICLES);
 	mVOPartGroupp = NULL;
@@ -192,6 +195,9 @@ LLViewerPartGroup::~LLViewerPartGroup()
 		delete mParticles[i] ;
 	}
 	mParticles.clear();
+
+	ll_aligned_free_16(mStreams);
+	ll_aligned_free_16(mPartFlags);
 	
 	LLViewerPartSim::decPartCount(count);
 }
@@ -257,151 +263,352 @@ BOOL LLViewerPartGroup::addPart(LLViewerPart* part, F32 desired_size)
 	}
 
 	gPipeline.markRebuild(mVOPartGroupp->mDrawable, LLDrawable::REBUILD_ALL, TRUE);
-	
+
+	U32 idx = mParticles.size();
+	reserveParts(idx + 1);
 	mParticles.push_back(part);
 	part->mSkipOffset=mSkippedTime;
+	loadPart(idx, part);
 	LLViewerPartSim::incPartCount(1);
 	return TRUE;
 }
 
-
-void LLViewerPartGroup::updateParticles(const F32 lastdt)
+void LLViewerPartGroup::reserveParts(U32 count)
 {
-	LLMemType mt(LLMemType::MTYPE_PARTICLES);
-	F32 dt;
-	
-	LLVector3 gravity(0.f, 0.f, GRAVITY);
+	if (count <= mCapacity)
+	{
+		return;
+	}
 
-	LLViewerPartSim::checkParticleCount(mParticles.size());
+	U32 capacity = llmax(mCapacity * 2, (U32)16);
+	while (capacity < count)
+	{
+		capacity *= 2;
+	}
 
-	LLViewerRegion *regionp = getRegion();
-	S32 end = (S32) mParticles.size();
-	for (S32 i = 0 ; i < (S32)mParticles.size();)
+	F32* streams = (F32*)ll_aligned_malloc_16(sizeof(F32) * PS_COUNT * capacity);
+	U32* flags = (U32*)ll_aligned_malloc_16(sizeof(U32) * capacity);
+	// Zero everything, so that the padding lanes processed by
+	// integrateParticles() hold sane values
+	memset(streams, 0, sizeof(F32) * PS_COUNT * capacity);
+	memset(flags, 0, sizeof(U32) * capacity);
+
+	if (mStreams)
 	{
-		LLVector3 a(0.f, 0.f, 0.f);
-		LLViewerPart* part = mParticles[i] ;
+		U32 used = mParticles.size();
+		for (U32 i = 0; i < PS_COUNT; ++i)
+		{
+			memcpy(streams + i * capacity, mStreams + i * mCapacity,
+				   sizeof(F32) * used);
+		}
+		memcpy(flags, mPartFlags, sizeof(U32) * used);
+		ll_aligned_free_16(mStreams);
+		ll_aligned_free_16(mPartFlags);
+	}
 
-		dt = lastdt + mSkippedTime - part->mSkipOffset;
-		part->mSkipOffset = 0.f;
+	mStreams = streams;
+	mPartFlags = flags;
+	mCapacity = capacity;
+}
+
+void LLViewerPartGroup::loadPart(U32 idx, const LLViewerPart* part)
+{
+	F32* streams = mStreams + idx;
+	const U32 stride = mCapacity;
+
+	streams[PS_POS_X * stride] = part->mPosAgent.mV[VX];
+	streams[PS_POS_Y * stride] = part->mPosAgent.mV[VY];
+	streams[PS_POS_Z * stride] = part->mPosAgent.mV[VZ];
+	streams[PS_VEL_X * stride] = part->mVelocity.mV[VX];
+	streams[PS_VEL_Y * stride] = part->mVelocity.mV[VY];
+	streams[PS_VEL_Z * stride] = part->mVelocity.mV[VZ];
+	streams[PS_ACC_X * stride] = part->mAccel.mV[VX];
+	streams[PS_ACC_Y * stride] = part->mAccel.mV[VY];
+	streams[PS_ACC_Z * stride] = part->mAccel.mV[VZ];
+	for (U32 i = 0; i < 4; ++i)
+	{
+		streams[(PS_COL_R + i) * stride] = part->mColor.mV[i];
+		streams[(PS_START_COL_R + i) * stride] = part->mStartColor.mV[i];
+		streams[(PS_END_COL_R + i) * stride] = part->mEndColor.mV[i];
+	}
+	for (U32 i = 0; i < 2; ++i)
+	{
+		streams[(PS_SCALE_X + i) * stride] = part->mScale.mV[i];
+		streams[(PS_START_SCALE_X + i) * stride] = part->mStartScale.mV[i];
+		streams[(PS_END_SCALE_X + i) * stride] = part->mEndScale.mV[i];
+	}
+	streams[PS_AGE * stride] = part->mLastUpdateTime;
+	streams[PS_MAX_AGE * stride] = part->mMaxAge;
+	streams[PS_SKIP_OFFSET * stride] = part->mSkipOffset;
+	mPartFlags[idx] = part->mFlags;
+}
 
-		// Update current time
-		const F32 cur_time = part->mLastUpdateTime + dt;
-		const F32 frac = cur_time / part->mMaxAge;
+void LLViewerPartGroup::storePart(U32 idx, LLViewerPart* part) const
+{
+	const F32* streams = mStreams + idx;
+	const U32 stride = mCapacity;
+
+	part->mPosAgent.setVec(streams[PS_POS_X * stride],
+						   streams[PS_POS_Y * stride],
+						   streams[PS_POS_Z * stride]);
+	part->mVelocity.setVec(streams[PS_VEL_X * stride],
+						   streams[PS_VEL_Y * stride],
+						   streams[PS_VEL_Z * stride]);
+	part->mAccel.setVec(streams[PS_ACC_X * stride],
+						streams[PS_ACC_Y * stride],
+						streams[PS_ACC_Z * stride]);
+	for (U32 i = 0; i < 4; ++i)
+	{
+		part->mColor.mV[i] = streams[(PS_COL_R + i) * stride];
+	}
+	part->mScale.setVec(streams[PS_SCALE_X * stride],
+						streams[PS_SCALE_Y * stride]);
+	part->mLastUpdateTime = streams[PS_AGE * stride];
+	part->mSkipOffset = streams[PS_SKIP_OFFSET * stride];
+}
 
-		// "Drift" the object based on the source object
-		if (part->mFlags & LLPartData::LL_PART_FOLLOW_SRC_MASK)
+void LLViewerPartGroup::removePart(U32 idx)
+{
+	U32 last = mParticles.size() - 1;
+	if (idx != last)
+	{
+		for (U32 i = 0; i < PS_COUNT; ++i)
 		{
-			part->mPosAgent = part->mPartSourcep->mPosAgent;
-			part->mPosAgent += part->mPosOffset;
+			F32* stream = mStreams + i * mCapacity;
+			stream[idx] = stream[last];
 		}
+		mPartFlags[idx] = mPartFlags[last];
+		mParticles[idx] = mParticles[last];
+	}
+	mParticles.pop_back();
+}
+
+
+// Behaviors that need the particle source, the wind or the particle callback.
+// They are applied on the LLViewerPart itself, which is synchronized with the
+// streams for the occasion.
+void LLViewerPartGroup::applyBehaviors(U32 idx, LLViewerPart* part)
+{
+	storePart(idx, part);
+
+	const F32 dt = getStream(PS_DT)[idx];
+
+	// Update current time
+	const F32 cur_time = part->mLastUpdateTime + dt;
+	const F32 frac = cur_time / part->mMaxAge;
+
+	// "Drift" the object based on the source object
+	if (part->mFlags & LLPartData::LL_PART_FOLLOW_SRC_MASK)
+	{
+		part->mPosAgent = part->mPartSourcep->mPosAgent;
+		part->mPosAgent += part->mPosOffset;
+	}
+
+	// Do a custom callback if we have one...
+	if (part->mVPCallback)
+	{
+		(*part->mVPCallback)(*part, dt);
+	}
+
+	if (part->mFlags & LLPartData::LL_PART_WIND_MASK)
+	{
+		LLViewerRegion *regionp = getRegion();
+		part->mVelocity *= 1.f - 0.1f*dt;
+		part->mVelocity += 0.1f*dt*regionp->mWind.getVelocity(regionp->getPosRegionFromAgent(part->mPosAgent));
+	}
+
+	// Now do interpolation towards a target
+	if (part->mFlags & LLPartData::LL_PART_TARGET_POS_MASK)
+	{
+		F32 remaining = part->mMaxAge - part->mLastUpdateTime;
+		F32 step = dt / remaining;
+
+		step = llclamp(step, 0.f, 0.1f);
+		step *= 5.f;
+		// we want a velocity that will result in reaching the target in the 
+		// Interpolate towards the target.
+		LLVector3 delta_pos = part->mPartSourcep->mTargetPosAgent - part->mPosAgent;
+
+		delta_pos /= remaining;
+
+		part->mVelocity *= (1.f - step);
+		part->mVelocity += step*delta_pos;
+	}
+
+	// Linear interpolation replaces the velocity integration (see
+	// integrateParticles())
+	if (part->mFlags & LLPartData::LL_PART_TARGET_LINEAR_MASK)
+	{
+		LLVector3 delta_pos = part->mPartSourcep->mTargetPosAgent - part->mPartSourcep->mPosAgent;			
+		part->mPosAgent = part->mPartSourcep->mPosAgent;
+		part->mPosAgent += frac*delta_pos;
+		part->mVelocity = delta_pos;
+	}
+
+	loadPart(idx, part);
+}
+
+static inline LLQuad select_quad(const LLQuad& mask, const LLQuad& a,
+									const LLQuad& b)
+{
+	return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
 
-		// Do a custom callback if we have one...
-		if (part->mVPCallback)
+// Velocity integration, color and scale interpolation, and aging of all the
+// particles, four at a time. Particles with LL_PART_TARGET_LINEAR_MASK got
+// their position and velocity set in applyBehaviors() and are not integrated.
+void LLViewerPartGroup::integrateParticles()
+{
+	const U32 count = mParticles.size();
+
+	const __m128i zeroi = _mm_setzero_si128();
+	const __m128i linear_bit = _mm_set1_epi32(LLPartData::LL_PART_TARGET_LINEAR_MASK);
+	const __m128i color_bit = _mm_set1_epi32(LLPartData::LL_PART_INTERP_COLOR_MASK);
+	const __m128i scale_bit = _mm_set1_epi32(LLPartData::LL_PART_INTERP_SCALE_MASK);
+	const LLQuad half = _mm_set1_ps(0.5f);
+	const LLQuad one = _mm_set1_ps(1.f);
+
+	F32* pos[3] = { getStream(PS_POS_X), getStream(PS_POS_Y), getStream(PS_POS_Z) };
+	F32* vel[3] = { getStream(PS_VEL_X), getStream(PS_VEL_Y), getStream(PS_VEL_Z) };
+	const F32* acc[3] = { getStream(PS_ACC_X), getStream(PS_ACC_Y), getStream(PS_ACC_Z) };
+	F32* ages = getStream(PS_AGE);
+	const F32* max_ages = getStream(PS_MAX_AGE);
+	const F32* dts = getStream(PS_DT);
+
+	// The capacity is a multiple of 4: the last block is processed in full,
+	// with the padding lanes results simply ignored.
+	for (U32 i = 0; i < count; i += 4)
+	{
+		__m128i flags = _mm_load_si128((const __m128i*)(mPartFlags + i));
+		LLQuad integrate = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(flags, linear_bit), zeroi));
+		LLQuad interp_color = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(flags, color_bit), color_bit));
+		LLQuad interp_scale = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(flags, scale_bit), scale_bit));
+
+		LLQuad dt = _mm_load_ps(dts + i);
+		LLQuad age = _mm_add_ps(_mm_load_ps(ages + i), dt);
+		LLQuad frac = _mm_div_ps(age, _mm_load_ps(max_ages + i));
+		LLQuad inv_frac = _mm_sub_ps(one, frac);
+		LLQuad half_dt2 = _mm_mul_ps(_mm_mul_ps(half, dt), dt);
+		_mm_store_ps(ages + i, age);
+
+		// Do velocity interpolation
+		for (U32 j = 0; j < 3; ++j)
 		{
-			(*part->mVPCallback)(*part, dt);
+			LLQuad p = _mm_load_ps(pos[j] + i);
+			LLQuad v = _mm_load_ps(vel[j] + i);
+			LLQuad a = _mm_load_ps(acc[j] + i);
+			LLQuad new_p = _mm_add_ps(_mm_add_ps(p, _mm_mul_ps(dt, v)),
+									  _mm_mul_ps(half_dt2, a));
+			LLQuad new_v = _mm_add_ps(v, _mm_mul_ps(a, dt));
+			_mm_store_ps(pos[j] + i, select_quad(integrate, new_p, p));
+			_mm_store_ps(vel[j] + i, select_quad(integrate, new_v, v));
 		}
 
-		if (part->mFlags & LLPartData::LL_PART_WIND_MASK)
+		// Do color interpolation
+		for (U32 j = 0; j < 4; ++j)
 		{
-			LLVector3 tempVel(part->mVelocity);
-			part->mVelocity *= 1.f - 0.1f*dt;
-			part->mVelocity += 0.1f*dt*regionp->mWind.getVelocity(regionp->getPosRegionFromAgent(part->mPosAgent));
+			F32* color = getStream((EPartStream)(PS_COL_R + j)) + i;
+			LLQuad start = _mm_load_ps(getStream((EPartStream)(PS_START_COL_R + j)) + i);
+			LLQuad end = _mm_load_ps(getStream((EPartStream)(PS_END_COL_R + j)) + i);
+			LLQuad c = _mm_add_ps(_mm_mul_ps(start, inv_frac),
+								  _mm_mul_ps(frac, end));
+			_mm_store_ps(color, select_quad(interp_color, c,
+											_mm_load_ps(color)));
 		}
 
-		// Now do interpolation towards a target
-		if (part->mFlags & LLPartData::LL_PART_TARGET_POS_MASK)
+		// Do scale interpolation
+		for (U32 j = 0; j < 2; ++j)
 		{
-			F32 remaining = part->mMaxAge - part->mLastUpdateTime;
-			F32 step = dt / remaining;
+			F32* scale = getStream((EPartStream)(PS_SCALE_X + j)) + i;
+			LLQuad start = _mm_load_ps(getStream((EPartStream)(PS_START_SCALE_X + j)) + i);
+			LLQuad end = _mm_load_ps(getStream((EPartStream)(PS_END_SCALE_X + j)) + i);
+			LLQuad s = _mm_add_ps(_mm_mul_ps(start, inv_frac),
+								  _mm_mul_ps(frac, end));
+			_mm_store_ps(scale, select_quad(interp_scale, s,
+											_mm_load_ps(scale)));
+		}
+	}
+}
 
-			step = llclamp(step, 0.f, 0.1f);
-			step *= 5.f;
-			// we want a velocity that will result in reaching the target in the 
-			// Interpolate towards the target.
-			LLVector3 delta_pos = part->mPartSourcep->mTargetPosAgent - part->mPosAgent;
+void LLViewerPartGroup::updateParticles(const F32 lastdt)
+{
+	LLMemType mt(LLMemType::MTYPE_PARTICLES);
 
-			delta_pos /= remaining;
+	LLViewerPartSim::checkParticleCount(mParticles.size());
 
-			part->mVelocity *= (1.f - step);
-			part->mVelocity += step*delta_pos;
-		}
+	const U32 behavior_mask = LLPartData::LL_PART_FOLLOW_SRC_MASK |
+							  LLPartData::LL_PART_WIND_MASK |
+							  LLPartData::LL_PART_TARGET_POS_MASK |
+							  LLPartData::LL_PART_TARGET_LINEAR_MASK;
 
+	S32 end = (S32) mParticles.size();
 
-		if (part->mFlags & LLPartData::LL_PART_TARGET_LINEAR_MASK)
-		{
-			LLVector3 delta_pos = part->mPartSourcep->mTargetPosAgent - part->mPartSourcep->mPosAgent;			
-			part->mPosAgent = part->mPartSourcep->mPosAgent;
-			part->mPosAgent += frac*delta_pos;
-			part->mVelocity = delta_pos;
-		}
-		else
+	// First pass: time steps and behaviors that cannot be vectorized
+	F32* dts = getStream(PS_DT);
+	F32* skip_offsets = getStream(PS_SKIP_OFFSET);
+	for (S32 i = 0; i < end; ++i)
+	{
+		LLViewerPart* part = mParticles[i];
+
+		dts[i] = lastdt + mSkippedTime - skip_offsets[i];
+		skip_offsets[i] = 0.f;
+
+		// Flags may have been changed by removeParticlesByID()
+		mPartFlags[i] = part->mFlags;
+
+		if (part->mVPCallback || (part->mFlags & behavior_mask))
 		{
-			// Do velocity interpolation
-			part->mPosAgent += dt*part->mVelocity;
-			part->mPosAgent += 0.5f*dt*dt*part->mAccel;
-			part->mVelocity += part->mAccel*dt;
+			applyBehaviors(i, part);
 		}
+	}
+
+	// Second pass: vectorized integration and interpolations
+	integrateParticles();
+
+	// Third pass: bounces, particles death and transfers between groups
+	for (S32 i = 0 ; i < (S32)mParticles.size();)
+	{
+		LLViewerPart* part = mParticles[i];
+		const U32 flags = mPartFlags[i];
+		F32* pos_z = getStream(PS_POS_Z) + i;
 
 		// Do a bounce test
-		if (part->mFlags & LLPartData::LL_PART_BOUNCE_MASK)
+		if (flags & LLPartData::LL_PART_BOUNCE_MASK)
 		{
 			// Need to do point vs. plane check...
 			// For now, just check relative to object height...
-			F32 dz = part->mPosAgent.mV[VZ] - part->mPartSourcep->mPosAgent.mV[VZ];
+			F32 dz = *pos_z - part->mPartSourcep->mPosAgent.mV[VZ];
 			if (dz < 0)
 			{
-				part->mPosAgent.mV[VZ] += -2.f*dz;
-				part->mVelocity.mV[VZ] *= -0.75f;
+				*pos_z += -2.f*dz;
+				getStream(PS_VEL_Z)[i] *= -0.75f;
 			}
 		}
 
+		LLVector3 pos_agent = getPartPosition(i);
 
 		// Reset the offset from the source position
-		if (part->mFlags & LLPartData::LL_PART_FOLLOW_SRC_MASK)
+		if (flags & LLPartData::LL_PART_FOLLOW_SRC_MASK)
 		{
-			part->mPosOffset = part->mPosAgent;
+			part->mPosOffset = pos_agent;
 			part->mPosOffset -= part->mPartSourcep->mPosAgent;
 		}
 
-		// Do color interpolation
-		if (part->mFlags & LLPartData::LL_PART_INTERP_COLOR_MASK)
-		{
-			part->mColor.setVec(part->mStartColor);
-			// note: LLColor4's v%k means multiply-alpha-only,
-			//       LLColor4's v*k means multiply-rgb-only
-			part->mColor *= 1.f - frac; // rgb*k
-			part->mColor %= 1.f - frac; // alpha*k
-			part->mColor += frac%(frac*part->mEndColor); // rgb,alpha
-		}
-
-		// Do scale interpolation
-		if (part->mFlags & LLPartData::LL_PART_INTERP_SCALE_MASK)
-		{
-			part->mScale.setVec(part->mStartScale);
-			part->mScale *= 1.f - frac;
-			part->mScale += frac*part->mEndScale;
-		}
-
-		// Set the last update time to now.
-		part->mLastUpdateTime = cur_time;
-
-
 		// Kill dead particles (either flagged dead, or too old)
-		if ((part->mLastUpdateTime > part->mMaxAge) || (LLViewerPart::LL_PART_DEAD_MASK == part->mFlags))
+		if ((getStream(PS_AGE)[i] > getStream(PS_MAX_AGE)[i]) || (LLViewerPart::LL_PART_DEAD_MASK == flags))
 		{
-			mParticles[i] = mParticles.back() ;
-			mParticles.pop_back() ;
+			removePart(i);
 			delete part ;
 		}
 		else 
 		{
-			F32 desired_size = calc_desired_size(part->mPosAgent, part->mScale);
-			if (!posInGroup(part->mPosAgent, desired_size))
+			F32 desired_size = calc_desired_size(pos_agent, getPartScale(i));
+			if (!posInGroup(pos_agent, desired_size))
 			{
 				// Transfer particles between groups
+				storePart(i, part);
+				removePart(i);
 				LLViewerPartSim::getInstance()->put(part) ;
-				mParticles[i] = mParticles.back() ;
-				mParticles.pop_back() ;
 			}
 			else
 			{
@@ -439,9 +646,13 @@ void LLViewerPartGroup::shift(const LLVector3 &offset)
 	mMinObjPos += offset;
 	mMaxObjPos += offset;
 
-	for (S32 i = 0 ; i < (S32)mParticles.size(); i++)
+	F32* pos[3] = { getStream(PS_POS_X), getStream(PS_POS_Y), getStream(PS_POS_Z) };
+	for (U32 j = 0; j < 3; ++j)
 	{
-		mParticles[i]->mPosAgent += offset;
+		for (S32 i = 0 ; i < (S32)mParticles.size(); i++)
+		{
+			pos[j][i] += offset.mV[j];
+		}
 	}
 }
 
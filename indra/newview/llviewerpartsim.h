@@ -49,6 +49,10 @@ typedef void (*LLVPCallback)(LLViewerPart &part, const F32 dt);
 //
 // An individual particle
 //
+// Note: while a particle belongs to a LLViewerPartGroup, its kinematic state
+// (position, velocity, acceleration, color, scale and age) lives in the
+// group particle streams, and the corresponding members below are only kept
+// in sync around the callbacks and the transfers between groups.
 
 
 class LLViewerPart : public LLPartData
@@ -108,6 +112,28 @@ public:
 	LLViewerRegion *getRegion() const		{ return mRegionp; }
 
 	void removeParticlesByID(const U32 source_id);
+
+	// Current state of the idx'th particle (same index as in mParticles)
+	LLVector3 getPartPosition(S32 idx) const
+	{
+		return LLVector3(getStream(PS_POS_X)[idx], getStream(PS_POS_Y)[idx],
+						 getStream(PS_POS_Z)[idx]);
+	}
+	LLVector3 getPartVelocity(S32 idx) const
+	{
+		return LLVector3(getStream(PS_VEL_X)[idx], getStream(PS_VEL_Y)[idx],
+						 getStream(PS_VEL_Z)[idx]);
+	}
+	LLColor4 getPartColor(S32 idx) const
+	{
+		return LLColor4(getStream(PS_COL_R)[idx], getStream(PS_COL_G)[idx],
+						getStream(PS_COL_B)[idx], getStream(PS_COL_A)[idx]);
+	}
+	LLVector2 getPartScale(S32 idx) const
+	{
+		return LLVector2(getStream(PS_SCALE_X)[idx],
+						 getStream(PS_SCALE_Y)[idx]);
+	}
 	
 	LLPointer<LLVOPartGroup> mVOPartGroupp;
 
@@ -118,6 +144,49 @@ public:
 	bool mHud;
 
 protected:
+	// Particle streams, in structure of arrays form so that the particles
+	// can be integrated four at a time with SSE.
+	enum EPartStream
+	{
+		PS_POS_X, PS_POS_Y, PS_POS_Z,
+		PS_VEL_X, PS_VEL_Y, PS_VEL_Z,
+		PS_ACC_X, PS_ACC_Y, PS_ACC_Z,
+		PS_COL_R, PS_COL_G, PS_COL_B, PS_COL_A,
+		PS_START_COL_R, PS_START_COL_G, PS_START_COL_B, PS_START_COL_A,
+		PS_END_COL_R, PS_END_COL_G, PS_END_COL_B, PS_END_COL_A,
+		PS_SCALE_X, PS_SCALE_Y,
+		PS_START_SCALE_X, PS_START_SCALE_Y,
+		PS_END_SCALE_X, PS_END_SCALE_Y,
+		PS_AGE,			// Last update time
+		PS_MAX_AGE,
+		PS_SKIP_OFFSET,
+		PS_DT,			// Time step for the current update
+		PS_COUNT
+	};
+
+	F32* getStream(EPartStream stream)				{ return mStreams + stream * mCapacity; }
+	const F32* getStream(EPartStream stream) const	{ return mStreams + stream * mCapacity; }
+
+	void reserveParts(U32 count);
+	// Copies the state of a particle into the streams, at index idx
+	void loadPart(U32 idx, const LLViewerPart* part);
+	// Copies the streams state at index idx back into the particle
+	void storePart(U32 idx, LLViewerPart* part) const;
+	// Removes the idx'th particle by moving the last particle in its slot
+	void removePart(U32 idx);
+
+	void applyBehaviors(U32 idx, LLViewerPart* part);
+	void integrateParticles();
+
+protected:
+	// PS_COUNT streams of mCapacity floats each, 16 bytes aligned
+	F32* mStreams;
+	// Particle flags, same indexing as the streams
+	U32* mPartFlags;
+	// Always a multiple of 4, so that the streams may be processed in full
+	// SSE registers
+	U32 mCapacity;
+
 	LLVector3 mCenterAgent;
 	F32 mBoxRadius;
 	LLVector3 mMinObjPos;
@@ -1178,7 +1178,7 @@ BOOL LLViewerTextEditor::handleDragAndDrop(S32 x, S32 y, MASK mask,
 								setCursorPos(mCursorPos + 1);
 							}
 
-							updateLineStartList();
+							updateLineStartList(insert_pos);
 						}
 						*accept = ACCEPT_YES_COPY_MULTI;
 					}
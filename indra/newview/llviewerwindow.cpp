@@ -77,6 +77,7 @@
 #include "lldebugview.h"
 #include "lldrawable.h"
 #include "lldrawpoolalpha.h"
+#include "lldrawpoolavatar.h"
 #include "lldrawpoolbump.h"
 #include "lldrawpoolwater.h"
 #include "llface.h"
@@ -495,6 +496,41 @@ public:
 			addText(xpos, ypos, llformat("%d Unique Textures", LLImageGL::sUniqueCount));
 			ypos += y_inc;
 
+			U32 skin_lookups = LLDrawPoolAvatar::sSkinCacheHits +
+							   LLDrawPoolAvatar::sSkinCacheMisses;
+			if (skin_lookups)
+			{
+				addText(xpos, ypos,
+						llformat("%d/%d Rigged Skinning Cache Hits (%.1f%%)",
+								 LLDrawPoolAvatar::sSkinCacheHits,
+								 skin_lookups,
+								 100.f * LLDrawPoolAvatar::sSkinCacheHits / skin_lookups));
+				ypos += y_inc;
+			}
+			LLDrawPoolAvatar::sSkinCacheHits = 0;
+			LLDrawPoolAvatar::sSkinCacheMisses = 0;
+
+			U32 anim_lod_reduced = LLVOAvatar::getLastAnimationLODCount(LLMotionController::ANIM_LOD_REDUCED);
+			U32 anim_lod_low = LLVOAvatar::getLastAnimationLODCount(LLMotionController::ANIM_LOD_LOW);
+			if (anim_lod_reduced || anim_lod_low)
+			{
+				addText(xpos, ypos,
+						llformat("Animation LOD: %d full, %d reduced, %d low (%.2f ms saved)",
+								 LLVOAvatar::getLastAnimationLODCount(LLMotionController::ANIM_LOD_FULL),
+								 anim_lod_reduced, anim_lod_low,
+								 LLVOAvatar::getLastAnimationLODSavedMs()));
+				ypos += y_inc;
+			}
+
+			U32 anim_batch = LLVOAvatar::getLastAnimationBatchSize();
+			if (anim_batch)
+			{
+				addText(xpos, ypos,
+						llformat("%d Avatar Animation Updates Batched",
+								 anim_batch));
+				ypos += y_inc;
+			}
+
 			addText(xpos, ypos, llformat("%d Render Calls", gPipeline.mBatchCount));
             ypos += y_inc;
 
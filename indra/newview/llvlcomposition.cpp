@@ -36,10 +36,12 @@
 
 #include "imageids.h"
 #include "llerror.h"
+#include "llqueuedthread.h"
 #include "llregionhandle.h" // for from_region_handle
 #include "v3math.h"
 
 #include "llsurface.h"
+#include "llsurfacepatch.h"
 #include "lltextureview.h"
 #include "llviewercontrol.h"
 #include "llviewerregion.h"
@@ -63,7 +65,8 @@ F32 bilinear(const F32 v00, const F32 v01, const F32 v10, const F32 v11,
 LLVLComposition::LLVLComposition(LLSurface* surfacep, const U32 width,
 								 const F32 scale)
 :	LLViewerLayer(width, scale),
-	mParamsReady(FALSE)
+	mParamsReady(FALSE),
+	mTextureStamp(1)
 {
 	mSurfacep = surfacep;
 
@@ -91,6 +94,9 @@ LLVLComposition::LLVLComposition(LLSurface* surfacep, const U32 width,
 
 LLVLComposition::~LLVLComposition()
 {
+	// Tiles still being composited by the worker thread are kept alive by
+	// their request.
+	mPendingTiles.clear();
 }
 
 void LLVLComposition::setSurface(LLSurface* surfacep)
@@ -107,6 +113,7 @@ void LLVLComposition::setDetailTextureID(S32 corner, const LLUUID& id)
 	mDetailTextures[corner] = LLViewerTextureManager::getFetchedTexture(id);
 	mDetailTextures[corner]->setNoDelete();
 	mRawImages[corner] = NULL;
+	++mTextureStamp;
 }
 
 BOOL LLVLComposition::generateHeights(const F32 x, const F32 y,
@@ -261,8 +268,269 @@ BOOL LLVLComposition::generateComposition()
 	return TRUE;
 }
 
+//-----------------------------------------------------------------------------
+// LLTerrainTile class
+// Inputs and result of the composition of the texels of the surface texture
+// covered by a patch. Built on the main thread, composited on any thread.
+//-----------------------------------------------------------------------------
+class LLTerrainTile : public LLThreadSafeRefCount
+{
+protected:
+	~LLTerrainTile()	{}
+
+public:
+	LLTerrainTile()
+	:	mPatchp(NULL),
+		mComposeTime(0.f),
+		mDone(0)
+	{
+	}
+
+	// Composites the texels into mImage. May be called from any thread.
+	void composite();
+
+	// Same as LLViewerLayer::getValueScaled(), but using the snapshot of the
+	// composition values.
+	F32 getValueScaled(const F32 x, const F32 y) const;
+
+	bool isDone()	{ return mDone != 0; }
+
+public:
+	LLPointer<LLImageRaw>	mRawImages[LLVLComposition::CORNER_COUNT];
+	LLPointer<LLImageRaw>	mImage;
+
+	// Snapshot of the composition values used by the tile texels
+	std::vector<F32>		mValues;
+	S32						mValuesX;
+	S32						mValuesY;
+	S32						mValuesWidth;
+	S32						mLayerWidth;
+	F32						mScaleInv;
+
+	// Texels bounding box and strides in the surface texture
+	S32						mTexXBegin;
+	S32						mTexYBegin;
+	S32						mTexXEnd;
+	S32						mTexYEnd;
+	F32						mTexXRatio;
+	F32						mTexYRatio;
+	F32						mSTXStride;
+	F32						mSTYStride;
+
+	// Main thread data
+	LLSurfacePatch*			mPatchp;
+	U32						mStamp;
+	U32						mDigest;
+
+	F32						mComposeTime;
+	LLAtomicS32				mDone;
+};
+
+F32 LLTerrainTile::getValueScaled(const F32 x, const F32 y) const
+{
+	S32 x1, x2, y1, y2;
+	F32 x_frac, y_frac;
+
+	x_frac = x*mScaleInv;
+	x1 = llfloor(x_frac);
+	x2 = x1 + 1;
+	x_frac -= x1;
+
+	y_frac = y*mScaleInv;
+	y1 = llfloor(y_frac);
+	y2 = y1 + 1;
+	y_frac -= y1;
+
+	x1 = llclamp(x1, 0, mLayerWidth - 1) - mValuesX;
+	x2 = llclamp(x2, 0, mLayerWidth - 1) - mValuesX;
+	y1 = llclamp(y1, 0, mLayerWidth - 1) - mValuesY;
+	y2 = llclamp(y2, 0, mLayerWidth - 1) - mValuesY;
+
+	S32 row1 = y1 * mValuesWidth;
+	S32 row2 = y2 * mValuesWidth;
+
+	F32 row1_left  = mValues[row1 + x1];
+	F32 row1_right = mValues[row1 + x2];
+	F32 row2_left  = mValues[row2 + x1];
+	F32 row2_right = mValues[row2 + x2];
+
+	F32 row1_interp = row1_left - x_frac * (row1_left - row1_right);
+	F32 row2_interp = row2_left - x_frac * (row2_left - row2_right);
+
+	return row1_interp - y_frac * (row1_interp - row2_interp);
+}
+
+void LLTerrainTile::composite()
+{
+	LLTimer compose_timer;
+
+	U8* st_data[LLVLComposition::CORNER_COUNT];
+	S32 st_data_size[LLVLComposition::CORNER_COUNT]; // for debugging
+	for (S32 i = 0; i < LLVLComposition::CORNER_COUNT; ++i)
+	{
+		st_data[i] = mRawImages[i]->getData();
+		st_data_size[i] = mRawImages[i]->getDataSize();
+	}
+
+	const U32 st_comps = 3;
+	const U32 st_width = BASE_SIZE;
+	const U32 st_height = BASE_SIZE;
+	const U32 tile_stride = mImage->getWidth() * st_comps;
+	U8* rawp = mImage->getData();
+
+	////////////////////////////////
+	//
+	// Iterate through the target texture, striding through the
+	// subtextures and interpolating appropriately.
+	//
+	//
+
+	F32 sti, stj;
+	S32 st_offset;
+	stj = mTexYBegin * mSTYStride - st_height * llfloor(mTexYBegin * mSTYStride / st_height);
+
+	for (S32 j = mTexYBegin; j < mTexYEnd; ++j)
+	{
+		U32 offset = (j - mTexYBegin) * tile_stride;
+		sti = mTexXBegin * mSTXStride - st_width * ((U32)(mTexXBegin * mSTXStride) / st_width);
+		for (S32 i = mTexXBegin; i < mTexXEnd; ++i)
+		{
+			S32 tex0, tex1;
+			F32 composition = getValueScaled(i * mTexXRatio, j * mTexYRatio);
+
+			tex0 = llfloor(composition);
+			tex0 = llclamp(tex0, 0, 3);
+			composition -= tex0;
+			tex1 = tex0 + 1;
+			tex1 = llclamp(tex1, 0, 3);
+
+			st_offset = (lltrunc(sti) + lltrunc(stj) * st_width) * st_comps;
+			for (U32 k = 0; k < st_comps; ++k)
+			{
+				// Linearly interpolate based on composition.
+				if (st_offset >= st_data_size[tex0] ||
+					st_offset >= st_data_size[tex1])
+				{
+					// SJB: This shouldn't be happening, but does... Rounding
+					// error ?
+				}
+				else
+				{
+					F32 a = *(st_data[tex0] + st_offset);
+					F32 b = *(st_data[tex1] + st_offset);
+					rawp[offset] = (U8)lltrunc(a + composition * (b - a));
+				}
+				offset++;
+				st_offset++;
+			}
+
+			sti += mSTXStride;
+			if (sti >= st_width)
+			{
+				sti -= st_width;
+			}
+		}
+
+		stj += mSTYStride;
+		if (stj >= st_height)
+		{
+			stj -= st_height;
+		}
+	}
+
+	mComposeTime = compose_timer.getElapsedTimeF32();
+	mDone = 1;
+}
+
+//-----------------------------------------------------------------------------
+// LLTerrainCompositionThread class
+// Worker thread compositing the terrain tiles.
+//-----------------------------------------------------------------------------
+class LLTerrainCompositionThread : public LLQueuedThread
+{
+public:
+	class CompositeRequest : public LLQueuedThread::QueuedRequest
+	{
+		friend class LLTerrainCompositionThread;
+
+	protected:
+		virtual ~CompositeRequest()	{} // use deleteRequest()
+
+	public:
+		CompositeRequest(handle_t handle, LLTerrainTile* tile)
+		:	LLQueuedThread::QueuedRequest(handle,
+										  LLQueuedThread::PRIORITY_NORMAL,
+										  FLAG_AUTO_COMPLETE),
+			mTile(tile)
+		{
+		}
+
+		// WORKER THREAD
+		/*virtual*/ bool processRequest()
+		{
+			mTile->composite();
+			return true;
+		}
+
+	private:
+		LLPointer<LLTerrainTile> mTile;
+	};
+
+public:
+	LLTerrainCompositionThread()
+	:	LLQueuedThread("terraincomposition")
+	{
+	}
+
+	// MAIN THREAD
+	bool requestComposite(LLTerrainTile* tile)
+	{
+		CompositeRequest* req = new CompositeRequest(generateHandle(), tile);
+		if (!addRequest(req))
+		{
+			req->deleteRequest();
+			return false;
+		}
+		return true;
+	}
+};
+
+static LLTerrainCompositionThread* sCompositionThread = NULL;
+
+// FNV-1a hash of the inputs of a tile (besides the detail textures)
+static U32 digest_tile(const LLTerrainTile* tile)
+{
+	U32 hash = 2166136261U;
+	const S32 rect[4] = { tile->mTexXBegin, tile->mTexYBegin,
+						  tile->mTexXEnd, tile->mTexYEnd };
+	const U8* data = (const U8*)rect;
+	for (size_t i = 0; i < sizeof(rect); ++i)
+	{
+		hash = (hash ^ data[i]) * 16777619U;
+	}
+	data = (const U8*)&tile->mValues[0];
+	for (size_t i = 0, count = tile->mValues.size() * sizeof(F32); i < count;
+		 ++i)
+	{
+		hash = (hash ^ data[i]) * 16777619U;
+	}
+	return hash;
+}
+
+//static
+void LLVLComposition::cleanupClass()
+{
+	if (sCompositionThread)
+	{
+		sCompositionThread->shutdown();
+		delete sCompositionThread;
+		sCompositionThread = NULL;
+	}
+}
+
 BOOL LLVLComposition::generateTexture(const F32 x, const F32 y,
-									  const F32 width, const F32 height)
+									  const F32 width, const F32 height,
+									  LLSurfacePatch* patchp)
 {
 	llassert(mSurfacep);
 	llassert(x >= 0.f);
@@ -270,6 +538,8 @@ BOOL LLVLComposition::generateTexture(const F32 x, const F32 y,
 
 	LLTimer gen_timer;
 
+	LLPointer<LLTerrainTile> tile = new LLTerrainTile;
+
 	///////////////////////////
 	//
 	// Generate raw data arrays for surface textures
@@ -277,9 +547,6 @@ BOOL LLVLComposition::generateTexture(const F32 x, const F32 y,
 	//
 
 	// These have already been validated by generateComposition.
-	U8* st_data[4];
-	S32 st_data_size[4]; // for debugging
-
 	for (S32 i = 0; i < 4; ++i)
 	{
 		if (mRawImages[i].isNull())
@@ -320,8 +587,7 @@ BOOL LLVLComposition::generateTexture(const F32 x, const F32 y,
 				mRawImages[i] = newraw; // deletes old
 			}
 		}
-		st_data[i] = mRawImages[i]->getData();
-		st_data_size[i] = mRawImages[i]->getDataSize();
+		tile->mRawImages[i] = mRawImages[i];
 	}
 
 	///////////////////////////////////////
@@ -355,7 +621,6 @@ BOOL LLVLComposition::generateTexture(const F32 x, const F32 y,
 
 	LLViewerTexture* texturep;
 	U32 tex_width, tex_height, tex_comps;
-	U32 tex_stride;
 	F32 tex_x_scalef, tex_y_scalef;
 	S32 tex_x_begin, tex_y_begin, tex_x_end, tex_y_end;
 	F32 tex_x_ratiof, tex_y_ratiof;
@@ -364,7 +629,6 @@ BOOL LLVLComposition::generateTexture(const F32 x, const F32 y,
 	tex_width = texturep->getWidth();
 	tex_height = texturep->getHeight();
 	tex_comps = texturep->getComponents();
-	tex_stride = tex_width * tex_comps;
 
 	U32 st_comps = 3;
 	U32 st_width = BASE_SIZE;
@@ -386,108 +650,193 @@ BOOL LLVLComposition::generateTexture(const F32 x, const F32 y,
 	tex_x_ratiof = (F32)mWidth*mScale / (F32)tex_width;
 	tex_y_ratiof = (F32)mWidth*mScale / (F32)tex_height;
 
-	LLPointer<LLImageRaw> raw = new LLImageRaw(tex_width, tex_height,
-											   tex_comps);
-	U8 *rawp = raw->getData();
-
-	F32 tex_width_inv = 1.f/tex_width;
-	F32 tex_height_inv = 1.f/tex_height;
-
 	F32 st_x_stride, st_y_stride;
 	st_x_stride = ((F32)st_width / (F32)mTexScaleX)*((F32)mWidth / (F32)tex_width);
 	st_y_stride = ((F32)st_height / (F32)mTexScaleY)*((F32)mWidth / (F32)tex_height);
 
 	llassert(st_x_stride > 0.f);
 	llassert(st_y_stride > 0.f);
-	////////////////////////////////
-	//
-	// Iterate through the target texture, striding through the
-	// subtextures and interpolating appropriately.
-	//
-	//
 
-	F32 sti, stj;
-	S32 st_offset;
-	sti = tex_x_begin * st_x_stride - st_width * llfloor(tex_x_begin * st_x_stride / st_width);
-	stj = tex_y_begin * st_y_stride - st_height * llfloor(tex_y_begin * st_y_stride / st_height);
+	tile->mTexXBegin = tex_x_begin;
+	tile->mTexYBegin = tex_y_begin;
+	tile->mTexXEnd = tex_x_end;
+	tile->mTexYEnd = tex_y_end;
+	tile->mTexXRatio = tex_x_ratiof;
+	tile->mTexYRatio = tex_y_ratiof;
+	tile->mSTXStride = st_x_stride;
+	tile->mSTYStride = st_y_stride;
+	tile->mStamp = mTextureStamp;
+
+	for (S32 i = 0; i < 4; ++i)
+	{
+		// Un-boost detatil textures (will get re-boosted if rendering in high
+		// detail)
+		mDetailTextures[i]->setBoostLevel(LLViewerTexture::BOOST_NONE);
+		mDetailTextures[i]->setMinDiscardLevel(MAX_DISCARD_LEVEL + 1);
+	}
 
-	st_offset = (llfloor(stj * st_width) + llfloor(sti)) * st_comps;
-	for (S32 j = tex_y_begin; j < tex_y_end; ++j)
+	if (tex_x_end <= tex_x_begin || tex_y_end <= tex_y_begin)
 	{
-		U32 offset = j * tex_stride + tex_x_begin * tex_comps;
-		sti = tex_x_begin * st_x_stride - st_width * ((U32)(tex_x_begin * st_x_stride) / st_width);
-		for (S32 i = tex_x_begin; i < tex_x_end; ++i)
+		// Nothing to composite
+		if (patchp)
 		{
-			S32 tex0, tex1;
-			F32 composition = getValueScaled(i * tex_x_ratiof, j * tex_y_ratiof);
+			cancelTiles(patchp);
+			patchp->setTextureGenerated(tile->mStamp, 0);
+		}
+		return TRUE;
+	}
 
-			tex0 = llfloor(composition);
-			tex0 = llclamp(tex0, 0, 3);
-			composition -= tex0;
-			tex1 = tex0 + 1;
-			tex1 = llclamp(tex1, 0, 3);
+	// Snapshot the composition values used by the texels (with the same
+	// computations and clamping as getValueScaled()), so that the tile does
+	// not depend on the layer data, which may be modified by
+	// generateHeights() for other patches while it is composited. One value
+	// of margin is kept on each side, to be safe with rounding.
+	S32 values_x0 = llclamp(llfloor((F32)(tex_x_begin * tex_x_ratiof) * mScaleInv) - 1,
+							0, mWidth - 1);
+	S32 values_x1 = llclamp(llfloor((F32)((tex_x_end - 1) * tex_x_ratiof) * mScaleInv) + 2,
+							0, mWidth - 1);
+	S32 values_y0 = llclamp(llfloor((F32)(tex_y_begin * tex_y_ratiof) * mScaleInv) - 1,
+							0, mWidth - 1);
+	S32 values_y1 = llclamp(llfloor((F32)((tex_y_end - 1) * tex_y_ratiof) * mScaleInv) + 2,
+							0, mWidth - 1);
+	S32 values_width = values_x1 - values_x0 + 1;
+	tile->mValues.resize(values_width * (values_y1 - values_y0 + 1));
+	for (S32 j = values_y0; j <= values_y1; ++j)
+	{
+		memcpy(&tile->mValues[(j - values_y0) * values_width],
+			   mDatap + j * mWidth + values_x0, values_width * sizeof(F32));
+	}
+	tile->mValuesX = values_x0;
+	tile->mValuesY = values_y0;
+	tile->mValuesWidth = values_width;
+	tile->mLayerWidth = mWidth;
+	tile->mScaleInv = mScaleInv;
+
+	// Per-patch dirty tracking: the texels only depend on the detail textures
+	// (mTextureStamp), the composition values and the texels rect, so there is
+	// no need to composite them again when a patch is dirtied with unchanged
+	// composition values (e.g. when the same LayerData is received again).
+	tile->mDigest = digest_tile(tile);
+	if (patchp && patchp->hasTexture(tile->mStamp, tile->mDigest))
+	{
+		cancelTiles(patchp);
+		patchp->setTextureGenerated(tile->mStamp, tile->mDigest);
+		return TRUE;
+	}
 
-			F32 xy_int_i, xy_int_j;
+	tile->mImage = new LLImageRaw(tex_x_end - tex_x_begin,
+								  tex_y_end - tex_y_begin, tex_comps);
 
-			xy_int_i = i * tex_width_inv;
-			xy_int_j = j * tex_height_inv;
+	static LLCachedControl<bool> background_composition(gSavedSettings,
+														"TerrainBackgroundComposition");
+	if (patchp && background_composition)
+	{
+		if (!sCompositionThread)
+		{
+			sCompositionThread = new LLTerrainCompositionThread();
+		}
+		if (sCompositionThread->requestComposite(tile))
+		{
+			cancelTiles(patchp);
+			tile->mPatchp = patchp;
+			mPendingTiles.push_back(tile);
+			return FALSE;
+		}
+	}
 
-			st_offset = (lltrunc(sti) + lltrunc(stj) * st_width) * st_comps;
-			for (U32 k = 0; k < tex_comps; ++k)
-			{
-				// Linearly interpolate based on composition.
-				if (st_offset >= st_data_size[tex0] ||
-					st_offset >= st_data_size[tex1])
-				{
-					// SJB: This shouldn't be happening, but does... Rounding
-					// error ?
-					//llwarns << "offset 0 [" << tex0 << "] =" << st_offset
-					//		<< " >= size=" << st_data_size[tex0] << llendl;
-					//llwarns << "offset 1 [" << tex1 << "] =" << st_offset
-					//		<< " >= size=" << st_data_size[tex1] << llendl;
-				}
-				else
-				{
-					F32 a = *(st_data[tex0] + st_offset);
-					F32 b = *(st_data[tex1] + st_offset);
-					rawp[offset] = (U8)lltrunc(a + composition * (b - a));
-				}
-				offset++;
-				st_offset++;
-			}
+	tile->composite();
+	uploadTile(tile);
+	LLSurface::sTextureUpdateTime += gen_timer.getElapsedTimeF32() - tile->mComposeTime;
+	if (patchp)
+	{
+		cancelTiles(patchp);
+		patchp->setTextureGenerated(tile->mStamp, tile->mDigest);
+	}
 
-			sti += st_x_stride;
-			if (sti >= st_width)
-			{
-				sti -= st_width;
-			}
-		}
+	return TRUE;
+}
 
-		stj += st_y_stride;
-		if (stj >= st_height)
+void LLVLComposition::cancelTiles(LLSurfacePatch* patchp)
+{
+	// Any tile still pending for this patch is now obsolete.
+	for (tile_list_t::iterator iter = mPendingTiles.begin(),
+							   end = mPendingTiles.end();
+		 iter != end; ++iter)
+	{
+		if ((*iter)->mPatchp == patchp)
 		{
-			stj -= st_height;
+			(*iter)->mPatchp = NULL;
 		}
 	}
+}
 
-	if (!texturep->hasGLTexture())
+void LLVLComposition::uploadTile(LLTerrainTile* tile)
+{
+	LLTimer upload_timer;
+
+	LLViewerTexture* texturep = mSurfacep->getSTexture();
+	S32 tex_width = texturep->getWidth();
+	S32 tex_height = texturep->getHeight();
+	S32 tex_comps = texturep->getComponents();
+	S32 width = tile->mTexXEnd - tile->mTexXBegin;
+	S32 height = tile->mTexYEnd - tile->mTexYBegin;
+	if (tex_comps != tile->mImage->getComponents() ||
+		tile->mTexXEnd > tex_width || tile->mTexYEnd > tex_height)
 	{
-		texturep->createGLTexture(0, raw);
+		// The surface texture changed in the meantime
+		return;
 	}
-	texturep->setSubImage(raw, tex_x_begin, tex_y_begin,
-						  tex_x_end - tex_x_begin, tex_y_end - tex_y_begin);
-	LLSurface::sTextureUpdateTime += gen_timer.getElapsedTimeF32();
-	LLSurface::sTexelsUpdated += (tex_x_end - tex_x_begin) * (tex_y_end - tex_y_begin);
 
-	for (S32 i = 0; i < 4; ++i)
+	if (mTexImage.isNull() || mTexImage->getWidth() != tex_width ||
+		mTexImage->getHeight() != tex_height ||
+		mTexImage->getComponents() != tex_comps)
 	{
-		// Un-boost detatil textures (will get re-boosted if rendering in high
-		// detail)
-		mDetailTextures[i]->setBoostLevel(LLViewerTexture::BOOST_NONE);
-		mDetailTextures[i]->setMinDiscardLevel(MAX_DISCARD_LEVEL + 1);
+		mTexImage = new LLImageRaw(tex_width, tex_height, tex_comps);
+		mTexImage->clear(0, 0, 0);
 	}
 
-	return TRUE;
+	S32 tex_stride = tex_width * tex_comps;
+	S32 tile_stride = width * tex_comps;
+	const U8* tile_data = tile->mImage->getData();
+	U8* tex_data = mTexImage->getData() + tile->mTexYBegin * tex_stride +
+				   tile->mTexXBegin * tex_comps;
+	for (S32 j = 0; j < height; ++j)
+	{
+		memcpy(tex_data, tile_data, tile_stride);
+		tex_data += tex_stride;
+		tile_data += tile_stride;
+	}
+
+	if (!texturep->hasGLTexture())
+	{
+		texturep->createGLTexture(0, mTexImage);
+	}
+	texturep->setSubImage(mTexImage, tile->mTexXBegin, tile->mTexYBegin,
+						  width, height);
+
+	LLSurface::sTextureUpdateTime += tile->mComposeTime +
+									 upload_timer.getElapsedTimeF32();
+	LLSurface::sTexelsUpdated += width * height;
+}
+
+void LLVLComposition::updateTiles()
+{
+	for (tile_list_t::iterator iter = mPendingTiles.begin();
+		 iter != mPendingTiles.end(); )
+	{
+		LLTerrainTile* tile = *iter;
+		if (!tile->isDone())
+		{
+			++iter;
+			continue;
+		}
+		if (tile->mPatchp)
+		{
+			uploadTile(tile);
+			tile->mPatchp->setTextureGenerated(tile->mStamp, tile->mDigest);
+		}
+		iter = mPendingTiles.erase(iter);
+	}
 }
 
 LLUUID LLVLComposition::getDetailTextureID(S32 corner)
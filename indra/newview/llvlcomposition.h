@@ -33,10 +33,14 @@
 #ifndef LL_LLVLCOMPOSITION_H
 #define LL_LLVLCOMPOSITION_H
 
+#include <list>
+
 #include "llviewerlayer.h"
 #include "llviewertexture.h"
 
 class LLSurface;
+class LLSurfacePatch;
+class LLTerrainTile;
 
 class LLVLComposition : public LLViewerLayer
 {
@@ -49,8 +53,18 @@ public:
 	// Viewer side hack to generate composition values
 	BOOL generateHeights(const F32 x, const F32 y, const F32 width, const F32 height);
 	BOOL generateComposition();
-	// Generate texture from composition values.
-	BOOL generateTexture(const F32 x, const F32 y, const F32 width, const F32 height);		
+	// Generate texture from composition values. When 'patchp' is not NULL,
+	// the texels are only composited when their inputs changed since the last
+	// time, and patchp->setTextureGenerated() is called once they are up to
+	// date. With TerrainBackgroundComposition TRUE, they are composited by a
+	// worker thread and FALSE is returned: updateTiles() then uploads them.
+	BOOL generateTexture(const F32 x, const F32 y, const F32 width, const F32 height,
+						 LLSurfacePatch* patchp = NULL);
+
+	// Uploads the texels composited by the worker thread. Main thread only.
+	void updateTiles();
+
+	static void cleanupClass();
 
 	// Use these as indeces ito the get/setters below that use 'corner'
 	enum ECorner
@@ -74,6 +88,10 @@ public:
 	friend class LLDrawPoolTerrain;
 	void setParamsReady()		{ mParamsReady = TRUE; }
 	BOOL getParamsReady() const	{ return mParamsReady; }
+protected:
+	void uploadTile(LLTerrainTile* tile);
+	void cancelTiles(LLSurfacePatch* patchp);
+
 protected:
 	BOOL mParamsReady;
 	LLSurface *mSurfacep;
@@ -87,6 +105,15 @@ protected:
 
 	F32 mTexScaleX;
 	F32 mTexScaleY;
+
+	// Copy of the surface texture texels
+	LLPointer<LLImageRaw> mTexImage;
+
+	typedef std::list<LLPointer<LLTerrainTile> > tile_list_t;
+	tile_list_t mPendingTiles;
+
+	// Changes whenever the detail textures change
+	U32 mTextureStamp;
 };
 
 #endif //LL_LLVLCOMPOSITION_H
@@ -65,8 +65,10 @@
 #include "llmeshrepository.h"
 #include "llmutelist.h"
 #include "llphysicsmotion.h"
+#include "llqueuedthread.h"
 #include "llselectmgr.h"
 #include "lltexlayer.h"
+#include "lltexlayercompositor.h"
 #include "lltoolmorph.h"
 #include "llviewercamera.h"
 #include "llviewercontrol.h"
@@ -578,6 +580,65 @@ private:
 	LLCharacter*			mCharacter;
 };
 
+//-----------------------------------------------------------------------------
+// LLAvatarAnimThread class
+// Worker thread used by LLVOAvatar::flushAnimationUpdates(). Each request
+// simply joins the main thread in draining the pending avatars list.
+//-----------------------------------------------------------------------------
+class LLAvatarAnimThread : public LLQueuedThread
+{
+public:
+	class AnimRequest : public LLQueuedThread::QueuedRequest
+	{
+		friend class LLAvatarAnimThread;
+
+	protected:
+		virtual ~AnimRequest()	{} // use deleteRequest()
+
+	public:
+		AnimRequest(handle_t handle)
+		:	LLQueuedThread::QueuedRequest(handle,
+										  LLQueuedThread::PRIORITY_HIGH,
+										  FLAG_AUTO_COMPLETE)
+		{
+		}
+
+		// WORKER THREAD
+		/*virtual*/ bool processRequest();
+	};
+
+public:
+	LLAvatarAnimThread(const std::string& name)
+	:	LLQueuedThread(name)
+	{
+	}
+
+	// MAIN THREAD
+	bool requestUpdates()
+	{
+		AnimRequest* req = new AnimRequest(generateHandle());
+		if (!addRequest(req))
+		{
+			req->deleteRequest();
+			return false;
+		}
+		return true;
+	}
+};
+
+static std::vector<LLAvatarAnimThread*> sAnimThreads;
+// Index of the next avatar to process in LLVOAvatar::sPendingAnimUpdates
+static LLAtomicS32 sAnimUpdateIndex(0);
+// Number of worker requests done with the current batch
+static LLAtomicS32 sAnimRequestsDone(0);
+
+bool LLAvatarAnimThread::AnimRequest::processRequest()
+{
+	LLVOAvatar::processAnimationUpdates();
+	sAnimRequestsDone++;
+	return true;
+}
+
 /**
  **
  ** End LLVOAvatar Support classes
@@ -597,6 +658,13 @@ S32 LLVOAvatar::sMaxVisible = 50;
 F32 LLVOAvatar::sRenderDistance = 256.f;
 S32	LLVOAvatar::sNumVisibleAvatars = 0;
 S32	LLVOAvatar::sNumLODChangesThisFrame = 0;
+std::vector<LLVOAvatar*> LLVOAvatar::sPendingAnimUpdates;
+U32 LLVOAvatar::sLastAnimBatchSize = 0;
+U32 LLVOAvatar::sAnimLODCounts[LLMotionController::ANIM_LOD_COUNT];
+U32 LLVOAvatar::sLastAnimLODCounts[LLMotionController::ANIM_LOD_COUNT];
+F64 LLVOAvatar::sAnimFullUpdateClocks = 0.0;
+F64 LLVOAvatar::sAnimLODSavedClocks = 0.0;
+F32 LLVOAvatar::sLastAnimLODSavedMs = 0.f;
 
 const LLUUID LLVOAvatar::sStepSoundOnLand("e8af4a28-aa83-4310-a7c4-c047e15ea0df");
 const LLUUID LLVOAvatar::sStepSounds[LL_MCODE_END] =
@@ -674,6 +742,7 @@ LLVOAvatar::LLVOAvatar(const LLUUID& id,
 	mTexHairColor(NULL),
 	mTexEyeColor(NULL),
 	mNeedsSkin(FALSE),
+	mAnimUpdatePending(false),
 	mLastSkinTime(0.f),
 	mUpdatePeriod(1),
 	mFullyLoaded(FALSE),
@@ -775,6 +844,8 @@ LLVOAvatar::~LLVOAvatar()
 	LL_DEBUGS("Avatar") << "LLVOAvatar Destructor (0x" << this << ") id:"
 						<< mID << LL_ENDL;
 
+	cancelAnimationUpdate();
+
 	mRoot.removeAllChildren();
 
 	delete [] mSkeleton;
@@ -833,6 +904,7 @@ LLVOAvatar::~LLVOAvatar()
 
 void LLVOAvatar::markDead()
 {
+	cancelAnimationUpdate();
 	if (mNameText)
 	{
 		mNameText->markDead();
@@ -1175,10 +1247,16 @@ void LLVOAvatar::initClass()
 		llerrs << "Error parsing skeleton node in avatar XML file: "
 			   << skeleton_path << llendl;
 	}
+
+	// Note: changes to this setting only take effect after a restart
+	U32 anim_threads = gSavedSettings.getU32("AvatarAnimationThreads");
+	startAnimationThreads(llmin(anim_threads, (U32)8));
 }
 
 void LLVOAvatar::cleanupClass()
 {
+	stopAnimationThreads();
+	LLTexLayerCompositor::cleanupClass();
 	delete sAvatarXmlInfo;
 	sAvatarXmlInfo = NULL;
 	sSkeletonXMLTree.cleanup();
@@ -2566,7 +2644,7 @@ void LLVOAvatar::idleUpdateMisc(bool detailed_update)
 {
 	if (LLVOAvatar::sJointDebug)
 	{
-		llinfos << getFullname() << ": joint touches: " << LLJoint::sNumTouches << " updates: " << LLJoint::sNumUpdates << llendl;
+		llinfos << getFullname() << ": joint touches: " << (S32)LLJoint::sNumTouches << " updates: " << (S32)LLJoint::sNumUpdates << llendl;
 	}
 
 	LLJoint::sNumUpdates = 0;
@@ -3443,20 +3521,10 @@ BOOL LLVOAvatar::updateCharacter(LLAgent &agent)
 		return FALSE;
 	}
 
-	// change animation time quanta based on avatar render load
+	// change animation time quanta based on avatar render load and LOD
 	if (!isSelf() && !mIsDummy)
 	{
-		F32 time_quantum = clamp_rescale((F32)sInstances.size(), 10.f, 35.f, 0.f, 0.25f);
-		F32 pixel_area_scale = clamp_rescale(mPixelArea, 100, 5000, 1.f, 0.f);
-		F32 time_step = time_quantum * pixel_area_scale;
-		if (time_step != 0.f)
-		{
-			// disable walk motion servo controller as it doesn't work with motion timesteps
-			stopMotion(ANIM_AGENT_WALK_ADJUST);
-			removeAnimationData("Walk Speed");
-		}
-		mMotionController.setTimeStep(time_step);
-//		llinfos << "Setting timestep to " << time_quantum * pixel_area_scale << llendl;
+		updateAnimationLOD();
 	}
 
 	if (getParent() && !mIsSitting)
@@ -3733,7 +3801,25 @@ BOOL LLVOAvatar::updateCharacter(LLAgent &agent)
 	}
 	else
 	{
+		// The pose blending and world matrix update of other avatars are
+		// batched in flushAnimationUpdates(); the head offset and feet
+		// positions computed below then lag one frame behind for them.
+		bool defer = !sAnimThreads.empty() && !isSelf() && !mIsDummy;
+		mMotionController.setDeferredBlend(defer);
+		U64 start_clocks = get_cpu_clock_count();
 		updateMotions(LLCharacter::NORMAL_UPDATE);
+		if (!isSelf() && !mIsDummy)
+		{
+			recordAnimationUpdate(mMotionController.getAnimationLOD(),
+								  get_cpu_clock_count() - start_clocks,
+								  mMotionController.lastUpdateInterpolated());
+		}
+		if (defer && !mAnimUpdatePending &&
+			mMotionController.hasPendingBlend())
+		{
+			mAnimUpdatePending = true;
+			sPendingAnimUpdates.push_back(this);
+		}
 	}
 
 	// update head position
@@ -3823,7 +3909,10 @@ BOOL LLVOAvatar::updateCharacter(LLAgent &agent)
 		}
 	}
 
-	mRoot.updateWorldMatrixChildren();
+	if (!mAnimUpdatePending)
+	{
+		mRoot.updateWorldMatrixChildren();
+	}
 
 	if (!mDebugText.size() && mText.notNull())
 	{
@@ -3841,6 +3930,206 @@ BOOL LLVOAvatar::updateCharacter(LLAgent &agent)
 	return TRUE;
 }
 
+//-----------------------------------------------------------------------------
+// Batched animation updates
+//-----------------------------------------------------------------------------
+
+//static
+void LLVOAvatar::startAnimationThreads(U32 count)
+{
+	stopAnimationThreads();
+	for (U32 i = 0; i < count; ++i)
+	{
+		sAnimThreads.push_back(new LLAvatarAnimThread(llformat("avataranim%d",
+															   i)));
+	}
+	if (count)
+	{
+		llinfos << "Started " << count << " avatar animation threads"
+				<< llendl;
+	}
+}
+
+//static
+void LLVOAvatar::stopAnimationThreads()
+{
+	if (sAnimThreads.empty())
+	{
+		return;
+	}
+
+	// Apply any pending update on the main thread before the threads go away
+	flushAnimationUpdates();
+
+	for (U32 i = 0, count = sAnimThreads.size(); i < count; ++i)
+	{
+		sAnimThreads[i]->shutdown();
+		delete sAnimThreads[i];
+	}
+	sAnimThreads.clear();
+}
+
+//-----------------------------------------------------------------------------
+// Animation LOD
+//-----------------------------------------------------------------------------
+
+void LLVOAvatar::updateAnimationLOD()
+{
+	// Legacy time quantum, for crowds of small avatars
+	F32 time_quantum = clamp_rescale((F32)sInstances.size(), 10.f, 35.f, 0.f, 0.25f);
+	F32 pixel_area_scale = clamp_rescale(mPixelArea, 100, 5000, 1.f, 0.f);
+	F32 time_step = time_quantum * pixel_area_scale;
+
+	U32 lod = LLMotionController::ANIM_LOD_FULL;
+	static LLCachedControl<bool> anim_lod(gSavedSettings,
+										  "AvatarAnimationLOD");
+	if (anim_lod)
+	{
+		static LLCachedControl<F32> reduced_area(gSavedSettings,
+												 "AvatarAnimLODReducedArea");
+		static LLCachedControl<F32> low_area(gSavedSettings,
+											 "AvatarAnimLODLowArea");
+		static LLCachedControl<F32> max_step(gSavedSettings,
+											 "AvatarAnimLODMaxTimeStep");
+		F32 full_area = llmax((F32)reduced_area, 1.f);
+		F32 min_area = llclamp((F32)low_area, 0.f, full_area);
+		if (mPixelArea < full_area)
+		{
+			lod = mPixelArea < min_area ? LLMotionController::ANIM_LOD_LOW
+										: LLMotionController::ANIM_LOD_REDUCED;
+			// The time step grows as the avatar gets smaller on screen and
+			// the pose gets interpolated between steps
+			F32 lod_step = clamp_rescale(mPixelArea, min_area, full_area,
+										 llclamp((F32)max_step, 0.f, 1.f),
+										 0.f);
+			time_step = llmax(time_step, lod_step);
+		}
+	}
+	mMotionController.setAnimationLOD(lod);
+
+	if (time_step != 0.f)
+	{
+		// disable walk motion servo controller as it doesn't work with motion timesteps
+		stopMotion(ANIM_AGENT_WALK_ADJUST);
+		removeAnimationData("Walk Speed");
+	}
+	mMotionController.setTimeStep(time_step);
+}
+
+//static
+void LLVOAvatar::recordAnimationUpdate(U32 lod, U64 clocks, bool interpolated)
+{
+	++sAnimLODCounts[lod];
+	if (lod == LLMotionController::ANIM_LOD_FULL && !interpolated)
+	{
+		// Running average cost of a full update
+		sAnimFullUpdateClocks = sAnimFullUpdateClocks > 0.0 ?
+			0.95 * sAnimFullUpdateClocks + 0.05 * (F64)clocks : (F64)clocks;
+	}
+	else if ((F64)clocks < sAnimFullUpdateClocks)
+	{
+		sAnimLODSavedClocks += sAnimFullUpdateClocks - (F64)clocks;
+	}
+}
+
+//static
+U32 LLVOAvatar::getLastAnimationLODCount(U32 lod)
+{
+	return lod < LLMotionController::ANIM_LOD_COUNT ? sLastAnimLODCounts[lod]
+													: 0;
+}
+
+//static
+void LLVOAvatar::flushAnimationUpdates()
+{
+	// This is called once per frame, after all avatars got animated: roll
+	// the animation LOD statistics over.
+	for (U32 i = 0; i < LLMotionController::ANIM_LOD_COUNT; ++i)
+	{
+		sLastAnimLODCounts[i] = sAnimLODCounts[i];
+		sAnimLODCounts[i] = 0;
+	}
+	sLastAnimLODSavedMs = (F32)(sAnimLODSavedClocks * 1000.0 /
+								(F64)LLFastTimer::countsPerSecond());
+	sAnimLODSavedClocks = 0.0;
+
+	U32 count = sPendingAnimUpdates.size();
+	sLastAnimBatchSize = count;
+	if (!count)
+	{
+		return;
+	}
+
+	LLFastTimer t(LLFastTimer::FTM_AVATAR_ANIM_FLUSH);
+
+	sAnimUpdateIndex = 0;
+	sAnimRequestsDone = 0;
+
+	// Do not bother waking up more threads than there are avatars to share
+	// with the main thread.
+	S32 requests = 0;
+	for (U32 i = 0, threads = sAnimThreads.size();
+		 i < threads && i + 1 < count; ++i)
+	{
+		if (sAnimThreads[i]->requestUpdates())
+		{
+			++requests;
+		}
+	}
+
+	processAnimationUpdates();
+
+	// Join: each request must be done with the list before it may change.
+	while ((S32)sAnimRequestsDone < requests)
+	{
+		LLThread::yield();
+	}
+
+	for (U32 i = 0; i < count; ++i)
+	{
+		sPendingAnimUpdates[i]->mAnimUpdatePending = false;
+	}
+	sPendingAnimUpdates.clear();
+}
+
+//static
+void LLVOAvatar::processAnimationUpdates()
+{
+	S32 count = sPendingAnimUpdates.size();
+	while (true)
+	{
+		S32 i = sAnimUpdateIndex++;
+		if (i >= count)
+		{
+			break;
+		}
+		sPendingAnimUpdates[i]->applyAnimationUpdate();
+	}
+}
+
+// Only touches this avatar's skeleton, so it may run on any thread while the
+// main thread waits in flushAnimationUpdates().
+void LLVOAvatar::applyAnimationUpdate()
+{
+	mMotionController.applyPendingBlend();
+	mRoot.updateWorldMatrixChildren();
+}
+
+void LLVOAvatar::cancelAnimationUpdate()
+{
+	if (mAnimUpdatePending)
+	{
+		mAnimUpdatePending = false;
+		std::vector<LLVOAvatar*>::iterator it =
+			std::find(sPendingAnimUpdates.begin(), sPendingAnimUpdates.end(),
+					  this);
+		if (it != sPendingAnimUpdates.end())
+		{
+			sPendingAnimUpdates.erase(it);
+		}
+	}
+}
+
 //-----------------------------------------------------------------------------
 // updateHeadOffset()
 //-----------------------------------------------------------------------------
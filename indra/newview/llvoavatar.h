@@ -257,6 +257,38 @@ public:
 	void			idleUpdateRenderCost();
 	void			idleUpdateBelowWater();
 
+	// Batched animation update: the pose blending and skeleton world matrix
+	// update of the avatars animated during the objects idle loop are
+	// deferred, then flushed together (and spread over the animation worker
+	// threads) by flushAnimationUpdates(), before anything gets rendered.
+	static void		startAnimationThreads(U32 count);
+	static void		stopAnimationThreads();
+	static void		flushAnimationUpdates();
+	// Called by the worker threads and the main thread during the flush
+	static void		processAnimationUpdates();
+	static U32		getLastAnimationBatchSize()	{ return sLastAnimBatchSize; }
+	// Animation LOD statistics for the last frame: number of animated
+	// avatars at each LLMotionController::EAnimationLOD level, and estimated
+	// time saved compared with updating all of them at full LOD.
+	static U32		getLastAnimationLODCount(U32 lod);
+	static F32		getLastAnimationLODSavedMs()	{ return sLastAnimLODSavedMs; }
+
+private:
+	void			applyAnimationUpdate();
+	void			cancelAnimationUpdate();
+
+	void			updateAnimationLOD();
+	static void		recordAnimationUpdate(U32 lod, U64 clocks,
+										  bool interpolated);
+
+	static std::vector<LLVOAvatar*>	sPendingAnimUpdates;
+	static U32						sLastAnimBatchSize;
+	static U32						sAnimLODCounts[LLMotionController::ANIM_LOD_COUNT];
+	static U32						sLastAnimLODCounts[LLMotionController::ANIM_LOD_COUNT];
+	static F64						sAnimFullUpdateClocks;
+	static F64						sAnimLODSavedClocks;
+	static F32						sLastAnimLODSavedMs;
+
 	//--------------------------------------------------------------------
 	// Static preferences (controlled by user settings/menus)
 	//--------------------------------------------------------------------
@@ -411,6 +443,8 @@ public:
 	U32			renderRigid();
 	U32			renderSkinned(EAvatarRenderPass pass);
 	F32			getLastSkinTime()		{ return mLastSkinTime; }
+	// Changes each time the skeleton pose changes (see LLJoint::mPoseVersion)
+	U32			getPoseVersion() const	{ return mRoot.getPoseVersion(); }
 	U32			renderSkinnedAttachments();
 	U32			renderTransparent(BOOL first_pass);
 	void		renderCollisionVolumes();
@@ -426,6 +460,7 @@ private:
 	bool		shouldAlphaMask();
 
 	BOOL		mNeedsSkin;		// avatar has been animated and verts have not been updated
+	bool		mAnimUpdatePending;	// queued for flushAnimationUpdates()
 	F32			mLastSkinTime;	// value of gFrameTimeSeconds at last skin update
 
 	S32			mUpdatePeriod;
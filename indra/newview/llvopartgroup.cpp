@@ -129,7 +129,7 @@ F32 LLVOPartGroup::getPartSize(S32 idx)
 {
 	if (idx < (S32) mViewerPartGroupp->mParticles.size())
 	{
-		return mViewerPartGroupp->mParticles[idx]->mScale.mV[0];
+		return mViewerPartGroupp->getPartScale(idx).mV[0];
 	}
 
 	return 0.f;
@@ -198,7 +198,8 @@ BOOL LLVOPartGroup::updateGeometry(LLDrawable* drawable)
 	{
 		const LLViewerPart* part = mViewerPartGroupp->mParticles[i];
 
-		LLVector3 part_pos_agent(part->mPosAgent);
+		LLVector3 part_pos_agent = mViewerPartGroupp->getPartPosition(i);
+		LLVector2 part_scale = mViewerPartGroupp->getPartScale(i);
 		LLVector3 at(part_pos_agent - camera_agent);
 
 		F32 camera_dist_squared = at.lengthSquared();
@@ -211,7 +212,7 @@ BOOL LLVOPartGroup::updateGeometry(LLDrawable* drawable)
 		{
 			inv_camera_dist_squared = 1.f;
 		}
-		F32 area = part->mScale.mV[0] * part->mScale.mV[1] * inv_camera_dist_squared;
+		F32 area = part_scale.mV[0] * part_scale.mV[1] * inv_camera_dist_squared;
 		tot_area = llmax(tot_area, area);
 
 		if (tot_area > max_area)
@@ -252,8 +253,8 @@ BOOL LLVOPartGroup::updateGeometry(LLDrawable* drawable)
 			facep->clearState(LLFace::FULLBRIGHT);
 		}
 
-		facep->mCenterLocal = part->mPosAgent;
-		facep->setFaceColor(part->mColor);
+		facep->mCenterLocal = part_pos_agent;
+		facep->setFaceColor(mViewerPartGroupp->getPartColor(i));
 		facep->setTexture(part->mImagep);
 
 #ifdef MEDIA_ON_PRIM
@@ -284,6 +285,20 @@ BOOL LLVOPartGroup::updateGeometry(LLDrawable* drawable)
 	return TRUE;
 }
 
+// Same as LLVector3::normalize(): vectors too short to be normalized are
+// zeroed.
+static inline void normalize_part_vector(LLVector4a& v)
+{
+	if (v.dot3(v).getF32() > FP_MAG_THRESHOLD * FP_MAG_THRESHOLD)
+	{
+		v.normalize3();
+	}
+	else
+	{
+		v.clear();
+	}
+}
+
 void LLVOPartGroup::getGeometry(S32 idx,
 								LLStrider<LLVector3>& verticesp,
 								LLStrider<LLVector3>& normalsp,
@@ -301,50 +316,72 @@ void LLVOPartGroup::getGeometry(S32 idx,
 
 	U32 vert_offset = mDrawable->getFace(idx)->getGeomIndex();
 
-	LLVector3 part_pos_agent(part.mPosAgent);
+	LLVector3 part_pos_agent = mViewerPartGroupp->getPartPosition(idx);
+	LLVector2 part_scale = mViewerPartGroupp->getPartScale(idx);
 	LLVector3 camera_agent = getCameraPosition();
-	LLVector3 at = part_pos_agent - camera_agent;
-	LLVector3 up;
-	LLVector3 right;
 
-	right = at % LLVector3(0.f, 0.f, 1.f);
-	right.normalize();
-	up = right % at;
-	up.normalize();
+	LLVector4a pos, at, up, right;
+	pos.load3(part_pos_agent.mV);
+	at.load3(camera_agent.mV);
+	at.setSub(pos, at);
+
+	static const LLVector4a z_axis(0.f, 0.f, 1.f);
+	right.setCross3(at, z_axis);
+	normalize_part_vector(right);
+	up.setCross3(right, at);
+	normalize_part_vector(up);
 
 	if (part.mFlags & LLPartData::LL_PART_FOLLOW_VELOCITY_MASK)
 	{
-		LLVector3 normvel = part.mVelocity;
-		normvel.normalize();
+		LLVector4a normvel;
+		normvel.load3(mViewerPartGroupp->getPartVelocity(idx).mV);
+		normalize_part_vector(normvel);
 		LLVector2 up_fracs;
-		up_fracs.mV[0] = normvel * right;
-		up_fracs.mV[1] = normvel * up;
+		up_fracs.mV[0] = normvel.dot3(right).getF32();
+		up_fracs.mV[1] = normvel.dot3(up).getF32();
 		up_fracs.normalize();
-		LLVector3 new_up;
-		LLVector3 new_right;
-		new_up = up_fracs.mV[0] * right + up_fracs.mV[1] * up;
-		new_right = up_fracs.mV[1] * right - up_fracs.mV[0] * up;
+		LLVector4a new_up = right;
+		new_up.mul(up_fracs.mV[0]);
+		LLVector4a tmp = up;
+		tmp.mul(up_fracs.mV[1]);
+		new_up.add(tmp);
+		LLVector4a new_right = right;
+		new_right.mul(up_fracs.mV[1]);
+		tmp = up;
+		tmp.mul(up_fracs.mV[0]);
+		new_right.sub(tmp);
 		up = new_up;
 		right = new_right;
-		up.normalize();
-		right.normalize();
+		normalize_part_vector(up);
+		normalize_part_vector(right);
 	}
 
-	right *= 0.5f * part.mScale.mV[0];
-	up *= 0.5f * part.mScale.mV[1];
+	right.mul(0.5f * part_scale.mV[0]);
+	up.mul(0.5f * part_scale.mV[1]);
+
+	// Quad corners: pos + up - right, pos - up - right, pos + up + right and
+	// pos - up + right
+	LLVector4a pos_up, pos_down, corner;
+	pos_up.setAdd(pos, up);
+	pos_down.setSub(pos, up);
+
+	corner.setSub(pos_up, right);
+	*verticesp++ = LLVector3(corner.getF32ptr());
+	corner.setSub(pos_down, right);
+	*verticesp++ = LLVector3(corner.getF32ptr());
+	corner.setAdd(pos_up, right);
+	*verticesp++ = LLVector3(corner.getF32ptr());
+	corner.setAdd(pos_down, right);
+	*verticesp++ = LLVector3(corner.getF32ptr());
+
+	LLColor4U color = mViewerPartGroupp->getPartColor(idx);
+	*colorsp++ = color;
+	*colorsp++ = color;
+	*colorsp++ = color;
+	*colorsp++ = color;
 
 	LLVector3 normal = -LLViewerCamera::getInstance()->getXAxis();
 
-	*verticesp++ = part_pos_agent + up - right;
-	*verticesp++ = part_pos_agent - up - right;
-	*verticesp++ = part_pos_agent + up + right;
-	*verticesp++ = part_pos_agent - up + right;
-
-	*colorsp++ = part.mColor;
-	*colorsp++ = part.mColor;
-	*colorsp++ = part.mColor;
-	*colorsp++ = part.mColor;
-
 	*texcoordsp++ = LLVector2(0.f, 1.f);
 	*texcoordsp++ = LLVector2(0.f, 0.f);
 	*texcoordsp++ = LLVector2(1.f, 1.f);
@@ -95,6 +95,7 @@ F32 LLVOVolume::sLODFactor = 1.f;
 F32 LLVOVolume::sLODSlopDistanceFactor = 0.5f; //Changing this to zero, effectively disables the LOD transition slop
 F32 LLVOVolume::sDistanceFactor = 1.0f;
 S32 LLVOVolume::sNumLODChanges = 0;
+LLVOVolume::pending_volumes_t LLVOVolume::sPendingVolumes;
 
 #ifdef MEDIA_ON_PRIM
 LLPointer<LLObjectMediaDataClient> LLVOVolume::sObjectMediaClient = NULL;
@@ -234,6 +235,8 @@ LLVOVolume::~LLVOVolume()
 	delete mVolumeImpl;
 	mVolumeImpl = NULL;
 
+	sPendingVolumes.erase(this);
+
 #ifdef MEDIA_ON_PRIM
 	if (!mMediaImplList.empty())
 	{
@@ -271,6 +274,8 @@ void LLVOVolume::markDead()
 		{
 			mSculptTexture->removeVolume(this);
 		}
+
+		sPendingVolumes.erase(this);
 	}
 
 	LLViewerObject::markDead();
@@ -279,6 +284,10 @@ void LLVOVolume::markDead()
 // static
 void LLVOVolume::initClass()
 {
+	// Note: changes to this setting only take effect after a restart
+	U32 gen_threads = gSavedSettings.getU32("RenderVolumeGenThreads");
+	LLPrimitive::getVolumeManager()->startGenThreads(llmin(gen_threads, (U32)8));
+
 #ifdef MEDIA_ON_PRIM
 	// gSavedSettings better be around
 	if (gSavedSettings.getBOOL("PrimMediaMasterEnabled"))
@@ -1088,6 +1097,15 @@ BOOL LLVOVolume::setVolume(const LLVolumeParams &params_in, const S32 detail, bo
 		volume_params.setSculptID(LLUUID::null, LL_SCULPT_TYPE_NONE);
 	}
 
+	// When switching the LOD of an already built volume, have the new LOD
+	// generated in a worker thread and keep the current one meanwhile.
+	if (!is404 && !is_flexible && lod != last_lod && last_lod >= 0 &&
+		volume_params == mVolumep->getParams() && !isMesh() &&
+		!requestVolumeLOD(volume_params, lod))
+	{
+		return FALSE;
+	}
+
 	BOOL res = LLPrimitive::setVolume(volume_params, lod, mVolumeImpl && mVolumeImpl->isVolumeUnique());
 	if (res || mSculptChanged)
 	{
@@ -1131,6 +1149,79 @@ BOOL LLVOVolume::setVolume(const LLVolumeParams &params_in, const S32 detail, bo
 	return FALSE;
 }
 
+bool LLVOVolume::requestVolumeLOD(const LLVolumeParams& volume_params, S32 lod)
+{
+	LLVolumeMgr* volume_mgr = LLPrimitive::getVolumeManager();
+	if (!volume_mgr->hasGenThreads())
+	{
+		return true;
+	}
+
+	U16 sculpt_width = 0;
+	U16 sculpt_height = 0;
+	S8 sculpt_components = 0;
+	const U8* sculpt_data = NULL;
+	S32 discard_level = -2;
+	if (isSculpted() && mSculptTexture.notNull())
+	{
+		// Same as in sculpt(), so that the latter finds nothing left to do
+		discard_level = llmin(mSculptTexture->getDiscardLevel(),
+							  mSculptTexture->getMaxDiscardLevel());
+		LLImageRaw* raw_image = mSculptTexture->getCachedRawImage();
+		if (raw_image)
+		{
+			sculpt_width = raw_image->getWidth();
+			sculpt_height = raw_image->getHeight();
+			sculpt_components = raw_image->getComponents();
+			sculpt_data = raw_image->getData();
+		}
+	}
+
+	if (volume_mgr->requestVolume(volume_params, lod, sculpt_width,
+								  sculpt_height, sculpt_components,
+								  sculpt_data, discard_level))
+	{
+		return true;
+	}
+
+	sPendingVolumes.insert(this);
+	return false;
+}
+
+//static
+void LLVOVolume::updatePendingVolumes()
+{
+	LLVolumeMgr* volume_mgr = LLPrimitive::getVolumeManager();
+	if (!volume_mgr->hasGenThreads())
+	{
+		return;
+	}
+
+	volume_mgr->updateGenThreads();
+
+	for (pending_volumes_t::iterator iter = sPendingVolumes.begin();
+		 iter != sPendingVolumes.end(); )
+	{
+		pending_volumes_t::iterator cur_iter = iter++;
+		LLVOVolume* vobj = *cur_iter;
+		LLVolume* volume = vobj->getVolume();
+		if (vobj->isDead() || vobj->mDrawable.isNull() || !volume)
+		{
+			sPendingVolumes.erase(cur_iter);
+			continue;
+		}
+
+		LLVolumeLODGroup* group = volume_mgr->getGroup(volume->getParams());
+		if (!group || group->hasLOD(vobj->mLOD))
+		{
+			vobj->mLODChanged = TRUE;
+			gPipeline.markRebuild(vobj->mDrawable, LLDrawable::REBUILD_VOLUME,
+								  FALSE);
+			sPendingVolumes.erase(cur_iter);
+		}
+	}
+}
+
 void LLVOVolume::updateSculptTexture()
 {
 	LLPointer<LLViewerFetchedTexture> old_sculpt = mSculptTexture;
@@ -3411,6 +3502,7 @@ U32 LLVOVolume::getHighLODTriangleCount()
 void LLVOVolume::preUpdateGeom()
 {
 	sNumLODChanges = 0;
+	updatePendingVolumes();
 }
 
 void LLVOVolume::parameterChanged(U16 param_type, bool local_origin)
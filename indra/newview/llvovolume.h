@@ -46,6 +46,7 @@
 #endif
 
 #include <map>
+#include <set>
 
 class LLViewerTextureAnim;
 class LLDrawPool;
@@ -204,6 +205,10 @@ public:
 	static		void	cleanupClass();
 #endif
 	static 		void 	preUpdateGeom();
+
+	// Swaps in the volumes generated by the volume manager worker threads and
+	// rebuilds the objects that were waiting for them.
+	static		void	updatePendingVolumes();
 	
 	enum 
 	{
@@ -429,6 +434,10 @@ public:
 	LLDeformedVolume* getDeformedVolume();
 
 protected:
+	// Returns true when the volume LOD is available or cannot be generated
+	// asynchronously, false when it is being generated in a worker thread.
+	bool requestVolumeLOD(const LLVolumeParams& volume_params, S32 lod);
+
 	S32	computeLODDetail(F32	distance, F32 radius);
 	BOOL calcLOD();
 	LLFace* addFace(S32 face_index);
@@ -487,6 +496,10 @@ public:
 protected:
 	static S32 sNumLODChanges;
 
+	// Objects waiting for a volume LOD being generated in a worker thread
+	typedef std::set<LLVOVolume*> pending_volumes_t;
+	static pending_volumes_t sPendingVolumes;
+
 	friend class LLVolumeImplFlexible;
 };
 